@@ -1,6 +1,8 @@
 /*
     Descripción: Programa que lee un archivo de bitácora, ordena las entradas por fecha/hora
     y permite buscar registros en un rango de fechas, además de guardar los resultados filtrados.
+    Si la bitácora está rotada (bitacora.txt.1, .2, ...) se leen todos los archivos, cada uno
+    en su propia tarea, y se mezclan en orden de tiempo sin volver a ordenar todo.
 
  *Autores:
  * [Ayleen Osnaya Ortega] - [A01426008]
@@ -13,6 +15,12 @@
 #include <vector>
 #include <fstream>
 #include <string>
+
+#include "../A01739942_Comun/estadisticas.h"
+#include "../A01739942_Comun/formato.h"
+#include "../A01739942_Comun/gzip.h"
+#include "../A01739942_Comun/hilos.h"
+#include "../A01739942_Comun/mezcla.h"
 using namespace std;
 
 
@@ -22,11 +30,11 @@ using namespace std;
 */
 struct entry{
     int month, day, hour, min, sec; // Fecha y hora desglosada
-    long long totalTime;            // Clave numérica para ordenar por fecha/hora
+    uint32_t totalTime;             // Clave para ordenar por fecha/hora: segundos desde el año base
     int ip1, ip2, ip3, ip4;         // Octetos de la IP (para comparar punto por punto)
     int port;                       // Puerto
     string reason;                  // Resto del mensaje (motivo / descripción)
-    string originLine;              // Línea original tal cual (útil para imprimir)
+    string originLine;              // Línea original, solo si no se puede regenerar igual (2.7)
 };
 
 // ---------------- 2. FUNCIONES AUXILIARES ----------------
@@ -85,13 +93,14 @@ void splitIp(string &i, int &a, int &b, int &c, int &d, int &p){
 
 /*
  * 2.5 TotalTime
- * Calcula una clave numérica a partir de fecha y hora (segundos relativos)
+ * Calcula una clave numérica a partir de fecha y hora: segundos desde el
+ * año base en 32 bits (comun::claveTiempo); anio es relativo a él.
  * Usa 31 días por mes, conforme a la suposición del enunciado
  * Complejidad: O(1).
  */
 
-long long total_time(int month, int day, int hour, int minute, int second){
-    return (((((month * 31LL + day) * 24 + hour) * 60 + minute) * 60) + second);
+uint32_t total_time(int month, int day, int hour, int minute, int second, uint32_t anio = 0){
+    return comun::claveTiempo(month, day, hour, minute, second, anio);
 } 
 
 /* -------------------------------------------------------------
@@ -120,6 +129,23 @@ bool lessEntry(const entry &A, const entry &B) {
 }
 
 
+/* -------------------------------------------------------------
+ * 2.7 entryRecord / writeEntry
+ * entry a comun::Registro (para esCanonica al leer) y su línea con
+ * comun::escribirRegistro (formato.h): regenerada de los campos, o
+ * originLine si no se podía. newline = false para la última línea de
+ * sorted.txt.
+ * complejidad: O(L), L = longitud de la línea.
+  -------------------------------------------------------------*/
+comun::Registro entryRecord(const entry& E) {
+    return comun::registroDeCampos(E.totalTime, E.ip1, E.ip2, E.ip3, E.ip4, E.port);
+}
+
+void writeEntry(comun::SalidaLineas& out, const entry& E, bool newline = true) {
+    comun::escribirRegistro(out, entryRecord(E), E.reason, E.originLine, newline);
+}
+
+
 // ---------------- 3. QUICK SORT ----------------
 /*
  * Implementación del algoritmo QuickSort para ordenar las entradas.
@@ -179,7 +205,7 @@ void quickSort(vector<entry>& a, int low, int high) {
  * upperBoundSum -> primera posición con totalTime > thetime
  * complejidad: O(log n).
   -------------------------------------------------------------*/
-int lowerBoundSum(const vector<entry> &v, long long thetime) { 
+int lowerBoundSum(const vector<entry> &v, uint32_t thetime) { 
     int l = 0, r = (int)v.size();
     while (l < r) {
         int m = l + (r - l) / 2;
@@ -196,7 +222,7 @@ int lowerBoundSum(const vector<entry> &v, long long thetime) {
  * Complejidad: O(log n)
  */
  
-int upperBoundSum(const vector<entry> &v, long long thetime) {
+int upperBoundSum(const vector<entry> &v, uint32_t thetime) {
     int l = 0, r = (int)v.size();
     while (l < r) {
         int m = l + (r - l) / 2;
@@ -206,27 +232,58 @@ int upperBoundSum(const vector<entry> &v, long long thetime) {
     return l;
 } //Binary search to find the upper bound 
 
+/*
+ * 4.3 anioDeConsulta
+ * Con --cambio-anio la consulta "mes día mes día" no dice el año: se toma
+ * el primero (del más viejo al más nuevo) que tenga registros en el mes
+ * de inicio, así "1 2 1 3" encuentra el enero de un juego que empieza en
+ * diciembre. Sin registros en ese mes, el año base.
+ * Complejidad: O(a log n), a = años en logs
+ */
+
+uint32_t anioDeConsulta(const vector<entry> &v, int month) {
+    if (v.empty()) return 0;
+    uint32_t ultimo = comun::anioDe(v.back().totalTime);
+    for (uint32_t anio = 0; anio <= ultimo; anio++) {
+        int desde = lowerBoundSum(v, total_time(month, 1, 0, 0, 0, anio));
+        int hasta = upperBoundSum(v, total_time(month, 31, 23, 59, 59, anio));
+        if (desde < hasta) return anio;
+    }
+    return 0;
+}
+
 
-/* ---------------- 5. FUNCIÓN PRINCIPAL ---------------- 
+// ---------------- 5. ARCHIVOS ROTADOS ----------------
 
 /* -------------------------------------------------------------
- * Función principal
- * 1) Lee bitacora.txt línea por línea
- * 2) Parsea tokens (mes, día, hora, ip:port, razón)
- * 3) Calcula totalTime y divide la IP en octetos
- * 4) Inserta registros en logs
- * 5) Ordena con quickSort usando la comparación definida
- * 6) Escribe sorted.txt con las líneas ordenadas
- * 7) Lee rango de fechas desde stdin y muestra registros en ese rango
- * complejidad: O(n^2)
+ * 5.1 Archivo
+ * Registros de un archivo del juego rotado y posición donde empieza cada
+ * tramo que ya está en orden.
   -------------------------------------------------------------*/
-int main(){
-    ifstream theFile("bitacora.txt");
+struct Archivo {
     vector<entry> logs;
+    vector<size_t> tramos;
+};
+
+// Largo promedio de tramo desde el cual un archivo se mezcla sin ordenarlo
+const size_t LARGO_MIN_TRAMO = 32;
+
+/* -------------------------------------------------------------
+ * 5.2 leerArchivo
+ * Lee el archivo línea por línea, parsea tokens (mes, día, hora, ip:port,
+ * razón), calcula totalTime, divide la IP en octetos e inserta los
+ * registros en a.logs.
+ * complejidad: O(n)
+  -------------------------------------------------------------*/
+void leerArchivo(const string& ruta, Archivo& a) {
+    comun::EntradaBitacora theFile(ruta);
     string line;
 
-    // Lectura y parsing: asumimos que bitacora.txt está bien formado
+    // Lectura y parsing: asumimos que la bitácora está bien formada
+    comun::Acumulador lectura("lectura"), parseo("parseo");
+    comun::Marca marca;
     while(getline(theFile,line)){
+        lectura.sumar(marca);
         entry TO; // temporal para cada línea
         size_t pos = 0; // posición para tokenizer
         string month_str = tokenizer(line, pos);   // token mes (ej. "Feb")
@@ -248,23 +305,166 @@ int main(){
         // dividir IP:PORT en sus componentes numéricos
         splitIp(ipPort, TO.ip1, TO.ip2, TO.ip3, TO.ip4, TO.port);
 
-        TO.originLine = line;   // almacenamos la línea original tal cual
-        logs.push_back(TO);     // agregamos al vector
+        // la línea original solo se guarda si no se puede regenerar idéntica
+        if (!comun::esCanonica(entryRecord(TO), TO.reason, line)) TO.originLine = line;
+        a.logs.push_back(TO);   // agregamos al vector
+        parseo.sumar(marca);
     }
     theFile.close();
+    lectura.sumar(marca);   // el último getline (fin de archivo)
+}
+
+/* -------------------------------------------------------------
+ * 5.3 ordenarArchivo
+ * Un archivo rotado viene casi en orden: se parte en sus tramos
+ * ascendentes y, si son largos (LARGO_MIN_TRAMO en promedio), se deja como
+ * está para que la mezcla los junte. Si está revuelto se ordena completo
+ * con quickSort y queda un solo tramo.
+ * complejidad: O(n) si viene en orden; O(n^2) en el peor caso de quickSort
+  -------------------------------------------------------------*/
+void ordenarArchivo(Archivo& a) {
+    a.tramos = comun::tramosAscendentes(a.logs.begin(), a.logs.end(), lessEntry);
+    if (a.tramos.size() > 1 && a.tramos.size() * LARGO_MIN_TRAMO > a.logs.size()) {
+        quickSort(a.logs, 0, (int)a.logs.size() - 1);
+        a.tramos.assign(1, 0);
+    }
+}
 
-    // Ordenar los registros según la comparación definida
-    quickSort(logs, 0, (int)logs.size() -1);
+/* -------------------------------------------------------------
+ * 5.4 inferirAnios
+ * Con --cambio-anio (comun::Calendario) asigna el año a cada registro:
+ * la bitácora no lo trae y un juego rotado que pasa de diciembre a enero
+ * debe dejar enero después. Los archivos se recorren del más viejo al más
+ * nuevo en el orden en que se leyeron, antes de ordenarlos. Si unas
+ * líneas que saltaron hacia adelante resultan ser un hueco y no rezagados,
+ * se les regresa el año (reasignados). Avisa si un archivo no parece
+ * estar en orden de tiempo.
+ * complejidad: O(n)
+  -------------------------------------------------------------*/
+void inferirAnios(vector<Archivo>& archivos, const vector<string>& rutas) {
+    comun::InferenciaAnio anios(true);
+    for (size_t f = 0; f < archivos.size(); f++) {
+        comun::InferenciaAnio inicio = anios;
+        vector<entry>& logs = archivos[f].logs;
+        for (size_t i = 0; i < logs.size(); i++) {
+            logs[i].totalTime = anios.ajustar(logs[i].totalTime);
+            for (size_t k = 1; k <= anios.reasignados() && k <= i; k++)
+                logs[i - k].totalTime += comun::SEGUNDOS_ANIO;
+        }
+        anios.avisarSiSospechosa(rutas[f], inicio);
+    }
+}
+
+/* -------------------------------------------------------------
+ * 5.5 mezclarArchivos
+ * Mezcla los tramos de todos los archivos con un árbol de perdedores
+ * (mezcla.h) comparando con lessEntry. Los archivos van del más viejo al
+ * más nuevo, así que en un empate total sale primero el más viejo.
+ * complejidad: O(n log t), t = número de tramos
+  -------------------------------------------------------------*/
+vector<entry> mezclarArchivos(vector<Archivo>& archivos) {
+    struct Tramo {
+        entry* pos;
+        entry* fin;
+    };
+    vector<Tramo> tramos;
+    size_t total = 0;
+    for (Archivo& a : archivos) {
+        for (size_t t = 0; t < a.tramos.size(); t++) {
+            size_t fin = t + 1 < a.tramos.size() ? a.tramos[t + 1] : a.logs.size();
+            tramos.push_back({a.logs.data() + a.tramos[t], a.logs.data() + fin});
+        }
+        total += a.logs.size();
+    }
+    auto menor = [&](size_t x, size_t y) { return lessEntry(*tramos[x].pos, *tramos[y].pos); };
+    comun::ArbolPerdedores<decltype(menor)> arbol(tramos.size(), menor);
+    arbol.iniciar([&](size_t i) { return tramos[i].pos == tramos[i].fin; });
+
+    vector<entry> logs;
+    logs.reserve(total);
+    while (!arbol.vacio()) {
+        Tramo& t = tramos[arbol.ganador()];
+        logs.push_back(move(*t.pos));
+        ++t.pos;
+        arbol.avanzar(t.pos == t.fin);
+    }
+    return logs;
+}
+
+
+/* ---------------- 6. FUNCIÓN PRINCIPAL ---------------- 
+
+/* -------------------------------------------------------------
+ * Función principal
+ * 1) Busca el juego de archivos rotados (bitacora.txt.N ... bitacora.txt)
+ * 2) Lee y parsea cada archivo en su propia tarea (leerArchivo) y lo deja
+ *    en tramos ordenados (ordenarArchivo); con --cambio-anio primero se
+ *    infieren los años de todos (inferirAnios) y después se ordena
+ * 3) Mezcla los tramos de todos los archivos en logs (mezclarArchivos)
+ * 4) Escribe sorted.txt con las líneas ordenadas
+ * 5) Lee rango de fechas desde stdin y muestra registros en ese rango
+ *    (del año base; con --cambio-anio del primer año con registros en el
+ *    mes de inicio (anioDeConsulta), y un fin antes del inicio es del año
+ *    siguiente, p.ej. "12 30 1 2")
+ * Con --anio-base AAAA se fija el año de la clave 0 (registro.h).
+ * Con --stats se imprime en stderr el tiempo y memoria de cada etapa (JSON);
+ * con --stats-hw también contadores de hardware (ciclos, fallos de caché);
+ * con --traza archivo.json, la línea de tiempo de las etapas (Chrome).
+ * complejidad: O(n^2)
+  -------------------------------------------------------------*/
+int main(int argc, char* argv[]){
+    comun::Estadisticas::global().habilitarSiSePide(argc, argv, "Act1.3");
+    if (!comun::Calendario::global().habilitarSiSePide(argc, argv)) return 1;
+    bool anios = comun::Calendario::global().cambioAnio;
+    vector<string> rutas = comun::archivosRotados("bitacora.txt");
+    vector<Archivo> archivos(rutas.size());
+    {
+        comun::EventoTraza carga("carga");   // todos los archivos, para la traza
+        comun::GrupoTareas g;
+        for (size_t i = 0; i < rutas.size(); i++) {
+            g.lanzar([&, i] {
+                leerArchivo(rutas[i], archivos[i]);
+                if (anios) return;      // se ordena después de inferir los años
+                comun::Temporizador t("orden");
+                ordenarArchivo(archivos[i]);
+            });
+        }
+        g.esperar();
+        if (anios) {
+            inferirAnios(archivos, rutas);
+            for (size_t i = 0; i < rutas.size(); i++) {
+                g.lanzar([&, i] {
+                    comun::Temporizador t("orden");
+                    ordenarArchivo(archivos[i]);
+                });
+            }
+            g.esperar();
+        }
+    }
+
+    // Un solo vector en orden con los registros de todos los archivos
+    vector<entry> logs;
+    {
+        comun::Temporizador t("mezcla");
+        logs = mezclarArchivos(archivos);
+        archivos.clear();
+    }
+    comun::Estadisticas::global().contar("lineas", logs.size());
 
     // Escribir todos los registros ordenados en sorted.txt (misma estructura que la entrada)
-    ofstream outFile("sorted.txt");
-    for (size_t i = 0; i < logs.size(); i++) {
-        outFile << logs[i].originLine;
-        if (i < logs.size() - 1) {  // Solo añade una nueva línea si no es la última entrada.
-         outFile << "\n";
+    {
+        comun::Temporizador t("escritura");
+        ofstream outFile("sorted.txt");
+        {
+            comun::SalidaLineas out(outFile);
+            for (size_t i = 0; i < logs.size(); i++) {
+                // Solo añade una nueva línea si no es la última entrada.
+                writeEntry(out, logs[i], i < logs.size() - 1);
+            }
         }
+        outFile.close(); 
     }
-    outFile.close(); 
+    comun::Temporizador consulta("consulta");
 
     // Lectura de rango de fechas desde stdin (para pruebas automáticas)
     int sm, sd, em, ed;
@@ -272,9 +472,12 @@ int main(){
     if (!(cin >> em >> ed)) return 0;
 
     // Convertir rango a totalTime (incluir desde 00:00:00 hasta 23:59:59)
-    long long sk = total_time(sm, sd, 0, 0, 0);
-    long long ek = total_time(em, ed, 23, 59, 59);
-    if (sk > ek) { long long t = sk; sk = ek; ek = t; }
+    uint32_t anio = anios ? anioDeConsulta(logs, sm) : 0;
+    uint32_t sk = total_time(sm, sd, 0, 0, 0, anio);
+    uint32_t ek = total_time(em, ed, 23, 59, 59, anio);
+    if (sk > ek && anios)
+        ek = anio + 1 < comun::ANIOS_MAX ? total_time(em, ed, 23, 59, 59, anio + 1) : UINT32_MAX;
+    else if (sk > ek) { uint32_t t = sk; sk = ek; ek = t; }
 
     // Encontrar índices con búsqueda binaria y mostrar los registros del rango
     int start = lowerBoundSum(logs, sk);
@@ -283,8 +486,9 @@ int main(){
         start = 0;
     if (end >= (int)logs.size()) 
         end = (int)logs.size() - 1;
+    comun::SalidaLineas out(cout);
     for (int i = start; i <= end; ++i) 
-        cout << logs[i].originLine << '\n';
+        writeEntry(out, logs[i]);
 
     return 0;
 }
\ No newline at end of file
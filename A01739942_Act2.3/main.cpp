@@ -12,6 +12,10 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+
+#include "../A01739942_Comun/estadisticas.h"
+#include "../A01739942_Comun/formato.h"
+#include "../A01739942_Comun/gzip.h"
 using namespace std;
 
 /* ---------------- 1. ESTRUCTURA PRINCIPAL ----------------
@@ -22,11 +26,11 @@ using namespace std;
  */
 struct entry {
     int month, day, hour, min, sec;    // Fecha y hora desglosada
-    long long totalTime;              // Clave numérica de fecha/hora para comparar fácilmente
+    uint32_t totalTime;               // Clave de fecha/hora: segundos desde el año base (32 bits)
     int ip1, ip2, ip3, ip4;           // Octetos de la IP
     int port;                        // Puerto de la conexión
     string reason;                   // Mensaje de error o descripción
-    string originLine;               // Línea original completa (útil para imprimir exactamente igual)
+    string originLine;               // Línea original, solo si no se puede regenerar igual (2.11)
 };
 
 struct Node {
@@ -117,13 +121,13 @@ void splitIp(const string &ipPort, int &a, int &b, int &c, int &d, int &p) {
 
 /*
  * 2.4 total_time
- * Calcula una clave numérica a partir de una fecha y hora desglosada.
- * Sirve para comparar rápidamente dos fechas/horas.
- * (Asume que las entradas están dentro del mismo año y rango razonable de meses).
+ * Clave numérica de una fecha y hora desglosada para comparar rápidamente
+ * dos fechas/horas: segundos desde el año base en 32 bits, con meses de 31
+ * días como supone el enunciado (comun::claveTiempo).
  * Complejidad: O(1).
  */
-long long total_time(int month, int day, int hour, int minute, int second) {
-    return (((((long long)month * 31 + day) * 24 + hour) * 60 + minute) * 60 + second);
+uint32_t total_time(int month, int day, int hour, int minute, int second) {
+    return comun::claveTiempo(month, day, hour, minute, second);
 }
 
 /*
@@ -272,18 +276,43 @@ Node* upperBoundIP(Node* start, unsigned long long key) {
     return ptr;
 }
 
-/* ---------------- 3. FUNCIÓN PRINCIPAL (main) ---------------- */
-int main() {
+/*
+ * 2.11 entryRecord / writeEntry
+ * Puente entre el entry de la lista y formato.h: entryRecord da los
+ * campos a esCanonica y a comun::escribirRegistro, que escribe originLine
+ * cuando existe. newline = false para el último nodo de SortedData.txt.
+ * Complejidad: O(L), L = longitud de la línea.
+ */
+comun::Registro entryRecord(const entry& E) {
+    return comun::registroDeCampos(E.totalTime, E.ip1, E.ip2, E.ip3, E.ip4, E.port);
+}
+
+void writeEntry(comun::SalidaLineas& out, const entry& E, bool newline = true) {
+    comun::escribirRegistro(out, entryRecord(E), E.reason, E.originLine, newline);
+}
+
+/* ---------------- 3. FUNCIÓN PRINCIPAL (main) ----------------
+ * Con --stats se imprime en stderr el tiempo y memoria de cada etapa (JSON);
+ * con --stats-hw también contadores de hardware (ciclos, fallos de caché);
+ * con --traza archivo.json, la línea de tiempo de las etapas (Chrome).
+ */
+int main(int argc, char* argv[]) {
+    comun::Estadisticas::global().habilitarSiSePide(argc, argv, "Act2.3");
     Node* head = nullptr;
     Node* tail = nullptr;
     // 3.1 Lectura del archivo bitácora y almacenamiento en la lista
-    ifstream theFile("bitacora.txt");
+    comun::EntradaBitacora theFile("bitacora.txt");
     if(!theFile.is_open()) {
         cerr << "Error: no se pudo abrir el archivo bitacora.txt\n";
         return 1;
     }
     string line;
+    size_t lineas = 0;
+    comun::Acumulador lectura("lectura"), parseo("parseo");
+    comun::EventoTraza carga("carga");   // todo el bucle, para la traza
+    comun::Marca marca;
     while(getline(theFile, line)) {
+        lectura.sumar(marca);
         entry E;
         size_t pos = 0;
         // Extraer tokens principales de la línea
@@ -301,7 +330,8 @@ int main() {
         E.totalTime = total_time(E.month, E.day, E.hour, E.min, E.sec);
         splitIp(ipPort, E.ip1, E.ip2, E.ip3, E.ip4, E.port);
         E.reason = reason;
-        E.originLine = line;
+        // la línea original solo se guarda si no se puede regenerar idéntica
+        if (!comun::esCanonica(entryRecord(E), E.reason, line)) E.originLine = line;
         // Insertar el nuevo registro al final de la lista ligada
         Node* newNode = new Node(E);
         if(head == nullptr) {
@@ -312,28 +342,44 @@ int main() {
             newNode->prev = tail;
             tail = newNode;
         }
+        lineas++;
+        parseo.sumar(marca);
     }
     theFile.close();
+    lectura.sumar(marca);   // el último getline (fin de archivo)
+    carga.terminar();
+    lectura.volcar();
+    parseo.volcar();
+    comun::Estadisticas::global().contar("lineas", lineas);
 
     // 3.2 Ordenamiento de la lista por IP (ascendente) usando Merge Sort
-    head = mergeSortList(head);
-    // Actualizar el apuntador 'tail' después del ordenamiento (mover al último nodo)
-    tail = head;
-    if(tail) {
-        while(tail->next) {
-            tail = tail->next;
+    {
+        comun::Temporizador t("orden");
+        head = mergeSortList(head);
+        // Actualizar el apuntador 'tail' después del ordenamiento (mover al último nodo)
+        tail = head;
+        if(tail) {
+            while(tail->next) {
+                tail = tail->next;
+            }
         }
     }
 
     // 3.3 Guardar la lista ordenada completa en el archivo "SortedData.txt"
-    ofstream outFile("SortedData.txt");
-    Node* it = head;
-    while(it) {
-        outFile << it->data.originLine;
-        if(it->next) outFile << "\n";  // agregar newline si no es el último
-        it = it->next;
+    {
+        comun::Temporizador t("escritura");
+        ofstream outFile("SortedData.txt");
+        {
+            comun::SalidaLineas out(outFile);
+            Node* it = head;
+            while(it) {
+                writeEntry(out, it->data, it->next != nullptr);  // agregar newline si no es el último
+                it = it->next;
+            }
+        }
+        outFile.close();
     }
-    outFile.close();
+    comun::Temporizador consulta("consulta");
 
     // 3.4 Lectura de rango de IPs desde entrada estándar
     string startIP, endIP;
@@ -372,8 +418,9 @@ int main() {
     }
     // Comenzar desde endNode y moverse hacia atrás hasta startNode
     Node* cur = endNode;
+    comun::SalidaLineas out(cout);
     while(cur) {
-        cout << cur->data.originLine << "\n";
+        writeEntry(out, cur->data);
         if(cur == startNode) break;
         cur = cur->prev;
     }
@@ -3,6 +3,10 @@
     por dirección IP, cuenta la frecuencia de accesos de cada IP y despliega las 5 IPs con
     mayor cantidad de accesos en orden descendente, mostrando toda su información en el
     formato original del archivo bitacora.txt.
+    Con --mem=4G (o 512M, ...) el programa no pasa de ese presupuesto: si los
+    registros agrupados ya no caben, termina de contar accesos por IP en una
+    tabla que se derrama a disco y vuelve a leer la bitácora guardando solo
+    los registros de las 5 IPs ganadoras (la salida es la misma).
 
     [Ayleen Osnaya Ortega] - [A01426008]
     [José Luis Gutiérrez Quintero] - [A01739337]
@@ -16,6 +20,11 @@
 #include <vector>
 #include <map>
 #include <algorithm>
+
+#include "../A01739942_Comun/estadisticas.h"
+#include "../A01739942_Comun/formato.h"
+#include "../A01739942_Comun/presupuesto.h"
+#include "../A01739942_Comun/tuberia.h"
 using namespace std;
 
 /* ---------------- 1. ESTRUCTURA PRINCIPAL ----------------
@@ -25,11 +34,11 @@ using namespace std;
  */
 struct entry {
     int month, day, hour, min, sec;    // Fecha y hora desglosada
-    long long totalTime;              // Clave numérica de fecha/hora para comparar fácilmente
+    uint32_t totalTime;               // Clave de fecha/hora: segundos desde el año base (32 bits)
     int ip1, ip2, ip3, ip4;           // Octetos de la IP
     int port;                        // Puerto de la conexión
     string reason;                   // Mensaje de error o descripción
-    string originLine;               // Línea original completa (útil para imprimir exactamente igual)
+    string originLine;               // Línea original, solo si no se puede regenerar igual (4.9)
 };
 
 /* ---------------- 2. ESTRUCTURA PARA CLAVE DE IP ----------------
@@ -57,10 +66,14 @@ struct IPKey {
  * - La clave de la IP (ip1, ip2, ip3, ip4)
  * - Vector con todas las entradas (registros de acceso) de esa IP
  * - Contador de cuántos accesos tiene esa IP
+ * Los vectores y el map cargan su memoria al presupuesto global (--mem).
  */
+typedef vector<entry, comun::AsignadorContado<entry>> Entries;
+typedef map<IPKey, Entries, less<IPKey>, comun::AsignadorContado<pair<const IPKey, Entries>>> IPMap;
+
 struct IPData {
     IPKey key;
-    vector<entry> entries;  // Todas las entradas de esta IP
+    Entries entries;        // Todas las entradas de esta IP
     int count;             // Número total de accesos de esta IP
 };
 
@@ -137,12 +150,13 @@ void splitIp(const string &ipPort, int &a, int &b, int &c, int &d, int &p) {
 
 /*
  * 4.4 total_time
- * Calcula una clave numérica a partir de una fecha y hora desglosada.
- * Sirve para comparar rápidamente dos fechas/horas.
+ * Clave numérica de una fecha y hora desglosada para comparar rápidamente
+ * dos fechas/horas: segundos desde el año base en 32 bits, con meses de 31
+ * días como supone el enunciado (comun::claveTiempo).
  * Complejidad: O(1).
  */
-long long total_time(int month, int day, int hour, int minute, int second) {
-    return (((((long long)month * 31 + day) * 24 + hour) * 60 + minute) * 60 + second);
+uint32_t total_time(int month, int day, int hour, int minute, int second) {
+    return comun::claveTiempo(month, day, hour, minute, second);
 }
 
 /*
@@ -159,8 +173,155 @@ bool lessEntry(const entry &a, const entry &b) {
     return a.reason < b.reason;
 }
 
-/* ---------------- 5. FUNCIÓN PRINCIPAL (main) ---------------- */
-int main() {
+/*
+ * 4.6 moreAccesses
+ * Orden del top: mayor cantidad de accesos primero y, en caso de empate,
+ * la IP con mayor valor numérico primero.
+ * Complejidad: O(1).
+ */
+bool moreAccesses(int countA, const IPKey& a, int countB, const IPKey& b) {
+    if(countA != countB) return countA > countB;
+    if(a.ip1 != b.ip1) return a.ip1 > b.ip1;
+    if(a.ip2 != b.ip2) return a.ip2 > b.ip2;
+    if(a.ip3 != b.ip3) return a.ip3 > b.ip3;
+    return a.ip4 > b.ip4;
+}
+
+/*
+ * 4.7 packKey / unpackKey
+ * IPKey como un entero de 32 bits (llave de la tabla de conteo que se
+ * derrama a disco) y de regreso.
+ * Complejidad: O(1).
+ */
+uint32_t packKey(const IPKey& k) {
+    return ((uint32_t)k.ip1 << 24) | ((uint32_t)k.ip2 << 16) | ((uint32_t)k.ip3 << 8) | (uint32_t)k.ip4;
+}
+
+IPKey unpackKey(uint32_t v) {
+    return {(int)(v >> 24), (int)((v >> 16) & 255), (int)((v >> 8) & 255), (int)(v & 255)};
+}
+
+/*
+ * 4.8 textBytes
+ * Bytes de texto de un registro (los strings no pasan por el asignador del
+ * vector, así que se cargan al presupuesto a mano).
+ * Complejidad: O(1).
+ */
+size_t textBytes(const entry& E) {
+    return E.reason.capacity() + E.originLine.capacity();
+}
+
+/*
+ * 4.9 entryRecord / writeEntry
+ * Los entry del árbol se escriben con comun::escribirRegistro
+ * (formato.h), con originLine si la línea no era canónica.
+ * Complejidad: O(L), L = longitud de la línea.
+ */
+comun::Registro entryRecord(const entry& E) {
+    return comun::registroDeCampos(E.totalTime, E.ip1, E.ip2, E.ip3, E.ip4, E.port);
+}
+
+void writeEntry(comun::SalidaLineas& out, const entry& E) {
+    comun::escribirRegistro(out, entryRecord(E), E.reason, E.originLine);
+}
+
+/*
+ * 4.10 parseEntry
+ * Llena 'E' con los campos de la línea [ini, fin).
+ * Complejidad: O(L), L = longitud de la línea.
+ */
+bool parseEntry(const char* ini, const char* fin, entry& E) {
+    string line(ini, fin);
+    size_t pos = 0;
+    
+    // Extraer tokens principales de la línea
+    string month_str = tokenizer(line, pos);
+    string day_str   = tokenizer(line, pos);
+    string time_str  = tokenizer(line, pos);
+    string ipPort    = tokenizer(line, pos);
+    string reason    = line.substr(pos);
+    
+    // Llenar los campos de la estructura entry
+    E.month  = months_int(month_str);
+    E.day    = stoi(day_str);
+    E.hour   = stoi(time_str.substr(0, 2));
+    E.min    = stoi(time_str.substr(3, 2));
+    E.sec    = stoi(time_str.substr(6, 2));
+    E.totalTime = total_time(E.month, E.day, E.hour, E.min, E.sec);
+    
+    splitIp(ipPort, E.ip1, E.ip2, E.ip3, E.ip4, E.port);
+    E.reason = reason;
+    if (!comun::esCanonica(entryRecord(E), E.reason, line)) E.originLine = line;
+    return true;
+}
+
+/*
+ * 4.11 printTopSpilled
+ * Modo de derrame (--mem): los registros no cupieron en el presupuesto, así
+ * que solo se tienen los accesos por IP (en una tabla que a su vez se
+ * derrama a disco si no cabe). Se eligen las 5 IPs del top con el mismo
+ * criterio de 5.3 y se vuelve a leer la bitácora guardando únicamente sus
+ * registros, que se ordenan con lessEntry y se imprimen como en 5.4.
+ * Complejidad: O(n) por cada una de las dos lecturas + O(m) para elegir el
+ * top + O(k log k) para ordenar los k registros que se imprimen.
+ */
+int printTopSpilled(comun::ConteoParticionado<uint32_t>& counts) {
+    comun::Temporizador orden("orden");
+    vector<pair<int, IPKey>> top;   // a lo más 5, ya en orden del top
+    size_t distinct = 0;
+    bool ok = counts.recorrer([&](uint32_t ip, uint64_t n) {
+        distinct++;
+        pair<int, IPKey> c = {(int)n, unpackKey(ip)};
+        size_t pos = 0;
+        while (pos < top.size() && moreAccesses(top[pos].first, top[pos].second, c.first, c.second)) pos++;
+        if (pos < 5) {
+            top.insert(top.begin() + pos, c);
+            if (top.size() > 5) top.pop_back();
+        }
+    });
+    if (!ok) {
+        cerr << "Error: no se pudo usar el archivo temporal de derrame\n";
+        return 1;
+    }
+    comun::Estadisticas::global().contar("ips_distintas", distinct);
+    orden.detener();
+
+    vector<Entries> chosen(top.size());
+    comun::Temporizador relectura("relectura");
+    comun::ResultadoIngesta res = comun::ingestarArchivo<entry>(
+        "bitacora.txt",
+        parseEntry,
+        [&](entry& E) {
+            IPKey key = {E.ip1, E.ip2, E.ip3, E.ip4};
+            for (size_t i = 0; i < top.size(); i++) {
+                if (!(key < top[i].second) && !(top[i].second < key)) {
+                    chosen[i].push_back(move(E));
+                    break;
+                }
+            }
+        });
+    if (!res.ok) return 1;
+    relectura.detener();
+
+    comun::Temporizador consulta("consulta");
+    comun::SalidaLineas out(cout);
+    for (Entries& entries : chosen) {
+        sort(entries.begin(), entries.end(), lessEntry);
+        for (const auto& e : entries) writeEntry(out, e);
+    }
+    return 0;
+}
+
+/* ---------------- 5. FUNCIÓN PRINCIPAL (main) ----------------
+ * Con --stats se imprime en stderr el tiempo y memoria de cada etapa (JSON);
+ * con --stats-hw también contadores de hardware (ciclos, fallos de caché);
+ * con --traza archivo.json, la línea de tiempo de las etapas (Chrome);
+ * con --mem=4G, el presupuesto de memoria (ver 4.11).
+ */
+int main(int argc, char* argv[]) {
+    comun::Estadisticas::global().habilitarSiSePide(argc, argv, "Act3.4");
+    comun::Presupuesto& budget = comun::Presupuesto::global();
+    if (!budget.habilitarSiSePide(argc, argv)) return 1;
     /*
      * 5.1 Lectura del archivo bitácora y agrupación por IP
      * Utiliza un map<IPKey, vector<entry>> para agrupar todos los registros de cada IP.
@@ -169,43 +330,46 @@ int main() {
      * Complejidad: O(n log m) donde n = número de líneas del archivo, m = número de IPs únicas.
      * El factor log m viene de las inserciones en el map (árbol rojo-negro).
      */
-    map<IPKey, vector<entry>> ipMap;
+    IPMap ipMap;
     
-    ifstream theFile("bitacora.txt");
-    if(!theFile.is_open()) {
-        cerr << "Error: no se pudo abrir el archivo bitacora.txt\n";
-        return 1;
-    }
-    
-    string line;
-    while(getline(theFile, line)) {
-        entry E;
-        size_t pos = 0;
-        
-        // Extraer tokens principales de la línea
-        string month_str = tokenizer(line, pos);
-        string day_str   = tokenizer(line, pos);
-        string time_str  = tokenizer(line, pos);
-        string ipPort    = tokenizer(line, pos);
-        string reason    = line.substr(pos);
-        
-        // Llenar los campos de la estructura entry
-        E.month  = months_int(month_str);
-        E.day    = stoi(day_str);
-        E.hour   = stoi(time_str.substr(0, 2));
-        E.min    = stoi(time_str.substr(3, 2));
-        E.sec    = stoi(time_str.substr(6, 2));
-        E.totalTime = total_time(E.month, E.day, E.hour, E.min, E.sec);
-        
-        splitIp(ipPort, E.ip1, E.ip2, E.ip3, E.ip4, E.port);
-        E.reason = reason;
-        E.originLine = line;
-        
-        // Agrupar por IP (sin considerar puerto como parte de la clave)
-        IPKey key = {E.ip1, E.ip2, E.ip3, E.ip4};
-        ipMap[key].push_back(E);
-    }
-    theFile.close();
+    /*
+     * La lectura y el parseo corren en otros hilos (comun::ingestarArchivo):
+     * un hilo lee el archivo por bloques, varios parsean las líneas y este
+     * hilo recibe cada entry en el orden del archivo y la inserta en el map.
+     * Si el presupuesto se excede, el map se vuelca a la tabla de conteo
+     * (4.11) y el resto del archivo solo se cuenta.
+     */
+    size_t lineas = 0, textoCargado = 0;
+    bool spilling = false;
+    comun::ConteoParticionado<uint32_t> counts;
+    comun::Temporizador ingesta("ingesta");
+    comun::ResultadoIngesta res = comun::ingestarArchivo<entry>(
+        "bitacora.txt",
+        parseEntry,
+        [&](entry& E) {
+            // Agrupar por IP (sin considerar puerto como parte de la clave)
+            IPKey key = {E.ip1, E.ip2, E.ip3, E.ip4};
+            lineas++;
+            if (spilling) {
+                counts.sumar(packKey(key));
+                return;
+            }
+            textoCargado += textBytes(E);
+            budget.cargar(textBytes(E));
+            ipMap[key].push_back(move(E));
+            if (budget.excedido()) {
+                spilling = true;
+                for (auto& pair : ipMap) counts.sumar(packKey(pair.first), pair.second.size());
+                IPMap().swap(ipMap);
+                budget.descargar(textoCargado);
+            }
+        });
+    if (!res.ok) return 1;
+    ingesta.detener();
+    comun::Estadisticas::global().contar("lineas", lineas);
+    if (spilling) return printTopSpilled(counts);
+    comun::Estadisticas::global().contar("ips_distintas", ipMap.size());
+    comun::Temporizador orden("orden");
 
     /*
      * 5.2 Creación de vector de IPData y ordenamiento interno por fecha/hora
@@ -219,13 +383,13 @@ int main() {
     for(auto& pair : ipMap) {
         IPData data;
         data.key = pair.first;
-        data.entries = pair.second;
         data.count = pair.second.size();
+        data.entries = move(pair.second);   // se mueve: no hace falta otra copia de los registros
         
         // Ordenar las entradas de esta IP por fecha/hora (criterio de desempate de la especificación)
         sort(data.entries.begin(), data.entries.end(), lessEntry);
         
-        ipDataList.push_back(data);
+        ipDataList.push_back(move(data));
     }
     
     /*
@@ -236,15 +400,11 @@ int main() {
      */
     sort(ipDataList.begin(), ipDataList.end(), 
          [](const IPData& a, const IPData& b) {
-             // Criterio principal: mayor cantidad de accesos primero
-             if(a.count != b.count) return a.count > b.count;
-             // Desempate: IP con mayor valor numérico primero
-             if(a.key.ip1 != b.key.ip1) return a.key.ip1 > b.key.ip1;
-             if(a.key.ip2 != b.key.ip2) return a.key.ip2 > b.key.ip2;
-             if(a.key.ip3 != b.key.ip3) return a.key.ip3 > b.key.ip3;
-             return a.key.ip4 > b.key.ip4;
+             return moreAccesses(a.count, a.key, b.count, b.key);
          });
     
+    orden.detener();
+    comun::Temporizador consulta("consulta");
     /*
      * 5.4 Despliegue de las 5 IPs con más accesos
      * Imprime todas las líneas originales de las 5 IPs que tienen mayor cantidad de accesos.
@@ -252,10 +412,11 @@ int main() {
      * Complejidad: O(k) donde k = suma de accesos de las top 5 IPs (en el peor caso, O(n)).
      */
     int limit = min(5, (int)ipDataList.size());
+    comun::SalidaLineas out(cout);
     for(int i = 0; i < limit; i++) {
         // Imprimir todas las líneas de esta IP en formato original
         for(const auto& e : ipDataList[i].entries) {
-            cout << e.originLine << "\n";
+            writeEntry(out, e);
         }
     }
 
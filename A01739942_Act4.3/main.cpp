@@ -31,6 +31,10 @@
 #include <sstream>
 #include <string>
 
+#include "../A01739942_Comun/estadisticas.h"
+#include "../A01739942_Comun/gzip.h"
+#include "../A01739942_Comun/paginas.h"
+
 using namespace std;
 
 // -----------------------------------------------------------------------------
@@ -280,7 +284,20 @@ int getHostIndex(const string& ip, bool& isNew) {
 // 4. Función principal (main)
 // -----------------------------------------------------------------------------
 
-int main() {
+/*
+ * Con --stats se imprime en stderr el tiempo y memoria de cada etapa (JSON);
+ * con --stats-hw también contadores de hardware (ciclos, fallos de caché);
+ * con --traza archivo.json, la línea de tiempo de las etapas (Chrome).
+ */
+int main(int argc, char* argv[]) {
+    comun::Estadisticas::global().habilitarSiSePide(argc, argv, "Act4.3");
+    comun::Temporizador inicio("inicio");
+
+    // Las dos tablas (~100 MB) se acceden al azar: en páginas de 2 MiB la
+    // TLB las cubre completas (si el sistema no puede, no pasa nada)
+    comun::sugerirPaginasGrandes(hostTable, sizeof(hostTable), true);
+    comun::sugerirPaginasGrandes(networkTable, sizeof(networkTable), true);
+
     // 4.1 Inicialización de tablas hash
     /*
      * Se marcan todas las posiciones como "no usadas" y se inicializan
@@ -305,7 +322,7 @@ int main() {
      * Se abre el archivo "bitacora.txt" en modo lectura.
      * El nombre está fijo, como lo indican las instrucciones de la actividad.
      */
-    ifstream file("bitacora.txt");
+    comun::EntradaBitacora file("bitacora.txt");
     if (!file.is_open()) {
         cerr << "No se pudo abrir bitacora.txt\n";
         return 1;
@@ -328,8 +345,14 @@ int main() {
      *  - Cada getHostIndex / getNetworkIndex es O(1) amortizado.
      *  - Complejidad total del bucle: O(N * L) ~ O(N).
      */
+    inicio.detener();
     string line;
+    size_t lineas = 0;
+    comun::Acumulador lectura("lectura"), parseo("parseo"), indice("indice");
+    comun::EventoTraza carga("carga");   // todo el bucle, para la traza
+    comun::Marca marca;
     while (getline(file, line)) {
+        lectura.sumar(marca);
         if (line.empty()) {
             continue; // línea vacía, se omite
         }
@@ -370,6 +393,7 @@ int main() {
 
         // 4.3.2 Obtener prefijo de red (dos primeros octetos)
         string prefix = prefixFromIP(ip);
+        parseo.sumar(marca);
 
         // 4.3.3 Insertar / obtener host en tabla hash
         bool isNewHost;
@@ -412,9 +436,18 @@ int main() {
         e.port = port;
         e.message = message;
         h.entryCount++;
+        lineas++;
+        indice.sumar(marca);
     }
 
     file.close();
+    lectura.sumar(marca);   // el último getline (fin de archivo)
+    carga.terminar();
+    lectura.volcar();
+    parseo.volcar();
+    indice.volcar();
+    comun::Estadisticas::global().contar("lineas", lineas);
+    comun::Temporizador consulta("consulta");
 
     // -------------------------------------------------------------------------
     // 4.4 Cálculo de redes con mayor número de hosts únicos
@@ -482,6 +515,8 @@ int main() {
     // -------------------------------------------------------------------------
     // 4.6 Liberación de memoria dinámica
     // -------------------------------------------------------------------------
+    consulta.detener();
+    comun::Temporizador liberacion("liberacion");
 
     /*
      * Se libera la memoria del arreglo dinámico entries de cada host usado.
@@ -31,6 +31,10 @@
 #include <sstream>
 #include <string>
 
+#include "../A01739942_Comun/estadisticas.h"
+#include "../A01739942_Comun/gzip.h"
+#include "../A01739942_Comun/paginas.h"
+
 using namespace std;
 
 // -----------------------------------------------------------------------------
@@ -495,7 +499,19 @@ void freeIPList(IPNode* head) {
 // 4. Función principal (main)
 // -----------------------------------------------------------------------------
 
-int main() {
+/*
+ * Con --stats se imprime en stderr el tiempo y memoria de cada etapa (JSON);
+ * con --stats-hw también contadores de hardware (ciclos, fallos de caché);
+ * con --traza archivo.json, la línea de tiempo de las etapas (Chrome).
+ */
+int main(int argc, char* argv[]) {
+    comun::Estadisticas::global().habilitarSiSePide(argc, argv, "Act5.2");
+    comun::Temporizador inicio("inicio");
+
+    // La tabla se accede al azar: en páginas de 2 MiB la TLB la cubre
+    // completa (si el sistema no puede, no pasa nada)
+    comun::sugerirPaginasGrandes(hashTable, sizeof(hashTable), true);
+
     // 4.1 Inicialización de la tabla hash
     /*
      * Se marcan todas las posiciones como no ocupadas.
@@ -516,7 +532,7 @@ int main() {
      * Se abre el archivo "bitacora.txt" en modo lectura.
      * El nombre está fijo según las instrucciones de la actividad.
      */
-    ifstream file("bitacora.txt");
+    comun::EntradaBitacora file("bitacora.txt");
     
     if (!file.is_open()) {
         cerr << "Error: No se pudo abrir el archivo bitacora.txt" << endl;
@@ -537,8 +553,14 @@ int main() {
      *  - Cada insertOrUpdate es O(1) amortizado
      *  - Complejidad total: O(N)
      */
+    inicio.detener();
     string line;
+    size_t lineas = 0;
+    comun::Acumulador lectura("lectura"), parseo("parseo"), indice("indice");
+    comun::EventoTraza carga("carga");   // todo el bucle, para la traza
+    comun::Marca marca;
     while (getline(file, line)) {
+        lectura.sumar(marca);
         if (line.empty()) {
             continue; // Línea vacía, se omite
         }
@@ -557,6 +579,7 @@ int main() {
         
         // Extraer identificador de red
         string network = extractNetwork(ip);
+        parseo.sumar(marca);
         
         if (!network.empty()) {
             if (!insertOrUpdate(network, ip)) {
@@ -573,9 +596,18 @@ int main() {
                 return 1;
             }
         }
+        lineas++;
+        indice.sumar(marca);
     }
     
     file.close();
+    lectura.sumar(marca);   // el último getline (fin de archivo)
+    carga.terminar();
+    lectura.volcar();
+    parseo.volcar();
+    indice.volcar();
+    comun::Estadisticas::global().contar("lineas", lineas);
+    comun::Temporizador consulta("consulta");
     
     // 4.4 Procesamiento de consultas
     /*
@@ -625,6 +657,9 @@ int main() {
             cout << endl;
         }
     }
+    consulta.detener();
+    comun::Estadisticas::global().contar("consultas", n > 0 ? n : 0);
+    comun::Temporizador liberacion("liberacion");
     
     // 4.5 Liberación de memoria dinámica
     /*
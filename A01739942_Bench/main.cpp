@@ -0,0 +1,1767 @@
+/*
+    Descripción: Benchmarks de los componentes compartidos (A01739942_Comun).
+    Cada subcomando mide un grupo de operaciones y reporta su rendimiento.
+
+    Subcomandos:
+        filtros    Throughput (GB/s) de los kernels de filtrado por columna
+                   en sus versiones escalar, SSE2 y AVX2; verifica que den
+                   lo mismo y los rangos de puerto pasados de 65535.
+        ipfiltro   Bloom bloqueado vs binary fuse vs búsqueda binaria: bits
+                   por IP, tiempo de construcción, ns por consulta y tasa de
+                   falsos positivos.
+        estructuras  Las estructuras de las cinco actividades (vector,
+                   lista, map, hash con cadenas) contra sus sucesores
+                   columnares: construir, búsqueda puntual, rango de
+                   fechas, grupos por red y top-10, con tiempo, memoria y
+                   contadores de hardware (-c), a 1M, 10M y 100M registros.
+        lectura    ifstream vs pread vs io_uring sobre -f, en frío y en
+                   caliente, solo lectura y lectura + parseo.
+        columnar   Bytes por registro en texto, en columnas y comprimido por
+                   bloques; parsear el texto contra descomprimir por nivel
+                   SIMD y leer solo los bloques de un día.
+        paginas    Sondeos en tabla hash y ordenamiento indirecto con páginas
+                   normales, THP y hugetlb: tiempo y fallos de dTLB (-c).
+        formato    Reescribir las líneas: ofstream << originLine contra
+                   snprintf y contra las tablas de formato.h, en líneas/s;
+                   verifica que los bytes sean idénticos.
+        detector   Detector de fuerza bruta en flujo (detector.h) contra
+                   unordered_map<ip, deque> sobre fallos en orden de tiempo,
+                   en millones de eventos/s y bytes de estado.
+
+    Uso:
+        ./bench <subcomando> [-n registros] [-r repeticiones] [-f bitacora.txt] [-c]
+                [--paginas normales|thp|hugetlb]
+    -n acepta sufijos K/M y una lista separada por comas (-n 1M,10M); los
+    subcomandos que no recorren tamaños usan el primero.
+    Con -f se usan las columnas de la bitácora real; si no, datos sintéticos
+    con la misma distribución (IPs y puertos uniformes, 7 razones).
+    Con -c cada renglón agrega contadores de hardware por operación (IPC,
+    fallos de L1d, LLC, saltos y dTLB) de la mejor repetición, si el sistema
+    los permite (perf_event_open).
+    --paginas fija la forma de las páginas de las estructuras grandes de los
+    demás subcomandos (por omisión thp; ver paginas.h).
+
+    Línea base y regresiones (ver sección 10):
+        --guardar-base [archivo]   guarda mediana y MAD de cada medición
+        --comparar [archivo]       compara contra la base guardada, imprime
+                                   la tabla de diferencias y sale con código
+                                   2 si alguna medición empeoró
+        --umbral pct               tolerancia de la comparación (def. 10)
+    El archivo por omisión es bench_base_<máquina>.json, así cada máquina
+    tiene su propia base.
+
+    Compilación: g++ -O2 -std=c++17 main.cpp -o bench
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <malloc.h>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unistd.h>
+#include <vector>
+
+#include "../A01739942_Comun/columnar.h"
+#include "../A01739942_Comun/contadores_hw.h"
+#include "../A01739942_Comun/detector.h"
+#include "../A01739942_Comun/filtro_ip.h"
+#include "../A01739942_Comun/filtros_simd.h"
+#include "../A01739942_Comun/formato.h"
+#include "../A01739942_Comun/gzip.h"
+#include "../A01739942_Comun/lector_asincrono.h"
+#include "../A01739942_Comun/paginas.h"
+#include "../A01739942_Comun/registro.h"
+
+using namespace std;
+using namespace comun;
+
+// ---------------- 1. PARÁMETROS Y UTILIDADES ----------------
+
+/*
+ * 1.1 Opciones
+ * Parámetros comunes a todos los subcomandos.
+ */
+struct Opciones {
+    size_t registros = 16u << 20;   // 16M renglones sintéticos
+    vector<size_t> tamanos;         // todos los de -n (vacío = no se dio)
+    int repeticiones = 5;
+    string archivo;                 // vacío = datos sintéticos
+    bool contadores = false;        // -c: contadores de hardware
+    string guardarBase;             // --guardar-base
+    string compararBase;            // --comparar
+    double umbral = 10.0;           // --umbral, en %
+};
+
+/*
+ * Tiempos de cada medición con nombre, para la línea base (sección 10).
+ */
+struct Resultado {
+    string nombre;
+    vector<double> tiempos;     // segundos, una entrada por repetición
+};
+vector<Resultado> resultados;
+
+/*
+ * 1.2 medir
+ * Ejecuta fn 'repeticiones' veces y devuelve el mejor tiempo en segundos.
+ * El mejor tiempo es el menos afectado por ruido del sistema. Si los
+ * contadores de hardware están abiertos, deja en hwMejor las diferencias de
+ * esa misma repetición. Con 'nombre' se guardan todos los tiempos en
+ * 'resultados' para la línea base. 'preparar' corre antes de cada
+ * repetición sin contar en el tiempo (p.ej. vaciar la caché de páginas).
+ */
+uint64_t hwMejor[HW_EVENTOS];
+
+double medir(int repeticiones, const function<void()>& fn, const string& nombre = "",
+             const function<void()>& preparar = nullptr) {
+    const ContadoresHw& hw = ContadoresHw::global();
+    double mejor = 1e30;
+    uint64_t antes[HW_EVENTOS], despues[HW_EVENTOS];
+    if (!nombre.empty()) resultados.push_back({nombre, {}});
+    for (int r = 0; r < repeticiones; r++) {
+        if (preparar) preparar();
+        hw.leer(antes);
+        auto ini = chrono::steady_clock::now();
+        fn();
+        auto fin = chrono::steady_clock::now();
+        hw.leer(despues);
+        double s = chrono::duration<double>(fin - ini).count();
+        if (!nombre.empty()) resultados.back().tiempos.push_back(s);
+        if (s < mejor) {
+            mejor = s;
+            for (int k = 0; k < HW_EVENTOS; k++) hwMejor[k] = despues[k] - antes[k];
+        }
+    }
+    return mejor;
+}
+
+/*
+ * 1.3 columnasHw
+ * Columnas extra con los contadores de la última medición divididos entre
+ * 'operaciones' (valores, consultas...). Vacío si no se pidió -c o no hay
+ * contadores; "-" en los eventos que el CPU no soporta.
+ */
+string encabezadoHw() {
+    if (!ContadoresHw::global().disponible()) return "";
+    ostringstream out;
+    out << setw(8) << "IPC" << setw(10) << "L1d/op" << setw(10) << "LLC/op" << setw(10) << "rama/op"
+        << setw(10) << "dTLB/op";
+    return out.str();
+}
+
+string columnasHw(double operaciones) {
+    const ContadoresHw& hw = ContadoresHw::global();
+    if (!hw.disponible()) return "";
+    ostringstream out;
+    out << fixed << setprecision(2);
+    if (hw.disponible(HW_CICLOS) && hw.disponible(HW_INSTRUCCIONES) && hwMejor[HW_CICLOS] > 0)
+        out << setw(8) << (double)hwMejor[HW_INSTRUCCIONES] / (double)hwMejor[HW_CICLOS];
+    else
+        out << setw(8) << "-";
+    out << setprecision(4);
+    for (int k : {HW_FALLOS_L1D, HW_FALLOS_LLC, HW_FALLOS_RAMA, HW_FALLOS_DTLB}) {
+        if (hw.disponible(k)) out << setw(10) << (double)hwMejor[k] / operaciones;
+        else out << setw(10) << "-";
+    }
+    return out.str();
+}
+
+/*
+ * 1.4 leerTamanos / leerEntero / leerReal
+ * Valores de las opciones: "1M,10M,500K" -> {1000000, 10000000, 500000};
+ * un entero >= minimo; un real >= 0. Devuelven false si el texto no es
+ * exactamente eso (vacío, letras de más, negativo), para reportar el uso
+ * en lugar de abortar.
+ */
+bool leerTamanos(const string& texto, vector<size_t>& r) {
+    r.clear();
+    stringstream in(texto);
+    string parte;
+    while (getline(in, parte, ',')) {
+        if (parte.empty() || !isdigit((unsigned char)parte[0])) return false;
+        char* fin = nullptr;
+        unsigned long long n = strtoull(parte.c_str(), &fin, 10), escala = 1;
+        if (*fin == 'K' || *fin == 'k') escala = 1000;
+        else if (*fin == 'M' || *fin == 'm') escala = 1000000;
+        if (escala > 1) fin++;
+        if (*fin != '\0' || n == 0 || n > (1ull << 40) / escala) return false;
+        n *= escala;
+        r.push_back((size_t)n);
+    }
+    return !r.empty();
+}
+
+bool leerEntero(const char* texto, long minimo, long& v) {
+    char* fin = nullptr;
+    v = strtol(texto, &fin, 10);
+    return fin != texto && *fin == '\0' && v >= minimo && v <= 1000000;
+}
+
+bool leerReal(const char* texto, double& v) {
+    char* fin = nullptr;
+    v = strtod(texto, &fin);
+    return fin != texto && *fin == '\0' && isfinite(v) && v >= 0;
+}
+
+/*
+ * 1.5 tablaSintetica
+ * Genera n registros con la distribución de bitacora.txt: tiempo uniforme en
+ * el año, IP uniforme, puerto 1000-9999 y 7 razones. Semilla fija para que
+ * las corridas sean comparables.
+ */
+void tablaSintetica(size_t n, TablaRegistros& t) {
+    static const char* razones[7] = {"Failed password for admin", "Failed password for illegal user guest",
+                                     "Failed password for root", "Illegal user", "Login timeout",
+                                     "No response from server", "Too many login attempts"};
+    for (const char* r : razones) t.razones.idDe(r);
+    mt19937_64 gen(12345);
+    t.reservar(n);
+    for (size_t i = 0; i < n; i++) {
+        uint64_t x = gen();
+        Registro r;
+        r.tiempo = claveTiempo(1 + (int)(x % 12), 1 + (int)((x >> 4) % 31), (int)((x >> 9) % 24),
+                               (int)((x >> 14) % 60), (int)((x >> 20) % 60));
+        r.ip = (uint32_t)(x >> 32);
+        r.puerto = (uint16_t)(1000 + (x >> 26) % 9000);
+        r.razon = (uint8_t)((x >> 40) % 7);
+        t.agregar(r);
+    }
+}
+
+/*
+ * 1.6 cargarDatos
+ * Llena la tabla desde la bitácora (-f) o con datos sintéticos.
+ */
+bool cargarDatos(const Opciones& op, TablaRegistros& t) {
+    if (!op.archivo.empty()) return cargarBitacora(op.archivo, t);
+    tablaSintetica(op.registros, t);
+    return true;
+}
+
+// ---------------- 2. SUBCOMANDO: filtros ----------------
+
+/*
+ * 2.1 verificarBordesPuerto
+ * Rangos de puerto como los que arma consultas para "port > 70000",
+ * "port between 100 and 70000" o "port >= 65535", sobre una columna con
+ * los valores de las orillas (0 y 65535 incluidos), en cada nivel SIMD.
+ * Un rango que empieza después de 65535 no debe seleccionar nada. Devuelve
+ * cuántos casos no dieron la selección esperada.
+ */
+int verificarBordesPuerto() {
+    vector<uint16_t> col;
+    for (int k = 0; k < 3; k++)         // más de 64 valores: pasa por el ciclo SIMD
+        for (uint16_t v : {0, 1, 80, 100, 1000, 32767, 32768, 65534, 65535}) col.insert(col.end(), 8, v);
+    struct Caso {
+        uint32_t lo, hi;
+    };
+    const Caso casos[] = {{70000, 80000}, {65536, UINT32_MAX}, {65535, 70000}, {100, 70000},
+                          {0, UINT32_MAX},  {65535, 65535},      {32768, 65534}};
+    size_t palabras = palabrasPara(col.size());
+    vector<uint64_t> bits(palabras);
+    NivelSimd maximo = nivelDetectado();
+    int errores = 0;
+    for (const Caso& c : casos) {
+        size_t esperado = 0;
+        for (uint16_t v : col) esperado += v >= c.lo && v <= c.hi;
+        for (int nivel = SIMD_ESCALAR; nivel <= maximo; nivel++) {
+            fijarNivelSimd((NivelSimd)nivel);
+            filtroRango(col.data(), col.size(), c.lo, c.hi, bits.data());
+            size_t obtenido = bitsContar(bits.data(), palabras);
+            if (obtenido == esperado) continue;
+            cerr << "puerto [" << c.lo << ", " << c.hi << "] " << nombreNivel((NivelSimd)nivel) << ": " << obtenido
+                 << " renglones, se esperaban " << esperado << "\n";
+            errores++;
+        }
+    }
+    fijarNivelSimd(maximo);
+    return errores;
+}
+
+/*
+ * 2.2 benchFiltros
+ * Para cada kernel (rango de tiempo, máscara CIDR, rango de puerto, igualdad
+ * de razón) y cada nivel SIMD disponible mide GB/s de columna leída.
+ * También verifica que cada nivel produzca el mismo mapa de bits que la
+ * versión escalar y los rangos de puerto en el borde de 16 bits
+ * (verificarBordesPuerto).
+ */
+int benchFiltros(const Opciones& op) {
+    TablaRegistros t;
+    if (!cargarDatos(op, t)) return 1;
+    size_t n = t.size();
+    size_t palabras = palabrasPara(n);
+    vector<uint64_t> bits(palabras), referencia(palabras);
+
+    struct Kernel {
+        const char* nombre;
+        size_t bytesPorValor;
+        function<void(uint64_t*)> correr;
+    };
+    uint32_t marzo = claveTiempo(3, 1, 0, 0, 0), abril = claveTiempo(3, 31, 23, 59, 59);
+    vector<Kernel> kernels = {
+        {"tiempo rango",  4, [&](uint64_t* b) { filtroRango(t.tiempo.data(), n, marzo, abril, b); }},
+        {"ip /8",         4, [&](uint64_t* b) { filtroMascara(t.ip.data(), n, 0xFF000000u, 10u << 24, b); }},
+        {"ip rango",      4, [&](uint64_t* b) { filtroRango(t.ip.data(), n, 10u << 24, (13u << 24) - 1, b); }},
+        {"puerto rango",  2, [&](uint64_t* b) { filtroRango(t.puerto.data(), n, 1000, 2000, b); }},
+        {"razon igual",   1, [&](uint64_t* b) { filtroIgual(t.razon.data(), n, 2, b); }},
+    };
+
+    NivelSimd maximo = nivelDetectado();
+    cout << "registros: " << n << "   nivel máximo: " << nombreNivel(maximo) << "\n\n";
+    cout << left << setw(16) << "kernel" << setw(10) << "nivel" << right << setw(10) << "ms"
+         << setw(10) << "GB/s" << setw(14) << "seleccion" << encabezadoHw() << "\n";
+
+    int errores = 0;
+    for (const Kernel& k : kernels) {
+        fijarNivelSimd(SIMD_ESCALAR);
+        k.correr(referencia.data());
+        for (int nivel = SIMD_ESCALAR; nivel <= maximo; nivel++) {
+            fijarNivelSimd((NivelSimd)nivel);
+            double s = medir(op.repeticiones, [&] { k.correr(bits.data()); },
+                             string("filtros/") + k.nombre + "/" + nombreNivel((NivelSimd)nivel));
+            bool igual = equal(bits.begin(), bits.end(), referencia.begin());
+            if (!igual) errores++;
+            double gb = (double)(n * k.bytesPorValor) / 1e9;
+            cout << left << setw(16) << k.nombre << setw(10) << nombreNivel((NivelSimd)nivel) << right
+                 << fixed << setprecision(2) << setw(10) << s * 1e3 << setw(10) << gb / s
+                 << setw(14) << bitsContar(bits.data(), palabras) << columnasHw((double)n)
+                 << (igual ? "" : "  DIFERENTE") << "\n";
+        }
+    }
+    fijarNivelSimd(maximo);
+
+    // Combinación de dos mapas (AND) como en un filtro con dos condiciones
+    vector<uint64_t> otro(palabras);
+    filtroRango(t.puerto.data(), n, 1000, 2000, otro.data());
+    double s = medir(op.repeticiones, [&] { bitsAnd(bits.data(), otro.data(), palabras); }, "filtros/bits AND");
+    cout << left << setw(16) << "bits AND" << setw(10) << "-" << right << setw(10) << s * 1e3
+         << setw(10) << (double)(palabras * 16) / 1e9 / s << "\n";
+
+    if (errores > 0) {
+        cerr << "Error: " << errores << " kernels no coinciden con la versión escalar\n";
+        return 1;
+    }
+    int bordes = verificarBordesPuerto();
+    if (bordes > 0) {
+        cerr << "Error: " << bordes << " rangos de puerto en el borde de 16 bits dan otra selección\n";
+        return 1;
+    }
+    return 0;
+}
+
+// ---------------- 3. SUBCOMANDO: ipfiltro ----------------
+
+/*
+ * 3.1 benchFiltroIp
+ * Construye los dos filtros sobre las IPs de la tabla y mide consultas de
+ * IPs presentes (deben dar todas verdadero) y de IPs aleatorias ausentes
+ * (las que den verdadero son falsos positivos). La búsqueda binaria sobre
+ * el vector ordenado es la referencia exacta (32 bits por IP).
+ */
+int benchFiltroIp(const Opciones& op) {
+    TablaRegistros t;
+    if (!cargarDatos(op, t)) return 1;
+    vector<uint32_t> ips = t.ip;
+    sort(ips.begin(), ips.end());
+    ips.erase(unique(ips.begin(), ips.end()), ips.end());
+    size_t n = ips.size();
+
+    // Consultas: la mitad presentes (en orden aleatorio), la mitad ausentes
+    const size_t CONSULTAS = 1u << 20;
+    mt19937_64 gen(777);
+    vector<uint32_t> presentes(CONSULTAS), ausentes;
+    for (uint32_t& ip : presentes) ip = ips[gen() % n];
+    while (ausentes.size() < CONSULTAS) {
+        uint32_t ip = (uint32_t)gen();
+        if (!binary_search(ips.begin(), ips.end(), ip)) ausentes.push_back(ip);
+    }
+
+    FiltroBloomBloqueado bloom;
+    FiltroFusionBinaria fusion;
+    double sBloom = medir(1, [&] {
+        bloom = FiltroBloomBloqueado(n);
+        for (uint32_t ip : t.ip) bloom.agregar(ip);
+    });
+    bool construido = true;
+    double sFusion = medir(1, [&] { construido = fusion.construir(t.ip); });
+    if (!construido) return 1;
+
+    struct Estructura {
+        const char* nombre;
+        size_t bytes;
+        double construccion;
+        function<bool(uint32_t)> contiene;
+    };
+    vector<Estructura> estructuras = {
+        {"bloom", bloom.bytes(), sBloom, [&](uint32_t ip) { return bloom.contiene(ip); }},
+        {"fusion", fusion.bytes(), sFusion, [&](uint32_t ip) { return fusion.contiene(ip); }},
+        {"busqueda bin", n * 4, 0, [&](uint32_t ip) { return binary_search(ips.begin(), ips.end(), ip); }},
+    };
+
+    cout << "IPs distintas: " << n << "\n\n";
+    cout << left << setw(14) << "estructura" << right << setw(10) << "bits/IP" << setw(12) << "constr ms"
+         << setw(12) << "ns presente" << setw(12) << "ns ausente" << setw(10) << "FP %" << encabezadoHw() << "\n";
+    int errores = 0;
+    for (const Estructura& e : estructuras) {
+        size_t hallados = 0, falsos = 0;
+        double sP = medir(op.repeticiones, [&] {
+            hallados = 0;
+            for (uint32_t ip : presentes) hallados += e.contiene(ip);
+        }, string("ipfiltro/") + e.nombre + "/presente");
+        string hwPresentes = columnasHw((double)CONSULTAS);
+        double sA = medir(op.repeticiones, [&] {
+            falsos = 0;
+            for (uint32_t ip : ausentes) falsos += e.contiene(ip);
+        }, string("ipfiltro/") + e.nombre + "/ausente");
+        if (hallados != CONSULTAS) errores++;
+        cout << left << setw(14) << e.nombre << right << fixed << setprecision(2) << setw(10)
+             << (double)e.bytes * 8 / (double)n << setw(12) << e.construccion * 1e3 << setw(12)
+             << sP * 1e9 / CONSULTAS << setw(12) << sA * 1e9 / CONSULTAS << setw(10) << setprecision(3)
+             << 100.0 * (double)falsos / CONSULTAS << hwPresentes
+             << (hallados == CONSULTAS ? "" : "  FALSO NEGATIVO") << "\n";
+    }
+    if (errores > 0) {
+        cerr << "Error: " << errores << " estructuras con falsos negativos\n";
+        return 1;
+    }
+    return 0;
+}
+
+// ---------------- 4. SUBCOMANDO: estructuras ----------------
+
+/*
+ * Comparación de las estructuras de las cinco actividades sobre la misma
+ * bitácora, con las mismas cargas de trabajo:
+ *   construir   cargar los n registros (incluye ordenar si la estructura
+ *               lo necesita)
+ *   puntual     registros de una IP
+ *   rango       registros en un rango de fechas (16 rangos de 3 días)
+ *   grupos      registros por red /16 (número de redes y la mayor)
+ *   top-10      las 10 IPs con más registros
+ * Las estructuras originales guardan la razón como string, como en las
+ * actividades (sin la línea original, para que 100M quepan en memoria).
+ */
+
+struct EntradaTexto {
+    uint32_t tiempo;
+    uint32_t ip;
+    uint16_t puerto;
+    string razon;
+};
+
+bool menorEntrada(const EntradaTexto& a, const EntradaTexto& b) {
+    if (a.tiempo != b.tiempo) return a.tiempo < b.tiempo;
+    if (a.ip != b.ip) return a.ip < b.ip;
+    return a.puerto < b.puerto;
+}
+
+EntradaTexto entradaDe(const TablaRegistros& t, size_t i) {
+    return {t.tiempo[i], t.ip[i], t.puerto[i], t.razones.texto(t.razon[i])};
+}
+
+/*
+ * 4.1 Respuestas
+ * Resultados de las consultas; todas las estructuras deben coincidir.
+ * 'top' va ordenado por cuenta descendente y luego por IP.
+ */
+typedef vector<pair<uint32_t, uint32_t>> ListaTop;     // (cuenta, ip)
+
+void ordenarTop(ListaTop& v, size_t k) {
+    size_t m = min(k, v.size());
+    partial_sort(v.begin(), v.begin() + (long)m, v.end(), [](const pair<uint32_t, uint32_t>& a, const pair<uint32_t, uint32_t>& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    v.resize(m);
+}
+
+struct Grupos {
+    size_t redes = 0, mayor = 0;
+    bool operator==(const Grupos& o) const { return redes == o.redes && mayor == o.mayor; }
+};
+
+Grupos gruposDeConteo(const map<uint32_t, size_t>& cuenta) {
+    Grupos g;
+    g.redes = cuenta.size();
+    for (const auto& c : cuenta) g.mayor = max(g.mayor, c.second);
+    return g;
+}
+
+/*
+ * 4.2 VectorOrdenado (Act1.3)
+ * vector de entradas ordenado por fecha; el rango usa búsqueda binaria y
+ * lo demás recorre todo el vector.
+ */
+struct VectorOrdenado {
+    static const bool ESCANEA = true;
+    vector<EntradaTexto> v;
+
+    void construir(const TablaRegistros& t) {
+        v.clear();
+        v.shrink_to_fit();
+        for (size_t i = 0; i < t.size(); i++) v.push_back(entradaDe(t, i));
+        sort(v.begin(), v.end(), menorEntrada);
+    }
+    size_t puntual(uint32_t ip) const {
+        size_t c = 0;
+        for (const EntradaTexto& e : v) c += e.ip == ip;
+        return c;
+    }
+    size_t rango(uint32_t lo, uint32_t hi) const {
+        auto a = lower_bound(v.begin(), v.end(), lo, [](const EntradaTexto& e, uint32_t x) { return e.tiempo < x; });
+        auto b = upper_bound(v.begin(), v.end(), hi, [](uint32_t x, const EntradaTexto& e) { return x < e.tiempo; });
+        return (size_t)(b - a);
+    }
+    Grupos grupos() const {
+        map<uint32_t, size_t> cuenta;
+        for (const EntradaTexto& e : v) cuenta[e.ip >> 16]++;
+        return gruposDeConteo(cuenta);
+    }
+    ListaTop top(size_t k) const {
+        map<uint32_t, uint32_t> cuenta;
+        for (const EntradaTexto& e : v) cuenta[e.ip]++;
+        ListaTop r;
+        for (const auto& c : cuenta) r.push_back({c.second, c.first});
+        ordenarTop(r, k);
+        return r;
+    }
+};
+
+/*
+ * 4.3 ListaLigada (Act2.3)
+ * Lista doblemente ligada ordenada con merge sort (list::sort); todas las
+ * consultas la recorren desde la cabeza.
+ */
+struct ListaLigada {
+    static const bool ESCANEA = true;
+    list<EntradaTexto> l;
+
+    void construir(const TablaRegistros& t) {
+        l.clear();
+        for (size_t i = 0; i < t.size(); i++) l.push_back(entradaDe(t, i));
+        l.sort(menorEntrada);
+    }
+    size_t puntual(uint32_t ip) const {
+        size_t c = 0;
+        for (const EntradaTexto& e : l) c += e.ip == ip;
+        return c;
+    }
+    size_t rango(uint32_t lo, uint32_t hi) const {
+        size_t c = 0;
+        for (const EntradaTexto& e : l) {
+            if (e.tiempo > hi) break;
+            c += e.tiempo >= lo;
+        }
+        return c;
+    }
+    Grupos grupos() const {
+        map<uint32_t, size_t> cuenta;
+        for (const EntradaTexto& e : l) cuenta[e.ip >> 16]++;
+        return gruposDeConteo(cuenta);
+    }
+    ListaTop top(size_t k) const {
+        map<uint32_t, uint32_t> cuenta;
+        for (const EntradaTexto& e : l) cuenta[e.ip]++;
+        ListaTop r;
+        for (const auto& c : cuenta) r.push_back({c.second, c.first});
+        ordenarTop(r, k);
+        return r;
+    }
+};
+
+/*
+ * 4.4 MapaPorIp (Act3_4)
+ * map<ip, vector<entrada>>: la búsqueda por IP es O(log n), el rango de
+ * fechas recorre todo.
+ */
+struct MapaPorIp {
+    static const bool ESCANEA = false;
+    map<uint32_t, vector<EntradaTexto>> m;
+
+    void construir(const TablaRegistros& t) {
+        m.clear();
+        for (size_t i = 0; i < t.size(); i++) m[t.ip[i]].push_back(entradaDe(t, i));
+    }
+    size_t puntual(uint32_t ip) const {
+        auto it = m.find(ip);
+        return it == m.end() ? 0 : it->second.size();
+    }
+    size_t rango(uint32_t lo, uint32_t hi) const {
+        size_t c = 0;
+        for (const auto& par : m)
+            for (const EntradaTexto& e : par.second) c += e.tiempo >= lo && e.tiempo <= hi;
+        return c;
+    }
+    Grupos grupos() const {
+        // el mapa está ordenado por IP: las redes /16 son tramos contiguos
+        Grupos g;
+        uint32_t actual = 0;
+        size_t enRed = 0;
+        for (const auto& par : m) {
+            if (g.redes == 0 || par.first >> 16 != actual) {
+                g.redes++;
+                actual = par.first >> 16;
+                enRed = 0;
+            }
+            enRed += par.second.size();
+            g.mayor = max(g.mayor, enRed);
+        }
+        return g;
+    }
+    ListaTop top(size_t k) const {
+        ListaTop r;
+        for (const auto& par : m) r.push_back({(uint32_t)par.second.size(), par.first});
+        ordenarTop(r, k);
+        return r;
+    }
+};
+
+/*
+ * 4.5 HashCadenas (Act4.3 / Act5.2)
+ * Direccionamiento abierto con la IP como texto y el hash multiplicativo
+ * (131) de Act4.3. Crece al pasar de 1/2 de ocupación.
+ */
+template <class V>
+class TablaCadenas {
+public:
+    struct Casilla {
+        string llave;
+        V valor{};
+        bool usada = false;
+    };
+    vector<Casilla> casillas = vector<Casilla>(1024);
+    size_t ocupadas = 0;
+
+    static uint32_t hashCadena(const string& s) {
+        uint32_t h = 0;
+        for (unsigned char c : s) h = h * 131 + c;
+        return h;
+    }
+
+    const V* buscar(const string& llave) const {
+        size_t mascara = casillas.size() - 1;
+        for (size_t i = hashCadena(llave) & mascara;; i = (i + 1) & mascara) {
+            if (!casillas[i].usada) return nullptr;
+            if (casillas[i].llave == llave) return &casillas[i].valor;
+        }
+    }
+
+    V& obtener(const string& llave) {
+        if ((ocupadas + 1) * 2 > casillas.size()) crecer();
+        size_t mascara = casillas.size() - 1;
+        size_t i = hashCadena(llave) & mascara;
+        while (casillas[i].usada && casillas[i].llave != llave) i = (i + 1) & mascara;
+        if (!casillas[i].usada) {
+            casillas[i].usada = true;
+            casillas[i].llave = llave;
+            ocupadas++;
+        }
+        return casillas[i].valor;
+    }
+
+private:
+    void crecer() {
+        vector<Casilla> viejas(casillas.size() * 2);
+        viejas.swap(casillas);
+        size_t mascara = casillas.size() - 1;
+        for (Casilla& c : viejas) {
+            if (!c.usada) continue;
+            size_t i = hashCadena(c.llave) & mascara;
+            while (casillas[i].usada) i = (i + 1) & mascara;
+            casillas[i] = move(c);
+        }
+    }
+};
+
+struct HashCadenas {
+    static const bool ESCANEA = false;
+    TablaCadenas<vector<EntradaTexto>> tabla;
+
+    void construir(const TablaRegistros& t) {
+        tabla = TablaCadenas<vector<EntradaTexto>>();
+        for (size_t i = 0; i < t.size(); i++) tabla.obtener(ipATexto(t.ip[i])).push_back(entradaDe(t, i));
+    }
+    size_t puntual(uint32_t ip) const {
+        const vector<EntradaTexto>* v = tabla.buscar(ipATexto(ip));
+        return v ? v->size() : 0;
+    }
+    size_t rango(uint32_t lo, uint32_t hi) const {
+        size_t c = 0;
+        for (const auto& casilla : tabla.casillas)
+            for (const EntradaTexto& e : casilla.valor) c += e.tiempo >= lo && e.tiempo <= hi;
+        return c;
+    }
+    Grupos grupos() const {
+        // como Act4.3: una segunda tabla con el prefijo de red como texto
+        TablaCadenas<size_t> redes;
+        Grupos g;
+        for (const auto& casilla : tabla.casillas) {
+            if (!casilla.usada) continue;
+            size_t& c = redes.obtener(casilla.llave.substr(0, casilla.llave.find('.', casilla.llave.find('.') + 1)));
+            c += casilla.valor.size();
+            g.mayor = max(g.mayor, c);
+        }
+        g.redes = redes.ocupadas;
+        return g;
+    }
+    ListaTop top(size_t k) const {
+        ListaTop r;
+        for (const auto& casilla : tabla.casillas)
+            if (casilla.usada) r.push_back({(uint32_t)casilla.valor.size(), casilla.valor[0].ip});
+        ordenarTop(r, k);
+        return r;
+    }
+};
+
+/*
+ * 4.6 Columnar (sucesor)
+ * TablaRegistros ordenada por fecha: el rango es búsqueda binaria sobre la
+ * columna de tiempo, la búsqueda por IP un filtro SIMD sobre la columna de
+ * IPs y los grupos /16 un arreglo plano de 65536 contadores.
+ */
+struct Columnar {
+    static const bool ESCANEA = true;
+    TablaRegistros t;
+    mutable vector<uint64_t> bits;
+
+    void construir(const TablaRegistros& origen) {
+        VectorGrande<uint32_t> orden(origen.size());
+        for (size_t i = 0; i < orden.size(); i++) orden[i] = (uint32_t)i;
+        sort(orden.begin(), orden.end(), [&](uint32_t a, uint32_t b) {
+            if (origen.tiempo[a] != origen.tiempo[b]) return origen.tiempo[a] < origen.tiempo[b];
+            if (origen.ip[a] != origen.ip[b]) return origen.ip[a] < origen.ip[b];
+            return origen.puerto[a] < origen.puerto[b];
+        });
+        t = TablaRegistros();
+        t.razones = origen.razones;
+        t.reservar(orden.size());
+        for (uint32_t i : orden) t.agregar({origen.tiempo[i], origen.ip[i], origen.puerto[i], origen.razon[i]});
+        bits.assign(palabrasPara(t.size()), 0);
+    }
+    size_t puntual(uint32_t ip) const {
+        filtroIgual(t.ip.data(), t.size(), ip, bits.data());
+        return bitsContar(bits.data(), bits.size());
+    }
+    size_t rango(uint32_t lo, uint32_t hi) const {
+        return (size_t)(upper_bound(t.tiempo.begin(), t.tiempo.end(), hi) - lower_bound(t.tiempo.begin(), t.tiempo.end(), lo));
+    }
+    Grupos grupos() const {
+        vector<size_t> cuenta(65536);
+        for (uint32_t ip : t.ip) cuenta[ip >> 16]++;
+        Grupos g;
+        for (size_t c : cuenta) {
+            g.redes += c > 0;
+            g.mayor = max(g.mayor, c);
+        }
+        return g;
+    }
+    ListaTop top(size_t k) const {
+        vector<uint32_t> ips = t.ip;
+        sort(ips.begin(), ips.end());
+        ListaTop r;
+        for (size_t i = 0, j; i < ips.size(); i = j) {
+            for (j = i + 1; j < ips.size() && ips[j] == ips[i]; j++) {}
+            r.push_back({(uint32_t)(j - i), ips[i]});
+        }
+        ordenarTop(r, k);
+        return r;
+    }
+};
+
+/*
+ * 4.7 ColumnarIndice (sucesor)
+ * Columnar más un índice por IP: hash de enteros con direccionamiento
+ * abierto (ip -> id) y las filas de cada IP contiguas (CSR: inicio[id] ..
+ * inicio[id+1]). Puntual y top-10 dejan de recorrer la tabla.
+ */
+struct ColumnarIndice : Columnar {
+    static const bool ESCANEA = false;
+    VectorGrande<uint32_t> llaves, ids;     // tabla hash; llave 0 con id UINT32_MAX = vacía
+    VectorGrande<uint32_t> inicio, filas;
+    vector<uint32_t> ipDeId;
+
+    static uint32_t hashIp(uint32_t ip) { return (uint32_t)mezclar64(ip, 0x9e3779b9); }
+
+    void construir(const TablaRegistros& origen) {
+        Columnar::construir(origen);
+        size_t capacidad = 1024;
+        while (capacidad < t.size() * 2) capacidad <<= 1;
+        llaves.assign(capacidad, 0);
+        ids.assign(capacidad, UINT32_MAX);
+        ipDeId.clear();
+        VectorGrande<uint32_t> idFila(t.size());
+        for (size_t i = 0; i < t.size(); i++) {
+            size_t p = buscarCasilla(t.ip[i]);
+            if (ids[p] == UINT32_MAX) {
+                llaves[p] = t.ip[i];
+                ids[p] = (uint32_t)ipDeId.size();
+                ipDeId.push_back(t.ip[i]);
+            }
+            idFila[i] = ids[p];
+        }
+        inicio.assign(ipDeId.size() + 1, 0);
+        for (uint32_t id : idFila) inicio[id + 1]++;
+        for (size_t i = 1; i < inicio.size(); i++) inicio[i] += inicio[i - 1];
+        filas.resize(t.size());
+        VectorGrande<uint32_t> siguiente(inicio.begin(), inicio.end() - 1);
+        for (size_t i = 0; i < t.size(); i++) filas[siguiente[idFila[i]]++] = (uint32_t)i;
+    }
+    size_t buscarCasilla(uint32_t ip) const {
+        size_t mascara = llaves.size() - 1;
+        size_t p = hashIp(ip) & mascara;
+        while (ids[p] != UINT32_MAX && llaves[p] != ip) p = (p + 1) & mascara;
+        return p;
+    }
+    size_t puntual(uint32_t ip) const {
+        size_t p = buscarCasilla(ip);
+        return ids[p] == UINT32_MAX ? 0 : inicio[ids[p] + 1] - inicio[ids[p]];
+    }
+    ListaTop top(size_t k) const {
+        ListaTop r(ipDeId.size());
+        for (size_t id = 0; id < ipDeId.size(); id++) r[id] = {inicio[id + 1] - inicio[id], ipDeId[id]};
+        ordenarTop(r, k);
+        return r;
+    }
+};
+
+/*
+ * 4.8 memoriaDisponibleKb
+ * MemAvailable de /proc/meminfo (0 si no se puede leer).
+ */
+long memoriaDisponibleKb() {
+    ifstream in("/proc/meminfo");
+    string clave;
+    long valor;
+    while (in >> clave >> valor) {
+        if (clave == "MemAvailable:") return valor;
+        in.ignore(256, '\n');
+    }
+    return 0;
+}
+
+/*
+ * 4.9 correrEstructura
+ * Construye la estructura E y mide las cinco cargas. Imprime un renglón por
+ * carga (ms, ns por operación y contadores de hardware con -c) y compara
+ * las respuestas con las de la primera estructura ('referencia').
+ * 'bytesPorRegistro' es una estimación para no intentar lo que no cabe.
+ */
+struct Consultas {
+    vector<uint32_t> ips;
+    vector<pair<uint32_t, uint32_t>> rangos;
+};
+
+struct Respuestas {
+    size_t puntual = 0, rango = 0;
+    Grupos grupos;
+    ListaTop top;
+};
+
+template <class E>
+int correrEstructura(const char* nombre, double bytesPorRegistro, const TablaRegistros& t, const Consultas& q,
+                     const Opciones& op, Respuestas& referencia, bool& hayReferencia) {
+    string prefijo = "estructuras/" + to_string(t.size()) + "/" + nombre + "/";
+    long disponible = memoriaDisponibleKb();
+    if (disponible > 0 && bytesPorRegistro * (double)t.size() / 1024 > (double)disponible * 0.8) {
+        cout << left << setw(16) << nombre << "omitida: necesita ~" << (size_t)(bytesPorRegistro * (double)t.size() / 1048576)
+             << " MB y hay " << disponible / 1024 << " MB disponibles\n";
+        return 0;
+    }
+    malloc_trim(0);
+    long rssAntes = rssActualKb();
+    unique_ptr<E> e(new E());
+    double sConstruir = medir(min(op.repeticiones, 3), [&] { e->construir(t); }, prefijo + "construir");
+    string hwConstruir = columnasHw((double)t.size());
+    malloc_trim(0);
+    double mb = (double)(rssActualKb() - rssAntes) / 1024;
+
+    // las estructuras que recorren todo hacen pocas búsquedas puntuales
+    size_t nPuntual = E::ESCANEA ? min<size_t>(4, q.ips.size()) : q.ips.size();
+    Respuestas r;
+    double sPuntual = medir(op.repeticiones, [&] {
+        r.puntual = 0;
+        for (size_t i = 0; i < nPuntual; i++) r.puntual += e->puntual(q.ips[i]);
+    }, prefijo + "puntual");
+    string hwPuntual = columnasHw((double)nPuntual);
+    size_t puntual4 = 0;
+    for (size_t i = 0; i < min<size_t>(4, q.ips.size()); i++) puntual4 += e->puntual(q.ips[i]);
+    double sRango = medir(op.repeticiones, [&] {
+        r.rango = 0;
+        for (const auto& rg : q.rangos) r.rango += e->rango(rg.first, rg.second);
+    }, prefijo + "rango");
+    string hwRango = columnasHw((double)q.rangos.size());
+    double sGrupos = medir(op.repeticiones, [&] { r.grupos = e->grupos(); }, prefijo + "grupos");
+    string hwGrupos = columnasHw(1);
+    double sTop = medir(op.repeticiones, [&] { r.top = e->top(10); }, prefijo + "top-10");
+    string hwTop = columnasHw(1);
+    r.puntual = puntual4;
+
+    bool igual = true;
+    if (!hayReferencia) {
+        referencia = r;
+        hayReferencia = true;
+    } else {
+        igual = r.puntual == referencia.puntual && r.rango == referencia.rango && r.grupos == referencia.grupos &&
+                r.top == referencia.top;
+    }
+
+    struct Renglon {
+        const char* carga;
+        double s, operaciones;
+        string hw;
+    };
+    Renglon renglones[] = {
+        {"construir", sConstruir, (double)t.size(), hwConstruir},
+        {"puntual", sPuntual, (double)nPuntual, hwPuntual},
+        {"rango", sRango, (double)q.rangos.size(), hwRango},
+        {"grupos /16", sGrupos, 1, hwGrupos},
+        {"top-10", sTop, 1, hwTop},
+    };
+    for (const Renglon& rg : renglones) {
+        cout << left << setw(16) << nombre << setw(12) << rg.carga << right << fixed << setprecision(2) << setw(12)
+             << rg.s * 1e3 << setw(16) << rg.s * 1e9 / rg.operaciones << setw(10);
+        if (&rg == renglones) cout << mb;     // la memoria solo en el renglón de construir
+        else cout << "";
+        cout << rg.hw << (igual ? "" : "  DIFERENTE") << "\n";
+    }
+    return igual ? 0 : 1;
+}
+
+/*
+ * 4.10 benchEstructuras
+ * Corre la matriz estructura × carga para cada tamaño de -n (por omisión
+ * 1M, 10M y 100M). Con datos sintéticos cada IP aparece ~8 veces para que
+ * las búsquedas puntuales, los grupos y el top-10 tengan sentido.
+ */
+int benchEstructuras(const Opciones& op) {
+    vector<size_t> tamanos = op.tamanos;
+    if (tamanos.empty()) tamanos = {1000000, 10000000, 100000000};
+    if (!op.archivo.empty()) tamanos = {0};
+    int errores = 0;
+    for (size_t n : tamanos) {
+        TablaRegistros t;
+        if (!op.archivo.empty()) {
+            if (!cargarBitacora(op.archivo, t)) return 1;
+        } else {
+            tablaSintetica(n, t);
+            uint64_t distintas = max<uint64_t>(1, n / 8);
+            for (uint32_t& ip : t.ip) ip = (uint32_t)mezclar64(ip % distintas, 1);
+        }
+
+        Consultas q;
+        mt19937_64 gen(99);
+        q.ips.resize(1u << 14);
+        for (uint32_t& ip : q.ips) ip = t.ip[gen() % t.size()];
+        for (int i = 0; i < 16; i++) {
+            int mes = 1 + (int)(gen() % 12), dia = 1 + (int)(gen() % 28);
+            q.rangos.push_back({claveTiempo(mes, dia, 0, 0, 0), claveTiempo(mes, dia + 2, 23, 59, 59)});
+        }
+
+        cout << "registros: " << t.size() << "\n\n";
+        cout << left << setw(16) << "estructura" << setw(12) << "carga" << right << setw(12) << "ms" << setw(16)
+             << "ns/op" << setw(10) << "MB" << encabezadoHw() << "\n";
+        Respuestas referencia;
+        bool hay = false;
+        errores += correrEstructura<VectorOrdenado>("vector", 100, t, q, op, referencia, hay);
+        errores += correrEstructura<ListaLigada>("lista", 130, t, q, op, referencia, hay);
+        errores += correrEstructura<MapaPorIp>("map", 110, t, q, op, referencia, hay);
+        errores += correrEstructura<HashCadenas>("hash cadenas", 110, t, q, op, referencia, hay);
+        errores += correrEstructura<Columnar>("columnar", 40, t, q, op, referencia, hay);
+        errores += correrEstructura<ColumnarIndice>("columnar+indice", 60, t, q, op, referencia, hay);
+        cout << "\n";
+    }
+    if (errores > 0) {
+        cerr << "Error: " << errores << " estructuras con respuestas diferentes\n";
+        return 1;
+    }
+    return 0;
+}
+
+// ---------------- 5. SUBCOMANDO: lectura ----------------
+
+/*
+ * 5.1 benchLectura
+ * Lee la bitácora (-f) con ifstream completo (como antes), pread por
+ * bloques e io_uring con EN_VUELO lecturas pendientes, en caliente (archivo
+ * en la caché de páginas) y en frío (se descarta antes de cada repetición
+ * con posix_fadvise). Mide solo lectura y lectura + parseo; en io_uring el
+ * parseo se traslapa con las lecturas pendientes.
+ */
+int benchLectura(const Opciones& op) {
+    if (op.archivo.empty()) {
+        cerr << "Error: lectura necesita -f archivo\n";
+        return 1;
+    }
+    LectorAsincrono cache;
+    if (!cache.abrir(op.archivo, LectorAsincrono::PREAD)) {
+        cerr << "Error: no se pudo abrir " << op.archivo << " (" << cache.error() << ")\n";
+        return 1;
+    }
+    double mb = (double)cache.tamano() / 1048576;
+    LectorAsincrono prueba;
+    bool hayUring = prueba.abrir(op.archivo, LectorAsincrono::URING);
+    if (!hayUring) cerr << "Aviso: io_uring no disponible (" << prueba.error() << ")\n";
+
+    struct Modo {
+        const char* nombre;
+        function<size_t()> leer;        // devuelve bytes leídos
+        function<size_t()> cargar;      // devuelve registros
+    };
+    auto leerCon = [&](LectorAsincrono::Modo m) {
+        LectorAsincrono l;
+        size_t total = 0;
+        if (l.abrir(op.archivo, m)) l.leer([&](const char*, size_t n) { total += n; });
+        return total;
+    };
+    vector<Modo> modos = {
+        {"ifstream",
+         [&] {
+             ifstream in(op.archivo, ios::binary);
+             vector<char> b(cache.tamano());
+             in.read(b.data(), (streamsize)b.size());
+             return (size_t)in.gcount();
+         },
+         [&] {
+             ifstream in(op.archivo, ios::binary);
+             vector<char> b(cache.tamano());
+             in.read(b.data(), (streamsize)b.size());
+             TablaRegistros t;
+             t.reservar(b.size() / 48 + 1);
+             parsearBuffer(b.data(), b.size(), t);
+             return t.size();
+         }},
+        {"pread", [&] { return leerCon(LectorAsincrono::PREAD); },
+         [&] {
+             TablaRegistros t;
+             cargarBitacora(op.archivo, t, LectorAsincrono::PREAD);
+             return t.size();
+         }},
+    };
+    if (hayUring)
+        modos.push_back({"io_uring", [&] { return leerCon(LectorAsincrono::URING); }, [&] {
+                             TablaRegistros t;
+                             cargarBitacora(op.archivo, t, LectorAsincrono::URING);
+                             return t.size();
+                         }});
+
+    cout << "archivo: " << op.archivo << " (" << fixed << setprecision(1) << mb << " MB)   bloque: "
+         << LectorAsincrono::BLOQUE / 1024 << " KB x " << LectorAsincrono::EN_VUELO << " en vuelo\n\n";
+    cout << left << setw(10) << "modo" << setw(10) << "cache" << setw(16) << "trabajo" << right << setw(10) << "ms"
+         << setw(10) << "MB/s" << setw(12) << "registros" << encabezadoHw() << "\n";
+    size_t registrosRef = 0;
+    int errores = 0;
+    for (const char* estado : {"caliente", "frio"}) {
+        bool frio = estado[0] == 'f';
+        function<void()> preparar = [&] {
+            if (frio) cache.descartarCache();
+            else cache.leer([](const char*, size_t) {});
+        };
+        for (const Modo& m : modos) {
+            size_t bytesLeidos = 0, registros = 0;
+            string base = string("lectura/") + m.nombre + "/" + estado + "/";
+            double sLeer = medir(op.repeticiones, [&] { bytesLeidos = m.leer(); }, base + "leer", preparar);
+            string hwLeer = columnasHw((double)cache.tamano());
+            double sCargar = medir(op.repeticiones, [&] { registros = m.cargar(); }, base + "leer+parsear", preparar);
+            if (registrosRef == 0) registrosRef = registros;
+            bool igual = registros == registrosRef && bytesLeidos == cache.tamano();
+            if (!igual) errores++;
+            cout << left << setw(10) << m.nombre << setw(10) << estado << setw(16) << "leer" << right << fixed
+                 << setprecision(2) << setw(10) << sLeer * 1e3 << setw(10) << mb / sLeer << setw(12) << "-" << hwLeer
+                 << "\n";
+            cout << left << setw(10) << m.nombre << setw(10) << estado << setw(16) << "leer+parsear" << right
+                 << setw(10) << sCargar * 1e3 << setw(10) << mb / sCargar << setw(12) << registros
+                 << columnasHw((double)cache.tamano()) << (igual ? "" : "  DIFERENTE") << "\n";
+        }
+    }
+    if (errores > 0) {
+        cerr << "Error: " << errores << " modos con resultados diferentes\n";
+        return 1;
+    }
+    return 0;
+}
+
+// ---------------- 6. SUBCOMANDO: columnar ----------------
+
+/*
+ * 6.1 benchColumnar
+ * Compara guardar la tabla como texto (una línea por registro, como
+ * bitacora.txt), en columnas sin comprimir y comprimida por bloques
+ * (columnar.h): bytes por registro, tiempo de parsear el texto contra
+ * descomprimir con cada nivel SIMD, y leer solo los bloques de un día.
+ * Verifica que lo descomprimido sea la tabla ordenada por tiempo.
+ */
+int benchColumnar(const Opciones& op) {
+    TablaRegistros t;
+    if (!cargarDatos(op, t)) return 1;
+    size_t n = t.size();
+    string texto;
+    texto.reserve(n * 64);
+    char linea[512];
+    for (size_t i = 0; i < n; i++) {
+        texto.append(linea, (size_t)formatearLinea(t, i, linea, sizeof(linea)));
+        texto.push_back('\n');
+    }
+    vector<uint32_t> orden(n);
+    for (uint32_t i = 0; i < n; i++) orden[i] = i;
+    stable_sort(orden.begin(), orden.end(), [&](uint32_t a, uint32_t b) { return t.tiempo[a] < t.tiempo[b]; });
+
+    BitacoraColumnar col;
+    double sComprimir = medir(op.repeticiones, [&] { col.comprimir(t); }, "columnar/comprimir");
+    string hwComprimir = columnasHw((double)n);
+
+    cout << "registros: " << n << "   bloques: " << col.bloques() << " x " << BitacoraColumnar::RENGLONES << "\n\n";
+    cout << left << setw(24) << "formato" << right << setw(12) << "B/registro" << setw(12) << "proporcion" << "\n";
+    double bTexto = (double)texto.size() / (double)n;
+    for (auto f : {make_pair("texto", (double)texto.size()), make_pair("columnas sin comprimir", (double)n * 11),
+                   make_pair("columnar por bloques", (double)col.bytes())})
+        cout << left << setw(24) << f.first << right << fixed << setprecision(2) << setw(12) << f.second / (double)n
+             << setw(11) << bTexto * (double)n / f.second << "x\n";
+
+    cout << "\n" << left << setw(16) << "operacion" << setw(10) << "nivel" << right << setw(10) << "ms"
+         << setw(12) << "Mreg/s" << encabezadoHw() << "\n";
+    auto fila = [&](const char* nombre, const char* nivel, double s, size_t registros, const string& hw,
+                    bool igual = true) {
+        cout << left << setw(16) << nombre << setw(10) << nivel << right << fixed << setprecision(2) << setw(10)
+             << s * 1e3 << setw(12) << (double)registros / 1e6 / s << hw << (igual ? "" : "  DIFERENTE") << "\n";
+    };
+    fila("comprimir", "-", sComprimir, n, hwComprimir);
+    size_t parseados = 0;
+    double sParsear = medir(op.repeticiones, [&] {
+        TablaRegistros p;
+        p.reservar(n);
+        parsearBuffer(texto.data(), texto.size(), p);
+        parseados = p.size();
+    }, "columnar/parsear texto");
+    fila("parsear texto", "-", sParsear, n, columnasHw((double)n), parseados == n);
+
+    int errores = parseados == n ? 0 : 1;
+    NivelSimd maximo = nivelDetectado();
+    for (int nivel = SIMD_ESCALAR; nivel <= maximo; nivel++) {
+        fijarNivelSimd((NivelSimd)nivel);
+        TablaRegistros d;
+        double s = medir(op.repeticiones, [&] {
+            d = TablaRegistros();
+            col.descomprimir(d);
+        }, string("columnar/descomprimir/") + nombreNivel((NivelSimd)nivel));
+        bool igual = d.size() == n;
+        for (size_t i = 0; igual && i < n; i++) {
+            uint32_t j = orden[i];
+            igual = d.tiempo[i] == t.tiempo[j] && d.ip[i] == t.ip[j] && d.puerto[i] == t.puerto[j] &&
+                    d.razon[i] == t.razon[j];
+        }
+        if (!igual) errores++;
+        fila("descomprimir", nombreNivel((NivelSimd)nivel), s, n, columnasHw((double)n), igual);
+    }
+    fijarNivelSimd(maximo);
+
+    // Acceso por bloques: solo los que tocan el 1 de marzo
+    uint32_t lo = claveTiempo(3, 1, 0, 0, 0), hi = claveTiempo(3, 1, 23, 59, 59);
+    pair<size_t, size_t> rango = col.bloquesEnTiempo(lo, hi);
+    size_t leidos = 0, enDia = 0;
+    vector<uint32_t> tiempo(BitacoraColumnar::RENGLONES), ip(BitacoraColumnar::RENGLONES);
+    vector<uint16_t> puerto(BitacoraColumnar::RENGLONES);
+    vector<uint8_t> razon(BitacoraColumnar::RENGLONES);
+    double sDia = medir(op.repeticiones, [&] {
+        leidos = enDia = 0;
+        for (size_t b = rango.first; b < rango.second; b++) {
+            size_t k = col.descomprimirBloque(b, tiempo.data(), ip.data(), puerto.data(), razon.data());
+            leidos += k;
+            for (size_t i = 0; i < k; i++) enDia += tiempo[i] >= lo && tiempo[i] <= hi;
+        }
+    }, "columnar/un dia");
+    size_t esperados = (size_t)count_if(t.tiempo.begin(), t.tiempo.end(), [&](uint32_t v) { return v >= lo && v <= hi; });
+    if (enDia != esperados) errores++;
+    fila("un dia", nombreNivel(maximo), sDia, max<size_t>(leidos, 1), columnasHw((double)max<size_t>(leidos, 1)),
+         enDia == esperados);
+    cout << "  (" << rango.second - rango.first << " bloques, " << enDia << " registros del día)\n";
+
+    if (errores > 0) {
+        cerr << "Error: " << errores << " resultados no coinciden con la tabla original\n";
+        return 1;
+    }
+    return 0;
+}
+
+// ---------------- 7. SUBCOMANDO: paginas ----------------
+
+/*
+ * 7.1 benchPaginas
+ * Las mismas dos cargas sobre memoria con páginas normales, THP y hugetlb
+ * (mapearGrande, paginas.h):
+ *   sondeo   búsquedas al azar (mitad presentes) en una tabla hash de
+ *            direccionamiento abierto con 2n casillas de 8 bytes, como
+ *            hostTable de Act4.3 o el índice por IP de columnar+indice
+ *   ordenar  ordenar n índices por una llave guardada en otro arreglo
+ *            (acceso indirecto al azar, como el orden por tiempo)
+ * "obtenido" es la forma que dio el sistema (hugetlb sin páginas
+ * reservadas cae a thp) y "2M MiB" lo que de verdad quedó en páginas
+ * grandes. Con -c la columna dTLB da los fallos de TLB por operación.
+ */
+int benchPaginas(const Opciones& op) {
+    size_t n = op.registros;
+    size_t casillas = 1024;
+    while (casillas < 2 * n) casillas <<= 1;
+    const size_t CONSULTAS = 4u << 20;
+    mt19937_64 gen(4242);
+    vector<uint32_t> llaves(n), consultas(CONSULTAS);
+    for (uint32_t& k : llaves) k = (uint32_t)gen() | 1;     // 0 = casilla vacía
+    for (size_t i = 0; i < CONSULTAS; i++) consultas[i] = i % 2 ? llaves[gen() % n] : (uint32_t)gen() | 1;
+
+    struct Casilla {
+        uint32_t llave, valor;
+    };
+    auto casillaDe = [](uint32_t k) { return (size_t)mezclar64(k, 0x9e3779b9); };
+    cout << "registros: " << n << "   tabla: " << casillas * sizeof(Casilla) / 1048576 << " MiB   llaves: "
+         << 2 * n * 4 / 1048576 << " MiB\n\n";
+    cout << left << setw(10) << "pedido" << setw(10) << "obtenido" << right << setw(8) << "2M MiB" << "  " << left
+         << setw(10) << "carga" << right << setw(10) << "ms" << setw(10) << "ns/op" << encabezadoHw() << "\n";
+
+    size_t encontradosRef = SIZE_MAX;
+    int errores = 0;
+    for (int k = PAGINAS_NORMALES; k <= PAGINAS_EXPLICITAS; k++) {
+        TipoPaginas pedido = (TipoPaginas)k;
+        MemoriaGrande tablaMem(casillas * sizeof(Casilla), pedido);
+        MemoriaGrande llaveMem(n * 4, pedido), ordenMem(n * 4, pedido);
+        if (!tablaMem || !llaveMem || !ordenMem) {
+            cerr << "Error: no hay memoria para " << nombrePaginas(pedido) << "\n";
+            return 1;
+        }
+        Casilla* tabla = (Casilla*)tablaMem.datos();
+        uint32_t* llave = (uint32_t*)llaveMem.datos();
+        uint32_t* orden = (uint32_t*)ordenMem.datos();
+        size_t mascara = casillas - 1;
+        for (size_t i = 0; i < n; i++) {
+            size_t c = casillaDe(llaves[i]) & mascara;
+            while (tabla[c].llave != 0 && tabla[c].llave != llaves[i]) c = (c + 1) & mascara;
+            tabla[c] = {llaves[i], (uint32_t)i};
+            llave[i] = llaves[i];
+        }
+        long mb = (kbEnPaginasGrandes(tabla) + kbEnPaginasGrandes(llave) + kbEnPaginasGrandes(orden)) / 1024;
+        string nombre = string("paginas/") + nombrePaginas(pedido);
+        auto fila = [&](const char* carga, double s, double ops, bool igual) {
+            cout << left << setw(10) << nombrePaginas(pedido) << setw(10) << nombrePaginas(tablaMem.obtenido()) << right
+                 << setw(8) << mb << "  " << left << setw(10) << carga << right << fixed << setprecision(2)
+                 << setw(10) << s * 1e3 << setw(10) << s * 1e9 / ops << columnasHw(ops) << (igual ? "" : "  DIFERENTE")
+                 << "\n";
+        };
+
+        size_t encontrados = 0;
+        double sSondeo = medir(op.repeticiones, [&] {
+            encontrados = 0;
+            for (uint32_t q : consultas) {
+                size_t c = casillaDe(q) & mascara;
+                while (tabla[c].llave != 0 && tabla[c].llave != q) c = (c + 1) & mascara;
+                encontrados += tabla[c].llave == q;
+            }
+        }, nombre + "/sondeo");
+        if (encontradosRef == SIZE_MAX) encontradosRef = encontrados;
+        if (encontrados != encontradosRef) errores++;
+        fila("sondeo", sSondeo, (double)CONSULTAS, encontrados == encontradosRef);
+
+        bool ordenado = true;
+        double sOrden = medir(op.repeticiones, [&] {
+            for (size_t i = 0; i < n; i++) orden[i] = (uint32_t)i;
+            sort(orden, orden + n, [&](uint32_t a, uint32_t b) { return llave[a] < llave[b]; });
+        }, nombre + "/ordenar");
+        for (size_t i = 1; i < n && ordenado; i++) ordenado = llave[orden[i - 1]] <= llave[orden[i]];
+        if (!ordenado) errores++;
+        fila("ordenar", sOrden, (double)n, ordenado);
+    }
+    if (errores > 0) {
+        cerr << "Error: " << errores << " resultados diferentes entre formas de página\n";
+        return 1;
+    }
+    return 0;
+}
+
+// ---------------- 8. SUBCOMANDO: formato ----------------
+
+/*
+ * 8.1 benchFormato
+ * Tres formas de volver a escribir las líneas de la bitácora:
+ *   originLine  guardar el texto de cada línea y escribirlo con
+ *               ofstream << linea (lo que hace Act3_4)
+ *   snprintf    regenerarla del registro con formatearLinea (registro.h)
+ *   tablas      regenerarla con FormateadorLineas sobre un búfer de 1 MiB
+ *               (formato.h)
+ * Todas escriben a /dev/null: se mide formatear y copiar, no el disco.
+ * Con -f las líneas originales son las del archivo y se verifica que las
+ * regeneradas sean idénticas byte a byte; sin -f, que las tres coincidan.
+ */
+int benchFormato(const Opciones& op) {
+    TablaRegistros t;
+    if (!cargarDatos(op, t)) return 1;
+    size_t n = t.size();
+    vector<string> originales;
+    originales.reserve(n);
+    char linea[512];
+    if (!op.archivo.empty()) {
+        EntradaBitacora in(op.archivo);
+        string l;
+        while (getline(in, l))
+            if (!l.empty()) originales.push_back(l);
+        if (originales.size() != n) {
+            cerr << "Error: " << op.archivo << " tiene líneas que no se pudieron parsear\n";
+            return 1;
+        }
+    } else {
+        for (size_t i = 0; i < n; i++) originales.emplace_back(linea, (size_t)formatearLinea(t, i, linea, sizeof linea));
+    }
+    size_t bytesTexto = 0, bytesGuardados = 0;
+    for (const string& l : originales) {
+        bytesTexto += l.size() + 1;
+        bytesGuardados += sizeof(string) + (l.capacity() > 15 ? l.capacity() + 1 : 0);
+    }
+
+    // salida de referencia y de cada forma, para comparar bytes
+    string esperado;
+    esperado.reserve(bytesTexto);
+    for (const string& l : originales) {
+        esperado += l;
+        esperado += '\n';
+    }
+    FormateadorLineas formateador(t.razones);
+    ostringstream conSnprintf, conTablas;
+    for (size_t i = 0; i < n; i++) {
+        int len = formatearLinea(t, i, linea, sizeof linea);
+        conSnprintf.write(linea, len);
+        conSnprintf.put('\n');
+    }
+    {
+        SalidaLineas sal(conTablas);
+        for (size_t i = 0; i < n; i++) formateador.linea(t, i, sal);
+    }
+
+    cout << "lineas: " << n << "   texto: " << fixed << setprecision(1) << (double)bytesTexto / (double)n
+         << " B/linea   originLine guardada: " << (double)bytesGuardados / (double)n << " B/registro (vs 11)\n\n";
+    cout << left << setw(12) << "forma" << right << setw(10) << "ms" << setw(14) << "Mlineas/s" << setw(10) << "MB/s"
+         << encabezadoHw() << "\n";
+    auto fila = [&](const char* nombre, double s, bool igual) {
+        cout << left << setw(12) << nombre << right << fixed << setprecision(2) << setw(10) << s * 1e3 << setw(14)
+             << (double)n / 1e6 / s << setw(10) << (double)bytesTexto / 1048576.0 / s << columnasHw((double)n)
+             << (igual ? "" : "  DIFERENTE") << "\n";
+    };
+
+    ofstream nulo("/dev/null");
+    double sOriginal = medir(op.repeticiones, [&] {
+        for (const string& l : originales) nulo << l << '\n';
+        nulo.flush();
+    }, "formato/originLine");
+    fila("originLine", sOriginal, true);
+
+    double sSnprintf = medir(op.repeticiones, [&] {
+        for (size_t i = 0; i < n; i++) {
+            int len = formatearLinea(t, i, linea, sizeof linea);
+            nulo.write(linea, len);
+            nulo.put('\n');
+        }
+        nulo.flush();
+    }, "formato/snprintf");
+    bool igualSnprintf = conSnprintf.str() == esperado;
+    fila("snprintf", sSnprintf, igualSnprintf);
+
+    double sTablas = medir(op.repeticiones, [&] {
+        SalidaLineas sal(nulo);
+        for (size_t i = 0; i < n; i++) formateador.linea(t, i, sal);
+        sal.vaciar();
+        nulo.flush();
+    }, "formato/tablas");
+    bool igualTablas = conTablas.str() == esperado;
+    fila("tablas", sTablas, igualTablas);
+
+    if (!igualSnprintf || !igualTablas) {
+        cerr << "Error: las líneas regeneradas no coinciden con las originales\n";
+        return 1;
+    }
+    return 0;
+}
+
+// ---------------- 9. SUBCOMANDO: detector ----------------
+
+/*
+ * 9.1 flujoFallos
+ * n fallos en orden de tiempo a lo largo de un mes: 5% de 16 IPs
+ * atacantes y el resto de IPs al azar entre 4M, que casi nunca repiten.
+ * Con -f se toman los fallos de la bitácora, ordenados.
+ */
+void flujoFallos(const Opciones& op, vector<uint32_t>& ips, vector<uint32_t>& tiempos) {
+    if (!op.archivo.empty()) {
+        TablaRegistros t;
+        if (!cargarBitacora(op.archivo, t)) return;
+        vector<size_t> ids;
+        for (size_t i = 0; i < t.size(); i++) {
+            string_view r = t.razones.texto(t.razon[i]);
+            if (r.rfind("Failed password", 0) == 0 || r == "Too many login attempts") ids.push_back(i);
+        }
+        stable_sort(ids.begin(), ids.end(), [&](size_t a, size_t b) { return t.tiempo[a] < t.tiempo[b]; });
+        for (size_t i : ids) {
+            ips.push_back(t.ip[i]);
+            tiempos.push_back(t.tiempo[i]);
+        }
+        return;
+    }
+    mt19937_64 gen(12345);
+    size_t n = op.registros;
+    ips.resize(n);
+    tiempos.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        uint64_t x = gen();
+        tiempos[i] = (uint32_t)((uint64_t)i * SEGUNDOS_MES / n);
+        ips[i] = x % 100 < 5 ? 0x0A000000u + (uint32_t)(x >> 8 & 15) : (uint32_t)(x >> 32) % (4u << 20) * 977u;
+    }
+}
+
+/*
+ * 9.2 benchDetector
+ * El mismo flujo de fallos por DetectorFuerzaBruta y por un detector con
+ * unordered_map<uint32_t, deque<uint32_t>> (un nodo por IP y un bloque de
+ * deque por anillo, desalojando en el mismo momento), para 5/60 y 20/3600.
+ * Verifica que ambos den el mismo número de alertas.
+ */
+int benchDetector(const Opciones& op) {
+    vector<uint32_t> ips, tiempos;
+    flujoFallos(op, ips, tiempos);
+    size_t n = ips.size();
+    if (n == 0) return 1;
+    cout << "fallos: " << n << "\n\n";
+    cout << left << setw(12) << "detector" << setw(10) << "N/T" << right << setw(10) << "ms" << setw(14)
+         << "Meventos/s" << setw(10) << "alertas" << setw(12) << "KiB estado" << encabezadoHw() << "\n";
+    bool iguales = true;
+    for (auto [umbral, ventana] : {pair<uint32_t, uint32_t>{5, 60}, {20, 3600}}) {
+        string nt = to_string(umbral) + "/" + to_string(ventana);
+        auto fila = [&](const char* nombre, double s, uint64_t alertas, size_t bytes) {
+            cout << left << setw(12) << nombre << setw(10) << nt << right << fixed << setprecision(2) << setw(10)
+                 << s * 1e3 << setw(14) << (double)n / 1e6 / s << setw(10) << alertas << setw(12) << bytes / 1024
+                 << columnasHw((double)n) << "\n";
+        };
+
+        uint64_t alertasPlano = 0;
+        size_t bytesPlano = 0;
+        double sPlano = medir(op.repeticiones, [&] {
+            DetectorFuerzaBruta d(umbral, ventana);
+            for (size_t i = 0; i < n; i++) d.fallo(ips[i], tiempos[i], [](const Alerta&) {});
+            alertasPlano = d.alertas;
+            bytesPlano = d.bytes();
+        }, "detector/plano/" + nt);
+        fila("plano", sPlano, alertasPlano, bytesPlano);
+
+        uint64_t alertasMapa = 0;
+        size_t bytesMapa = 0;
+        double sMapa = medir(op.repeticiones, [&] {
+            struct Estado {
+                deque<uint32_t> tiempos;
+                uint32_t alertaHasta = 0;
+            };
+            unordered_map<uint32_t, Estado> mapa;
+            size_t limite = 1024 / 2;
+            uint64_t alertas = 0;
+            for (size_t i = 0; i < n; i++) {
+                uint32_t t = tiempos[i];
+                if (mapa.size() + 1 > limite && mapa.find(ips[i]) == mapa.end()) {
+                    for (auto it = mapa.begin(); it != mapa.end();)
+                        it = t - it->second.tiempos.back() >= ventana ? mapa.erase(it) : next(it);
+                    limite = 1024 / 2;
+                    while (limite < mapa.size() * 2) limite *= 2;
+                }
+                Estado& e = mapa[ips[i]];
+                if (!e.tiempos.empty() && t - e.tiempos.back() >= ventana) e.tiempos.clear();
+                e.tiempos.push_back(t);
+                if (e.tiempos.size() > umbral) e.tiempos.pop_front();
+                if (e.tiempos.size() == umbral && t - e.tiempos.front() < ventana && e.tiempos.front() >= e.alertaHasta) {
+                    e.alertaHasta = t + 1;
+                    alertas++;
+                }
+            }
+            alertasMapa = alertas;
+            // nodo + cubeta + bloque de deque (512 B) + arreglo de bloques (64 B) por IP
+            bytesMapa = mapa.bucket_count() * sizeof(void*) + mapa.size() * (sizeof(Estado) + 32 + 512 + 64);
+        }, "detector/mapa/" + nt);
+        fila("mapa+deque", sMapa, alertasMapa, bytesMapa);
+        iguales = iguales && alertasPlano == alertasMapa;
+    }
+    if (!iguales) {
+        cerr << "Error: los detectores no coinciden en el número de alertas\n";
+        return 1;
+    }
+    return 0;
+}
+
+// ---------------- 10. LÍNEA BASE Y REGRESIONES ----------------
+
+/*
+ * 10.1 Estadística robusta
+ * mediana y MAD (mediana de las desviaciones absolutas a la mediana). A
+ * diferencia de promedio y desviación estándar, una repetición atípica
+ * (otro proceso, interrupción) casi no las mueve.
+ */
+double mediana(vector<double> v) {
+    if (v.empty()) return 0;
+    size_t m = v.size() / 2;
+    nth_element(v.begin(), v.begin() + (long)m, v.end());
+    double med = v[m];
+    if (v.size() % 2 == 0) med = (med + *max_element(v.begin(), v.begin() + (long)m)) / 2;
+    return med;
+}
+
+double mad(const vector<double>& v, double med) {
+    vector<double> d;
+    for (double x : v) d.push_back(fabs(x - med));
+    return mediana(d);
+}
+
+struct Resumen {
+    double medianaMs = 0, madMs = 0;
+    int n = 0;
+};
+
+/*
+ * 10.2 Identidad de la máquina
+ * Nombre de host y modelo de CPU; el archivo por omisión usa el host.
+ */
+string nombreMaquina() {
+    char buf[256] = "desconocida";
+    gethostname(buf, sizeof(buf) - 1);
+    return buf;
+}
+
+string modeloCpu() {
+    ifstream in("/proc/cpuinfo");
+    string linea;
+    while (getline(in, linea))
+        if (linea.compare(0, 10, "model name") == 0) {
+            size_t p = linea.find(':');
+            return p == string::npos ? "" : linea.substr(p + 2);
+        }
+    return "";
+}
+
+string archivoBase(const string& dado) {
+    return dado.empty() || dado == "-" ? "bench_base_" + nombreMaquina() + ".json" : dado;
+}
+
+/*
+ * 10.3 guardarBase
+ * Escribe un JSON con una medición por renglón:
+ *   {"maquina":"...","cpu":"...","resultados":{
+ *   "filtros/ip /8/AVX2":{"mediana_ms":1.234,"mad_ms":0.010,"n":5},
+ *   ...}}
+ * Si el archivo ya existe se conservan las mediciones de otros
+ * subcomandos y se reemplazan las de esta corrida.
+ */
+bool leerBase(const string& ruta, vector<pair<string, Resumen>>& base, string& cpu);
+
+bool guardarBase(const string& ruta) {
+    vector<pair<string, Resumen>> base;
+    string cpuAnterior;
+    leerBase(ruta, base, cpuAnterior);
+    for (const Resultado& r : resultados) {
+        Resumen z;
+        double med = mediana(r.tiempos);
+        z.medianaMs = med * 1e3;
+        z.madMs = mad(r.tiempos, med) * 1e3;
+        z.n = (int)r.tiempos.size();
+        auto it = find_if(base.begin(), base.end(), [&](const pair<string, Resumen>& b) { return b.first == r.nombre; });
+        if (it != base.end()) it->second = z;
+        else base.push_back({r.nombre, z});
+    }
+    ofstream out(ruta);
+    if (!out.is_open()) {
+        cerr << "Error: no se pudo escribir " << ruta << "\n";
+        return false;
+    }
+    out << "{\"maquina\":\"" << nombreMaquina() << "\",\"cpu\":\"" << modeloCpu() << "\",\"resultados\":{\n";
+    out << fixed << setprecision(6);
+    for (size_t i = 0; i < base.size(); i++)
+        out << "\"" << base[i].first << "\":{\"mediana_ms\":" << base[i].second.medianaMs
+            << ",\"mad_ms\":" << base[i].second.madMs << ",\"n\":" << base[i].second.n << "}"
+            << (i + 1 < base.size() ? "," : "") << "\n";
+    out << "}}\n";
+    cout << "\nLínea base guardada en " << ruta << " (" << resultados.size() << " mediciones)\n";
+    return true;
+}
+
+/*
+ * 10.4 leerBase
+ * Lee el formato de guardarBase (un resultado por renglón). No es un
+ * parser de JSON general: solo entiende lo que escribe este programa.
+ */
+bool leerBase(const string& ruta, vector<pair<string, Resumen>>& base, string& cpu) {
+    ifstream in(ruta);
+    if (!in.is_open()) return false;
+    string linea;
+    while (getline(in, linea)) {
+        size_t c = linea.find("\"cpu\":\"");
+        if (c != string::npos) cpu = linea.substr(c + 7, linea.find('"', c + 7) - (c + 7));
+        size_t m = linea.find("\":{\"mediana_ms\":");
+        if (linea.empty() || linea[0] != '"' || m == string::npos) continue;
+        Resumen z;
+        if (sscanf(linea.c_str() + m, "\":{\"mediana_ms\":%lf,\"mad_ms\":%lf,\"n\":%d", &z.medianaMs, &z.madMs, &z.n) != 3)
+            continue;
+        base.push_back({linea.substr(1, m - 1), z});
+    }
+    return true;
+}
+
+/*
+ * 10.5 compararBase
+ * Para cada medición de esta corrida busca la de la base y la clasifica:
+ *  - REGRESION: la mediana subió más del umbral Y la diferencia supera 3
+ *    veces el ruido (1.4826·MAD ≈ desviación estándar, el mayor de las dos
+ *    corridas) y al menos DIFERENCIA_MIN_MS. Así una medición ruidosa no
+ *    dispara falsas alarmas, ni una de microsegundos con MAD de 0 (el
+ *    reloj y el planificador mueven eso de una corrida a otra; para
+ *    vigilarla hay que subir -n).
+ *  - MEJORA: lo mismo hacia abajo.
+ *  - ok: dentro del ruido o del umbral.
+ * Devuelve el número de regresiones.
+ */
+const double DIFERENCIA_MIN_MS = 0.1;
+
+int compararBase(const string& ruta, double umbral) {
+    vector<pair<string, Resumen>> base;
+    string cpu;
+    if (!leerBase(ruta, base, cpu)) {
+        cerr << "Error: no se pudo leer la línea base " << ruta << "\n";
+        return -1;
+    }
+    if (!cpu.empty() && cpu != modeloCpu())
+        cerr << "Aviso: la base se midió en otro CPU (" << cpu << ")\n";
+
+    cout << "\nComparación contra " << ruta << " (umbral " << umbral << "%)\n";
+    cout << left << setw(36) << "medición" << right << setw(12) << "base ms" << setw(12) << "nuevo ms"
+         << setw(10) << "cambio" << setw(10) << "ruido" << "  estado\n";
+    int regresiones = 0;
+    for (const Resultado& r : resultados) {
+        double med = mediana(r.tiempos), nuevoMs = med * 1e3, madNuevo = mad(r.tiempos, med) * 1e3;
+        auto it = find_if(base.begin(), base.end(), [&](const pair<string, Resumen>& b) { return b.first == r.nombre; });
+        cout << left << setw(36) << r.nombre << right << fixed << setprecision(3);
+        if (it == base.end()) {
+            cout << setw(12) << "-" << setw(12) << nuevoMs << setw(10) << "-" << setw(10) << "-" << "  NUEVA\n";
+            continue;
+        }
+        const Resumen& b = it->second;
+        double cambio = b.medianaMs > 0 ? (nuevoMs - b.medianaMs) / b.medianaMs * 100 : 0;
+        double ruido = max(3 * 1.4826 * max(b.madMs, madNuevo), DIFERENCIA_MIN_MS);
+        const char* estado = "ok";
+        if (cambio > umbral && nuevoMs - b.medianaMs > ruido) {
+            estado = "REGRESION";
+            regresiones++;
+        } else if (cambio < -umbral && b.medianaMs - nuevoMs > ruido) {
+            estado = "MEJORA";
+        }
+        cout << setw(12) << b.medianaMs << setw(12) << nuevoMs << setw(9) << setprecision(1) << showpos << cambio
+             << noshowpos << "%" << setw(10) << setprecision(3) << ruido << "  " << estado << "\n";
+    }
+    if (regresiones > 0) cerr << "Error: " << regresiones << " mediciones empeoraron más de " << umbral << "%\n";
+    return regresiones;
+}
+
+// ---------------- 11. FUNCIÓN PRINCIPAL ----------------
+
+/*
+ * 11.1 Subcomandos registrados
+ */
+struct Subcomando {
+    const char* nombre;
+    int (*correr)(const Opciones&);
+};
+
+const Subcomando SUBCOMANDOS[] = {
+    {"filtros", benchFiltros},
+    {"ipfiltro", benchFiltroIp},
+    {"estructuras", benchEstructuras},
+    {"lectura", benchLectura},
+    {"columnar", benchColumnar},
+    {"paginas", benchPaginas},
+    {"formato", benchFormato},
+    {"detector", benchDetector},
+};
+
+/*
+ * 11.2 main
+ * Lee el subcomando y las opciones, ejecuta el benchmark correspondiente y,
+ * si se pidió, guarda o compara la línea base. Códigos de salida: 0 bien,
+ * 1 error, 2 regresión de rendimiento.
+ */
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "Uso: " << argv[0] << " <subcomando> [-n registros] [-r repeticiones] [-f bitacora.txt] [-c]\n"
+             << "       [--paginas normales|thp|hugetlb] [--guardar-base [archivo]] [--comparar [archivo]]\n"
+             << "       [--umbral pct]\n";
+        cerr << "Subcomandos:";
+        for (const Subcomando& s : SUBCOMANDOS) cerr << " " << s.nombre;
+        cerr << "\n";
+        return 1;
+    }
+    Opciones op;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc) {
+            if (!leerTamanos(argv[++i], op.tamanos)) {
+                cerr << "-n espera registros > 0 con sufijo K/M opcional, separados por comas: " << argv[i] << "\n";
+                return 1;
+            }
+            op.registros = op.tamanos[0];
+        }
+        else if (arg == "-r" && i + 1 < argc) {
+            long r = 0;
+            if (!leerEntero(argv[++i], 1, r)) {
+                cerr << "-r espera un número de repeticiones (1 a 1000000): " << argv[i] << "\n";
+                return 1;
+            }
+            op.repeticiones = (int)r;
+        }
+        else if (arg == "-f" && i + 1 < argc) op.archivo = argv[++i];
+        else if (arg == "-c") op.contadores = true;
+        else if (arg == "--paginas" && i + 1 < argc) {
+            TipoPaginas tipo;
+            if (!leerTipoPaginas(argv[++i], tipo)) {
+                cerr << "Tipo de páginas desconocido: " << argv[i] << " (normales, thp o hugetlb)\n";
+                return 1;
+            }
+            fijarPoliticaPaginas(tipo);
+        }
+        else if (arg == "--guardar-base" || arg == "--comparar") {
+            string ruta = i + 1 < argc && argv[i + 1][0] != '-' ? argv[++i] : "";
+            (arg == "--comparar" ? op.compararBase : op.guardarBase) = archivoBase(ruta);
+        } else if (arg == "--umbral" && i + 1 < argc) {
+            if (!leerReal(argv[++i], op.umbral)) {
+                cerr << "--umbral espera un porcentaje >= 0: " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else {
+            cerr << "Opción desconocida: " << arg << "\n";
+            return 1;
+        }
+    }
+    if (op.contadores && !ContadoresHw::global().abrir())
+        cerr << "Aviso: contadores de hardware no disponibles (" << ContadoresHw::global().error() << ")\n";
+    for (const Subcomando& s : SUBCOMANDOS) {
+        if (argv[1] != string(s.nombre)) continue;
+        int codigo = s.correr(op);
+        if (codigo != 0) return codigo;
+        if (!op.compararBase.empty()) {
+            int regresiones = compararBase(op.compararBase, op.umbral);
+            if (regresiones < 0) return 1;
+            if (regresiones > 0) return 2;
+        }
+        if (!op.guardarBase.empty() && !guardarBase(op.guardarBase)) return 1;
+        return 0;
+    }
+    cerr << "Subcomando desconocido: " << argv[1] << "\n";
+    return 1;
+}
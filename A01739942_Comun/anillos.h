@@ -0,0 +1,178 @@
+/*
+    Descripción: Colas circulares acotadas sin candados para pasar trabajo
+    entre hilos (p.ej. las etapas de tuberia.h).
+
+        AnilloSpsc  un productor y un consumidor: cada índice lo escribe un
+                    solo hilo, basta con load/store acquire-release.
+        AnilloMpmc  varios productores y varios consumidores (cola de
+                    Vyukov): cada casilla lleva un número de secuencia que
+                    dice si está libre o llena para la vuelta actual.
+
+    Ninguna bloquea: intentarMeter/intentarSacar devuelven false si la cola
+    está llena/vacía y el que llama decide si espera (esperarTurno) o hace
+    otra cosa. La capacidad se redondea a potencia de 2.
+*/
+
+#ifndef COMUN_ANILLOS_H
+#define COMUN_ANILLOS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace comun {
+
+// ---------------- 1. ESPERA ----------------
+
+/*
+ * 1.1 esperarTurno
+ * Espera activa corta con pause y, si se alarga, cede el CPU (con menos
+ * núcleos que hilos, girar sin ceder solo retrasa al que debe avanzar).
+ *     unsigned intentos = 0;
+ *     while (!cola.intentarSacar(x)) esperarTurno(intentos);
+ */
+inline void esperarTurno(unsigned& intentos) {
+    if (++intentos < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#endif
+    } else {
+        std::this_thread::yield();
+    }
+}
+
+inline size_t potenciaDe2(size_t n) {
+    size_t p = 2;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+// ---------------- 2. UN PRODUCTOR, UN CONSUMIDOR ----------------
+
+/*
+ * 2.1 AnilloSpsc
+ * 'cola' solo la escribe el productor y 'cabeza' solo el consumidor; cada
+ * uno guarda una copia del índice del otro para no leer la línea de caché
+ * compartida en cada operación.
+ * Complejidad: O(1) por operación.
+ */
+template <class T>
+class AnilloSpsc {
+public:
+    explicit AnilloSpsc(size_t capacidad)
+        : mascara(potenciaDe2(capacidad) - 1), casillas(new T[mascara + 1]) {}
+
+    bool intentarMeter(T valor) {
+        size_t c = cola.load(std::memory_order_relaxed);
+        if (c - cabezaVista > mascara) {
+            cabezaVista = cabeza.load(std::memory_order_acquire);
+            if (c - cabezaVista > mascara) return false;
+        }
+        casillas[c & mascara] = std::move(valor);
+        cola.store(c + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool intentarSacar(T& valor) {
+        size_t h = cabeza.load(std::memory_order_relaxed);
+        if (h == colaVista) {
+            colaVista = cola.load(std::memory_order_acquire);
+            if (h == colaVista) return false;
+        }
+        valor = std::move(casillas[h & mascara]);
+        cabeza.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacidad() const { return mascara + 1; }
+
+private:
+    const size_t mascara;
+    std::unique_ptr<T[]> casillas;
+    alignas(64) std::atomic<size_t> cabeza{0};
+    size_t colaVista = 0;               // del consumidor
+    alignas(64) std::atomic<size_t> cola{0};
+    size_t cabezaVista = 0;             // del productor
+};
+
+// ---------------- 3. VARIOS PRODUCTORES Y CONSUMIDORES ----------------
+
+/*
+ * 3.1 AnilloMpmc
+ * La casilla i está libre para el productor de la posición p cuando su
+ * secuencia vale p, y llena para el consumidor cuando vale p + 1. Cada
+ * lado reserva su posición con un CAS sobre su índice.
+ * Complejidad: O(1) por operación sin contención.
+ */
+template <class T>
+class AnilloMpmc {
+public:
+    explicit AnilloMpmc(size_t capacidad)
+        : mascara(potenciaDe2(capacidad) - 1), casillas(new Casilla[mascara + 1]) {
+        for (size_t i = 0; i <= mascara; i++) casillas[i].secuencia.store(i, std::memory_order_relaxed);
+    }
+
+    bool intentarMeter(T valor) {
+        size_t pos = cola.load(std::memory_order_relaxed);
+        for (;;) {
+            Casilla& c = casillas[pos & mascara];
+            size_t sec = c.secuencia.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)sec - (intptr_t)pos;
+            if (dif == 0) {
+                if (cola.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.valor = std::move(valor);
+                    c.secuencia.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false;       // llena
+            } else {
+                pos = cola.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool intentarSacar(T& valor) {
+        size_t pos = cabeza.load(std::memory_order_relaxed);
+        for (;;) {
+            Casilla& c = casillas[pos & mascara];
+            size_t sec = c.secuencia.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)sec - (intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (cabeza.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    valor = std::move(c.valor);
+                    c.secuencia.store(pos + mascara + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false;       // vacía
+            } else {
+                pos = cabeza.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t capacidad() const { return mascara + 1; }
+
+private:
+    struct alignas(64) Casilla {
+        std::atomic<size_t> secuencia;
+        T valor;
+    };
+
+    const size_t mascara;
+    std::unique_ptr<Casilla[]> casillas;
+    alignas(64) std::atomic<size_t> cabeza{0};
+    alignas(64) std::atomic<size_t> cola{0};
+};
+
+} // namespace comun
+
+#endif
@@ -0,0 +1,279 @@
+/*
+    Descripción: Perfil de asignaciones de memoria (operator new/delete).
+    Cuenta asignaciones, bytes pedidos y bytes vivos; el reporte de --stats
+    los desglosa por etapa (y por línea de la bitácora) y lista los sitios
+    de llamada que más asignan.
+
+    Es opcional en tiempo de compilación: solo se reemplaza el operator new
+    global si se compila con -DPERFILAR_ASIGNACIONES (y conviene -rdynamic
+    para que los sitios salgan con nombre de función):
+        g++ -O2 -std=c++17 -DPERFILAR_ASIGNACIONES -rdynamic main.cpp
+    Sin la macro este archivo no cambia nada y todos los contadores valen 0.
+    Como define el operator new global, con la macro debe incluirse en una
+    sola unidad de compilación (todos los programas de este repo son una).
+
+    Sitios: 1 de cada MUESTREO asignaciones guarda su pila (backtrace) en
+    una tabla fija; el reporte estima el total multiplicando por MUESTREO.
+*/
+
+#ifndef COMUN_ASIGNACIONES_H
+#define COMUN_ASIGNACIONES_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef PERFILAR_ASIGNACIONES
+#include <cxxabi.h>
+#include <execinfo.h>
+#endif
+
+namespace comun {
+
+// ---------------- 1. CONTADORES ----------------
+
+#ifdef PERFILAR_ASIGNACIONES
+const bool PERFILANDO_ASIGNACIONES = true;
+#else
+const bool PERFILANDO_ASIGNACIONES = false;
+#endif
+
+/*
+ * 1.1 ContadoresAsignacion
+ * Totales del proceso (todos los hilos). relaxed: solo se necesitan sumas
+ * correctas, no orden entre hilos.
+ */
+struct ContadoresAsignacion {
+    std::atomic<uint64_t> asignaciones{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<int64_t> vivos{0};
+    std::atomic<int64_t> picoVivos{0};
+
+    void sumar(size_t n) {
+        asignaciones.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(n, std::memory_order_relaxed);
+        int64_t v = vivos.fetch_add((int64_t)n, std::memory_order_relaxed) + (int64_t)n;
+        int64_t p = picoVivos.load(std::memory_order_relaxed);
+        while (v > p && !picoVivos.compare_exchange_weak(p, v, std::memory_order_relaxed)) {}
+    }
+
+    void restar(size_t n) { vivos.fetch_sub((int64_t)n, std::memory_order_relaxed); }
+};
+
+inline ContadoresAsignacion asignacionesGlobales;
+
+// ---------------- 2. SITIOS DE LLAMADA ----------------
+
+/*
+ * 2.1 TablaSitios
+ * Tabla hash fija (direccionamiento abierto) de pilas muestreadas.
+ * Protegida con un spinlock: solo se toca en 1 de cada MUESTREO
+ * asignaciones.
+ */
+class TablaSitios {
+public:
+    static const int PROFUNDIDAD = 10;
+    static const int CAPACIDAD = 4096;
+    static const uint32_t MUESTREO = 16;
+
+    struct Sitio {
+        void* pila[PROFUNDIDAD];
+        int marcos = 0;
+        uint64_t muestras = 0, bytes = 0;
+    };
+
+    void agregar(void* const* pila, int marcos, size_t n) {
+        uint64_t h = 1469598103934665603ull;
+        for (int i = 0; i < marcos; i++) h = (h ^ (uint64_t)(uintptr_t)pila[i]) * 1099511628211ull;
+        while (candado.test_and_set(std::memory_order_acquire)) {}
+        for (int k = 0; k < CAPACIDAD; k++) {
+            Sitio& s = sitios[(h + (uint64_t)k) % CAPACIDAD];
+            if (s.marcos == 0) {
+                std::memcpy(s.pila, pila, sizeof(void*) * (size_t)marcos);
+                s.marcos = marcos;
+            } else if (s.marcos != marcos || std::memcmp(s.pila, pila, sizeof(void*) * (size_t)marcos) != 0) {
+                continue;
+            }
+            s.muestras++;
+            s.bytes += n;
+            break;
+        }
+        candado.clear(std::memory_order_release);
+    }
+
+    /*
+     * mayores
+     * Los k sitios con más muestras.
+     */
+    std::vector<const Sitio*> mayores(size_t k) const {
+        std::vector<const Sitio*> v;
+        for (const Sitio& s : sitios)
+            if (s.marcos > 0) v.push_back(&s);
+        size_t m = std::min(k, v.size());
+        std::partial_sort(v.begin(), v.begin() + (long)m, v.end(),
+                          [](const Sitio* a, const Sitio* b) { return a->muestras > b->muestras; });
+        v.resize(m);
+        return v;
+    }
+
+private:
+    Sitio sitios[CAPACIDAD];
+    std::atomic_flag candado = ATOMIC_FLAG_INIT;
+};
+
+#ifdef PERFILAR_ASIGNACIONES
+inline TablaSitios sitiosAsignacion;
+#endif
+
+/*
+ * 2.2 describirSitio
+ * Convierte la pila en "f1 <- f2 <- f3" saltando los marcos del propio
+ * perfilador, operator new, la biblioteca estándar (std::, __gnu_cxx::) y
+ * libc, para que el primer nombre sea el código del programa que pidió
+ * memoria. Los marcos sin símbolo (código en línea) salen como
+ * "binario+0xdesplazamiento", que se resuelve con addr2line -f -C -i -e
+ * (compilando también con -g).
+ */
+inline std::string describirSitio(const TablaSitios::Sitio& s) {
+    std::string r;
+#ifdef PERFILAR_ASIGNACIONES
+    char** simbolos = backtrace_symbols(s.pila, s.marcos);
+    if (!simbolos) return r;
+    int mostrados = 0;
+    for (int i = 0; i < s.marcos && mostrados < 3; i++) {
+        // formato: "binario(simbolo+0x1f) [0x...]"
+        std::string linea = simbolos[i], nombre;
+        size_t a = linea.find('('), b = linea.find('+', a == std::string::npos ? 0 : a);
+        if (a != std::string::npos && b != std::string::npos && b > a + 1) {
+            std::string crudo = linea.substr(a + 1, b - a - 1);
+            int estado = 0;
+            char* d = abi::__cxa_demangle(crudo.c_str(), nullptr, nullptr, &estado);
+            nombre = estado == 0 && d ? d : crudo;
+            std::free(d);
+        } else if (a != std::string::npos && b == a + 1) {
+            size_t barra = linea.rfind('/', a);
+            size_t fin = linea.find(')', b);
+            nombre = linea.substr(barra == std::string::npos ? 0 : barra + 1, a - (barra == std::string::npos ? 0 : barra + 1)) +
+                     linea.substr(b, fin == std::string::npos ? std::string::npos : fin - b);
+        } else {
+            nombre = linea;
+        }
+        size_t estandar = nombre.find(" std::");   // "void std::vector<...>::..."
+        if (estandar != std::string::npos && estandar > nombre.find('<')) estandar = std::string::npos;
+        if (nombre.find("operator new") != std::string::npos || nombre.find("std::") == 0 ||
+            estandar != std::string::npos ||
+            nombre.find("__gnu_cxx::") == 0 || nombre.find("comun::registrarAsignacion") == 0 ||
+            nombre.find("comun::asignarConEncabezado") == 0 ||
+            nombre.find("libc.so") != std::string::npos || nombre.find("libstdc++.so") != std::string::npos || nombre.find("__libc_start") == 0 || nombre == "_start")
+            continue;
+        size_t paren = nombre.find('(');
+        if (paren != std::string::npos && paren > 0) nombre = nombre.substr(0, paren);
+        if (mostrados++) r += " <- ";
+        r += nombre;
+    }
+    std::free(simbolos);
+#else
+    (void)s;
+#endif
+    return r;
+}
+
+// ---------------- 3. GANCHO DE operator new ----------------
+
+#ifdef PERFILAR_ASIGNACIONES
+
+/*
+ * 3.1 registrarAsignacion
+ * Suma a los contadores y, 1 de cada MUESTREO veces por hilo, guarda la
+ * pila. 'dentro' evita la recursión si backtrace asigna memoria.
+ */
+inline void registrarAsignacion(size_t n) {
+    asignacionesGlobales.sumar(n);
+    thread_local uint32_t cuenta = 0;
+    thread_local bool dentro = false;
+    if (dentro || ++cuenta % TablaSitios::MUESTREO != 0) return;
+    dentro = true;
+    // Se guardan todos los marcos: con inlining no se sabe cuántos son del
+    // propio perfilador; describirSitio los descarta por nombre.
+    void* pila[TablaSitios::PROFUNDIDAD];
+    int marcos = backtrace(pila, TablaSitios::PROFUNDIDAD);
+    if (marcos > 0) sitiosAsignacion.agregar(pila, marcos, n);
+    dentro = false;
+}
+
+/*
+ * 3.2 Bloques con encabezado
+ * El bloque real empieza con un Encabezado (tamaño pedido, para restarlo
+ * de los bytes vivos en delete) y el puntero del usuario va 'enc' bytes
+ * después, con enc = la alineación pedida (al menos la de new), para no
+ * romperla. Al liberar, la base se recupera con la misma alineación (los
+ * delete alineados la reciben) y se libera la base, no el puntero del
+ * usuario. La aritmética va por uintptr_t: así el compilador no ve
+ * índices negativos sobre el objeto del usuario ni un free de un puntero
+ * que salió de new (-Warray-bounds, -Wmismatched-new-delete).
+ */
+struct Encabezado {
+    size_t bytes;
+};
+
+inline size_t tamEncabezado(size_t alineacion) {
+    return std::max(alineacion, (size_t)__STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+inline void* asignarConEncabezado(size_t n, size_t alineacion) {
+    size_t enc = tamEncabezado(alineacion);
+    void* base = alineacion <= __STDCPP_DEFAULT_NEW_ALIGNMENT__
+                     ? std::malloc(n + enc)
+                     : std::aligned_alloc(enc, (n + enc + enc - 1) / enc * enc);
+    if (!base) return nullptr;
+    static_cast<Encabezado*>(base)->bytes = n;
+    registrarAsignacion(n);
+    return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(base) + enc);
+}
+
+inline void liberarConEncabezado(void* p, size_t alineacion) {
+    if (!p) return;
+    void* base = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(p) - tamEncabezado(alineacion));
+    asignacionesGlobales.restar(static_cast<Encabezado*>(base)->bytes);
+    std::free(base);
+}
+
+#endif
+
+} // namespace comun
+
+#ifdef PERFILAR_ASIGNACIONES
+
+void* operator new(size_t n) {
+    void* p = comun::asignarConEncabezado(n, 0);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t n) { return operator new(n); }
+void* operator new(size_t n, std::align_val_t a) {
+    void* p = comun::asignarConEncabezado(n, (size_t)a);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t n, std::align_val_t a) { return operator new(n, a); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept { return comun::asignarConEncabezado(n, 0); }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { return comun::asignarConEncabezado(n, 0); }
+
+void operator delete(void* p) noexcept { comun::liberarConEncabezado(p, 0); }
+void operator delete[](void* p) noexcept { comun::liberarConEncabezado(p, 0); }
+void operator delete(void* p, size_t) noexcept { comun::liberarConEncabezado(p, 0); }
+void operator delete[](void* p, size_t) noexcept { comun::liberarConEncabezado(p, 0); }
+void operator delete(void* p, std::align_val_t a) noexcept { comun::liberarConEncabezado(p, (size_t)a); }
+void operator delete[](void* p, std::align_val_t a) noexcept { comun::liberarConEncabezado(p, (size_t)a); }
+void operator delete(void* p, size_t, std::align_val_t a) noexcept { comun::liberarConEncabezado(p, (size_t)a); }
+void operator delete[](void* p, size_t, std::align_val_t a) noexcept { comun::liberarConEncabezado(p, (size_t)a); }
+
+#endif
+
+#endif
@@ -0,0 +1,503 @@
+/*
+    Descripción: Almacenamiento comprimido por bloques y columnas de la
+    bitácora ya parseada, para guardar historia larga en mucho menos espacio
+    que el texto (~59 bytes por línea) y volver a cargarla sin parsear.
+
+    Los registros se ordenan por tiempo y se cortan en bloques de
+    RENGLONES renglones. Cada bloque guarda cada columna por separado:
+
+        tiempo  primer valor en el directorio; después el primer delta y las
+                diferencias entre deltas consecutivos (delta de delta) en
+                varint zigzag. En orden de tiempo casi todas caben en 1-2 bytes.
+        ip      marco de referencia: ipMin del bloque en el directorio y
+                cada ip - ipMin con el mínimo de bits que alcanza.
+        puerto  igual, puerto - puertoMin (a lo más 16 bits).
+        razon   el id con los bits del id más grande (3 bits hasta 8
+                razones distintas).
+
+    Los valores empacados van en 8 carriles intercalados (el valor i en el
+    carril i % 8): los 8 valores de un grupo empiezan en el mismo bit de 8
+    palabras consecutivas, así que AVX2 desempaca un grupo con un
+    desplazamiento, un OR y una máscara (SSE2 en dos mitades). El nivel se
+    elige como en filtros_simd.h.
+
+    El directorio guarda por bloque su desplazamiento y el mínimo y máximo
+    de tiempo e ip (mapa de zonas): un rango de tiempo se resuelve con dos
+    búsquedas binarias y solo se descomprimen los bloques que lo tocan.
+
+    Archivo (bitacora.txt.col): encabezado de filtro_ip.h con firma
+    COLUMNA2 (tiempo desde el año base, registro.h), textos de las razones,
+    directorio y datos de los bloques.
+*/
+
+#ifndef COMUN_COLUMNAR_H
+#define COMUN_COLUMNAR_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "filtro_ip.h"
+#include "filtros_simd.h"
+#include "hilos.h"
+#include "registro.h"
+
+namespace comun {
+
+// ---------------- 1. ENTEROS DE LARGO VARIABLE ----------------
+
+/*
+ * 1.1 zigzag / deshacerZigzag
+ * Lleva enteros con signo a sin signo intercalando: 0, -1, 1, -2 ... ->
+ * 0, 1, 2, 3 ..., para que los negativos pequeños también sean varints cortos.
+ */
+inline uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+inline int64_t deshacerZigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+/*
+ * 1.2 escribirVarint / leerVarint
+ * 7 bits por byte, el bit alto indica que sigue otro byte. leerVarint no
+ * pasa de fin ni de 10 bytes (64 bits): devuelve false si el varint está
+ * truncado o es demasiado largo.
+ * Complejidad: O(bytes).
+ */
+inline void escribirVarint(uint64_t v, std::vector<uint8_t>& out) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+inline bool leerVarint(const uint8_t*& p, const uint8_t* fin, uint64_t& v) {
+    v = 0;
+    for (int s = 0; p < fin && s < 64; s += 7) {
+        uint8_t b = *p++;
+        v |= (uint64_t)(b & 0x7F) << s;
+        if (b < 0x80) return true;
+    }
+    return false;
+}
+
+// ---------------- 2. EMPAQUE DE BITS ----------------
+
+/*
+ * 2.1 bitsPara
+ * Bits necesarios para representar x (0 para x = 0).
+ */
+inline int bitsPara(uint32_t x) { return x == 0 ? 0 : 32 - __builtin_clz(x); }
+
+/*
+ * 2.2 palabrasEmpacadas
+ * Palabras de 32 bits que ocupan n valores de w bits en 8 carriles.
+ */
+inline size_t palabrasEmpacadas(size_t n, int w) {
+    size_t grupos = (n + 7) / 8;
+    return 8 * ((grupos * (size_t)w + 31) / 32);
+}
+
+/*
+ * 2.3 empacar
+ * Agrega a out los n valores v[i] - base con w bits cada uno. El carril l
+ * es un flujo de bits en las palabras l, l+8, l+16, ...; el grupo g (valores
+ * 8g..8g+7) empieza en el bit g*w de su carril. El último grupo se rellena
+ * con ceros.
+ * Complejidad: O(n).
+ */
+inline void empacar(const uint32_t* v, size_t n, int w, uint32_t base, std::vector<uint8_t>& out) {
+    std::vector<uint32_t> palabras(palabrasEmpacadas(n, w), 0);
+    for (size_t i = 0; w > 0 && i < n; i++) {
+        uint32_t x = v[i] - base;
+        size_t bit = i / 8 * (size_t)w, k = bit / 32, l = i % 8;
+        int s = (int)(bit % 32);
+        palabras[8 * k + l] |= x << s;
+        if (s + w > 32) palabras[8 * (k + 1) + l] |= x >> (32 - s);
+    }
+    size_t inicio = out.size();
+    out.resize(inicio + palabras.size() * 4);
+    if (!palabras.empty()) std::memcpy(out.data() + inicio, palabras.data(), palabras.size() * 4);
+}
+
+/*
+ * 2.4 desempacarEscalar
+ * Valores [ini, n) de vuelta a 32 bits (out[i] = valor + base).
+ */
+inline void desempacarEscalar(const uint8_t* datos, size_t ini, size_t n, int w, uint32_t base, uint32_t* out) {
+    uint32_t mascara = w == 32 ? 0xFFFFFFFFu : (1u << w) - 1;
+    for (size_t i = ini; i < n; i++) {
+        if (w == 0) {
+            out[i] = base;
+            continue;
+        }
+        size_t bit = i / 8 * (size_t)w, k = bit / 32, l = i % 8;
+        int s = (int)(bit % 32);
+        uint32_t lo, hi;
+        std::memcpy(&lo, datos + 4 * (8 * k + l), 4);
+        uint32_t x = lo >> s;
+        if (s + w > 32) {
+            std::memcpy(&hi, datos + 4 * (8 * (k + 1) + l), 4);
+            x |= hi << (32 - s);
+        }
+        out[i] = (x & mascara) + base;
+    }
+}
+
+#ifdef COMUN_X86
+/*
+ * 2.5 Versiones SIMD
+ * Un grupo completo por iteración; el grupo incompleto del final (si lo
+ * hay) lo termina la versión escalar.
+ */
+inline void desempacarSse2(const uint8_t* datos, size_t n, int w, uint32_t base, uint32_t* out) {
+    size_t grupos = w == 0 ? 0 : n / 8;
+    const __m128i vbase = _mm_set1_epi32((int)base);
+    const __m128i mascara = _mm_set1_epi32((int)(w == 32 ? 0xFFFFFFFFu : (1u << w) - 1));
+    const __m128i* p = (const __m128i*)datos;
+    for (size_t g = 0; g < grupos; g++) {
+        size_t bit = g * (size_t)w, k = bit / 32;
+        int s = (int)(bit % 32);
+        __m128i cuenta = _mm_cvtsi32_si128(s), resto = _mm_cvtsi32_si128(32 - s);
+        for (int mitad = 0; mitad < 2; mitad++) {
+            __m128i v = _mm_srl_epi32(_mm_loadu_si128(p + 2 * k + mitad), cuenta);
+            if (s + w > 32) v = _mm_or_si128(v, _mm_sll_epi32(_mm_loadu_si128(p + 2 * (k + 1) + mitad), resto));
+            _mm_storeu_si128((__m128i*)(out + 8 * g + 4 * mitad), _mm_add_epi32(_mm_and_si128(v, mascara), vbase));
+        }
+    }
+    desempacarEscalar(datos, grupos * 8, n, w, base, out);
+}
+
+__attribute__((target("avx2")))
+inline void desempacarAvx2(const uint8_t* datos, size_t n, int w, uint32_t base, uint32_t* out) {
+    size_t grupos = w == 0 ? 0 : n / 8;
+    const __m256i vbase = _mm256_set1_epi32((int)base);
+    const __m256i mascara = _mm256_set1_epi32((int)(w == 32 ? 0xFFFFFFFFu : (1u << w) - 1));
+    const __m256i* p = (const __m256i*)datos;
+    for (size_t g = 0; g < grupos; g++) {
+        size_t bit = g * (size_t)w, k = bit / 32;
+        int s = (int)(bit % 32);
+        __m256i v = _mm256_srl_epi32(_mm256_loadu_si256(p + k), _mm_cvtsi32_si128(s));
+        if (s + w > 32)
+            v = _mm256_or_si256(v, _mm256_sll_epi32(_mm256_loadu_si256(p + k + 1), _mm_cvtsi32_si128(32 - s)));
+        _mm256_storeu_si256((__m256i*)(out + 8 * g), _mm256_add_epi32(_mm256_and_si256(v, mascara), vbase));
+    }
+    desempacarEscalar(datos, grupos * 8, n, w, base, out);
+}
+#endif
+
+/*
+ * 2.6 desempacar
+ * n valores de w bits a out[0..n), con la versión del nivel SIMD activo.
+ * Complejidad: O(n).
+ */
+inline void desempacar(const uint8_t* datos, size_t n, int w, uint32_t base, uint32_t* out) {
+#ifdef COMUN_X86
+    switch (nivelSimd()) {
+    case SIMD_AVX2: desempacarAvx2(datos, n, w, base, out); return;
+    case SIMD_SSE2: desempacarSse2(datos, n, w, base, out); return;
+    default: break;
+    }
+#endif
+    desempacarEscalar(datos, 0, n, w, base, out);
+}
+
+// ---------------- 3. BITÁCORA COLUMNAR ----------------
+
+/*
+ * 3.1 ZonaBloque
+ * Entrada del directorio: dónde está el bloque y qué valores contiene.
+ * Se guarda tal cual en el archivo (40 bytes).
+ */
+struct ZonaBloque {
+    uint64_t inicio;            // desplazamiento en los datos
+    uint32_t bytes;
+    uint32_t n;                 // renglones (RENGLONES salvo el último)
+    uint32_t tMin, tMax;
+    uint32_t ipMin, ipMax;
+    uint16_t puertoMin;
+    uint8_t bitsIp, bitsPuerto, bitsRazon;
+    uint8_t relleno[3];
+};
+
+class BitacoraColumnar {
+public:
+    static constexpr size_t RENGLONES = 4096;   // múltiplo de 8
+
+    size_t size() const { return total; }
+    size_t bloques() const { return zonas.size(); }
+    const ZonaBloque& zona(size_t b) const { return zonas[b]; }
+
+    // bytes de datos y directorio (lo que ocupa el archivo, sin encabezado)
+    size_t bytes() const { return datos.size() + zonas.size() * sizeof(ZonaBloque); }
+
+    /*
+     * 3.2 comprimir
+     * Ordena la tabla por tiempo (estable, sin copiarla si ya está en orden)
+     * y comprime los bloques en paralelo; luego los concatena.
+     * Complejidad: O(n log n) si hay que ordenar, O(n) si no.
+     */
+    void comprimir(const TablaRegistros& t) {
+        total = t.size();
+        razones.clear();
+        for (int i = 0; i < t.razones.size(); i++) razones.push_back(t.razones.texto(i));
+        const uint32_t* tiempo = t.tiempo.data();
+        const uint32_t* ip = t.ip.data();
+        const uint16_t* puerto = t.puerto.data();
+        const uint8_t* razon = t.razon.data();
+        TablaRegistros ordenada;
+        if (!std::is_sorted(t.tiempo.begin(), t.tiempo.end())) {
+            std::vector<uint32_t> orden(total);
+            std::iota(orden.begin(), orden.end(), 0u);
+            std::stable_sort(orden.begin(), orden.end(),
+                             [&](uint32_t a, uint32_t b) { return t.tiempo[a] < t.tiempo[b]; });
+            ordenada.reservar(total);
+            for (uint32_t i : orden) ordenada.agregar({t.tiempo[i], t.ip[i], t.puerto[i], t.razon[i]});
+            tiempo = ordenada.tiempo.data();
+            ip = ordenada.ip.data();
+            puerto = ordenada.puerto.data();
+            razon = ordenada.razon.data();
+        }
+
+        size_t nb = (total + RENGLONES - 1) / RENGLONES;
+        zonas.assign(nb, ZonaBloque{});
+        std::vector<std::vector<uint8_t>> partes(nb);
+        paraleloPara(0, nb, 4, [&](size_t a, size_t b) {
+            for (size_t k = a; k < b; k++) {
+                size_t ini = k * RENGLONES, n = std::min(RENGLONES, total - ini);
+                comprimirBloque(tiempo + ini, ip + ini, puerto + ini, razon + ini, n, zonas[k], partes[k]);
+            }
+        });
+        datos.clear();
+        for (size_t k = 0; k < nb; k++) {
+            zonas[k].inicio = datos.size();
+            datos.insert(datos.end(), partes[k].begin(), partes[k].end());
+        }
+    }
+
+    /*
+     * 3.3 descomprimirBloque
+     * Escribe los renglones del bloque b en tiempo/ip/puerto/razon[0..n) y
+     * devuelve n. Cada bloque es independiente (acceso aleatorio).
+     * Complejidad: O(RENGLONES).
+     */
+    size_t descomprimirBloque(size_t b, uint32_t* tiempo, uint32_t* ip, uint16_t* puerto, uint8_t* razon) const {
+        const ZonaBloque& z = zonas[b];
+        size_t n = z.n;
+        const uint8_t* p = leerTiempos(z, tiempo);
+
+        desempacar(p, n, z.bitsIp, z.ipMin, ip);
+        p += palabrasEmpacadas(n, z.bitsIp) * 4;
+        uint32_t temp[RENGLONES];
+        desempacar(p, n, z.bitsPuerto, z.puertoMin, temp);
+        for (size_t i = 0; i < n; i++) puerto[i] = (uint16_t)temp[i];
+        p += palabrasEmpacadas(n, z.bitsPuerto) * 4;
+        desempacar(p, n, z.bitsRazon, 0, temp);
+        for (size_t i = 0; i < n; i++) razon[i] = (uint8_t)temp[i];
+        return n;
+    }
+
+    /*
+     * 3.4 descomprimir
+     * Llena t (vacía) con todos los registros, en orden de tiempo. Los
+     * bloques se descomprimen en paralelo directo sobre las columnas.
+     * Complejidad: O(n).
+     */
+    void descomprimir(TablaRegistros& t) const {
+        for (const std::string& r : razones) t.razones.idDe(r);
+        t.reservar(total);
+        t.tiempo.resize(total);
+        t.ip.resize(total);
+        t.puerto.resize(total);
+        t.razon.resize(total);
+        paraleloPara(0, zonas.size(), 4, [&](size_t a, size_t b) {
+            for (size_t k = a; k < b; k++) {
+                size_t ini = k * RENGLONES;
+                descomprimirBloque(k, &t.tiempo[ini], &t.ip[ini], &t.puerto[ini], &t.razon[ini]);
+            }
+        });
+    }
+
+    /*
+     * 3.5 bloquesEnTiempo
+     * Rango [primero, ultimo) de bloques que pueden tener tiempos en
+     * [lo, hi]. Los bloques están en orden de tiempo, así que tMin y tMax
+     * son no decrecientes.
+     * Complejidad: O(log bloques).
+     */
+    std::pair<size_t, size_t> bloquesEnTiempo(uint32_t lo, uint32_t hi) const {
+        auto primero = std::partition_point(zonas.begin(), zonas.end(),
+                                            [&](const ZonaBloque& z) { return z.tMax < lo; });
+        auto ultimo = std::partition_point(primero, zonas.end(),
+                                           [&](const ZonaBloque& z) { return z.tMin <= hi; });
+        return {(size_t)(primero - zonas.begin()), (size_t)(ultimo - zonas.begin())};
+    }
+
+    /*
+     * 3.6 guardar / cargar
+     * Parámetros del encabezado: renglones, bloques, bytes de datos,
+     * número de razones y si los años se infirieron (--cambio-anio): un
+     * archivo guardado con la otra opción tiene otras claves y no se carga.
+     * Las razones van como largo (uint16) + texto.
+     */
+    bool guardar(const std::string& ruta) const {
+        std::vector<uint8_t> cuerpo;
+        for (const std::string& r : razones) {
+            uint16_t largo = (uint16_t)std::min<size_t>(r.size(), 0xFFFF);
+            cuerpo.push_back((uint8_t)largo);
+            cuerpo.push_back((uint8_t)(largo >> 8));
+            cuerpo.insert(cuerpo.end(), r.begin(), r.begin() + largo);
+        }
+        const uint8_t* dir = (const uint8_t*)zonas.data();
+        cuerpo.insert(cuerpo.end(), dir, dir + zonas.size() * sizeof(ZonaBloque));
+        cuerpo.insert(cuerpo.end(), datos.begin(), datos.end());
+        uint64_t anios = Calendario::global().cambioAnio;
+        return escribirArchivo(ruta, FIRMA, {total, zonas.size(), datos.size(), razones.size(), anios}, cuerpo.data(),
+                               cuerpo.size());
+    }
+
+    bool cargar(const std::string& ruta) {
+        std::ifstream in(ruta, std::ios::binary);
+        std::vector<uint64_t> params;
+        if (!in.is_open() || !leerEncabezado(in, FIRMA, params) || params.size() != 5) return false;
+        if (params[4] != (uint64_t)Calendario::global().cambioAnio) return false;
+        if (params[3] > (uint64_t)DiccionarioRazones::MAX_RAZONES) return false;
+        total = params[0];
+        razones.assign(params[3], std::string());
+        for (std::string& r : razones) {
+            uint8_t largo[2];
+            if (!in.read((char*)largo, 2)) return false;
+            r.resize((size_t)largo[0] | (size_t)largo[1] << 8);
+            if (!in.read(&r[0], (std::streamsize)r.size())) return false;
+        }
+        // los tamaños del encabezado no pueden pasar de lo que queda del archivo
+        std::streampos aqui = in.tellg();
+        in.seekg(0, std::ios::end);
+        uint64_t resto = (uint64_t)(in.tellg() - aqui);
+        in.seekg(aqui);
+        if (params[1] > resto / sizeof(ZonaBloque) || params[2] > resto - params[1] * sizeof(ZonaBloque)) return false;
+        zonas.assign(params[1], ZonaBloque{});
+        datos.resize(params[2]);
+        if (!in.read((char*)zonas.data(), (std::streamsize)(zonas.size() * sizeof(ZonaBloque))) ||
+            !in.read((char*)datos.data(), (std::streamsize)datos.size()))
+            return false;
+        // el directorio debe cuadrar con los datos antes de confiar en él
+        size_t renglones = 0;
+        for (size_t k = 0; k < zonas.size(); k++) {
+            bool ultimo = k + 1 == zonas.size();
+            if (!bloqueValido(zonas[k], ultimo)) return false;
+            renglones += zonas[k].n;
+        }
+        return renglones == total;
+    }
+
+private:
+    static constexpr char FIRMA[8] = {'C', 'O', 'L', 'U', 'M', 'N', 'A', '2'};
+
+    size_t total = 0;
+    std::vector<std::string> razones;
+    std::vector<ZonaBloque> zonas;
+    std::vector<uint8_t> datos;
+
+    static size_t alinear4(size_t x) { return (x + 3) & ~(size_t)3; }
+
+    /*
+     * leerTiempos
+     * Reconstruye los tiempos del bloque z (n >= 1) y devuelve dónde
+     * empiezan las columnas empacadas, o nullptr si los varints no caben en
+     * el bloque o dan tiempos fuera de orden o de rango (sin desbordar:
+     * cada paso se revisa en 64 bits antes de sumarlo).
+     */
+    const uint8_t* leerTiempos(const ZonaBloque& z, uint32_t* tiempo) const {
+        const uint8_t* ini = datos.data() + z.inicio;
+        const uint8_t* fin = ini + z.bytes;
+        const uint8_t* p = ini;
+        tiempo[0] = z.tMin;
+        int64_t delta = 0;
+        for (size_t i = 1; i < z.n; i++) {
+            uint64_t v;
+            if (!leerVarint(p, fin, v)) return nullptr;
+            int64_t paso = i == 1 ? (int64_t)v : deshacerZigzag(v);
+            if (paso < -(int64_t)UINT32_MAX || paso > (int64_t)UINT32_MAX) return nullptr;
+            delta += paso;
+            int64_t t = (int64_t)tiempo[i - 1] + delta;
+            if (delta < 0 || t > (int64_t)UINT32_MAX) return nullptr;
+            tiempo[i] = (uint32_t)t;
+        }
+        size_t usados = alinear4((size_t)(p - ini));
+        return usados <= z.bytes ? ini + usados : nullptr;
+    }
+
+    /*
+     * bloqueValido
+     * Revisa una entrada del directorio leída de disco antes de usarla:
+     * renglones, anchos de bits (ip <= 32, puerto <= 16, razón <= 8), que
+     * los varints y las palabras empacadas quepan en z.bytes, que los
+     * tiempos estén en orden entre tMin y tMax y que los ids de razón
+     * existan. Un .col viejo o corrupto se rechaza en vez de leer fuera
+     * del bloque.
+     * Complejidad: O(RENGLONES).
+     */
+    bool bloqueValido(const ZonaBloque& z, bool ultimo) const {
+        bool completo = z.n == RENGLONES || (ultimo && z.n > 0 && z.n < RENGLONES);
+        if (!completo || z.inicio > datos.size() || z.bytes > datos.size() - z.inicio) return false;
+        if (z.bitsIp > 32 || z.bitsPuerto > 16 || z.bitsRazon > 8) return false;
+        uint32_t tiempo[RENGLONES];
+        const uint8_t* p = leerTiempos(z, tiempo);
+        if (!p || tiempo[z.n - 1] != z.tMax) return false;
+        size_t empacados = (palabrasEmpacadas(z.n, z.bitsIp) + palabrasEmpacadas(z.n, z.bitsPuerto) +
+                            palabrasEmpacadas(z.n, z.bitsRazon)) * 4;
+        if (empacados > z.bytes - (size_t)(p - (datos.data() + z.inicio))) return false;
+        p += (palabrasEmpacadas(z.n, z.bitsIp) + palabrasEmpacadas(z.n, z.bitsPuerto)) * 4;
+        uint32_t razon[RENGLONES];
+        desempacar(p, z.n, z.bitsRazon, 0, razon);
+        for (size_t i = 0; i < z.n; i++)
+            if (razon[i] >= razones.size()) return false;
+        return true;
+    }
+
+    /*
+     * 3.7 comprimirBloque
+     * Tiempos en varint (delta y delta de delta), relleno a 4 bytes y las
+     * tres columnas empacadas. Las palabras empacadas quedan alineadas a 4
+     * bytes dentro del bloque.
+     */
+    static void comprimirBloque(const uint32_t* tiempo, const uint32_t* ip, const uint16_t* puerto,
+                                const uint8_t* razon, size_t n, ZonaBloque& z, std::vector<uint8_t>& out) {
+        z.n = (uint32_t)n;
+        z.tMin = tiempo[0];
+        z.tMax = tiempo[n - 1];
+        int64_t anterior = 0;
+        for (size_t i = 1; i < n; i++) {
+            int64_t delta = (int64_t)tiempo[i] - (int64_t)tiempo[i - 1];
+            if (i == 1) escribirVarint((uint64_t)delta, out);
+            else escribirVarint(zigzag(delta - anterior), out);
+            anterior = delta;
+        }
+        out.resize(alinear4(out.size()), 0);
+
+        auto minmax = std::minmax_element(ip, ip + n);
+        z.ipMin = *minmax.first;
+        z.ipMax = *minmax.second;
+        z.bitsIp = (uint8_t)bitsPara(z.ipMax - z.ipMin);
+        empacar(ip, n, z.bitsIp, z.ipMin, out);
+
+        std::vector<uint32_t> ancho(puerto, puerto + n);
+        auto mmPuerto = std::minmax_element(ancho.begin(), ancho.end());
+        z.puertoMin = (uint16_t)*mmPuerto.first;
+        z.bitsPuerto = (uint8_t)bitsPara(*mmPuerto.second - *mmPuerto.first);
+        empacar(ancho.data(), n, z.bitsPuerto, z.puertoMin, out);
+
+        ancho.assign(razon, razon + n);
+        z.bitsRazon = (uint8_t)bitsPara(*std::max_element(ancho.begin(), ancho.end()));
+        empacar(ancho.data(), n, z.bitsRazon, 0, out);
+        z.bytes = (uint32_t)out.size();
+    }
+};
+
+} // namespace comun
+
+#endif
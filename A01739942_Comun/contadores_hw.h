@@ -0,0 +1,253 @@
+/*
+    Descripción: Contadores de hardware del CPU (perf_event_open) para
+    explicar los tiempos: ciclos, instrucciones, fallos de L1 de datos, de
+    último nivel de caché (LLC), de predicción de saltos y de TLB de datos.
+
+    Cada contador se abre por separado (no en grupo) para que, si el CPU o
+    la máquina virtual no soporta alguno, los demás sigan funcionando. Si
+    perf_event_open no está permitido (perf_event_paranoid, contenedores) o
+    no existe, disponible() es false y las lecturas devuelven ceros: el
+    programa sigue igual, solo sin esos datos.
+
+    Lectura: si el kernel lo permite se usa rdpmc desde espacio de usuario
+    con la página mmap del evento (sin llamada al sistema, ~30 ciclos por
+    contador); si no, read() sobre el descriptor.
+
+    perf_event_open cuenta un solo hilo, y rdpmc o read() sobre el evento
+    de otro hilo dan basura. Por eso cada hilo tiene su propio juego de
+    eventos: abrir() abre el del hilo que lo llama (el principal) y decide
+    si hay contadores; los demás hilos (trabajadores de PoolHilos,
+    GrupoTareas) abren el suyo la primera vez que leen. Una etapa medida
+    dentro de una tarea cuenta el trabajo de ese hilo; una etapa que el
+    hilo principal mide alrededor de trabajo paralelo solo cuenta el suyo.
+*/
+
+#ifndef COMUN_CONTADORES_HW_H
+#define COMUN_CONTADORES_HW_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace comun {
+
+// ---------------- 1. EVENTOS ----------------
+
+/*
+ * 1.1 Eventos medidos, en el orden de los arreglos de valores.
+ */
+enum EventoHw {
+    HW_CICLOS,
+    HW_INSTRUCCIONES,
+    HW_FALLOS_L1D,
+    HW_FALLOS_LLC,
+    HW_FALLOS_RAMA,
+    HW_FALLOS_DTLB,
+    HW_EVENTOS
+};
+
+inline const char* const NOMBRES_HW[HW_EVENTOS] = {"ciclos",      "instrucciones", "fallos_l1d",
+                                                   "fallos_llc",  "fallos_rama",   "fallos_dtlb"};
+
+// ---------------- 2. EVENTOS DE UN HILO ----------------
+
+/*
+ * 2.1 EventosHilo
+ * Los descriptores (y páginas mmap) de los eventos de un hilo. Solo se
+ * leen desde el hilo que los abrió.
+ */
+class EventosHilo {
+public:
+    EventosHilo() = default;
+    EventosHilo(const EventosHilo&) = delete;
+    EventosHilo& operator=(const EventosHilo&) = delete;
+
+    /*
+     * abrir
+     * Abre los eventos disponibles para el hilo actual (modo usuario).
+     * Devuelve true si al menos uno se abrió; si no, deja en mensaje el
+     * primer error.
+     */
+    bool abrir(std::string& mensaje) {
+        intentado = true;
+#if defined(__linux__)
+        for (int k = 0; k < HW_EVENTOS; k++) {
+            struct perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            configurar((EventoHw)k, attr);
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd[k] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            if (fd[k] < 0) {
+                if (mensaje.empty()) mensaje = std::string(NOMBRES_HW[k]) + ": " + std::strerror(errno);
+                continue;
+            }
+            abiertos++;
+            void* p = mmap(nullptr, (size_t)sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, fd[k], 0);
+            pagina[k] = p == MAP_FAILED ? nullptr : (struct perf_event_mmap_page*)p;
+        }
+        return abiertos > 0;
+#else
+        mensaje = "perf_event_open solo existe en Linux";
+        return false;
+#endif
+    }
+
+    bool abierto(int k) const { return fd[k] >= 0; }
+
+    void leer(uint64_t v[HW_EVENTOS]) const {
+        for (int k = 0; k < HW_EVENTOS; k++) v[k] = fd[k] < 0 ? 0 : leerUno(k);
+    }
+
+    ~EventosHilo() {
+#if defined(__linux__)
+        for (int k = 0; k < HW_EVENTOS; k++) {
+            if (pagina[k]) munmap(pagina[k], (size_t)sysconf(_SC_PAGESIZE));
+            if (fd[k] >= 0) close(fd[k]);
+        }
+#endif
+    }
+
+    bool intentado = false;
+
+private:
+    int fd[HW_EVENTOS] = {-1, -1, -1, -1, -1, -1};
+    int abiertos = 0;
+#if defined(__linux__)
+    struct perf_event_mmap_page* pagina[HW_EVENTOS] = {};
+
+    static void configurar(EventoHw e, struct perf_event_attr& attr) {
+        const uint64_t LECTURA_FALLO = (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        switch (e) {
+        case HW_CICLOS:        attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case HW_INSTRUCCIONES: attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case HW_FALLOS_L1D:    attr.type = PERF_TYPE_HW_CACHE; attr.config = PERF_COUNT_HW_CACHE_L1D | LECTURA_FALLO; break;
+        case HW_FALLOS_LLC:    attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+        case HW_FALLOS_RAMA:   attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+        case HW_FALLOS_DTLB:   attr.type = PERF_TYPE_HW_CACHE; attr.config = PERF_COUNT_HW_CACHE_DTLB | LECTURA_FALLO; break;
+        default: break;
+        }
+    }
+#endif
+
+    /*
+     * leerUno
+     * Protocolo de la página mmap: se repite si el kernel la actualizó en
+     * medio (lock cambió). Con rdpmc el valor es offset + contador físico
+     * (extendido según su ancho de bits).
+     */
+    uint64_t leerUno(int k) const {
+#if defined(__linux__)
+#if defined(__x86_64__) || defined(__i386__)
+        const struct perf_event_mmap_page* pc = pagina[k];
+        if (pc && pc->cap_user_rdpmc) {
+            uint32_t seq, idx;
+            uint64_t cuenta;
+            do {
+                seq = pc->lock;
+                __asm__ __volatile__("" ::: "memory");
+                idx = pc->index;
+                cuenta = (uint64_t)pc->offset;
+                if (idx) {
+                    uint32_t lo, hi;
+                    __asm__ __volatile__("rdpmc" : "=a"(lo), "=d"(hi) : "c"(idx - 1));
+                    int64_t pmc = (int64_t)(((uint64_t)hi << 32) | lo);
+                    int ancho = pc->pmc_width;
+                    pmc <<= 64 - ancho;
+                    pmc >>= 64 - ancho;
+                    cuenta += (uint64_t)pmc;
+                }
+                __asm__ __volatile__("" ::: "memory");
+            } while (pc->lock != seq);
+            if (idx) return cuenta;
+        }
+#endif
+        uint64_t valor = 0;
+        if (read(fd[k], &valor, sizeof(valor)) != (ssize_t)sizeof(valor)) return 0;
+        return valor;
+#else
+        (void)k;
+        return 0;
+#endif
+    }
+};
+
+// ---------------- 3. CONTADORES ----------------
+
+class ContadoresHw {
+public:
+    /*
+     * 3.1 global
+     * Los contadores del proceso; se abren con abrir() solo si se piden.
+     */
+    static ContadoresHw& global() {
+        static ContadoresHw instancia;
+        return instancia;
+    }
+
+    /*
+     * 3.2 abrir
+     * Abre los eventos del hilo que llama (el que será "principal").
+     * Devuelve true si al menos uno se abrió; si no, error() explica por
+     * qué y ningún hilo intenta abrir los suyos.
+     */
+    bool abrir() {
+        if (activos) return true;
+        activos = principal.abrir(mensaje);
+        dueno = std::this_thread::get_id();
+        return activos;
+    }
+
+    bool disponible() const { return activos; }
+    bool disponible(int k) const { return activos && principal.abierto(k); }
+    const std::string& error() const { return mensaje; }
+
+    /*
+     * 3.3 leer
+     * Valores actuales de los eventos del hilo que llama (0 en los no
+     * disponibles). Solo sirven las diferencias entre dos lecturas del
+     * mismo hilo. Un hilo que no es el principal abre sus eventos en su
+     * primera lectura (una vez por hilo, ~6 llamadas al sistema).
+     * Complejidad: O(HW_EVENTOS).
+     */
+    void leer(uint64_t v[HW_EVENTOS]) const {
+        if (!activos) {
+            for (int k = 0; k < HW_EVENTOS; k++) v[k] = 0;
+            return;
+        }
+        if (std::this_thread::get_id() == dueno) {
+            principal.leer(v);
+            return;
+        }
+        thread_local EventosHilo propios;
+        if (!propios.intentado) {
+            std::string ignorado;
+            propios.abrir(ignorado);
+        }
+        propios.leer(v);
+    }
+
+private:
+    // los del hilo principal no son thread_local: el reporte final los lee
+    // durante la destrucción de estáticos, después de los thread_local
+    EventosHilo principal;
+    bool activos = false;
+    std::thread::id dueno;
+    std::string mensaje;
+};
+
+} // namespace comun
+
+#endif
@@ -0,0 +1,198 @@
+/*
+    Descripción: Detector de fuerza bruta en flujo. Recibe los fallos de
+    acceso (p.ej. "Failed password ..." y "Too many login attempts") en
+    orden de tiempo y avisa cuando una IP junta N fallos en T segundos.
+
+    Estado por IP: los tiempos de sus últimos N fallos en un anillo, dentro
+    de una tabla hash plana (direccionamiento abierto, sondeo lineal) con
+    llave uint32: cada ranura es un bloque contiguo de 3 + N enteros
+        ip | cuenta y cabeza del anillo | alertaHasta | tiempos[N]
+    así que cada evento toca una o dos líneas de caché, sin nodos ni
+    punteros. Con el anillo lleno, el fallo más viejo de los N está en la
+    cabeza: hay alerta si t - cabeza < T. Cada evento cuesta O(1).
+
+    Una IP con su último fallo hace T segundos o más ya no puede llegar a
+    la alerta con lo que tiene guardado: su estado está inactivo. Al
+    llenarse la tabla (mitad de ranuras ocupadas) primero se desalojan las
+    inactivas y se reconstruye con el tamaño justo para las vivas; solo si
+    siguen siendo muchas crece. La memoria sigue a las IPs activas en la
+    ventana, no a todas las que han aparecido.
+
+    Después de una alerta la IP no vuelve a avisar hasta juntar N fallos
+    nuevos (todos posteriores a la alerta). Un evento más viejo que el
+    último de su IP (entrada sin ordenar) se cuenta en el tiempo del último.
+
+    Medición: bench detector (millones de eventos por segundo en un núcleo).
+*/
+
+#ifndef COMUN_DETECTOR_H
+#define COMUN_DETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace comun {
+
+// ---------------- 1. ALERTA ----------------
+
+/*
+ * 1.1 Alerta
+ * La IP ip juntó 'fallos' fallos entre desde y tiempo (segundos de
+ * claveTiempo, tiempo - desde < ventana).
+ */
+struct Alerta {
+    uint32_t ip;
+    uint32_t tiempo;
+    uint32_t desde;
+    uint32_t fallos;
+};
+
+// ---------------- 2. DETECTOR ----------------
+
+/*
+ * 2.1 DetectorFuerzaBruta
+ *     DetectorFuerzaBruta d(5, 60);       // 5 fallos en 60 s
+ *     for (...) d.fallo(r.ip, r.tiempo, [&](const Alerta& a) { ... });
+ * umbral entre 1 y UMBRAL_MAX; ventana en segundos (> 0).
+ * Espacio: (3 + umbral) * 4 bytes por ranura, con al menos 2 ranuras por
+ * IP activa.
+ */
+class DetectorFuerzaBruta {
+public:
+    static constexpr uint32_t UMBRAL_MAX = 4096;
+    static constexpr size_t CAPACIDAD_MIN = 1024;
+
+    DetectorFuerzaBruta(uint32_t umbral, uint32_t ventana)
+        : umbral(umbral), ventana(ventana), paso(CAMPOS + umbral) {
+        redimensionar(CAPACIDAD_MIN);
+    }
+
+    /*
+     * fallo
+     * Registra un fallo de ip en el tiempo t y llama a alerta(const Alerta&)
+     * si con él la IP llega a 'umbral' fallos dentro de la ventana.
+     * Complejidad: O(1) amortizado.
+     */
+    template <class F>
+    void fallo(uint32_t ip, uint32_t t, F&& alerta) {
+        eventos++;
+        if (t < reloj) desordenados++;
+        else reloj = t;
+        uint32_t* r = buscar(ip);
+        if (r[META] == 0) {
+            if (ocupadas + 1 > capacidad / 2) {
+                desalojar(reloj);
+                r = buscar(ip);
+            }
+            r[IP] = ip;
+            r[ALERTA_HASTA] = 0;
+            ocupadas++;
+        } else {
+            uint32_t ultimo = r[TIEMPOS + posicion(r, cuenta(r) - 1)];
+            if (t < ultimo) t = ultimo;
+            if (t - ultimo >= ventana) r[META] = 0;   // inactiva: empieza de cero
+        }
+
+        uint32_t n = cuenta(r), cabeza = r[META] >> 16;
+        if (n < umbral) {
+            r[TIEMPOS + posicion(r, n)] = t;
+            n++;
+        } else {
+            r[TIEMPOS + cabeza] = t;
+            if (++cabeza == umbral) cabeza = 0;
+        }
+        r[META] = n | cabeza << 16;
+
+        uint32_t desde = r[TIEMPOS + cabeza];
+        if (n == umbral && t - desde < ventana && desde >= r[ALERTA_HASTA]) {
+            r[ALERTA_HASTA] = t + 1;
+            alertas++;
+            alerta(Alerta{ip, t, desde, umbral});
+        }
+    }
+
+    /*
+     * desalojar
+     * Quita los estados inactivos en el tiempo t (último fallo hace
+     * 'ventana' segundos o más) y reconstruye la tabla con capacidad para
+     * las vivas: al menos 4 ranuras por IP viva, así la tabla queda a un
+     * cuarto o menos y el siguiente desalojo tarda en llegar.
+     * Complejidad: O(capacidad).
+     */
+    void desalojar(uint32_t t) {
+        size_t vivas = 0;
+        for (size_t i = 0; i < capacidad; i++) {
+            const uint32_t* r = &ranuras[i * paso];
+            if (r[META] != 0 && !inactiva(r, t)) vivas++;
+        }
+        size_t nueva = CAPACIDAD_MIN;
+        while (nueva < vivas * 4) nueva *= 2;
+        std::vector<uint32_t> viejas;
+        viejas.swap(ranuras);
+        size_t capacidadVieja = capacidad;
+        redimensionar(nueva);
+        for (size_t i = 0; i < capacidadVieja; i++) {
+            const uint32_t* r = &viejas[i * paso];
+            if (r[META] == 0) continue;
+            if (inactiva(r, t)) {
+                desalojadas++;
+                continue;
+            }
+            uint32_t* destino = buscar(r[IP]);
+            for (uint32_t k = 0; k < paso; k++) destino[k] = r[k];
+            ocupadas++;
+        }
+        barridos++;
+    }
+
+    size_t activas() const { return ocupadas; }
+    size_t bytes() const { return ranuras.capacity() * sizeof(uint32_t); }
+
+    // contadores para --stats
+    uint64_t eventos = 0, alertas = 0, desalojadas = 0, desordenados = 0, barridos = 0;
+
+private:
+    // posiciones dentro de una ranura
+    static constexpr uint32_t IP = 0, META = 1, ALERTA_HASTA = 2, TIEMPOS = 3, CAMPOS = 3;
+
+    uint32_t umbral, ventana, paso;
+    std::vector<uint32_t> ranuras;      // capacidad * paso; META == 0: libre
+    size_t capacidad = 0, ocupadas = 0;
+    uint32_t bitsHash = 0, reloj = 0;
+
+    void redimensionar(size_t n) {
+        capacidad = n;
+        bitsHash = 0;
+        while (((size_t)1 << bitsHash) < n) bitsHash++;
+        ranuras.assign(n * paso, 0);
+        ocupadas = 0;
+    }
+
+    static uint32_t cuenta(const uint32_t* r) { return r[META] & 0xFFFF; }
+
+    // i-ésimo tiempo del anillo contando desde el más viejo
+    uint32_t posicion(const uint32_t* r, uint32_t i) const {
+        uint32_t p = (r[META] >> 16) + i;
+        return p >= umbral ? p - umbral : p;
+    }
+
+    bool inactiva(const uint32_t* r, uint32_t t) const {
+        uint32_t ultimo = r[TIEMPOS + posicion(r, cuenta(r) - 1)];
+        return t >= ultimo && t - ultimo >= ventana;
+    }
+
+    // ranura de ip, o la libre donde iría (hash multiplicativo, sondeo lineal)
+    uint32_t* buscar(uint32_t ip) {
+        size_t mascara = capacidad - 1;
+        size_t i = (size_t)((ip * 0x9E3779B1u) >> (32 - bitsHash)) & mascara;
+        for (;; i = (i + 1) & mascara) {
+            uint32_t* r = &ranuras[i * paso];
+            if (r[META] == 0 || r[IP] == ip) return r;
+        }
+    }
+};
+
+} // namespace comun
+
+#endif
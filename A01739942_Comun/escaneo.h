@@ -0,0 +1,314 @@
+/*
+    Descripción: Detector de escaneo de puertos en flujo. Cuenta cuántos
+    puertos distintos usa cada IP dentro de una ventana de tiempo, avisa
+    cuando una IP pasa de un umbral y al final reporta los mayores
+    escáneres. La memoria queda acotada sin importar el tráfico.
+
+    Estado por IP (una ranura de 32 bytes en una tabla hash plana con
+    llave uint32):
+        exacto      hasta EXACTOS puertos distintos guardados en la ranura
+        bosquejo    al pasar de EXACTOS se cambia a un HyperLogLog de
+                    2^8 registros (256 bytes, error típico ~6.5%; con pocos
+                    registros ocupados el estimado usa conteo lineal)
+    Los bosquejos salen de una reserva de tamaño fijo; si se acaba, la IP
+    se queda en EXACTOS ("saturada") y se cuenta en sinBosquejo.
+
+    Ventanas fijas de 'ventana' segundos (t / ventana). Cada ranura lleva
+    la ventana en que se escribió: las de ventanas pasadas cuentan como
+    libres, así que cambiar de ventana no borra la tabla; solo se recorren
+    las ranuras usadas para actualizar el top.
+
+    Cota de memoria: a lo más maxIps IPs por ventana. Con la tabla llena,
+    una IP nueva reemplaza a la de menos puertos entre sus primeras
+    SONDEOS ranuras si esa lleva uno solo (todavía no parece escaneo); si
+    no, el registro se descarta. Los escáneres, con muchos puertos, se
+    quedan. Total: 2 * maxIps * 32 bytes + maxBosquejos * 256 bytes.
+
+    La entrada debe venir en orden de tiempo (como en detector.h); un
+    registro de una ventana anterior se cuenta en la actual.
+*/
+
+#ifndef COMUN_ESCANEO_H
+#define COMUN_ESCANEO_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace comun {
+
+// ---------------- 1. HYPERLOGLOG ----------------
+
+/*
+ * 1.1 Bosquejo de puertos
+ * HyperLogLog con 2^BITS_HLL registros de un byte. agregar devuelve true
+ * si cambió algún registro (solo entonces cambia el estimado).
+ * Complejidad: agregar O(1), estimar O(2^BITS_HLL).
+ */
+const int BITS_HLL = 8;
+const uint32_t REGISTROS_HLL = 1u << BITS_HLL;
+
+inline uint64_t mezclar64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+inline bool agregarHll(uint8_t* registros, uint16_t puerto) {
+    uint64_t h = mezclar64(puerto);
+    uint32_t j = (uint32_t)(h >> (64 - BITS_HLL));
+    uint64_t resto = h << BITS_HLL | (1ull << (BITS_HLL - 1));    // centinela: rango <= 64 - BITS_HLL + 1
+    uint8_t rango = (uint8_t)(__builtin_clzll(resto) + 1);
+    if (rango <= registros[j]) return false;
+    registros[j] = rango;
+    return true;
+}
+
+inline uint32_t estimarHll(const uint8_t* registros) {
+    double suma = 0;
+    uint32_t ceros = 0;
+    for (uint32_t j = 0; j < REGISTROS_HLL; j++) {
+        suma += std::ldexp(1.0, -registros[j]);
+        ceros += registros[j] == 0;
+    }
+    double m = REGISTROS_HLL;
+    double e = 0.7213 / (1 + 1.079 / m) * m * m / suma;
+    if (e <= 2.5 * m && ceros > 0) e = m * std::log(m / ceros);     // conteo lineal
+    return (uint32_t)std::min(e + 0.5, 65535.0);
+}
+
+// ---------------- 2. DETECTOR ----------------
+
+/*
+ * 2.1 ConfigEscaneo
+ * umbral: puertos distintos en una ventana para considerar escaneo.
+ * maxIps: IPs por ventana (la tabla tiene el doble de ranuras).
+ * maxBosquejos: IPs por ventana que pueden pasar de EXACTOS puertos.
+ */
+struct ConfigEscaneo {
+    uint32_t ventana = 3600;
+    uint32_t umbral = 100;
+    size_t maxIps = 1u << 16;
+    size_t maxBosquejos = 1u << 12;
+    size_t top = 10;
+};
+
+/*
+ * 2.2 Escaneo
+ * La IP usó 'puertos' puertos distintos en la ventana que empieza en
+ * 'inicio'; exacto = false si es el estimado de un bosquejo (o saturado).
+ */
+struct Escaneo {
+    uint32_t ip;
+    uint32_t inicio;
+    uint32_t puertos;
+    bool exacto;
+};
+
+/*
+ * 2.3 DetectorEscaneo
+ *     DetectorEscaneo d(config);
+ *     for (...) d.registrar(r.ip, r.tiempo, r.puerto, [&](const Escaneo& e) { ... });
+ *     d.terminar();
+ *     for (const Escaneo& e : d.mayores()) ...
+ * alerta se llama una vez por IP y ventana, al llegar a 'umbral' puertos.
+ * mayores() son los 'top' escaneos (IP y ventana) con más puertos, uno
+ * por IP, de mayor a menor.
+ */
+class DetectorEscaneo {
+public:
+    static constexpr uint32_t EXACTOS = 8;
+    static constexpr int SONDEOS = 8;
+
+    explicit DetectorEscaneo(const ConfigEscaneo& config) : config(config) {
+        size_t n = 1024;
+        while (n < config.maxIps * 2) n *= 2;
+        ranuras.assign(n, Ranura{});
+        bitsHash = 0;
+        while (((size_t)1 << bitsHash) < n) bitsHash++;
+        registros.assign(config.maxBosquejos * REGISTROS_HLL, 0);
+        for (size_t b = config.maxBosquejos; b-- > 0;) libres.push_back((uint32_t)b);
+    }
+
+    /*
+     * registrar
+     * Cuenta el puerto para la IP en la ventana de t.
+     * Complejidad: O(1) amortizado (O(2^BITS_HLL) cuando cambia un
+     * registro del bosquejo).
+     */
+    template <class F>
+    void registrar(uint32_t ip, uint32_t t, uint16_t puerto, F&& alerta) {
+        eventos++;
+        uint32_t v = t / config.ventana + 1;      // 0 = ranura nunca usada
+        if (v > ventana) {
+            cerrarVentana();
+            ventana = v;
+        } else if (v < ventana) {
+            desordenados++;
+        }
+        Ranura* r = buscar(ip);
+        if (!r) return;
+        uint32_t antes = r->puertos;
+        if (r->bosquejo == SIN_BOSQUEJO) {
+            for (uint32_t k = 0; k < r->puertos && k < EXACTOS; k++)
+                if (r->exactos[k] == puerto) return;
+            if (r->puertos < EXACTOS) r->exactos[r->puertos++] = puerto;
+            else if (!r->saturada) pasarABosquejo(*r, puerto);
+        } else {
+            uint8_t* m = &registros[(size_t)r->bosquejo * REGISTROS_HLL];
+            if (agregarHll(m, puerto)) r->puertos = (uint16_t)std::max<uint32_t>(estimarHll(m), r->puertos);
+        }
+        if (antes < config.umbral && r->puertos >= config.umbral) {
+            alertas++;
+            alerta(escaneoDe(*r));
+        }
+    }
+
+    /*
+     * terminar
+     * Cierra la última ventana para que entre al top. Se llama al final:
+     * lo que se registre después cuenta como fuera de orden.
+     */
+    void terminar() {
+        cerrarVentana();
+        ventana++;
+    }
+
+    const std::vector<Escaneo>& mayores() const { return top; }
+
+    size_t bytes() const {
+        return ranuras.capacity() * sizeof(Ranura) + registros.capacity() +
+               (usadas.capacity() + libres.capacity()) * sizeof(uint32_t);
+    }
+
+    // contadores para --stats
+    uint64_t eventos = 0, alertas = 0, reemplazadas = 0, descartados = 0, bosquejos = 0, sinBosquejo = 0,
+             desordenados = 0;
+
+private:
+    static constexpr uint32_t SIN_BOSQUEJO = 0xFFFFFFFF;
+
+    struct Ranura {
+        uint32_t ip = 0;
+        uint32_t ventana = 0;
+        uint32_t bosquejo = SIN_BOSQUEJO;     // índice en registros
+        uint16_t puertos = 0;                 // distintos (o estimado)
+        uint8_t saturada = 0;
+        uint8_t relleno = 0;
+        uint16_t exactos[EXACTOS];
+    };
+    static_assert(sizeof(Ranura) == 32, "una ranura por media línea de caché");
+
+    ConfigEscaneo config;
+    std::vector<Ranura> ranuras;
+    std::vector<uint8_t> registros;     // maxBosquejos * REGISTROS_HLL
+    std::vector<uint32_t> libres;       // bosquejos sin usar
+    std::vector<uint32_t> usadas;       // ranuras escritas en la ventana actual
+    std::vector<Escaneo> top;
+    uint32_t bitsHash = 0, ventana = 0;
+
+    Escaneo escaneoDe(const Ranura& r) const {
+        return Escaneo{r.ip, (r.ventana - 1) * config.ventana, r.puertos,
+                       r.bosquejo == SIN_BOSQUEJO && !r.saturada};
+    }
+
+    /*
+     * buscar
+     * Ranura de ip en la ventana actual, o una nueva: la primera libre (o
+     * de una ventana pasada) de su sondeo lineal. Con maxIps en la
+     * ventana, reemplaza a la de menos puertos entre las primeras SONDEOS
+     * del sondeo si lleva a lo más uno; si no, nullptr (descartado).
+     * Las ranuras no se borran dentro de una ventana, así que el sondeo de
+     * una IP nunca cruza un hueco.
+     */
+    Ranura* buscar(uint32_t ip) {
+        size_t mascara = ranuras.size() - 1;
+        size_t i = (size_t)((ip * 0x9E3779B1u) >> (32 - bitsHash)) & mascara;
+        Ranura* menor = nullptr;
+        for (int k = 0;; k++, i = (i + 1) & mascara) {
+            Ranura& r = ranuras[i];
+            if (r.ventana != ventana) {
+                if (usadas.size() >= config.maxIps) break;
+                usadas.push_back((uint32_t)i);
+                iniciar(r, ip);
+                return &r;
+            }
+            if (r.ip == ip) return &r;
+            if (k < SONDEOS && (!menor || r.puertos < menor->puertos)) menor = &r;
+        }
+        if (!menor || menor->puertos > 1) {
+            descartados++;
+            return nullptr;
+        }
+        reemplazadas++;
+        soltarBosquejo(*menor);
+        iniciar(*menor, ip);
+        return menor;
+    }
+
+    void iniciar(Ranura& r, uint32_t ip) {
+        r.ip = ip;
+        r.ventana = ventana;
+        r.bosquejo = SIN_BOSQUEJO;
+        r.puertos = 0;
+        r.saturada = 0;
+    }
+
+    void soltarBosquejo(Ranura& r) {
+        if (r.bosquejo == SIN_BOSQUEJO) return;
+        std::fill_n(&registros[(size_t)r.bosquejo * REGISTROS_HLL], REGISTROS_HLL, 0);
+        libres.push_back(r.bosquejo);
+        r.bosquejo = SIN_BOSQUEJO;
+    }
+
+    void pasarABosquejo(Ranura& r, uint16_t puerto) {
+        if (libres.empty()) {
+            r.saturada = 1;
+            sinBosquejo++;
+            return;
+        }
+        r.bosquejo = libres.back();
+        libres.pop_back();
+        bosquejos++;
+        uint8_t* m = &registros[(size_t)r.bosquejo * REGISTROS_HLL];
+        for (uint32_t k = 0; k < EXACTOS; k++) agregarHll(m, r.exactos[k]);
+        agregarHll(m, puerto);
+        r.puertos = (uint16_t)std::max<uint32_t>(estimarHll(m), EXACTOS + 1);
+    }
+
+    /*
+     * cerrarVentana
+     * Pasa las IPs de la ventana al top (una entrada por IP, la de más
+     * puertos) y devuelve sus bosquejos a la reserva.
+     * Complejidad: O(u * top), u = ranuras usadas en la ventana.
+     */
+    void cerrarVentana() {
+        for (uint32_t i : usadas) {
+            Ranura& r = ranuras[i];
+            if (r.ventana != ventana) continue;
+            if (r.puertos >= config.umbral) ofrecerTop(escaneoDe(r));
+            soltarBosquejo(r);
+        }
+        usadas.clear();
+    }
+
+    void ofrecerTop(const Escaneo& e) {
+        auto mayor = [](const Escaneo& a, const Escaneo& b) { return a.puertos > b.puertos; };
+        for (Escaneo& x : top) {
+            if (x.ip != e.ip) continue;
+            if (e.puertos > x.puertos) x = e;
+            std::stable_sort(top.begin(), top.end(), mayor);
+            return;
+        }
+        if (top.size() >= config.top && (top.empty() || top.back().puertos >= e.puertos)) return;
+        if (top.size() >= config.top) top.pop_back();
+        top.insert(std::upper_bound(top.begin(), top.end(), e, mayor), e);
+    }
+};
+
+} // namespace comun
+
+#endif
@@ -0,0 +1,404 @@
+/*
+    Descripción: Instrumentación ligera por etapas para todos los programas.
+    Mide cuánto tiempo y memoria se va en cada etapa (lectura, parseo,
+    orden/índice, escritura, consulta) y, si se pidió con --stats, imprime un
+    bloque JSON en stderr al terminar el programa (stdout no cambia).
+
+    Piezas:
+        Estadisticas::global()   registro único del proceso
+        Temporizador             RAII: mide un bloque completo
+        Acumulador               para bucles por línea: suma muchos tramos
+                                 cortos y registra una sola vez al final
+        contar(nombre, n)        contadores libres (líneas, consultas, ...)
+
+    Para que el costo sea despreciable aun dentro de bucles de cientos de
+    miles de líneas, los tiempos se toman con el contador de ciclos (rdtsc,
+    ~10 ns) y se convierten a ms una sola vez al imprimir, calibrando contra
+    steady_clock sobre toda la vida del proceso. La memoria residente se
+    muestrea solo al cerrar cada etapa (/proc/self/statm) y el pico se toma
+    de getrusage.
+
+    Con --stats-hw además se leen contadores de hardware por etapa (ciclos,
+    instrucciones, fallos de caché/TLB/saltos; ver contadores_hw.h). Si no
+    están disponibles el reporte lo indica en "hw_error" y sigue igual.
+
+    Con --traza archivo.json cada Temporizador también queda como evento en
+    una línea de tiempo de Chrome/Perfetto (ver traza.h).
+
+    Compilado con -DPERFILAR_ASIGNACIONES, cada etapa también reporta
+    asignaciones, bytes pedidos, bytes vivos al cerrar y asignaciones por
+    línea, y el reporte lista los sitios que más asignan (ver asignaciones.h).
+*/
+
+#ifndef COMUN_ESTADISTICAS_H
+#define COMUN_ESTADISTICAS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "asignaciones.h"
+#include "contadores_hw.h"
+#include "traza.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace comun {
+
+// ---------------- 1. RELOJ Y MEMORIA ----------------
+
+/*
+ * 1.1 ticks
+ * Contador de ciclos del CPU (x86) o nanosegundos de steady_clock en otras
+ * arquitecturas. Solo sirve para diferencias.
+ * Complejidad: O(1).
+ */
+inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+/*
+ * 1.2 rssActualKb
+ * Memoria residente actual en KB (segundo campo de /proc/self/statm).
+ * Devuelve 0 si no se puede leer (p.ej. fuera de Linux).
+ */
+inline long rssActualKb() {
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    long total = 0, residente = 0;
+    if (std::fscanf(f, "%ld %ld", &total, &residente) != 2) residente = 0;
+    std::fclose(f);
+    return residente * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/*
+ * 1.3 rssPicoKb
+ * Pico de memoria residente del proceso en KB.
+ */
+inline long rssPicoKb() {
+    struct rusage uso;
+    if (getrusage(RUSAGE_SELF, &uso) != 0) return 0;
+    return uso.ru_maxrss;
+}
+
+/*
+ * 1.4 Muestra
+ * Lo que se mide de una etapa: ticks, contadores de hardware y
+ * asignaciones. Se usa tanto para lecturas absolutas (Marca) como para
+ * diferencias acumuladas.
+ */
+struct Muestra {
+    uint64_t t = 0;
+    uint64_t hw[HW_EVENTOS] = {};
+    uint64_t asignaciones = 0, bytes = 0;
+
+    void sumarDiferencia(const Muestra& fin, const Muestra& ini) {
+        t += fin.t - ini.t;
+        // los contadores son por hilo: un tramo que empezó en otro hilo no
+        // se puede restar (y daría la vuelta); se omite
+        for (int k = 0; k < HW_EVENTOS; k++)
+            if (fin.hw[k] >= ini.hw[k]) hw[k] += fin.hw[k] - ini.hw[k];
+        asignaciones += fin.asignaciones - ini.asignaciones;
+        bytes += fin.bytes - ini.bytes;
+    }
+};
+
+// ---------------- 2. REGISTRO DE ESTADÍSTICAS ----------------
+
+class Estadisticas {
+public:
+    /*
+     * 2.1 global
+     * Instancia del proceso. Se recomienda llamarla al inicio de main para
+     * que el tiempo total y la calibración cubran todo el programa.
+     */
+    static Estadisticas& global() {
+        static Estadisticas instancia;
+        return instancia;
+    }
+
+    /*
+     * 2.2 habilitar
+     * Activa la impresión del JSON al terminar el proceso. Los tiempos se
+     * registran siempre; solo el reporte es opcional.
+     */
+    void habilitar(const char* programa) {
+        nombrePrograma = programa;
+        habilitado = true;
+    }
+
+    /*
+     * 2.3 habilitarContadoresHw
+     * Intenta abrir los contadores de hardware; a partir de aquí cada etapa
+     * también acumula sus diferencias.
+     */
+    void habilitarContadoresHw() {
+        pedidoHw = true;
+        conHw = ContadoresHw::global().abrir();
+    }
+
+    bool contadoresHw() const { return conHw; }
+
+    /*
+     * 2.4 habilitarSiSePide
+     * Busca "--stats", "--stats-hw" y "--traza archivo" en los argumentos;
+     * los quita de argv (para que el programa no los vea) y habilita el
+     * reporte o la traza.
+     */
+    void habilitarSiSePide(int& argc, char* argv[], const char* programa) {
+        int j = 1;
+        for (int i = 1; i < argc; i++) {
+            if (std::strcmp(argv[i], "--stats") == 0) habilitar(programa);
+            else if (std::strcmp(argv[i], "--stats-hw") == 0) {
+                habilitar(programa);
+                habilitarContadoresHw();
+            } else if (std::strcmp(argv[i], "--traza") == 0 && i + 1 < argc) {
+                Trazador::global().habilitar(argv[++i]);
+            } else argv[j++] = argv[i];
+        }
+        argc = j;
+    }
+
+    /*
+     * 2.5 registrar
+     * Suma a la etapa lo medido en 'd' (ticks, contadores de hardware y
+     * asignaciones) y muestrea la memoria residente y los bytes vivos. Las
+     * etapas se buscan por nombre en un arreglo pequeño (hay pocas), en el
+     * orden en que aparecen por primera vez. Puede llamarse desde varios
+     * hilos (etapas medidas dentro de tareas del conjunto de hilos).
+     */
+    void registrar(const char* etapa, const Muestra& d) {
+        std::lock_guard<std::mutex> g(candado);
+        Etapa& e = buscar(etapas, etapa);
+        e.total.sumarDiferencia(d, Muestra());
+        e.veces++;
+        long rss = rssActualKb();
+        if (rss > e.rssKb) e.rssKb = rss;
+        e.vivos = asignacionesGlobales.vivos.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * 2.6 contar
+     * Suma n al contador con ese nombre.
+     */
+    void contar(const char* nombre, uint64_t n = 1) {
+        std::lock_guard<std::mutex> g(candado);
+        buscar(contadores, nombre).veces += n;
+    }
+
+    /*
+     * 2.7 imprimirJson
+     * Escribe el bloque de estadísticas en f, en una sola línea.
+     */
+    void imprimirJson(FILE* f) const {
+        uint64_t t1 = ticks();
+        auto r1 = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(r1 - reloj0).count();
+        double msPorTick = t1 > ticks0 ? ms / (double)(t1 - ticks0) : 0;
+
+        std::fprintf(f, "{\"programa\":\"%s\",\"total_ms\":%.3f,\"pico_rss_kb\":%ld,",
+                     nombrePrograma.c_str(), ms, rssPicoKb());
+        if (pedidoHw && !conHw) std::fprintf(f, "\"hw_error\":\"%s\",", ContadoresHw::global().error().c_str());
+        std::fprintf(f, "\"etapas\":{");
+        const ContadoresHw& hw = ContadoresHw::global();
+        uint64_t lineas = 0;
+        for (const Etapa& c : contadores)
+            if (c.nombre == "lineas") lineas = c.veces;
+        for (size_t i = 0; i < etapas.size(); i++) {
+            const Etapa& e = etapas[i];
+            std::fprintf(f, "%s\"%s\":{\"ms\":%.3f,\"veces\":%llu,\"rss_kb\":%ld", i ? "," : "",
+                         e.nombre.c_str(), (double)e.total.t * msPorTick, (unsigned long long)e.veces, e.rssKb);
+            if (PERFILANDO_ASIGNACIONES) {
+                std::fprintf(f, ",\"asignaciones\":%llu,\"bytes_asignados\":%llu,\"bytes_vivos\":%lld",
+                             (unsigned long long)e.total.asignaciones, (unsigned long long)e.total.bytes,
+                             (long long)e.vivos);
+                if (lineas > 0)
+                    std::fprintf(f, ",\"asignaciones_por_linea\":%.3f", (double)e.total.asignaciones / (double)lineas);
+            }
+            if (conHw) {
+                std::fprintf(f, ",\"hw\":{");
+                const char* sep = "";
+                for (int k = 0; k < HW_EVENTOS; k++) {
+                    if (!hw.disponible(k)) continue;
+                    std::fprintf(f, "%s\"%s\":%llu", sep, NOMBRES_HW[k], (unsigned long long)e.total.hw[k]);
+                    sep = ",";
+                }
+                std::fprintf(f, "}");
+            }
+            std::fprintf(f, "}");
+        }
+        std::fprintf(f, "},\"contadores\":{");
+        for (size_t i = 0; i < contadores.size(); i++)
+            std::fprintf(f, "%s\"%s\":%llu", i ? "," : "", contadores[i].nombre.c_str(),
+                         (unsigned long long)contadores[i].veces);
+        std::fprintf(f, "}");
+#ifdef PERFILAR_ASIGNACIONES
+        const ContadoresAsignacion& a = asignacionesGlobales;
+        std::fprintf(f, ",\"asignaciones\":{\"total\":%llu,\"bytes\":%llu,\"pico_vivos\":%lld,\"sitios\":[",
+                     (unsigned long long)a.asignaciones.load(), (unsigned long long)a.bytes.load(),
+                     (long long)a.picoVivos.load());
+        // Pilas distintas pueden describirse igual (difieren en marcos
+        // omitidos): se juntan por descripción antes de elegir las 10 mayores.
+        std::vector<Etapa> porSitio;
+        for (const TablaSitios::Sitio* s : sitiosAsignacion.mayores(64)) {
+            std::string sitio = describirSitio(*s);
+            for (char& c : sitio)
+                if (c == '"' || c == '\\') c = '\'';
+            Etapa& e = buscar(porSitio, sitio.c_str());
+            e.total.asignaciones += s->muestras * TablaSitios::MUESTREO;
+            e.total.bytes += s->bytes * TablaSitios::MUESTREO;
+        }
+        std::sort(porSitio.begin(), porSitio.end(),
+                  [](const Etapa& x, const Etapa& y) { return x.total.asignaciones > y.total.asignaciones; });
+        for (size_t i = 0; i < porSitio.size() && i < 10; i++)
+            std::fprintf(f, "%s{\"sitio\":\"%s\",\"asignaciones_estimadas\":%llu,\"bytes_estimados\":%llu}",
+                         i ? "," : "", porSitio[i].nombre.c_str(), (unsigned long long)porSitio[i].total.asignaciones,
+                         (unsigned long long)porSitio[i].total.bytes);
+        std::fprintf(f, "]}");
+#endif
+        std::fprintf(f, "}\n");
+    }
+
+    /*
+     * Al destruirse (después de que main regresa, por cualquier camino) se
+     * imprime el reporte si fue solicitado.
+     */
+    ~Estadisticas() {
+        if (habilitado) imprimirJson(stderr);
+    }
+
+private:
+    struct Etapa {
+        std::string nombre;
+        Muestra total;
+        uint64_t veces = 0;
+        long rssKb = 0;
+        int64_t vivos = 0;      // bytes vivos al cerrar la etapa (con PERFILAR_ASIGNACIONES)
+    };
+
+    std::string nombrePrograma;
+    bool habilitado = false, pedidoHw = false, conHw = false;
+    uint64_t ticks0;
+    std::chrono::steady_clock::time_point reloj0;
+    std::vector<Etapa> etapas, contadores;
+    std::mutex candado;         // protege etapas y contadores
+
+    // Se construyen antes los contadores y el trazador para que se destruyan
+    // después (el reporte se imprime en el destructor y los consulta).
+    Estadisticas() : ticks0(ticks()), reloj0(std::chrono::steady_clock::now()) {
+        ContadoresHw::global();
+        Trazador::global();
+    }
+
+    static Etapa& buscar(std::vector<Etapa>& v, const char* nombre) {
+        for (Etapa& e : v)
+            if (e.nombre == nombre) return e;
+        v.push_back(Etapa());
+        v.back().nombre = nombre;
+        return v.back();
+    }
+};
+
+// ---------------- 3. MEDIDORES ----------------
+
+/*
+ * 3.1 Marca
+ * Lectura absoluta en un instante: ticks y, si están activos, contadores
+ * de hardware y de asignaciones. Sin ellos solo cuesta un rdtsc.
+ */
+struct Marca : Muestra {
+    Marca() { tomar(); }
+
+    void tomar() {
+        t = ticks();
+        if (Estadisticas::global().contadoresHw()) ContadoresHw::global().leer(hw);
+        if (PERFILANDO_ASIGNACIONES) {
+            asignaciones = asignacionesGlobales.asignaciones.load(std::memory_order_relaxed);
+            bytes = asignacionesGlobales.bytes.load(std::memory_order_relaxed);
+        }
+    }
+};
+
+/*
+ * 3.2 Temporizador
+ * Mide desde su construcción hasta que sale del bloque, o hasta detener()
+ * si la etapa termina antes que el bloque (variables que se usan después).
+ * También marca inicio y fin de la etapa en la traza, si está activa.
+ *     { Temporizador t("orden"); quickSort(...); }
+ */
+class Temporizador {
+public:
+    explicit Temporizador(const char* etapa) : nombre(etapa) { Trazador::global().iniciar(etapa); }
+    ~Temporizador() { detener(); }
+    Temporizador(const Temporizador&) = delete;
+    Temporizador& operator=(const Temporizador&) = delete;
+
+    void detener() {
+        if (!nombre) return;
+        Marca fin;
+        Muestra d;
+        d.sumarDiferencia(fin, inicio);
+        Estadisticas::global().registrar(nombre, d);
+        Trazador::global().terminar(nombre);
+        nombre = nullptr;
+    }
+
+private:
+    const char* nombre;
+    Marca inicio;
+};
+
+/*
+ * 3.3 Acumulador
+ * Para partir un bucle en etapas sin pagar una búsqueda por iteración.
+ * Se lleva una Marca compartida y cada acumulador cobra el tramo desde la
+ * marca anterior:
+ *     Marca marca;
+ *     while (getline(...)) { lectura.sumar(marca); ...; parseo.sumar(marca); }
+ * Al destruirse registra el total una sola vez.
+ */
+class Acumulador {
+public:
+    explicit Acumulador(const char* etapa) : nombre(etapa) {}
+    ~Acumulador() { volcar(); }
+    Acumulador(const Acumulador&) = delete;
+    Acumulador& operator=(const Acumulador&) = delete;
+
+    void sumar(Marca& marca) {
+        Marca ahora;
+        total.sumarDiferencia(ahora, marca);
+        marca = ahora;
+    }
+
+    /*
+     * volcar
+     * Registra lo acumulado (si hay algo) y reinicia.
+     */
+    void volcar() {
+        if (total.t == 0) return;
+        Estadisticas::global().registrar(nombre, total);
+        total = Muestra();
+    }
+
+private:
+    const char* nombre;
+    Muestra total;
+};
+
+} // namespace comun
+
+#endif
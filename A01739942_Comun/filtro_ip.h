@@ -0,0 +1,327 @@
+/*
+    Descripción: Filtros compactos de pertenencia para IPs (uint32).
+    Responden "¿esta IP aparece en la bitácora?" sin guardar las IPs: pueden
+    dar falsos positivos (con probabilidad pequeña y conocida) pero nunca
+    falsos negativos.
+
+    1) FiltroBloomBloqueado: filtro de Bloom dividido en bloques de 64 bytes
+       (una línea de caché). Cada IP elige un bloque y enciende k bits dentro
+       de él, así una consulta cuesta un solo fallo de caché. Admite
+       inserciones en cualquier momento. ~10 bits por IP -> ~1% de falsos
+       positivos.
+
+    2) FiltroFusionBinaria: filtro "binary fuse" de 3 posiciones con huellas
+       de 8 bits, para el caso de solo lectura (se construye una vez con todas
+       las IPs). Las 3 posiciones de cada IP caen en tres segmentos contiguos
+       del arreglo, cerca entre sí. ~9 bits por IP -> ~0.4% de falsos
+       positivos.
+
+    Ambos se pueden guardar junto a la bitácora (bitacora.txt.bloom,
+    bitacora.txt.fusion) y cargarse sin volver a leer el log.
+*/
+
+#ifndef COMUN_FILTRO_IP_H
+#define COMUN_FILTRO_IP_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace comun {
+
+// ---------------- 1. HASH ----------------
+
+/*
+ * 1.1 mezclar64
+ * Mezcla de bits (finalizador de splitmix64) con semilla: cambia ~la mitad
+ * de los bits de salida por cada bit de entrada.
+ * Complejidad: O(1).
+ */
+inline uint64_t mezclar64(uint64_t x, uint64_t semilla) {
+    x += semilla + 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+/*
+ * 1.2 reducir
+ * Mapea un hash de 32 bits al rango [0, n) con una multiplicación
+ * (más barato que el módulo).
+ */
+inline uint32_t reducir(uint32_t h, uint32_t n) { return (uint32_t)(((uint64_t)h * n) >> 32); }
+
+// ---------------- 2. ARCHIVOS ----------------
+
+/*
+ * 2.1 Encabezado de archivo
+ * Todos los filtros guardan: firma de 8 bytes, parámetros y datos crudos.
+ * abrirArchivo escribe el encabezado y deja el flujo listo para los datos
+ * (para quien los escribe en varias partes, sin juntarlos antes).
+ */
+inline bool abrirArchivo(std::ofstream& out, const std::string& ruta, const char firma[8],
+                         const std::vector<uint64_t>& params) {
+    out.open(ruta, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Error: no se pudo escribir " << ruta << "\n";
+        return false;
+    }
+    out.write(firma, 8);
+    uint64_t np = params.size();
+    out.write((const char*)&np, 8);
+    out.write((const char*)params.data(), (std::streamsize)(np * 8));
+    return (bool)out;
+}
+
+inline bool escribirArchivo(const std::string& ruta, const char firma[8], const std::vector<uint64_t>& params,
+                            const void* datos, size_t bytes) {
+    std::ofstream out;
+    if (!abrirArchivo(out, ruta, firma, params)) return false;
+    out.write((const char*)datos, (std::streamsize)bytes);
+    return (bool)out;
+}
+
+inline bool leerEncabezado(std::ifstream& in, const char firma[8], std::vector<uint64_t>& params) {
+    char f[8];
+    uint64_t np = 0;
+    if (!in.read(f, 8) || std::memcmp(f, firma, 8) != 0) return false;
+    if (!in.read((char*)&np, 8) || np > 16) return false;
+    params.resize(np);
+    return (bool)in.read((char*)params.data(), (std::streamsize)(np * 8));
+}
+
+// ---------------- 3. BLOOM BLOQUEADO ----------------
+
+class FiltroBloomBloqueado {
+public:
+    static const int K = 7;     // bits por IP dentro del bloque (óptimo para ~10 bits/IP)
+
+    /*
+     * Bloque de 512 bits alineado a línea de caché.
+     */
+    struct alignas(64) Bloque {
+        uint64_t w[8];
+    };
+
+    FiltroBloomBloqueado() {}
+
+    /*
+     * Reserva espacio para n IPs con bitsPorIp bits cada una.
+     */
+    explicit FiltroBloomBloqueado(size_t n, double bitsPorIp = 10.0) {
+        size_t bloques = (size_t)std::ceil((double)std::max<size_t>(n, 1) * bitsPorIp / 512.0);
+        bloquesVec.assign(std::max<size_t>(bloques, 1), Bloque{});
+    }
+
+    /*
+     * agregar / contiene
+     * Los 32 bits altos del hash eligen el bloque; los 63 bits restantes dan
+     * K posiciones de 9 bits (0-511) dentro del bloque.
+     * Complejidad: O(K), un solo bloque tocado.
+     */
+    void agregar(uint32_t ip) {
+        uint64_t h = mezclar64(ip, SEMILLA);
+        Bloque& b = bloquesVec[reducir((uint32_t)(h >> 32), (uint32_t)bloquesVec.size())];
+        uint64_t bitsPos = h * 0xD6E8FEB86659FD93ull;   // segunda mezcla para las posiciones
+        for (int k = 0; k < K; k++) {
+            uint32_t pos = (uint32_t)(bitsPos >> (k * 9)) & 511;
+            b.w[pos >> 6] |= 1ull << (pos & 63);
+        }
+    }
+
+    bool contiene(uint32_t ip) const {
+        uint64_t h = mezclar64(ip, SEMILLA);
+        const Bloque& b = bloquesVec[reducir((uint32_t)(h >> 32), (uint32_t)bloquesVec.size())];
+        uint64_t bitsPos = h * 0xD6E8FEB86659FD93ull;
+        bool todos = true;
+        for (int k = 0; k < K; k++) {
+            uint32_t pos = (uint32_t)(bitsPos >> (k * 9)) & 511;
+            todos &= (b.w[pos >> 6] >> (pos & 63)) & 1;
+        }
+        return todos;
+    }
+
+    size_t bytes() const { return bloquesVec.size() * sizeof(Bloque); }
+
+    bool guardar(const std::string& ruta) const {
+        return escribirArchivo(ruta, FIRMA, {bloquesVec.size()}, bloquesVec.data(), bytes());
+    }
+
+    bool cargar(const std::string& ruta) {
+        std::ifstream in(ruta, std::ios::binary);
+        std::vector<uint64_t> params;
+        if (!in.is_open() || !leerEncabezado(in, FIRMA, params) || params.size() != 1) return false;
+        bloquesVec.assign(params[0], Bloque{});
+        return (bool)in.read((char*)bloquesVec.data(), (std::streamsize)bytes());
+    }
+
+private:
+    static constexpr uint64_t SEMILLA = 0x5EED0B100Dull;
+    static constexpr char FIRMA[8] = {'B', 'L', 'O', 'O', 'M', 'I', 'P', '1'};
+    std::vector<Bloque> bloquesVec;
+};
+
+// ---------------- 4. FILTRO BINARY FUSE ----------------
+
+class FiltroFusionBinaria {
+public:
+    /*
+     * construir
+     * Construye el filtro para el conjunto de IPs (se eliminan repetidas).
+     * Algoritmo de "peeling": cada IP ocupa 3 posiciones; mientras haya una
+     * posición usada por una sola IP se saca esa IP y se apila. Si todas salen,
+     * se asignan las huellas en orden inverso para que el XOR de las 3
+     * posiciones de cada IP sea su huella. Si queda un ciclo se reintenta con
+     * otra semilla (raro).
+     * Complejidad: O(n) esperado.
+     */
+    bool construir(std::vector<uint32_t> ips) {
+        std::sort(ips.begin(), ips.end());
+        ips.erase(std::unique(ips.begin(), ips.end()), ips.end());
+        dimensionar((uint32_t)ips.size());
+        size_t n = ips.size();
+
+        std::vector<uint32_t> conteo(largo);
+        std::vector<uint64_t> xorHash(largo);
+        std::vector<uint32_t> cola;
+        std::vector<std::pair<uint64_t, uint8_t>> pila;     // (hash, cuál de las 3 posiciones)
+        for (int intento = 0; intento < 100; intento++) {
+            semilla = mezclar64((uint64_t)intento, 0xF05E);
+            std::fill(conteo.begin(), conteo.end(), 0);
+            std::fill(xorHash.begin(), xorHash.end(), 0);
+            for (uint32_t ip : ips) {
+                uint64_t h = mezclar64(ip, semilla);
+                uint32_t p[3];
+                posiciones(h, p);
+                for (uint32_t q : p) {
+                    conteo[q]++;
+                    xorHash[q] ^= h;
+                }
+            }
+            cola.clear();
+            pila.clear();
+            for (uint32_t q = 0; q < largo; q++)
+                if (conteo[q] == 1) cola.push_back(q);
+            while (!cola.empty()) {
+                uint32_t q = cola.back();
+                cola.pop_back();
+                if (conteo[q] != 1) continue;
+                uint64_t h = xorHash[q];
+                uint32_t p[3];
+                posiciones(h, p);
+                uint8_t cual = (uint8_t)(p[0] == q ? 0 : p[1] == q ? 1 : 2);
+                pila.push_back({h, cual});
+                for (uint32_t r : p) {
+                    conteo[r]--;
+                    xorHash[r] ^= h;
+                    if (conteo[r] == 1) cola.push_back(r);
+                }
+            }
+            if (pila.size() == n) break;
+        }
+        if (pila.size() != n) {
+            std::cerr << "Error: no se pudo construir el filtro binary fuse\n";
+            return false;
+        }
+
+        huellas.assign(largo, 0);
+        for (size_t i = pila.size(); i-- > 0;) {
+            uint64_t h = pila[i].first;
+            uint32_t p[3];
+            posiciones(h, p);
+            uint8_t f = huella(h);
+            for (int k = 0; k < 3; k++)
+                if (k != pila[i].second) f ^= huellas[p[k]];
+            huellas[p[pila[i].second]] = f;
+        }
+        return true;
+    }
+
+    /*
+     * contiene
+     * XOR de las 3 huellas == huella de la IP. Tres lecturas en una ventana
+     * de 3 segmentos contiguos.
+     * Complejidad: O(1).
+     */
+    bool contiene(uint32_t ip) const {
+        if (huellas.empty()) return false;
+        uint64_t h = mezclar64(ip, semilla);
+        uint32_t p[3];
+        posiciones(h, p);
+        return (uint8_t)(huella(h) ^ huellas[p[0]] ^ huellas[p[1]] ^ huellas[p[2]]) == 0;
+    }
+
+    size_t bytes() const { return huellas.size(); }
+
+    bool guardar(const std::string& ruta) const {
+        return escribirArchivo(ruta, FIRMA, {semilla, largoSegmento, cuentaSegmentos, largo},
+                               huellas.data(), huellas.size());
+    }
+
+    bool cargar(const std::string& ruta) {
+        std::ifstream in(ruta, std::ios::binary);
+        std::vector<uint64_t> params;
+        if (!in.is_open() || !leerEncabezado(in, FIRMA, params) || params.size() != 4) return false;
+        semilla = params[0];
+        largoSegmento = (uint32_t)params[1];
+        cuentaSegmentos = (uint32_t)params[2];
+        largo = (uint32_t)params[3];
+        mascaraSegmento = largoSegmento - 1;
+        huellas.assign(largo, 0);
+        return (bool)in.read((char*)huellas.data(), (std::streamsize)largo);
+    }
+
+private:
+    static constexpr char FIRMA[8] = {'F', 'U', 'S', 'E', '8', 'I', 'P', '1'};
+    uint64_t semilla = 0;
+    uint32_t largoSegmento = 4, mascaraSegmento = 3, cuentaSegmentos = 1, largo = 0;
+    std::vector<uint8_t> huellas;
+
+    static uint8_t huella(uint64_t h) { return (uint8_t)(h ^ (h >> 32)); }
+
+    /*
+     * dimensionar
+     * Parámetros del artículo de binary fuse para aridad 3: segmentos de
+     * potencia de 2 que crecen con log(n) y un factor de espacio que tiende
+     * a 1.125 (9 bits por IP con huellas de 8 bits).
+     */
+    void dimensionar(uint32_t n) {
+        const uint32_t aridad = 3;
+        largoSegmento = n <= 1 ? 4 : 1u << (int)std::floor(std::log((double)n) / std::log(3.33) + 2.25);
+        if (largoSegmento > 262144) largoSegmento = 262144;
+        mascaraSegmento = largoSegmento - 1;
+        double factor = n <= 1 ? 0 : std::max(1.125, 0.875 + 0.25 * std::log(1000000.0) / std::log((double)n));
+        uint32_t capacidad = n <= 1 ? 0 : (uint32_t)std::round((double)n * factor);
+        uint32_t segmentosIniciales = (capacidad + largoSegmento - 1) / largoSegmento;
+        segmentosIniciales = segmentosIniciales > aridad - 1 ? segmentosIniciales - (aridad - 1) : 0;
+        largo = (segmentosIniciales + aridad - 1) * largoSegmento;
+        cuentaSegmentos = (largo + largoSegmento - 1) / largoSegmento;
+        cuentaSegmentos = cuentaSegmentos <= aridad - 1 ? 1 : cuentaSegmentos - (aridad - 1);
+        largo = (cuentaSegmentos + aridad - 1) * largoSegmento;
+    }
+
+    /*
+     * posiciones
+     * Primera posición uniforme en los primeros cuentaSegmentos segmentos;
+     * las otras dos en los dos segmentos siguientes, desplazadas por bits
+     * del hash dentro de su segmento.
+     */
+    void posiciones(uint64_t h, uint32_t p[3]) const {
+        uint64_t alto = (uint64_t)(((__uint128_t)h * ((uint64_t)cuentaSegmentos * largoSegmento)) >> 64);
+        p[0] = (uint32_t)alto;
+        p[1] = p[0] + largoSegmento;
+        p[2] = p[1] + largoSegmento;
+        p[1] ^= (uint32_t)(h >> 18) & mascaraSegmento;
+        p[2] ^= (uint32_t)h & mascaraSegmento;
+    }
+};
+
+} // namespace comun
+
+#endif
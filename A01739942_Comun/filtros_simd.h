@@ -0,0 +1,429 @@
+/*
+    Descripción: Kernels de filtrado sobre columnas que producen mapas de bits
+    de selección (bit j = 1 si el renglón j cumple el predicado).
+
+    Predicados soportados:
+        rango    lo <= v <= hi       (tiempo, IP, puerto, id de razón)
+        máscara  (v & m) == valor    (CIDR sobre la IP)
+        igualdad v == x              (rango con lo == hi)
+        conjunto v en {..}           (ids de razón, tabla de 256 bits)
+
+    Cada kernel tiene tres versiones: escalar, SSE2 (4/8/16 valores por
+    instrucción) y AVX2 (8/16/32 valores). La versión se elige una sola vez al
+    arrancar según el CPU; las versiones AVX2 se compilan con
+    __attribute__((target)) para no exigir -mavx2 al compilar el programa.
+
+    Los mapas de bits resultantes se combinan con bitsAnd / bitsOr palabra por
+    palabra, así que un filtro con varias condiciones es una secuencia de
+    kernels sin ramas por renglón.
+*/
+
+#ifndef COMUN_FILTROS_SIMD_H
+#define COMUN_FILTROS_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COMUN_X86 1
+#endif
+
+namespace comun {
+
+// ---------------- 1. NIVEL DE SIMD ----------------
+
+/*
+ * 1.1 NivelSimd
+ * Conjunto de instrucciones usado por los kernels.
+ */
+enum NivelSimd { SIMD_ESCALAR = 0, SIMD_SSE2 = 1, SIMD_AVX2 = 2 };
+
+inline const char* nombreNivel(NivelSimd n) {
+    return n == SIMD_AVX2 ? "avx2" : n == SIMD_SSE2 ? "sse2" : "escalar";
+}
+
+/*
+ * 1.2 nivelDetectado
+ * Mejor nivel disponible en el CPU actual.
+ */
+inline NivelSimd nivelDetectado() {
+#ifdef COMUN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    return SIMD_SSE2;
+#else
+    return SIMD_ESCALAR;
+#endif
+}
+
+/*
+ * 1.3 nivelSimd / fijarNivelSimd
+ * Nivel activo. Los benchmarks lo bajan para comparar versiones; nunca se
+ * permite subir por encima de lo que el CPU soporta.
+ */
+inline NivelSimd& nivelActivo() {
+    static NivelSimd nivel = nivelDetectado();
+    return nivel;
+}
+
+inline NivelSimd nivelSimd() { return nivelActivo(); }
+
+inline void fijarNivelSimd(NivelSimd n) {
+    NivelSimd maximo = nivelDetectado();
+    nivelActivo() = n > maximo ? maximo : n;
+}
+
+// ---------------- 2. MAPAS DE BITS ----------------
+
+/*
+ * 2.1 palabrasPara
+ * Número de palabras de 64 bits para n renglones.
+ */
+inline size_t palabrasPara(size_t n) { return (n + 63) / 64; }
+
+/*
+ * 2.2 bitsAnd / bitsOr
+ * dst = dst AND/OR src, palabra por palabra. El compilador las vectoriza.
+ * Complejidad: O(n/64).
+ */
+inline void bitsAnd(uint64_t* dst, const uint64_t* src, size_t palabras) {
+    for (size_t i = 0; i < palabras; i++) dst[i] &= src[i];
+}
+
+inline void bitsOr(uint64_t* dst, const uint64_t* src, size_t palabras) {
+    for (size_t i = 0; i < palabras; i++) dst[i] |= src[i];
+}
+
+/*
+ * 2.3 bitsContar
+ * Número de bits encendidos.
+ */
+inline size_t bitsContar(const uint64_t* bits, size_t palabras) {
+    size_t total = 0;
+    for (size_t i = 0; i < palabras; i++) total += (size_t)__builtin_popcountll(bits[i]);
+    return total;
+}
+
+/*
+ * 2.4 bitsVacio
+ * true si ningún bit está encendido (permite cortar un lote en cuanto un
+ * filtro lo deja vacío).
+ */
+inline bool bitsVacio(const uint64_t* bits, size_t palabras) {
+    uint64_t o = 0;
+    for (size_t i = 0; i < palabras; i++) o |= bits[i];
+    return o == 0;
+}
+
+/*
+ * 2.5 bitsASeleccion
+ * Convierte el mapa de bits en la lista de posiciones encendidas.
+ * Devuelve cuántas posiciones escribió en sel.
+ * Complejidad: O(palabras + bits encendidos).
+ */
+template <typename T>
+inline size_t bitsASeleccion(const uint64_t* bits, size_t palabras, T* sel) {
+    size_t k = 0;
+    for (size_t w = 0; w < palabras; w++) {
+        uint64_t b = bits[w];
+        while (b) {
+            sel[k++] = (T)(w * 64 + (size_t)__builtin_ctzll(b));
+            b &= b - 1;
+        }
+    }
+    return k;
+}
+
+// ---------------- 3. KERNELS ESCALARES ----------------
+
+/*
+ * 3.1 Versiones escalares
+ * Procesan 64 renglones por palabra de salida; lo <= v <= hi se evalúa con
+ * una sola resta sin signo. También se usan para la cola de las versiones SIMD.
+ * Complejidad: O(n).
+ */
+template <typename T>
+inline void rangoEscalar(const T* col, size_t ini, size_t n, uint32_t lo, uint32_t hi, uint64_t* bits) {
+    uint32_t ancho = hi - lo;
+    for (size_t i = ini; i < n; i += 64) {
+        size_t fin = i + 64 < n ? i + 64 : n;
+        uint64_t w = 0;
+        for (size_t j = i; j < fin; j++)
+            w |= (uint64_t)(((uint32_t)col[j] - lo) <= ancho) << (j - i);
+        bits[i / 64] = w;
+    }
+}
+
+inline void mascaraEscalar(const uint32_t* col, size_t ini, size_t n, uint32_t mascara,
+                           uint32_t valor, uint64_t* bits) {
+    for (size_t i = ini; i < n; i += 64) {
+        size_t fin = i + 64 < n ? i + 64 : n;
+        uint64_t w = 0;
+        for (size_t j = i; j < fin; j++)
+            w |= (uint64_t)((col[j] & mascara) == valor) << (j - i);
+        bits[i / 64] = w;
+    }
+}
+
+#ifdef COMUN_X86
+
+// ---------------- 4. KERNELS SSE2 ----------------
+
+/*
+ * 4.1 Comparación sin signo con SSE2
+ * SSE2 solo compara enteros con signo; restar lo y voltear el bit de signo
+ * convierte "v - lo <= ancho (sin signo)" en una comparación con signo.
+ * Cada iteración produce 64 bits de salida.
+ */
+inline void rangoU32Sse2(const uint32_t* col, size_t n, uint32_t lo, uint32_t hi, uint64_t* bits) {
+    const __m128i vlo = _mm_set1_epi32((int)lo);
+    const __m128i signo = _mm_set1_epi32((int)0x80000000u);
+    const __m128i lim = _mm_set1_epi32((int)((hi - lo) ^ 0x80000000u));
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        uint64_t w = 0;
+        for (int k = 0; k < 16; k++) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(col + i + k * 4));
+            v = _mm_xor_si128(_mm_sub_epi32(v, vlo), signo);
+            __m128i fuera = _mm_cmpgt_epi32(v, lim);
+            uint64_t m = (uint64_t)(~_mm_movemask_ps(_mm_castsi128_ps(fuera)) & 0xF);
+            w |= m << (k * 4);
+        }
+        bits[i / 64] = w;
+    }
+    rangoEscalar(col, i, n, lo, hi, bits);
+}
+
+inline void mascaraU32Sse2(const uint32_t* col, size_t n, uint32_t mascara, uint32_t valor, uint64_t* bits) {
+    const __m128i vm = _mm_set1_epi32((int)mascara);
+    const __m128i vv = _mm_set1_epi32((int)valor);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        uint64_t w = 0;
+        for (int k = 0; k < 16; k++) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(col + i + k * 4));
+            __m128i eq = _mm_cmpeq_epi32(_mm_and_si128(v, vm), vv);
+            w |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(eq)) << (k * 4);
+        }
+        bits[i / 64] = w;
+    }
+    mascaraEscalar(col, i, n, mascara, valor, bits);
+}
+
+inline void rangoU16Sse2(const uint16_t* col, size_t n, uint32_t lo, uint32_t hi, uint64_t* bits) {
+    // Límites fuera de 16 bits se recortan: ningún valor puede pasar de 65535
+    if (lo > 0xFFFF) { rangoEscalar(col, 0, n, lo, hi, bits); return; }
+    if (hi > 0xFFFF) hi = 0xFFFF;
+    const __m128i vlo = _mm_set1_epi16((short)lo);
+    const __m128i signo = _mm_set1_epi16((short)0x8000);
+    const __m128i lim = _mm_set1_epi16((short)((hi - lo) ^ 0x8000));
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        uint64_t w = 0;
+        for (int k = 0; k < 4; k++) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(col + i + k * 16));
+            __m128i b = _mm_loadu_si128((const __m128i*)(col + i + k * 16 + 8));
+            a = _mm_cmpgt_epi16(_mm_xor_si128(_mm_sub_epi16(a, vlo), signo), lim);
+            b = _mm_cmpgt_epi16(_mm_xor_si128(_mm_sub_epi16(b, vlo), signo), lim);
+            uint32_t fuera = (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(a, b));
+            w |= (uint64_t)(~fuera & 0xFFFF) << (k * 16);
+        }
+        bits[i / 64] = w;
+    }
+    rangoEscalar(col, i, n, lo, hi, bits);
+}
+
+inline void rangoU8Sse2(const uint8_t* col, size_t n, uint32_t lo, uint32_t hi, uint64_t* bits) {
+    if (lo > 0xFF) { rangoEscalar(col, 0, n, lo, hi, bits); return; }
+    if (hi > 0xFF) hi = 0xFF;
+    const __m128i vlo = _mm_set1_epi8((char)lo);
+    const __m128i signo = _mm_set1_epi8((char)0x80);
+    const __m128i lim = _mm_set1_epi8((char)((hi - lo) ^ 0x80));
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        uint64_t w = 0;
+        for (int k = 0; k < 4; k++) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(col + i + k * 16));
+            __m128i fuera = _mm_cmpgt_epi8(_mm_xor_si128(_mm_sub_epi8(v, vlo), signo), lim);
+            w |= (uint64_t)(~(uint32_t)_mm_movemask_epi8(fuera) & 0xFFFF) << (k * 16);
+        }
+        bits[i / 64] = w;
+    }
+    rangoEscalar(col, i, n, lo, hi, bits);
+}
+
+// ---------------- 5. KERNELS AVX2 ----------------
+
+/*
+ * 5.1 Versiones AVX2
+ * Mismo truco de signo que SSE2 con registros de 256 bits:
+ * 8 valores de 32 bits, 16 de 16 bits o 32 de 8 bits por comparación.
+ */
+__attribute__((target("avx2")))
+inline void rangoU32Avx2(const uint32_t* col, size_t n, uint32_t lo, uint32_t hi, uint64_t* bits) {
+    const __m256i vlo = _mm256_set1_epi32((int)lo);
+    const __m256i signo = _mm256_set1_epi32((int)0x80000000u);
+    const __m256i lim = _mm256_set1_epi32((int)((hi - lo) ^ 0x80000000u));
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        uint64_t w = 0;
+        for (int k = 0; k < 8; k++) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(col + i + k * 8));
+            v = _mm256_xor_si256(_mm256_sub_epi32(v, vlo), signo);
+            __m256i fuera = _mm256_cmpgt_epi32(v, lim);
+            uint64_t m = (uint64_t)(~_mm256_movemask_ps(_mm256_castsi256_ps(fuera)) & 0xFF);
+            w |= m << (k * 8);
+        }
+        bits[i / 64] = w;
+    }
+    rangoEscalar(col, i, n, lo, hi, bits);
+}
+
+__attribute__((target("avx2")))
+inline void mascaraU32Avx2(const uint32_t* col, size_t n, uint32_t mascara, uint32_t valor, uint64_t* bits) {
+    const __m256i vm = _mm256_set1_epi32((int)mascara);
+    const __m256i vv = _mm256_set1_epi32((int)valor);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        uint64_t w = 0;
+        for (int k = 0; k < 8; k++) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(col + i + k * 8));
+            __m256i eq = _mm256_cmpeq_epi32(_mm256_and_si256(v, vm), vv);
+            w |= (uint64_t)_mm256_movemask_ps(_mm256_castsi256_ps(eq)) << (k * 8);
+        }
+        bits[i / 64] = w;
+    }
+    mascaraEscalar(col, i, n, mascara, valor, bits);
+}
+
+__attribute__((target("avx2")))
+inline void rangoU16Avx2(const uint16_t* col, size_t n, uint32_t lo, uint32_t hi, uint64_t* bits) {
+    if (lo > 0xFFFF) { rangoEscalar(col, 0, n, lo, hi, bits); return; }
+    if (hi > 0xFFFF) hi = 0xFFFF;
+    const __m256i vlo = _mm256_set1_epi16((short)lo);
+    const __m256i signo = _mm256_set1_epi16((short)0x8000);
+    const __m256i lim = _mm256_set1_epi16((short)((hi - lo) ^ 0x8000));
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        uint64_t w = 0;
+        for (int k = 0; k < 2; k++) {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(col + i + k * 32));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(col + i + k * 32 + 16));
+            a = _mm256_cmpgt_epi16(_mm256_xor_si256(_mm256_sub_epi16(a, vlo), signo), lim);
+            b = _mm256_cmpgt_epi16(_mm256_xor_si256(_mm256_sub_epi16(b, vlo), signo), lim);
+            // packs intercala carriles de 128 bits; permute4x64 restaura el orden
+            __m256i p = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+            uint32_t fuera = (uint32_t)_mm256_movemask_epi8(p);
+            w |= (uint64_t)(~fuera) << (k * 32);
+        }
+        bits[i / 64] = w;
+    }
+    rangoEscalar(col, i, n, lo, hi, bits);
+}
+
+__attribute__((target("avx2")))
+inline void rangoU8Avx2(const uint8_t* col, size_t n, uint32_t lo, uint32_t hi, uint64_t* bits) {
+    if (lo > 0xFF) { rangoEscalar(col, 0, n, lo, hi, bits); return; }
+    if (hi > 0xFF) hi = 0xFF;
+    const __m256i vlo = _mm256_set1_epi8((char)lo);
+    const __m256i signo = _mm256_set1_epi8((char)0x80);
+    const __m256i lim = _mm256_set1_epi8((char)((hi - lo) ^ 0x80));
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(col + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(col + i + 32));
+        a = _mm256_cmpgt_epi8(_mm256_xor_si256(_mm256_sub_epi8(a, vlo), signo), lim);
+        b = _mm256_cmpgt_epi8(_mm256_xor_si256(_mm256_sub_epi8(b, vlo), signo), lim);
+        uint64_t fuera = (uint64_t)(uint32_t)_mm256_movemask_epi8(a) |
+                         ((uint64_t)(uint32_t)_mm256_movemask_epi8(b) << 32);
+        bits[i / 64] = ~fuera;
+    }
+    rangoEscalar(col, i, n, lo, hi, bits);
+}
+
+#endif // COMUN_X86
+
+// ---------------- 6. PUNTOS DE ENTRADA ----------------
+
+/*
+ * 6.1 filtroRango / filtroMascara
+ * Escriben palabrasPara(n) palabras en bits según el nivel activo.
+ * Los bits sobrantes de la última palabra quedan en 0.
+ * Complejidad: O(n) con 8-32 comparaciones por instrucción.
+ */
+inline void filtroRango(const uint32_t* col, size_t n, uint32_t lo, uint32_t hi, uint64_t* bits) {
+#ifdef COMUN_X86
+    switch (nivelSimd()) {
+    case SIMD_AVX2: rangoU32Avx2(col, n, lo, hi, bits); return;
+    case SIMD_SSE2: rangoU32Sse2(col, n, lo, hi, bits); return;
+    default: break;
+    }
+#endif
+    rangoEscalar(col, 0, n, lo, hi, bits);
+}
+
+inline void filtroRango(const uint16_t* col, size_t n, uint32_t lo, uint32_t hi, uint64_t* bits) {
+#ifdef COMUN_X86
+    switch (nivelSimd()) {
+    case SIMD_AVX2: rangoU16Avx2(col, n, lo, hi, bits); return;
+    case SIMD_SSE2: rangoU16Sse2(col, n, lo, hi, bits); return;
+    default: break;
+    }
+#endif
+    rangoEscalar(col, 0, n, lo, hi, bits);
+}
+
+inline void filtroRango(const uint8_t* col, size_t n, uint32_t lo, uint32_t hi, uint64_t* bits) {
+#ifdef COMUN_X86
+    switch (nivelSimd()) {
+    case SIMD_AVX2: rangoU8Avx2(col, n, lo, hi, bits); return;
+    case SIMD_SSE2: rangoU8Sse2(col, n, lo, hi, bits); return;
+    default: break;
+    }
+#endif
+    rangoEscalar(col, 0, n, lo, hi, bits);
+}
+
+inline void filtroMascara(const uint32_t* col, size_t n, uint32_t mascara, uint32_t valor, uint64_t* bits) {
+#ifdef COMUN_X86
+    switch (nivelSimd()) {
+    case SIMD_AVX2: mascaraU32Avx2(col, n, mascara, valor, bits); return;
+    case SIMD_SSE2: mascaraU32Sse2(col, n, mascara, valor, bits); return;
+    default: break;
+    }
+#endif
+    mascaraEscalar(col, 0, n, mascara, valor, bits);
+}
+
+/*
+ * 6.2 filtroConjunto
+ * v pertenece a un conjunto de 256 valores dado como 4 palabras de bits
+ * (p.ej. los ids de razón que contienen una palabra). Es una búsqueda en
+ * tabla por renglón, sin ramas; no tiene versión SIMD porque la tabla de
+ * 256 bits no cabe en un solo registro de comparación.
+ */
+inline void filtroConjunto(const uint8_t* col, size_t n, const uint64_t* conjunto, uint64_t* bits) {
+    for (size_t i = 0; i < n; i += 64) {
+        size_t fin = i + 64 < n ? i + 64 : n;
+        uint64_t w = 0;
+        for (size_t j = i; j < fin; j++) {
+            uint8_t v = col[j];
+            w |= ((conjunto[v >> 6] >> (v & 63)) & 1) << (j - i);
+        }
+        bits[i / 64] = w;
+    }
+}
+
+/*
+ * 6.3 filtroIgual
+ * Igualdad como rango de un solo valor.
+ */
+template <typename T>
+inline void filtroIgual(const T* col, size_t n, uint32_t v, uint64_t* bits) {
+    filtroRango(col, n, v, v, bits);
+}
+
+} // namespace comun
+
+#endif
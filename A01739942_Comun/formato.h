@@ -0,0 +1,305 @@
+/*
+    Descripción: Reconstrucción rápida de las líneas de la bitácora
+    ("Mon DD HH:MM:SS a.b.c.d:puerto razón") a partir de registros
+    empacados, para no tener que guardar la línea original de cada uno.
+
+    formatearLinea (registro.h) usa snprintf: interpreta la cadena de
+    formato en cada llamada y convierte cada número dividiendo entre 10.
+    Aquí todo sale de tablas calculadas una vez y se copia con memcpy de
+    largo fijo:
+        prefijo de día   "Mon DD " por cada día del año (diaDelAnio)
+        dos dígitos      "00".."99" para hora, minuto, segundo y puerto
+        octetos          "0".."255" con su largo, 4 bytes por entrada
+        razones          copia contigua de los textos del diccionario
+    y se escribe directo en un búfer de salida grande (SalidaLineas) que se
+    entrega al ostream de a 1 MiB, sin pasar por operator<< por línea.
+    esCanonica dice si una línea leída se puede regenerar así: las
+    actividades guardan el texto original solo de las que no.
+
+    El resultado es idéntico byte a byte al de formatearLinea (salvo que
+    aquí las razones largas no se truncan), y por lo tanto al de la
+    bitácora cuando la línea viene en forma canónica: día y horas con dos
+    dígitos y un espacio entre campos. Medición: bench formato.
+*/
+
+#ifndef COMUN_FORMATO_H
+#define COMUN_FORMATO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "registro.h"
+
+namespace comun {
+
+// ---------------- 1. TABLAS ----------------
+
+/*
+ * 1.1 TablasFormato
+ * Tablas compartidas por todos los formateadores (se llenan la primera vez
+ * que se piden). prefijoDia tiene los DIAS_ANIO días del año: cualquier
+ * clave de tiempo cae en alguno, sea del año que sea.
+ * Espacio: ~5 KB.
+ */
+struct TablasFormato {
+    char prefijoDia[DIAS_ANIO][8];  // "Mon DD " (7 bytes usados)
+    char dosDigitos[100][2];
+    char octeto[256][4];
+    uint8_t largoOcteto[256];
+
+    static const TablasFormato& global() {
+        static const TablasFormato t;
+        return t;
+    }
+
+private:
+    TablasFormato() {
+        for (int i = 0; i < 100; i++) {
+            dosDigitos[i][0] = (char)('0' + i / 10);
+            dosDigitos[i][1] = (char)('0' + i % 10);
+        }
+        for (int i = 0; i < 256; i++) {
+            char buf[8];
+            int n = std::snprintf(buf, sizeof buf, "%d", i);
+            std::memset(octeto[i], 0, 4);
+            std::memcpy(octeto[i], buf, (size_t)n);
+            largoOcteto[i] = (uint8_t)n;
+        }
+        std::memset(prefijoDia, ' ', sizeof prefijoDia);
+        for (uint32_t k = 0; k < DIAS_ANIO; k++) {
+            uint32_t t = k * SEGUNDOS_DIA;
+            std::memcpy(prefijoDia[k], MESES[mesDe(t) - 1], 3);
+            std::memcpy(prefijoDia[k] + 4, dosDigitos[diaDe(t)], 2);
+        }
+    }
+};
+
+// ---------------- 2. ESCRITURA DE CAMPOS ----------------
+
+/*
+ * 2.1 escribirDecimal
+ * v (< 100000) en decimal sin ceros a la izquierda, dos dígitos a la vez.
+ * Devuelve el fin de lo escrito.
+ * Complejidad: O(1).
+ */
+inline char* escribirDecimal(const TablasFormato& tf, uint32_t v, char* p) {
+    if (v < 10) {
+        *p = (char)('0' + v);
+        return p + 1;
+    }
+    if (v < 100) {
+        std::memcpy(p, tf.dosDigitos[v], 2);
+        return p + 2;
+    }
+    if (v < 1000) {
+        *p = (char)('0' + v / 100);
+        std::memcpy(p + 1, tf.dosDigitos[v % 100], 2);
+        return p + 3;
+    }
+    if (v < 10000) {
+        std::memcpy(p, tf.dosDigitos[v / 100], 2);
+        std::memcpy(p + 2, tf.dosDigitos[v % 100], 2);
+        return p + 4;
+    }
+    *p = (char)('0' + v / 10000);
+    v %= 10000;
+    std::memcpy(p + 1, tf.dosDigitos[v / 100], 2);
+    std::memcpy(p + 3, tf.dosDigitos[v % 100], 2);
+    return p + 5;
+}
+
+/*
+ * 2.2 escribirLinea
+ * Escribe la línea del registro (sin '\n') en p y devuelve su fin. Hace
+ * falta espacio para MAX_FIJO + razon.size() bytes: cada octeto se copia
+ * con 4 bytes aunque mida menos (lo que sobra lo pisa el campo siguiente).
+ * El año no se escribe: la bitácora no lo trae.
+ * Complejidad: O(L), L = largo de la razón.
+ */
+const size_t MAX_FIJO = 48;     // "Mon DD HH:MM:SS " + IP + ":puerto " y holgura
+
+inline char* escribirLinea(const TablasFormato& tf, const Registro& r, std::string_view razon, char* p) {
+    uint32_t s = r.tiempo % SEGUNDOS_DIA;
+    std::memcpy(p, tf.prefijoDia[diaDelAnio(r.tiempo)], 8);
+    std::memcpy(p + 7, tf.dosDigitos[s / 3600], 2);
+    p[9] = ':';
+    std::memcpy(p + 10, tf.dosDigitos[s / 60 % 60], 2);
+    p[12] = ':';
+    std::memcpy(p + 13, tf.dosDigitos[s % 60], 2);
+    p[15] = ' ';
+    p += 16;
+    for (int desp = 24; desp >= 0; desp -= 8) {
+        uint32_t o = (r.ip >> desp) & 255;
+        std::memcpy(p, tf.octeto[o], 4);
+        p += tf.largoOcteto[o];
+        *p++ = desp > 0 ? '.' : ':';
+    }
+    p = escribirDecimal(tf, r.puerto, p);
+    *p++ = ' ';
+    std::memcpy(p, razon.data(), razon.size());
+    return p + razon.size();
+}
+
+/*
+ * 2.3 esCanonica
+ * ¿Es 'linea' exactamente lo que escribirLinea regenera del registro? Si
+ * sí, no hace falta guardar el texto original: se vuelve a escribir
+ * idéntico. Las líneas con campos fuera de rango, ceros de más o espacios
+ * extra dan false y se guardan tal cual.
+ * Complejidad: O(L).
+ */
+inline bool esCanonica(const Registro& r, std::string_view razon, std::string_view linea) {
+    char buf[512];
+    if (MAX_FIJO + razon.size() > sizeof buf) return false;
+    char* fin = escribirLinea(TablasFormato::global(), r, razon, buf);
+    return linea == std::string_view(buf, (size_t)(fin - buf));
+}
+
+// ---------------- 3. SALIDA ----------------
+
+/*
+ * 3.1 SalidaLineas
+ * Búfer de salida grande: quien escribe pide espacio con reservar(n),
+ * escribe directo ahí y marca el fin con confirmar(). Al llenarse (o al
+ * destruirse) se entrega completo al ostream con un solo write.
+ *     SalidaLineas sal(cout);
+ *     char* p = sal.reservar(n);
+ *     sal.confirmar(escribirLinea(..., p));
+ */
+class SalidaLineas {
+public:
+    static constexpr size_t CAPACIDAD = 1u << 20;
+
+    explicit SalidaLineas(std::ostream& out, size_t capacidad = CAPACIDAD) : out(out), bufer(capacidad) {}
+    ~SalidaLineas() { vaciar(); }
+
+    SalidaLineas(const SalidaLineas&) = delete;
+    SalidaLineas& operator=(const SalidaLineas&) = delete;
+
+    char* reservar(size_t n) {
+        if (usado + n > bufer.size()) {
+            vaciar();
+            if (n > bufer.size()) bufer.resize(n);
+        }
+        return bufer.data() + usado;
+    }
+
+    void confirmar(char* fin) { usado = (size_t)(fin - bufer.data()); }
+
+    void escribir(const char* p, size_t n) {
+        std::memcpy(reservar(n), p, n);
+        usado += n;
+    }
+
+    void vaciar() {
+        if (usado > 0) out.write(bufer.data(), (std::streamsize)usado);
+        usado = 0;
+    }
+
+private:
+    std::ostream& out;
+    std::vector<char> bufer;
+    size_t usado = 0;
+};
+
+/*
+ * 3.2 escribirLinea (a una SalidaLineas)
+ * La línea del registro con su razón en texto, con '\n' al final si salto.
+ */
+inline void escribirLinea(SalidaLineas& sal, const Registro& r, std::string_view razon, bool salto = true) {
+    char* p = escribirLinea(TablasFormato::global(), r, razon, sal.reservar(MAX_FIJO + razon.size() + 1));
+    if (salto) *p++ = '\n';
+    sal.confirmar(p);
+}
+
+/*
+ * 3.3 registroDeCampos / escribirRegistro
+ * Para las actividades, que guardan la IP en cuatro octetos y el texto de
+ * la línea solo si no es canónica (esCanonica): registroDeCampos arma el
+ * Registro (razón 0: el texto va aparte) y escribirRegistro escribe la
+ * línea regenerada, o lineaOriginal tal cual cuando no está vacía.
+ * Complejidad: O(L).
+ */
+inline Registro registroDeCampos(uint32_t tiempo, int ip1, int ip2, int ip3, int ip4, int puerto) {
+    Registro r;
+    r.tiempo = tiempo;
+    r.ip = ((uint32_t)ip1 << 24) | ((uint32_t)ip2 << 16) | ((uint32_t)ip3 << 8) | (uint32_t)ip4;
+    r.puerto = (uint16_t)puerto;
+    r.razon = 0;
+    return r;
+}
+
+inline void escribirRegistro(SalidaLineas& sal, const Registro& r, std::string_view razon,
+                             std::string_view lineaOriginal, bool salto = true) {
+    if (lineaOriginal.empty()) {
+        escribirLinea(sal, r, razon, salto);
+        return;
+    }
+    sal.escribir(lineaOriginal.data(), lineaOriginal.size());
+    if (salto) sal.escribir("\n", 1);
+}
+
+// ---------------- 4. FORMATEADOR ----------------
+
+/*
+ * 4.1 FormateadorLineas
+ * Escribe líneas de una tabla (o de registros sueltos con razones del
+ * mismo diccionario) en una SalidaLineas. Copia los textos de las razones
+ * a un arreglo contiguo: el diccionario los guarda en un deque de strings
+ * y así cada línea lee su razón de memoria que ya está en caché.
+ * actualizar() agrega las razones nuevas si el diccionario creció.
+ *     FormateadorLineas f(t.razones);
+ *     SalidaLineas sal(cout);
+ *     for (uint32_t id : ids) f.linea(t, id, sal);
+ * Complejidad: O(L) por línea.
+ */
+class FormateadorLineas {
+public:
+    explicit FormateadorLineas(const DiccionarioRazones& razones) : tf(TablasFormato::global()) {
+        inicio.push_back(0);
+        actualizar(razones);
+    }
+
+    void actualizar(const DiccionarioRazones& razones) {
+        for (int id = (int)inicio.size() - 1; id < razones.size(); id++) {
+            textos += razones.texto(id);
+            inicio.push_back((uint32_t)textos.size());
+        }
+    }
+
+    std::string_view razon(uint8_t id) const {
+        return std::string_view(textos.data() + inicio[id], inicio[id + 1] - inicio[id]);
+    }
+
+    // escribe la línea con '\n'; r.razon es un id del diccionario
+    void linea(const Registro& r, SalidaLineas& sal) const {
+        std::string_view texto = razon(r.razon);
+        char* p = escribirLinea(tf, r, texto, sal.reservar(MAX_FIJO + texto.size() + 1));
+        *p++ = '\n';
+        sal.confirmar(p);
+    }
+
+    void linea(const TablaRegistros& t, size_t i, SalidaLineas& sal) const {
+        linea(Registro{t.tiempo[i], t.ip[i], t.puerto[i], t.razon[i]}, sal);
+    }
+
+    // razón en texto (registros que no pasaron por un diccionario)
+    void linea(const Registro& r, std::string_view texto, SalidaLineas& sal) const {
+        escribirLinea(sal, r, texto);
+    }
+
+private:
+    const TablasFormato& tf;
+    std::string textos;
+    std::vector<uint32_t> inicio;   // textos de la razón i: [inicio[i], inicio[i+1])
+};
+
+} // namespace comun
+
+#endif
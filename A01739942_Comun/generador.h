@@ -0,0 +1,395 @@
+/*
+    Descripción: Generadores perezosos con corrutinas de C++20 para recorrer
+    la bitácora sin materializarla.
+
+    Las actividades leen todo a un vector (o al ipMap, o a la tabla hash)
+    antes del siguiente paso. Con un Generador<T> cada etapa pide el
+    siguiente elemento a la anterior solo cuando lo necesita: no hay
+    contenedores intermedios y una consulta como "las primeras 100 líneas de
+    la IP X" deja de leer el archivo en cuanto junta las 100.
+
+        registrosDe("bitacora.txt")
+            | filtrar([](const RegistroCrudo& c) { return c.r.ip == x; })
+            | tomar(100)
+
+    Etapas:
+        filtrar(pred)                   solo los que cumplen pred
+        transformar(fn)                 fn(x) por cada x
+        tomar(n)                        los primeros n y se detiene
+        agruparConsecutivos(clave)      rachas de elementos seguidos con la
+                                        misma clave (la bitácora viene en
+                                        orden de tiempo: por minuto, día...)
+
+    Los elementos se entregan por referencia al valor que vive dentro de la
+    corrutina: una referencia (y los string_view de RegistroCrudo) solo es
+    válida hasta pedir el siguiente; si hay que conservarlo se copia.
+
+    Para un juego de bitácoras rotadas, registrosMezclados entrega los
+    registros de todos los archivos como un solo flujo en orden de tiempo.
+
+    Requiere C++20 (g++ -std=c++20).
+*/
+
+#ifndef COMUN_GENERADOR_H
+#define COMUN_GENERADOR_H
+
+#if !defined(__cpp_impl_coroutine)
+#error "generador.h requiere corrutinas de C++20 (compilar con -std=c++20)"
+#endif
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "gzip.h"
+#include "mezcla.h"
+#include "registro.h"
+
+namespace comun {
+
+// ---------------- 1. GENERADOR ----------------
+
+/*
+ * 1.1 Generador
+ * Tipo de regreso de una corrutina que hace co_yield de valores T. La
+ * corrutina arranca suspendida y avanza un co_yield cada vez que el
+ * iterador se incrementa; al destruir el generador se destruye su marco
+ * (aunque no haya terminado), así que cortar un recorrido no fuga nada.
+ * Una excepción dentro de la corrutina sale en el ++ que la provocó.
+ * Complejidad: O(1) por elemento además del trabajo de la corrutina.
+ */
+template <class T>
+class Generador {
+public:
+    struct promise_type {
+        const T* actual = nullptr;
+        std::exception_ptr excepcion;
+
+        Generador get_return_object() {
+            return Generador(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        // un temporal de co_yield vive hasta que se reanuda la corrutina
+        std::suspend_always yield_value(const T& valor) noexcept {
+            actual = std::addressof(valor);
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { excepcion = std::current_exception(); }
+
+        // un generador no espera a nadie
+        template <class U>
+        std::suspend_never await_transform(U&&) = delete;
+    };
+
+    using Manija = std::coroutine_handle<promise_type>;
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        iterator() = default;
+        explicit iterator(Manija m) : manija(m) {}
+
+        reference operator*() const { return *manija.promise().actual; }
+        pointer operator->() const { return manija.promise().actual; }
+
+        iterator& operator++() {
+            avanzar(manija);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        bool operator==(std::default_sentinel_t) const { return !manija || manija.done(); }
+
+    private:
+        Manija manija;
+    };
+
+    Generador(Generador&& otro) noexcept : manija(std::exchange(otro.manija, {})) {}
+    Generador& operator=(Generador&& otro) noexcept {
+        if (this != &otro) {
+            if (manija) manija.destroy();
+            manija = std::exchange(otro.manija, {});
+        }
+        return *this;
+    }
+    Generador(const Generador&) = delete;
+    Generador& operator=(const Generador&) = delete;
+
+    ~Generador() {
+        if (manija) manija.destroy();
+    }
+
+    // begin() corre la corrutina hasta el primer co_yield; solo se recorre una vez
+    iterator begin() {
+        if (manija) avanzar(manija);
+        return iterator(manija);
+    }
+    std::default_sentinel_t end() { return {}; }
+
+private:
+    Manija manija;
+
+    explicit Generador(Manija m) : manija(m) {}
+
+    static void avanzar(Manija m) {
+        m.resume();
+        if (m.done() && m.promise().excepcion) std::rethrow_exception(m.promise().excepcion);
+    }
+};
+
+// ---------------- 2. ETAPAS ----------------
+
+/*
+ * 2.1 Etapa / operator|
+ * Una etapa sin su entrada (filtrar(pred), tomar(n)...): g | etapa la aplica
+ * al generador g, así las etapas se encadenan de izquierda a derecha.
+ */
+template <class F>
+struct Etapa {
+    F aplicar;
+};
+
+template <class T, class F>
+auto operator|(Generador<T>&& g, Etapa<F> e) {
+    return e.aplicar(std::move(g));
+}
+
+/*
+ * 2.2 filtrar
+ * Complejidad: O(1) por elemento además de pred.
+ */
+template <class T, class P>
+Generador<T> filtrar(Generador<T> g, P pred) {
+    for (const T& x : g)
+        if (pred(x)) co_yield x;
+}
+
+template <class P>
+auto filtrar(P pred) {
+    return Etapa{[pred](auto g) { return filtrar(std::move(g), pred); }};
+}
+
+/*
+ * 2.3 transformar
+ * El valor de fn(x) vive en la corrutina hasta pedir el siguiente.
+ */
+template <class T, class F, class U = std::decay_t<std::invoke_result_t<F&, const T&>>>
+Generador<U> transformar(Generador<T> g, F fn) {
+    for (const T& x : g) co_yield fn(x);
+}
+
+template <class F>
+auto transformar(F fn) {
+    return Etapa{[fn](auto g) { return transformar(std::move(g), fn); }};
+}
+
+/*
+ * 2.4 tomar
+ * Entrega los primeros n y regresa sin volver a reanudar la entrada: las
+ * etapas de atrás (y la lectura del archivo) se detienen ahí.
+ */
+template <class T>
+Generador<T> tomar(Generador<T> g, size_t n) {
+    if (n == 0) co_return;
+    for (const T& x : g) {
+        co_yield x;
+        if (--n == 0) co_return;
+    }
+}
+
+inline auto tomar(size_t n) {
+    return Etapa{[n](auto g) { return tomar(std::move(g), n); }};
+}
+
+/*
+ * 2.5 agruparConsecutivos
+ * Junta los elementos seguidos que tienen la misma clave(x) en una Racha.
+ * Solo la racha actual se guarda en memoria; los elementos se copian
+ * porque la referencia de la entrada deja de ser válida al avanzar (con
+ * RegistroCrudo, cuya razón apunta al bloque leído, conviene transformar
+ * antes a un valor que sea dueño de su texto).
+ * Para agrupar sin orden hace falta una tabla (como group by en Consultas).
+ */
+template <class K, class T>
+struct Racha {
+    K clave;
+    std::vector<T> elementos;
+};
+
+template <class T, class C, class K = std::decay_t<std::invoke_result_t<C&, const T&>>>
+Generador<Racha<K, T>> agruparConsecutivos(Generador<T> g, C clave) {
+    Racha<K, T> racha;
+    bool abierta = false;
+    for (const T& x : g) {
+        K k = clave(x);
+        if (abierta && !(k == racha.clave)) {
+            co_yield racha;
+            racha.elementos.clear();
+        }
+        racha.clave = std::move(k);
+        racha.elementos.push_back(x);
+        abierta = true;
+    }
+    if (abierta) co_yield racha;
+}
+
+template <class C>
+auto agruparConsecutivos(C clave) {
+    return Etapa{[clave](auto g) { return agruparConsecutivos(std::move(g), clave); }};
+}
+
+// ---------------- 3. FUENTES ----------------
+
+/*
+ * 3.1 lineasDe
+ * Líneas del archivo (sin '\n' ni '\r'), leídas por bloques de 1 MiB; la
+ * línea que queda partida entre dos bloques se completa con el siguiente.
+ * El archivo puede estar comprimido con gzip (EntradaBitacora, gzip.h).
+ * Si el archivo no se puede abrir escribe el error, deja *ok en false y no
+ * entrega nada.
+ * Memoria: un bloque más la línea más larga.
+ */
+inline Generador<std::string_view> lineasDe(std::string ruta, bool* ok = nullptr) {
+    EntradaBitacora archivo(ruta);
+    if (ok) *ok = archivo.is_open();
+    if (!archivo.is_open()) {
+        std::cerr << "Error: no se pudo abrir el archivo " << ruta << "\n";
+        co_return;
+    }
+    const size_t BLOQUE = 1u << 20;
+    std::vector<char> buf(BLOQUE);
+    size_t arrastre = 0;        // bytes de una línea incompleta al inicio de buf
+    for (;;) {
+        if (arrastre == buf.size()) buf.resize(buf.size() * 2);
+        archivo.read(buf.data() + arrastre, (std::streamsize)(buf.size() - arrastre));
+        size_t n = (size_t)archivo.gcount();
+        size_t total = arrastre + n;
+        const char* p = buf.data();
+        const char* fin = p + total;
+        for (;;) {
+            const char* nl = (const char*)std::memchr(p, '\n', (size_t)(fin - p));
+            if (!nl) break;
+            const char* finLinea = (nl > p && nl[-1] == '\r') ? nl - 1 : nl;
+            co_yield std::string_view(p, (size_t)(finLinea - p));
+            p = nl + 1;
+        }
+        arrastre = (size_t)(fin - p);
+        if (n == 0) {
+            // última línea sin '\n' (como getline)
+            if (arrastre > 0) {
+                if (fin[-1] == '\r') --fin;
+                co_yield std::string_view(p, (size_t)(fin - p));
+            }
+            if (ok && archivo.fallo()) *ok = false;
+            co_return;
+        }
+        std::memmove(buf.data(), p, arrastre);
+    }
+}
+
+/*
+ * 3.2 registrosDe
+ * Registros de la bitácora en el orden del archivo; las líneas mal formadas
+ * se omiten y se cuentan en *omitidas. r.razon no se llena (no hay
+ * diccionario): la razón va como texto en 'razon'. anios, si está activa,
+ * asigna el año de cada registro a partir de su estado (registro.h); las
+ * líneas que saltan hacia adelante se retienen hasta saber si eran
+ * rezagados o un hueco.
+ */
+inline Generador<RegistroCrudo> registrosDe(std::string ruta, bool* ok = nullptr, size_t* omitidas = nullptr,
+                                            InferenciaAnio anios = InferenciaAnio()) {
+    // líneas que saltaron hacia adelante y esperan a saber su año (a lo más
+    // CONFIRMAR - 1); la razón se copia porque el búfer de líneas avanza
+    struct Pendiente {
+        Registro r;
+        std::string razon;
+    };
+    std::vector<Pendiente> pendientes;
+    const InferenciaAnio inicio = anios;
+    std::string origen = ruta;
+    RegistroCrudo c{};
+    for (std::string_view linea : lineasDe(std::move(ruta), ok)) {
+        if (!parsearCampos(linea.data(), linea.data() + linea.size(), c.r, c.razon)) {
+            if (omitidas) ++*omitidas;
+            continue;
+        }
+        c.r.tiempo = anios.ajustar(c.r.tiempo);
+        if (anios.pendientes() > 0) {
+            pendientes.push_back({c.r, std::string(c.razon)});
+            continue;
+        }
+        for (size_t k = 0; k < anios.reasignados() && k < pendientes.size(); k++)
+            pendientes[pendientes.size() - 1 - k].r.tiempo += SEGUNDOS_ANIO;
+        for (const Pendiente& p : pendientes) co_yield RegistroCrudo{p.r, p.razon};
+        pendientes.clear();
+        co_yield c;
+    }
+    for (const Pendiente& p : pendientes) co_yield RegistroCrudo{p.r, p.razon};
+    anios.avisarSiSospechosa(origen, inicio);
+}
+
+/*
+ * 3.3 registrosMezclados
+ * Un juego de bitácoras rotadas (archivosRotados, del más viejo al más
+ * nuevo) como un solo flujo en orden de tiempo: un registrosDe por archivo
+ * y un árbol de perdedores (mezcla.h) que entrega siempre la cabeza menor.
+ * Solo la línea actual de cada archivo está en memoria; la razón entregada
+ * sigue válida porque su archivo no avanza hasta pedir el siguiente.
+ * Con --cambio-anio (Calendario) el año con que empieza cada archivo
+ * depende de los anteriores: antes de mezclar se recorren todos menos el
+ * último solo para contar los cambios de año.
+ * Complejidad: O(log k) comparaciones por registro.
+ */
+inline Generador<RegistroCrudo> registrosMezclados(std::vector<std::string> rutas, bool* ok = nullptr) {
+    size_t k = rutas.size();
+    std::unique_ptr<bool[]> leidos(new bool[k]);
+    std::vector<InferenciaAnio> inicio;
+    InferenciaAnio anios(Calendario::global().cambioAnio);
+    for (size_t i = 0; i < k; i++) {
+        inicio.push_back(anios);
+        if (anios.activa() && i + 1 < k)
+            for (const RegistroCrudo& c : registrosDe(rutas[i])) anios.ajustar(c.r.tiempo);
+    }
+    std::vector<Generador<RegistroCrudo>> fuentes;
+    std::vector<Generador<RegistroCrudo>::iterator> cabezas;
+    fuentes.reserve(k);
+    for (size_t i = 0; i < k; i++) {
+        fuentes.push_back(registrosDe(rutas[i], &leidos[i], nullptr, inicio[i]));
+        cabezas.push_back(fuentes.back().begin());
+    }
+    auto menor = [&](size_t a, size_t b) { return cabezas[a]->r.tiempo < cabezas[b]->r.tiempo; };
+    ArbolPerdedores<decltype(menor)> arbol(k, menor);
+    arbol.iniciar([&](size_t i) { return cabezas[i] == fuentes[i].end(); });
+    while (!arbol.vacio()) {
+        size_t w = arbol.ganador();
+        co_yield *cabezas[w];
+        ++cabezas[w];
+        arbol.avanzar(cabezas[w] == fuentes[w].end());
+    }
+    if (ok) {
+        *ok = true;
+        for (size_t i = 0; i < k; i++) *ok = *ok && leidos[i];
+    }
+}
+
+} // namespace comun
+
+#endif
@@ -0,0 +1,469 @@
+/*
+    Descripción: Lectura transparente de bitácoras comprimidas con gzip.
+
+    Las bitácoras archivadas están en .gz; en lugar de descomprimirlas a
+    disco antes de correr un programa, los bytes leídos pasan por un
+    Descompresor que detecta el formato por los primeros bytes:
+
+        texto plano   se entrega tal cual (sin copia extra en la tubería)
+        gzip          inflate en flujo, un miembro tras otro (cat a.gz b.gz)
+        BGZF          gzip partido en miembros independientes de <= 64 KB
+                      (bgzip, htslib) con su tamaño en el encabezado: se
+                      cortan sin descomprimir y cada lote de miembros se
+                      descomprime en paralelo en el conjunto de hilos
+
+    Un gzip común (un solo miembro) no se puede partir: su descompresión es
+    secuencial, pero corre en el hilo lector de la tubería mientras los
+    parsers trabajan, así que solo limita si inflate es más lento que el
+    parseo. Con BGZF la descompresión escala con los núcleos.
+
+    zlib se carga al vuelo con dlopen (libz.so.1) la primera vez que aparece
+    un archivo comprimido, igual que io_uring se usa sin liburing: los
+    programas no necesitan -lz y el texto plano no depende de zlib.
+
+    Entradas:
+        leerDescomprimido(lector, entregar)   para la tubería (tuberia.h)
+        EntradaBitacora in("bitacora.txt")    istream para getline (Acts)
+    Ambas aceptan bitacora.txt.gz si bitacora.txt no existe (rutaEntrada).
+*/
+
+#ifndef COMUN_GZIP_H
+#define COMUN_GZIP_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+#if defined(__has_include)
+#if __has_include(<zlib.h>) && __has_include(<dlfcn.h>)
+#include <dlfcn.h>
+#include <zlib.h>
+#define COMUN_CON_ZLIB 1
+#endif
+#endif
+
+#include "hilos.h"
+#include "lector_asincrono.h"
+
+namespace comun {
+
+// ---------------- 1. ZLIB AL VUELO ----------------
+
+/*
+ * 1.1 Zlib
+ * Las cuatro funciones de inflate que se usan, resueltas con dlsym. La
+ * carga ocurre una sola vez (estático local) y es segura entre hilos.
+ */
+struct Zlib {
+#ifdef COMUN_CON_ZLIB
+    int (*inflateInit2_)(z_streamp, int, const char*, int) = nullptr;
+    int (*inflate)(z_streamp, int) = nullptr;
+    int (*inflateReset)(z_streamp) = nullptr;
+    int (*inflateEnd)(z_streamp) = nullptr;
+#endif
+    std::string error;
+
+    static const Zlib& global() {
+        static Zlib z;
+        return z;
+    }
+
+    bool disponible() const { return error.empty(); }
+
+#ifdef COMUN_CON_ZLIB
+    // gzip con encabezado (15 + 16); la versión es la del zlib.h compilado
+    int iniciar(z_stream& z) const {
+        std::memset(&z, 0, sizeof z);
+        return inflateInit2_(&z, 15 + 16, ZLIB_VERSION, (int)sizeof(z_stream));
+    }
+#endif
+
+private:
+    Zlib() {
+#ifdef COMUN_CON_ZLIB
+        void* lib = dlopen("libz.so.1", RTLD_NOW | RTLD_LOCAL);
+        if (!lib) lib = dlopen("libz.so", RTLD_NOW | RTLD_LOCAL);
+        if (!lib) {
+            error = "no se pudo cargar zlib (libz.so.1)";
+            return;
+        }
+        inflateInit2_ = (int (*)(z_streamp, int, const char*, int))dlsym(lib, "inflateInit2_");
+        inflate = (int (*)(z_streamp, int))dlsym(lib, "inflate");
+        inflateReset = (int (*)(z_streamp))dlsym(lib, "inflateReset");
+        inflateEnd = (int (*)(z_streamp))dlsym(lib, "inflateEnd");
+        if (!inflateInit2_ || !inflate || !inflateReset || !inflateEnd) error = "zlib incompleta";
+#else
+        error = "compilado sin zlib.h";
+#endif
+    }
+};
+
+// ---------------- 2. FORMATO ----------------
+
+/*
+ * 2.1 esGzip
+ * Número mágico 1f 8b y método deflate (8).
+ */
+inline bool esGzip(const unsigned char* p, size_t n) {
+    return n >= 3 && p[0] == 0x1f && p[1] == 0x8b && p[2] == 8;
+}
+
+/*
+ * 2.2 tamanoMiembroBgzf
+ * Tamaño total (BSIZE + 1) del miembro BGZF que empieza en p, leído del
+ * subcampo "BC" del encabezado extra. Devuelve 0 si no es un miembro BGZF
+ * y -1 si faltan bytes para saberlo.
+ * Complejidad: O(XLEN).
+ */
+inline int64_t tamanoMiembroBgzf(const unsigned char* p, size_t n) {
+    if (n < 12) return -1;
+    if (!esGzip(p, n) || !(p[3] & 4)) return 0;     // FLG.FEXTRA
+    size_t xlen = (size_t)p[10] | ((size_t)p[11] << 8);
+    if (n < 12 + xlen) return -1;
+    for (size_t i = 12; i + 4 <= 12 + xlen;) {
+        size_t slen = (size_t)p[i + 2] | ((size_t)p[i + 3] << 8);
+        if (p[i] == 'B' && p[i + 1] == 'C' && slen == 2 && i + 6 <= 12 + xlen)
+            return (int64_t)((size_t)p[i + 4] | ((size_t)p[i + 5] << 8)) + 1;
+        i += 4 + slen;
+    }
+    return 0;
+}
+
+/*
+ * 2.3 rutaEntrada
+ * ruta si existe; si no, ruta.gz si existe; si no, ruta (para que el error
+ * salga al abrirla).
+ */
+inline std::string rutaEntrada(const std::string& ruta) {
+    struct stat st;
+    if (stat(ruta.c_str(), &st) == 0) return ruta;
+    std::string gz = ruta + ".gz";
+    if (stat(gz.c_str(), &st) == 0) return gz;
+    return ruta;
+}
+
+// ---------------- 3. DESCOMPRESOR ----------------
+
+/*
+ * 3.1 Descompresor
+ * Recibe los bytes del archivo en orden (procesar) y entrega el texto
+ * descomprimido en pedazos de a lo más SALIDA bytes, también en orden; al
+ * final se llama terminar. Si falla, error() dice por qué.
+ * BGZF: los miembros completos se juntan hasta LOTE_BGZF bytes comprimidos
+ * y el lote se descomprime con paraleloPara (cada miembro dice en su cola,
+ * ISIZE, cuánto mide descomprimido: cada tarea escribe en su lugar del
+ * búfer de salida sin coordinarse con las demás).
+ * Complejidad: O(n); memoria O(LOTE_BGZF) o O(SALIDA) en flujo.
+ */
+class Descompresor {
+public:
+    enum Formato { DESCONOCIDO, PLANO, GZIP, BGZF };
+
+    static constexpr size_t SALIDA = 1u << 20;
+    static constexpr size_t LOTE_BGZF = 4u << 20;
+
+    Descompresor() = default;
+    Descompresor(const Descompresor&) = delete;
+    Descompresor& operator=(const Descompresor&) = delete;
+
+    ~Descompresor() {
+#ifdef COMUN_CON_ZLIB
+        if (flujoIniciado) Zlib::global().inflateEnd(&flujo);
+#endif
+    }
+
+    Formato formato() const { return tipo; }
+    const std::string& error() const { return mensaje; }
+    size_t descomprimidos() const { return salidos; }
+
+    template <class F>
+    bool procesar(const char* datos, size_t n, F&& entregar) {
+        if (n == 0) return true;
+        if (tipo == DESCONOCIDO && !detectar((const unsigned char*)datos, n)) return false;
+        switch (tipo) {
+        case PLANO:
+            salidos += n;
+            entregar(datos, n);
+            return true;
+        case GZIP:
+            return inflarFlujo(datos, n, entregar);
+        default:
+            pendiente.insert(pendiente.end(), datos, datos + n);
+            return pendiente.size() < LOTE_BGZF || descomprimirLote(false, entregar);
+        }
+    }
+
+    template <class F>
+    bool terminar(F&& entregar) {
+        if (tipo == GZIP && !finMiembro) return fallar("archivo gzip truncado");
+        if (tipo == BGZF) return descomprimirLote(true, entregar);
+        return true;
+    }
+
+private:
+    Formato tipo = DESCONOCIDO;
+    std::string mensaje;
+    size_t salidos = 0;
+    std::vector<char> salida;
+    std::vector<char> pendiente;        // BGZF: bytes de miembros aún sin descomprimir
+#ifdef COMUN_CON_ZLIB
+    z_stream flujo;
+#endif
+    bool flujoIniciado = false, finMiembro = false, ignorarResto = false;
+
+    bool fallar(const std::string& m) {
+        mensaje = m;
+        return false;
+    }
+
+    bool detectar(const unsigned char* p, size_t n) {
+        if (!esGzip(p, n)) {
+            tipo = PLANO;
+            return true;
+        }
+        const Zlib& z = Zlib::global();
+        if (!z.disponible()) return fallar("el archivo está comprimido y " + z.error);
+#ifdef COMUN_CON_ZLIB
+        tipo = tamanoMiembroBgzf(p, n) > 0 ? BGZF : GZIP;
+        if (tipo == GZIP) {
+            if (z.iniciar(flujo) != Z_OK) return fallar("inflateInit2 falló");
+            flujoIniciado = true;
+            salida.resize(SALIDA);
+        }
+#endif
+        return true;
+    }
+
+    /*
+     * inflarFlujo
+     * Un miembro tras otro: al terminar uno (Z_STREAM_END) se reinicia el
+     * estado si hay más bytes. Lo que sigue al último miembro y no es
+     * gzip (relleno de ceros de cintas, basura) se ignora, como gzip -d.
+     */
+    template <class F>
+    bool inflarFlujo(const char* datos, size_t n, F& entregar) {
+#ifdef COMUN_CON_ZLIB
+        if (ignorarResto) return true;
+        const Zlib& z = Zlib::global();
+        flujo.next_in = (Bytef*)datos;
+        flujo.avail_in = (uInt)n;
+        for (;;) {
+            if (finMiembro) {
+                if (flujo.avail_in == 0) break;
+                if (flujo.next_in[0] != 0x1f) {
+                    ignorarResto = true;
+                    break;
+                }
+                z.inflateReset(&flujo);
+                finMiembro = false;
+            }
+            flujo.next_out = (Bytef*)salida.data();
+            flujo.avail_out = (uInt)salida.size();
+            int r = z.inflate(&flujo, Z_NO_FLUSH);
+            size_t producidos = salida.size() - flujo.avail_out;
+            if (producidos > 0) {
+                salidos += producidos;
+                entregar((const char*)salida.data(), producidos);
+            }
+            if (r == Z_STREAM_END) {
+                finMiembro = true;
+                continue;
+            }
+            if (r != Z_OK && r != Z_BUF_ERROR)
+                return fallar(std::string("gzip inválido: ") + (flujo.msg ? flujo.msg : "inflate falló"));
+            // sin entrada y sin salida pendiente (avail_out > 0): hace falta el siguiente bloque
+            if ((flujo.avail_in == 0 && flujo.avail_out > 0) || r == Z_BUF_ERROR) break;
+        }
+        return true;
+#else
+        (void)datos;
+        (void)n;
+        (void)entregar;
+        return fallar("compilado sin zlib.h");
+#endif
+    }
+
+    /*
+     * descomprimirLote
+     * Corta los miembros completos de pendiente, los descomprime en
+     * paralelo y entrega el texto en orden. Con final = true no puede
+     * quedar un miembro a medias.
+     */
+    template <class F>
+    bool descomprimirLote(bool final, F& entregar) {
+#ifdef COMUN_CON_ZLIB
+        const unsigned char* p = (const unsigned char*)pendiente.data();
+        size_t total = pendiente.size();
+        std::vector<size_t> inicio, destino(1, 0);
+        size_t pos = 0;
+        while (pos < total) {
+            int64_t t = tamanoMiembroBgzf(p + pos, total - pos);
+            if (t == 0) return fallar("miembro gzip sin tamaño BGZF en el byte " + std::to_string(pos));
+            if (t < 0 || pos + (size_t)t > total) break;
+            if (t < 26) return fallar("miembro BGZF inválido");
+            const unsigned char* cola = p + pos + (size_t)t - 4;   // ISIZE
+            size_t isize = (size_t)cola[0] | ((size_t)cola[1] << 8) | ((size_t)cola[2] << 16) | ((size_t)cola[3] << 24);
+            inicio.push_back(pos);
+            destino.push_back(destino.back() + isize);
+            pos += (size_t)t;
+        }
+        if (final && pos < total) return fallar("archivo BGZF truncado");
+        size_t m = inicio.size();
+        if (m == 0) return true;
+        salida.resize(destino[m]);
+
+        std::atomic<bool> bien{true};
+        PoolHilos& pool = PoolHilos::global();
+        size_t grano = std::max<size_t>(1, m / (4 * pool.hilos()));
+        paraleloPara(0, m, grano, [&](size_t a, size_t b) {
+            EventoTraza e("inflarBgzf");
+            const Zlib& z = Zlib::global();
+            z_stream s;
+            if (z.iniciar(s) != Z_OK) {
+                bien = false;
+                return;
+            }
+            for (size_t i = a; i < b && bien; i++) {
+                size_t fin = i + 1 < m ? inicio[i + 1] : pos;
+                s.next_in = (Bytef*)(p + inicio[i]);
+                s.avail_in = (uInt)(fin - inicio[i]);
+                s.next_out = (Bytef*)(salida.data() + destino[i]);
+                s.avail_out = (uInt)(destino[i + 1] - destino[i]);
+                // ISIZE de más o de menos: inflate no llega a Z_STREAM_END
+                // con la salida justa, o sobran bytes
+                int r = z.inflate(&s, Z_FINISH);
+                if (r != Z_STREAM_END || s.avail_out != 0) bien = false;
+                z.inflateReset(&s);
+            }
+            z.inflateEnd(&s);
+        }, pool);
+        if (!bien) return fallar("miembro BGZF dañado");
+
+        for (size_t d = 0; d < salida.size(); d += SALIDA) {
+            size_t k = std::min(SALIDA, salida.size() - d);
+            entregar((const char*)salida.data() + d, k);
+        }
+        salidos += salida.size();
+        pendiente.erase(pendiente.begin(), pendiente.begin() + (std::ptrdiff_t)pos);
+        return true;
+#else
+        (void)final;
+        (void)entregar;
+        return fallar("compilado sin zlib.h");
+#endif
+    }
+};
+
+// ---------------- 4. ENTRADAS ----------------
+
+/*
+ * 4.1 leerDescomprimido
+ * Como lector.leer(entregar) pero con el texto ya descomprimido. Devuelve
+ * false y deja el motivo en error si falla la lectura o el formato.
+ */
+template <class F>
+bool leerDescomprimido(LectorAsincrono& lector, F&& entregar, std::string& error,
+                       size_t* descomprimidos = nullptr) {
+    Descompresor d;
+    bool bien = true;
+    bool leido = lector.leer([&](const char* datos, size_t n) {
+        if (bien && !d.procesar(datos, n, entregar)) bien = false;
+    });
+    if (!leido) {
+        error = lector.error();
+        return false;
+    }
+    if (!bien || !d.terminar(entregar)) {
+        error = d.error();
+        return false;
+    }
+    if (descomprimidos) *descomprimidos = d.descomprimidos();
+    return true;
+}
+
+/*
+ * 4.2 BufferDescomprimido / EntradaBitacora
+ * istream sobre un archivo plano o comprimido, para los programas que leen
+ * con getline. Reemplaza a ifstream (is_open, close):
+ *     comun::EntradaBitacora theFile("bitacora.txt");
+ *     while (getline(theFile, line)) ...
+ * En texto plano, después del primer bloque se lee directo al búfer de
+ * get, sin pasar por el descompresor.
+ */
+class BufferDescomprimido : public std::streambuf {
+public:
+    explicit BufferDescomprimido(const std::string& ruta) : nombre(rutaEntrada(ruta)), crudo(1u << 20) {
+        archivo = std::fopen(nombre.c_str(), "rb");
+    }
+    ~BufferDescomprimido() override { cerrar(); }
+
+    bool abierto() const { return archivo != nullptr; }
+    bool fallo() const { return fallido; }
+
+    void cerrar() {
+        if (archivo) std::fclose(archivo);
+        archivo = nullptr;
+    }
+
+protected:
+    int_type underflow() override {
+        if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+        if (!archivo) return traits_type::eof();
+        listo.clear();
+        while (listo.empty() && !terminado) {
+            size_t n = std::fread(crudo.data(), 1, crudo.size(), archivo);
+            if (n > 0 && d.formato() == Descompresor::PLANO) {
+                setg(crudo.data(), crudo.data(), crudo.data() + n);
+                return traits_type::to_int_type(*gptr());
+            }
+            auto agregar = [&](const char* datos, size_t k) { listo.insert(listo.end(), datos, datos + k); };
+            bool bien = n > 0 ? d.procesar(crudo.data(), n, agregar) : d.terminar(agregar);
+            if (n == 0) terminado = true;
+            if (n == 0 && std::ferror(archivo)) bien = false;
+            if (!bien) {
+                std::cerr << "Error: " << nombre << ": " << (d.error().empty() ? "falló la lectura" : d.error()) << "\n";
+                terminado = fallido = true;
+            }
+        }
+        if (listo.empty()) return traits_type::eof();
+        setg(listo.data(), listo.data(), listo.data() + listo.size());
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    std::string nombre;
+    std::FILE* archivo = nullptr;
+    std::vector<char> crudo, listo;
+    Descompresor d;
+    bool terminado = false, fallido = false;
+};
+
+class EntradaBitacora : public std::istream {
+public:
+    explicit EntradaBitacora(const std::string& ruta) : std::istream(nullptr), buffer(ruta) {
+        rdbuf(&buffer);
+        if (!buffer.abierto()) setstate(std::ios::failbit);
+    }
+
+    bool is_open() const { return buffer.abierto(); }
+    void close() { buffer.cerrar(); }
+
+    // true si la lectura o la descompresión fallaron a medio archivo
+    bool fallo() const { return buffer.fallo(); }
+
+private:
+    BufferDescomprimido buffer;
+};
+
+} // namespace comun
+
+#endif
@@ -0,0 +1,433 @@
+/*
+    Descripción: Conjunto de hilos con robo de trabajo, compartido por todas
+    las etapas paralelas (índices, consultas, construcción de filtros).
+
+    Cada trabajador tiene una deque de Chase–Lev: mete y saca tareas por
+    abajo (LIFO, lo más reciente sigue en caché) y los demás le roban por
+    arriba (lo más viejo, que suele ser el trozo más grande). Las tareas
+    que llegan de hilos que no son trabajadores entran a una cola común
+    (AnilloMpmc). Un trabajador sin nada que hacer gira un poco, roba a un
+    vecino al azar y, si sigue sin trabajo, se duerme hasta que llegue otra
+    tarea.
+
+    El hilo que espera a un grupo (GrupoTareas::esperar) no se bloquea:
+    ejecuta tareas mientras tanto. Por eso el conjunto crea hilos - 1
+    trabajadores: con un solo núcleo no hay trabajadores y todo corre en el
+    hilo que espera, sin cambios de contexto.
+
+    Primitivas:
+        GrupoTareas g; g.lanzar(fn); ...; g.esperar();
+        paraleloPara(ini, fin, grano, [](size_t a, size_t b) { ... });
+        paraleloReducir(ini, fin, grano, [](size_t a, size_t b) { return T; },
+                        [](T izq, T der) { return T; });
+
+    Las etapas de tuberia.h (lector, parsers) no son tareas: viven toda la
+    ingesta y esperan a las demás, y dentro del conjunto ocuparían un
+    trabajador bloqueado.
+*/
+
+#ifndef COMUN_HILOS_H
+#define COMUN_HILOS_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "anillos.h"
+#include "traza.h"
+
+namespace comun {
+
+class GrupoTareas;
+
+// ---------------- 1. DEQUE DE CHASE–LEV ----------------
+
+struct Tarea {
+    std::function<void()> fn;
+    GrupoTareas* grupo;
+};
+
+/*
+ * 1.1 DequeTrabajo
+ * Versión de Lê, Pop, Cohen y Zappa Nardelli (2013) con atómicos de C++11.
+ * Solo el dueño llama meter/sacar; cualquiera puede robar. Al crecer, el
+ * arreglo viejo se conserva hasta el final porque un ladrón puede estar
+ * leyéndolo.
+ * Complejidad: O(1) amortizado por operación.
+ */
+class DequeTrabajo {
+public:
+    DequeTrabajo() { arreglo.store(nuevoArreglo(64), std::memory_order_relaxed); }
+
+    void meter(Tarea* t) {
+        int64_t b = abajo.load(std::memory_order_relaxed);
+        int64_t a = arriba.load(std::memory_order_acquire);
+        Arreglo* x = arreglo.load(std::memory_order_relaxed);
+        if (b - a > (int64_t)x->mascara) x = crecer(x, a, b);
+        x->casillas[b & x->mascara].store(t, std::memory_order_relaxed);
+        abajo.store(b + 1, std::memory_order_release);
+    }
+
+    Tarea* sacar() {
+        int64_t b = abajo.load(std::memory_order_relaxed) - 1;
+        Arreglo* x = arreglo.load(std::memory_order_relaxed);
+        abajo.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t a = arriba.load(std::memory_order_relaxed);
+        if (a > b) {                // vacía
+            abajo.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Tarea* t = x->casillas[b & x->mascara].load(std::memory_order_relaxed);
+        if (a == b) {               // la última: se compite con los ladrones
+            if (!arriba.compare_exchange_strong(a, a + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                t = nullptr;
+            abajo.store(b + 1, std::memory_order_relaxed);
+        }
+        return t;
+    }
+
+    Tarea* robar() {
+        int64_t a = arriba.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = abajo.load(std::memory_order_acquire);
+        if (a >= b) return nullptr;
+        Arreglo* x = arreglo.load(std::memory_order_acquire);
+        Tarea* t = x->casillas[a & x->mascara].load(std::memory_order_relaxed);
+        if (!arriba.compare_exchange_strong(a, a + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;         // otro ladrón (o el dueño) la tomó
+        return t;
+    }
+
+    bool vacia() const {
+        return arriba.load(std::memory_order_relaxed) >= abajo.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Arreglo {
+        size_t mascara;
+        std::unique_ptr<std::atomic<Tarea*>[]> casillas;
+    };
+
+    alignas(64) std::atomic<int64_t> arriba{0};
+    alignas(64) std::atomic<int64_t> abajo{0};
+    std::atomic<Arreglo*> arreglo;
+    std::vector<std::unique_ptr<Arreglo>> arreglos;     // todos los que ha tenido
+
+    Arreglo* nuevoArreglo(size_t capacidad) {
+        arreglos.emplace_back(new Arreglo{capacidad - 1, std::unique_ptr<std::atomic<Tarea*>[]>(
+                                                             new std::atomic<Tarea*>[capacidad])});
+        return arreglos.back().get();
+    }
+
+    Arreglo* crecer(Arreglo* viejo, int64_t a, int64_t b) {
+        Arreglo* x = nuevoArreglo((viejo->mascara + 1) * 2);
+        for (int64_t i = a; i < b; i++)
+            x->casillas[i & x->mascara].store(viejo->casillas[i & viejo->mascara].load(std::memory_order_relaxed),
+                                              std::memory_order_relaxed);
+        arreglo.store(x, std::memory_order_release);
+        return x;
+    }
+};
+
+// ---------------- 2. CONJUNTO DE HILOS ----------------
+
+class PoolHilos {
+public:
+    /*
+     * 2.1 configurar / global
+     * configurar() fija el número de hilos (0 = núcleos del CPU) y si cada
+     * trabajador se fija a un núcleo; debe llamarse antes del primer uso
+     * de global().
+     */
+    static void configurar(unsigned hilos, bool fijarNucleos) {
+        hilosPedidos() = hilos;
+        fijarPedido() = fijarNucleos;
+    }
+
+    static PoolHilos& global() {
+        static PoolHilos instancia(hilosPedidos(), fijarPedido());
+        return instancia;
+    }
+
+    PoolHilos(unsigned hilos, bool fijarNucleos) : externas(1024) {
+        if (hilos == 0) hilos = std::max(1u, std::thread::hardware_concurrency());
+        total = hilos;
+        deques.reserve(hilos);
+        for (unsigned i = 0; i + 1 < hilos; i++) deques.emplace_back(new DequeTrabajo());
+        for (unsigned i = 0; i + 1 < hilos; i++)
+            trabajadores.emplace_back([this, i, fijarNucleos] { trabajar(i, fijarNucleos); });
+    }
+
+    ~PoolHilos() {
+        {
+            std::lock_guard<std::mutex> g(candado);
+            parar = true;
+        }
+        despertar.notify_all();
+        for (std::thread& t : trabajadores) t.join();
+    }
+
+    PoolHilos(const PoolHilos&) = delete;
+    PoolHilos& operator=(const PoolHilos&) = delete;
+
+    /*
+     * hilos: trabajadores + el hilo que espera. Sirve para decidir cuántos
+     * trozos vale la pena crear.
+     */
+    unsigned hilos() const { return total; }
+
+    /*
+     * 2.2 enviar
+     * Un trabajador mete la tarea en su propia deque; otro hilo la pone en
+     * la cola común (si está llena se ejecuta aquí mismo).
+     */
+    void enviar(Tarea* t) {
+        int yo = indiceActual();
+        if (yo >= 0 && propietario() == this) deques[(size_t)yo]->meter(t);
+        else if (!externas.intentarMeter(t)) {
+            ejecutar(t);
+            return;
+        }
+        pendientes.fetch_add(1, std::memory_order_seq_cst);
+        if (dormidos.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> g(candado);
+            despertar.notify_one();
+        }
+    }
+
+    /*
+     * 2.3 ejecutarUna
+     * Busca una tarea (la propia deque, la cola común, robar) y la corre.
+     * Devuelve false si no encontró ninguna.
+     */
+    bool ejecutarUna() {
+        Tarea* t = buscar();
+        if (!t) return false;
+        ejecutar(t);
+        return true;
+    }
+
+    inline void ejecutar(Tarea* t);
+
+private:
+    unsigned total = 1;
+    std::vector<std::unique_ptr<DequeTrabajo>> deques;
+    std::vector<std::thread> trabajadores;
+    AnilloMpmc<Tarea*> externas;
+    std::atomic<int64_t> pendientes{0};
+    std::atomic<unsigned> dormidos{0};
+    std::mutex candado;
+    std::condition_variable despertar;
+    bool parar = false;
+
+    static unsigned& hilosPedidos() {
+        static unsigned h = 0;
+        return h;
+    }
+    static bool& fijarPedido() {
+        static bool f = false;
+        return f;
+    }
+
+    // índice del trabajador actual y su conjunto (-1 fuera de un trabajador)
+    static int& indiceActual() {
+        thread_local int i = -1;
+        return i;
+    }
+    static PoolHilos*& propietario() {
+        thread_local PoolHilos* p = nullptr;
+        return p;
+    }
+
+    Tarea* buscar() {
+        int yo = propietario() == this ? indiceActual() : -1;
+        Tarea* t = nullptr;
+        if (yo >= 0) t = deques[(size_t)yo]->sacar();
+        if (!t) externas.intentarSacar(t);
+        if (!t && !deques.empty()) {
+            // robar empezando por un vecino al azar para repartir la contención
+            thread_local uint32_t semilla = 0x9e3779b9u ^ (uint32_t)(uintptr_t)&semilla;
+            semilla ^= semilla << 13;
+            semilla ^= semilla >> 17;
+            semilla ^= semilla << 5;
+            size_t n = deques.size();
+            for (size_t k = 0, v = semilla % n; k < n && !t; k++, v = (v + 1) % n)
+                if ((int)v != yo) t = deques[v]->robar();
+        }
+        if (t) pendientes.fetch_sub(1, std::memory_order_relaxed);
+        return t;
+    }
+
+    void trabajar(unsigned indice, bool fijar) {
+        indiceActual() = (int)indice;
+        propietario() = this;
+#if defined(__linux__)
+        if (fijar) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET((indice + 1) % std::max(1u, std::thread::hardware_concurrency()), &cpus);
+            pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        }
+#else
+        (void)fijar;
+#endif
+        Trazador::global().nombrarHilo("trabajador " + std::to_string(indice + 1));
+        unsigned intentos = 0;
+        for (;;) {
+            if (ejecutarUna()) {
+                intentos = 0;
+                continue;
+            }
+            if (intentos < 128) {
+                esperarTurno(intentos);
+                continue;
+            }
+            std::unique_lock<std::mutex> g(candado);
+            dormidos.fetch_add(1, std::memory_order_seq_cst);
+            despertar.wait(g, [this] { return parar || pendientes.load(std::memory_order_seq_cst) > 0; });
+            dormidos.fetch_sub(1, std::memory_order_seq_cst);
+            if (parar) return;
+            intentos = 0;
+        }
+    }
+};
+
+// ---------------- 3. GRUPOS DE TAREAS ----------------
+
+/*
+ * 3.1 GrupoTareas
+ * Lanza tareas y espera a que terminen todas. La primera excepción que
+ * lance una tarea se vuelve a lanzar en esperar().
+ */
+class GrupoTareas {
+public:
+    explicit GrupoTareas(PoolHilos& p = PoolHilos::global()) : pool(p) {}
+    ~GrupoTareas() { esperarSinLanzar(); }
+    GrupoTareas(const GrupoTareas&) = delete;
+    GrupoTareas& operator=(const GrupoTareas&) = delete;
+
+    void lanzar(std::function<void()> fn) {
+        restantes.fetch_add(1, std::memory_order_relaxed);
+        pool.enviar(new Tarea{std::move(fn), this});
+    }
+
+    /*
+     * esperar
+     * Mientras queden tareas del grupo, ejecuta tareas (de este grupo o de
+     * otros): así una tarea puede lanzar y esperar subtareas sin bloquear
+     * un trabajador.
+     */
+    void esperar() {
+        esperarSinLanzar();
+        if (error) {
+            std::exception_ptr e = error;
+            error = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+private:
+    friend class PoolHilos;
+    PoolHilos& pool;
+    std::atomic<size_t> restantes{0};
+    std::exception_ptr error;
+    std::mutex candadoError;
+
+    void esperarSinLanzar() {
+        unsigned intentos = 0;
+        while (restantes.load(std::memory_order_acquire) > 0) {
+            if (pool.ejecutarUna()) intentos = 0;
+            else esperarTurno(intentos);
+        }
+    }
+
+    void terminar(std::exception_ptr e) {
+        if (e) {
+            std::lock_guard<std::mutex> g(candadoError);
+            if (!error) error = e;
+        }
+        restantes.fetch_sub(1, std::memory_order_release);
+    }
+};
+
+inline void PoolHilos::ejecutar(Tarea* t) {
+    std::exception_ptr e;
+    try {
+        t->fn();
+    } catch (...) {
+        e = std::current_exception();
+    }
+    GrupoTareas* g = t->grupo;
+    delete t;
+    g->terminar(e);
+}
+
+// ---------------- 4. ALGORITMOS PARALELOS ----------------
+
+/*
+ * 4.1 paraleloPara
+ * fn(a, b) sobre trozos de [ini, fin) de a lo más 'grano' elementos. Se
+ * parte por mitades: cada mitad derecha queda disponible para robar y la
+ * izquierda se sigue partiendo en el mismo hilo.
+ * Complejidad: O(n / hilos + log(n / grano)) de profundidad.
+ */
+template <class Fn>
+void paraleloPara(size_t ini, size_t fin, size_t grano, const Fn& fn, PoolHilos& pool = PoolHilos::global()) {
+    grano = std::max<size_t>(1, grano);
+    if (fin - ini <= grano || pool.hilos() == 1) {
+        for (size_t a = ini; a < fin; a += grano) fn(a, std::min(fin, a + grano));
+        return;
+    }
+    GrupoTareas g(pool);
+    while (fin - ini > grano) {
+        size_t medio = ini + (fin - ini) / 2;
+        g.lanzar([=, &fn, &pool] { paraleloPara(medio, fin, grano, fn, pool); });
+        fin = medio;
+    }
+    if (ini < fin) fn(ini, fin);
+    g.esperar();
+}
+
+/*
+ * 4.2 paraleloReducir
+ * Como paraleloPara, pero cada trozo produce un T y los resultados se
+ * combinan en orden: combinar(izquierda, derecha) siempre recibe el trozo
+ * anterior a la izquierda, así que no hace falta que sea conmutativa
+ * (p.ej. concatenar índices por tramos).
+ */
+template <class T, class Fn, class Combinar>
+T paraleloReducir(size_t ini, size_t fin, size_t grano, const Fn& fn, const Combinar& combinar,
+                  PoolHilos& pool = PoolHilos::global()) {
+    grano = std::max<size_t>(1, grano);
+    if (fin - ini <= grano) return fn(ini, fin);
+    if (pool.hilos() == 1) {
+        T r = fn(ini, ini + grano);
+        for (size_t a = ini + grano; a < fin; a += grano) r = combinar(std::move(r), fn(a, std::min(fin, a + grano)));
+        return r;
+    }
+    size_t medio = ini + (fin - ini) / 2;
+    T derecha;
+    GrupoTareas g(pool);
+    g.lanzar([&] { derecha = paraleloReducir<T>(medio, fin, grano, fn, combinar, pool); });
+    T izquierda = paraleloReducir<T>(ini, medio, grano, fn, combinar, pool);
+    g.esperar();
+    return combinar(std::move(izquierda), std::move(derecha));
+}
+
+} // namespace comun
+
+#endif
@@ -0,0 +1,363 @@
+/*
+    Descripción: Índice invertido de palabras del campo reason.
+
+    El diccionario se construye sobre las razones DISTINTAS, no sobre cada
+    registro: cada palabra apunta a la lista de ids de razón que la contienen
+    y cada razón tiene su lista de ids de registro. Buscar "root" o
+    "illegal user" se resuelve primero a nivel diccionario (qué razones tienen
+    todas las palabras) y después se juntan las listas de esas razones. Con los
+    7 mensajes de bitacora.txt el diccionario tiene unas 15 palabras y el
+    índice cuesta casi lo mismo que la columna de razones.
+
+    Si una palabra aparece en muchas razones distintas (bitácoras con mensajes
+    variables), juntar todas sus razones sería caro; para esas palabras
+    "pesadas" se guarda además su propia lista de registros y las búsquedas
+    con varias palabras las intersectan por galope.
+
+    Las listas de registros se guardan comprimidas: diferencias entre ids
+    consecutivos codificadas como varint (1 byte si la diferencia es < 128),
+    con una tabla de saltos cada 128 ids para poder avanzar sin decodificar
+    todo.
+*/
+
+#ifndef COMUN_INDICE_INVERTIDO_H
+#define COMUN_INDICE_INVERTIDO_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "registro.h"
+
+namespace comun {
+
+// ---------------- 1. LISTA COMPRIMIDA ----------------
+
+/*
+ * 1.1 ListaComprimida
+ * Ids crecientes codificados como delta + varint en bloques de TAM_BLOQUE.
+ * Cada bloque guarda su primer id sin comprimir en la tabla de saltos junto
+ * con la posición de sus bytes, así que un cursor puede saltar de bloque en
+ * bloque comparando solo esos primeros ids.
+ */
+class ListaComprimida {
+public:
+    static const uint32_t TAM_BLOQUE = 128;
+
+    struct Salto {
+        uint32_t primero;   // primer id del bloque
+        uint32_t offset;    // posición en bytes del segundo id del bloque
+    };
+
+    /*
+     * agregar: id debe ser mayor que el último agregado.
+     * Complejidad: O(1).
+     */
+    void agregar(uint32_t id) {
+        if (n % TAM_BLOQUE == 0) {
+            saltos.push_back({id, (uint32_t)datos.size()});
+        } else {
+            uint32_t d = id - ultimo;
+            while (d >= 0x80) {
+                datos.push_back((uint8_t)(d | 0x80));
+                d >>= 7;
+            }
+            datos.push_back((uint8_t)d);
+        }
+        ultimo = id;
+        ++n;
+    }
+
+    size_t size() const { return n; }
+    size_t bytes() const { return datos.capacity() + saltos.capacity() * sizeof(Salto); }
+
+    /*
+     * 1.2 Cursor
+     * Recorre la lista en orden. avanzarHasta(v) salta bloques completos con
+     * búsqueda exponencial (galope) sobre la tabla de saltos y decodifica
+     * solo dentro del bloque destino.
+     */
+    class Cursor {
+    public:
+        explicit Cursor(const ListaComprimida& l) : lista(&l) { entrarBloque(0); }
+
+        bool fin() const { return indice >= lista->n; }
+        uint32_t valor() const { return actual; }
+
+        void avanzar() {
+            if (++indice >= lista->n) return;
+            if (indice % TAM_BLOQUE == 0) {
+                entrarBloque(indice / TAM_BLOQUE);
+                return;
+            }
+            uint32_t d = 0;
+            int corrimiento = 0;
+            uint8_t b;
+            do {
+                b = lista->datos[pos++];
+                d |= (uint32_t)(b & 0x7F) << corrimiento;
+                corrimiento += 7;
+            } while (b & 0x80);
+            actual += d;
+        }
+
+        /*
+         * avanzarHasta: deja el cursor en el primer id >= v.
+         * Complejidad: O(log b + TAM_BLOQUE), b = bloques saltados.
+         */
+        void avanzarHasta(uint32_t v) {
+            if (fin() || actual >= v) return;
+            const std::vector<Salto>& s = lista->saltos;
+            size_t bloque = indice / TAM_BLOQUE;
+            // Galope: último bloque cuyo primer id es <= v
+            size_t paso = 1, lo = bloque, hi = bloque + 1;
+            while (hi < s.size() && s[hi].primero <= v) {
+                lo = hi;
+                hi += paso;
+                paso <<= 1;
+            }
+            if (hi > s.size()) hi = s.size();
+            while (hi - lo > 1) {
+                size_t m = (lo + hi) / 2;
+                if (s[m].primero <= v) lo = m;
+                else hi = m;
+            }
+            if (lo > bloque) entrarBloque(lo);
+            while (!fin() && actual < v) avanzar();
+        }
+
+    private:
+        const ListaComprimida* lista;
+        size_t indice = 0;      // posición lógica en la lista
+        size_t pos = 0;         // posición en bytes del siguiente delta
+        uint32_t actual = 0;
+
+        void entrarBloque(size_t b) {
+            indice = b * TAM_BLOQUE;
+            if (b < lista->saltos.size()) {
+                actual = lista->saltos[b].primero;
+                pos = lista->saltos[b].offset;
+            }
+        }
+    };
+
+    /*
+     * decodificar: agrega todos los ids a salida.
+     */
+    void decodificar(std::vector<uint32_t>& salida) const {
+        salida.reserve(salida.size() + n);
+        for (Cursor c(*this); !c.fin(); c.avanzar()) salida.push_back(c.valor());
+    }
+
+private:
+    std::vector<uint8_t> datos;
+    std::vector<Salto> saltos;
+    size_t n = 0;
+    uint32_t ultimo = 0;
+};
+
+/*
+ * 1.3 interseccionGalope
+ * Intersección de varias listas comprimidas. La lista más corta conduce y
+ * las demás avanzan con avanzarHasta; cuando una lista queda adelante, la
+ * conductora salta directamente a ese valor (leapfrog).
+ * Complejidad: O(m * k * log(n/m)) aprox., m = lista más corta, k = listas.
+ */
+inline void interseccionGalope(std::vector<const ListaComprimida*> listas, std::vector<uint32_t>& salida) {
+    if (listas.empty()) return;
+    std::sort(listas.begin(), listas.end(),
+              [](const ListaComprimida* a, const ListaComprimida* b) { return a->size() < b->size(); });
+    std::vector<ListaComprimida::Cursor> cursores;
+    for (const ListaComprimida* l : listas) cursores.emplace_back(*l);
+
+    ListaComprimida::Cursor& guia = cursores[0];
+    while (!guia.fin()) {
+        uint32_t v = guia.valor();
+        bool todos = true;
+        for (size_t k = 1; k < cursores.size(); k++) {
+            cursores[k].avanzarHasta(v);
+            if (cursores[k].fin()) return;
+            if (cursores[k].valor() != v) {
+                guia.avanzarHasta(cursores[k].valor());
+                todos = false;
+                break;
+            }
+        }
+        if (todos) {
+            salida.push_back(v);
+            guia.avanzar();
+        }
+    }
+}
+
+// ---------------- 2. ÍNDICE INVERTIDO ----------------
+
+/*
+ * 2.1 tokenizarRazon
+ * Separa el texto en palabras alfanuméricas en minúsculas.
+ * "Failed password for illegal user guest" -> failed, password, for, ...
+ */
+inline void tokenizarRazon(std::string_view texto, std::vector<std::string>& palabras) {
+    std::string actual;
+    for (char c : texto) {
+        if (std::isalnum((unsigned char)c)) {
+            actual += (char)std::tolower((unsigned char)c);
+        } else if (!actual.empty()) {
+            palabras.push_back(actual);
+            actual.clear();
+        }
+    }
+    if (!actual.empty()) palabras.push_back(actual);
+}
+
+/*
+ * 2.2 IndiceInvertido
+ */
+class IndiceInvertido {
+public:
+    // Palabras presentes en más razones que esto tienen lista propia
+    static const size_t UMBRAL_RAZONES = 8;
+
+    /*
+     * construir
+     * 1) Tokeniza cada razón distinta del diccionario y arma palabra -> razones
+     * 2) Una pasada por la columna de razones llena la lista de cada razón
+     *    (y la de cada palabra pesada)
+     * Complejidad: O(n + texto del diccionario).
+     */
+    void construir(const TablaRegistros& t) {
+        int nr = t.razones.size();
+        porRazon.assign((size_t)nr, ListaComprimida());
+        std::vector<std::vector<int>> pesadasDeRazon((size_t)nr);
+        std::vector<std::string> palabras;
+        for (int r = 0; r < nr; r++) {
+            palabras.clear();
+            tokenizarRazon(t.razones.texto(r), palabras);
+            std::sort(palabras.begin(), palabras.end());
+            palabras.erase(std::unique(palabras.begin(), palabras.end()), palabras.end());
+            for (const std::string& p : palabras) {
+                auto it = idPalabra.find(p);
+                int id;
+                if (it == idPalabra.end()) {
+                    id = (int)razonesDePalabra.size();
+                    idPalabra.emplace(p, id);
+                    razonesDePalabra.emplace_back();
+                } else {
+                    id = it->second;
+                }
+                razonesDePalabra[(size_t)id].push_back(r);
+            }
+        }
+        listaPalabra.assign(razonesDePalabra.size(), ListaComprimida());
+        pesada.assign(razonesDePalabra.size(), false);
+        for (size_t w = 0; w < razonesDePalabra.size(); w++) {
+            if (razonesDePalabra[w].size() <= UMBRAL_RAZONES) continue;
+            pesada[w] = true;
+            for (int r : razonesDePalabra[w]) pesadasDeRazon[(size_t)r].push_back((int)w);
+        }
+
+        for (size_t i = 0; i < t.size(); i++) {
+            uint8_t r = t.razon[i];
+            porRazon[r].agregar((uint32_t)i);
+            for (int w : pesadasDeRazon[r]) listaPalabra[(size_t)w].agregar((uint32_t)i);
+        }
+    }
+
+    /*
+     * razonesCon
+     * Ids de razón (ordenados) que contienen todas las palabras.
+     * Devuelve false si alguna palabra no existe en el diccionario.
+     * Complejidad: O(k * r), k = palabras, r = razones por palabra.
+     */
+    bool razonesCon(const std::vector<std::string>& palabras, std::vector<int>& razones) const {
+        razones.clear();
+        for (size_t k = 0; k < palabras.size(); k++) {
+            auto it = idPalabra.find(palabras[k]);
+            if (it == idPalabra.end()) return false;
+            const std::vector<int>& rs = razonesDePalabra[(size_t)it->second];
+            if (k == 0) {
+                razones = rs;
+            } else {
+                std::vector<int> inter;
+                std::set_intersection(razones.begin(), razones.end(), rs.begin(), rs.end(),
+                                      std::back_inserter(inter));
+                razones.swap(inter);
+            }
+        }
+        return !palabras.empty();
+    }
+
+    /*
+     * buscar
+     * Ids de registro (ordenados) cuya razón contiene todas las palabras.
+     *  - Si alguna palabra es pesada y su lista es más corta que la unión de
+     *    las razones candidatas, se intersectan las listas de las palabras
+     *    pesadas por galope y se descartan los ids cuya razón no califica.
+     *  - Si no, se mezclan las listas de las razones que califican.
+     */
+    void buscar(const std::vector<std::string>& palabras, const TablaRegistros& t,
+                std::vector<uint32_t>& ids) const {
+        ids.clear();
+        std::vector<int> razones;
+        if (!razonesCon(palabras, razones) || razones.empty()) return;
+
+        size_t costoUnion = 0;
+        for (int r : razones) costoUnion += porRazon[(size_t)r].size();
+        std::vector<const ListaComprimida*> listas;
+        size_t menor = SIZE_MAX;
+        for (const std::string& p : palabras) {
+            int w = idPalabra.at(p);
+            if (!pesada[(size_t)w]) continue;
+            listas.push_back(&listaPalabra[(size_t)w]);
+            menor = std::min(menor, listaPalabra[(size_t)w].size());
+        }
+
+        if (!listas.empty() && menor < costoUnion) {
+            std::vector<bool> califica((size_t)t.razones.size(), false);
+            for (int r : razones) califica[(size_t)r] = true;
+            std::vector<uint32_t> inter;
+            interseccionGalope(listas, inter);
+            for (uint32_t id : inter)
+                if (califica[t.razon[id]]) ids.push_back(id);
+            return;
+        }
+
+        // Unión de listas disjuntas: se decodifican y se mezclan por pares
+        for (int r : razones) {
+            std::vector<uint32_t> lista;
+            porRazon[(size_t)r].decodificar(lista);
+            if (ids.empty()) {
+                ids.swap(lista);
+            } else {
+                std::vector<uint32_t> mezcla(ids.size() + lista.size());
+                std::merge(ids.begin(), ids.end(), lista.begin(), lista.end(), mezcla.begin());
+                ids.swap(mezcla);
+            }
+        }
+    }
+
+    size_t palabrasDistintas() const { return razonesDePalabra.size(); }
+
+    size_t bytes() const {
+        size_t total = 0;
+        for (const ListaComprimida& l : porRazon) total += l.bytes();
+        for (const ListaComprimida& l : listaPalabra) total += l.bytes();
+        for (const auto& rs : razonesDePalabra) total += rs.capacity() * sizeof(int);
+        return total;
+    }
+
+private:
+    std::unordered_map<std::string, int> idPalabra;
+    std::vector<std::vector<int>> razonesDePalabra;   // palabra -> ids de razón
+    std::vector<ListaComprimida> porRazon;            // razón -> registros
+    std::vector<ListaComprimida> listaPalabra;        // palabra pesada -> registros
+    std::vector<bool> pesada;
+};
+
+} // namespace comun
+
+#endif
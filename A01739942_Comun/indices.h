@@ -0,0 +1,122 @@
+/*
+    Descripción: Índices secundarios sobre la tabla columnar. Para cada razón,
+    cada mes y cada cubeta de puertos se guarda el conjunto de ids de registro
+    como BitmapRoaring, de modo que una consulta como "Failed password for root
+    en marzo" intersecta dos mapas en lugar de recorrer toda la tabla.
+
+    Los índices se construyen justo después de cargar la bitácora, en paralelo
+    sobre el conjunto de hilos (hilos.h): la tabla se parte en tramos
+    alineados a 2^16 registros (un contenedor roaring), cada tarea indexa un
+    grupo de tramos y los resultados se concatenan en orden sin tener que
+    mezclar contenedores.
+*/
+
+#ifndef COMUN_INDICES_H
+#define COMUN_INDICES_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "hilos.h"
+#include "registro.h"
+#include "roaring.h"
+#include "traza.h"
+
+namespace comun {
+
+/*
+ * Tamaño de cubeta de puertos: 1024 puertos por cubeta -> 64 cubetas.
+ * Un rango de puertos alineado a la cubeta se responde solo con el índice.
+ */
+const uint32_t TAM_CUBETA_PUERTO = 1024;
+const uint32_t CUBETAS_PUERTO = 65536 / TAM_CUBETA_PUERTO;
+
+struct IndicesSecundarios {
+    std::vector<BitmapRoaring> porRazon;    // [id de razón]
+    std::vector<BitmapRoaring> porMes;      // [mesAbsoluto]: 1..12 el año base, 13.. los siguientes
+    std::vector<BitmapRoaring> porPuerto;   // [puerto / TAM_CUBETA_PUERTO]
+
+    /*
+     * indexarTramo
+     * Indexa los registros [ini, fin). Los ids llegan en orden creciente, así
+     * que cada inserción cae en el último contenedor: O(1) por registro.
+     */
+    void indexarTramo(const TablaRegistros& t, size_t ini, size_t fin) {
+        porRazon.resize((size_t)t.razones.size());
+        porMes.resize(13);
+        porPuerto.resize(CUBETAS_PUERTO);
+        for (size_t i = ini; i < fin; i++) {
+            uint32_t id = (uint32_t)i;
+            uint32_t mes = mesAbsoluto(t.tiempo[i]);
+            if (mes >= porMes.size()) porMes.resize(mes + 1);
+            porRazon[t.razon[i]].agregar(id);
+            porMes[mes].agregar(id);
+            porPuerto[t.puerto[i] / TAM_CUBETA_PUERTO].agregar(id);
+        }
+    }
+
+    /*
+     * concatenar
+     * Agrega los índices de otro tramo posterior (ids mayores). Con varios
+     * años un tramo puede tener más meses que otro.
+     */
+    void concatenar(IndicesSecundarios&& otro) {
+        if (otro.porMes.size() > porMes.size()) porMes.resize(otro.porMes.size());
+        for (size_t k = 0; k < porRazon.size(); k++) porRazon[k].concatenar(std::move(otro.porRazon[k]));
+        for (size_t k = 0; k < otro.porMes.size(); k++) porMes[k].concatenar(std::move(otro.porMes[k]));
+        for (size_t k = 0; k < porPuerto.size(); k++) porPuerto[k].concatenar(std::move(otro.porPuerto[k]));
+    }
+
+    /*
+     * construir
+     * Reparte los tramos de 2^16 registros en tareas (unas 4 por hilo, para
+     * que el robo de trabajo empareje) y concatena los parciales en orden.
+     * Complejidad: O(n / hilos) + O(contenedores) para concatenar.
+     */
+    void construir(const TablaRegistros& t, PoolHilos& pool = PoolHilos::global()) {
+        const size_t TRAMO = 1u << 16;
+        size_t n = t.size();
+        size_t tramos = std::max<size_t>(1, (n + TRAMO - 1) / TRAMO);
+        size_t grano = std::max<size_t>(1, tramos / (4 * pool.hilos()));
+        *this = paraleloReducir<IndicesSecundarios>(
+            0, tramos, grano,
+            [&](size_t a, size_t b) {
+                EventoTraza e("indexarTramo");
+                IndicesSecundarios parcial;
+                parcial.indexarTramo(t, std::min(n, a * TRAMO), std::min(n, b * TRAMO));
+                return parcial;
+            },
+            [](IndicesSecundarios izq, IndicesSecundarios der) {
+                EventoTraza e("concatenar");
+                izq.concatenar(std::move(der));
+                return izq;
+            },
+            pool);
+    }
+
+    /*
+     * bytes
+     * Memoria total de los tres índices.
+     */
+    size_t bytes() const {
+        size_t total = 0;
+        for (const auto* v : {&porRazon, &porMes, &porPuerto})
+            for (const BitmapRoaring& b : *v) total += b.bytes();
+        return total;
+    }
+
+    /*
+     * unirRango
+     * OR de los mapas v[lo..hi] (p.ej. los meses de un rango de tiempo).
+     */
+    static BitmapRoaring unirRango(const std::vector<BitmapRoaring>& v, size_t lo, size_t hi) {
+        BitmapRoaring r;
+        for (size_t k = lo; k <= hi && k < v.size(); k++) r |= v[k];
+        return r;
+    }
+};
+
+} // namespace comun
+
+#endif
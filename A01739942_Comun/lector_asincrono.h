@@ -0,0 +1,366 @@
+/*
+    Descripción: Lectura de archivos por bloques con varias lecturas en
+    vuelo (io_uring), para que el disco trabaje mientras el programa parsea
+    el bloque anterior.
+
+    Se piden EN_VUELO bloques de BLOQUE bytes alineados a página; cada vez
+    que se entrega un bloque (en orden de archivo) se pide el siguiente, así
+    siempre hay lecturas pendientes mientras corre el parser. Las
+    respuestas pueden llegar en desorden: cada bloque tiene su casilla y se
+    entrega solo cuando le toca.
+
+    io_uring se usa con llamadas al sistema directas (sin liburing). Si no
+    existe (kernel < 5.6, fuera de Linux, deshabilitado con
+    io_uring_disabled o por seccomp en contenedores) se cae a pread
+    secuencial con la lectura anticipada del kernel: mismo resultado, sin
+    traslape.
+
+    Uso:
+        LectorAsincrono lector;
+        if (!lector.abrir("bitacora.txt")) ...
+        lector.leer([&](const char* datos, size_t n) { ... });
+*/
+
+#ifndef COMUN_LECTOR_ASINCRONO_H
+#define COMUN_LECTOR_ASINCRONO_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace comun {
+
+class LectorAsincrono {
+public:
+    static const size_t BLOQUE = 1u << 20;     // 1 MiB por lectura
+    static const unsigned EN_VUELO = 8;        // lecturas pendientes a la vez
+
+    enum Modo { AUTOMATICO, URING, PREAD };
+
+    LectorAsincrono() = default;
+    LectorAsincrono(const LectorAsincrono&) = delete;
+    LectorAsincrono& operator=(const LectorAsincrono&) = delete;
+
+    ~LectorAsincrono() { cerrar(); }
+
+    /*
+     * 1.1 abrir
+     * Abre el archivo y, si el modo lo permite, prepara el anillo de
+     * io_uring. Con URING falla si io_uring no está disponible; con
+     * AUTOMATICO se usa pread en ese caso. error() explica el motivo.
+     */
+    bool abrir(const std::string& ruta, Modo modo = AUTOMATICO) {
+#if defined(__linux__)
+        cerrar();
+        fd = ::open(ruta.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            mensaje = ruta + ": " + std::strerror(errno);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            mensaje = ruta + ": " + std::strerror(errno);
+            return false;
+        }
+        bytes = (size_t)st.st_size;
+        for (unsigned i = 0; i < EN_VUELO; i++) {
+            buffers[i] = (char*)std::aligned_alloc(4096, BLOQUE);
+            if (!buffers[i]) {
+                mensaje = "sin memoria para los buffers";
+                return false;
+            }
+        }
+        usarUring = modo != PREAD && prepararAnillo();
+        if (modo == URING && !usarUring) return false;
+        if (!usarUring) posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        return true;
+#else
+        (void)ruta;
+        (void)modo;
+        mensaje = "solo implementado en Linux";
+        return false;
+#endif
+    }
+
+    size_t tamano() const { return bytes; }
+    const char* modo() const { return usarUring ? "io_uring" : "pread"; }
+    const std::string& error() const { return mensaje; }
+
+    /*
+     * 1.2 descartarCache
+     * Pide al kernel que saque el archivo de la caché de páginas, para
+     * medir lecturas en frío sin permisos de root. Solo descarta páginas
+     * limpias; devuelve false si no se pudo.
+     */
+    bool descartarCache() const {
+#if defined(__linux__)
+        return fd >= 0 && posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+#else
+        return false;
+#endif
+    }
+
+    /*
+     * 1.3 leer
+     * Entrega el archivo completo a entregar(datos, n) en bloques
+     * consecutivos de BLOQUE bytes (el último puede ser menor). Los datos
+     * solo son válidos durante la llamada. Devuelve false si una lectura
+     * falló.
+     * Complejidad: O(n) bytes; a lo más EN_VUELO lecturas pendientes.
+     */
+    template <class F>
+    bool leer(F&& entregar) {
+#if defined(__linux__)
+        if (fd < 0) return false;
+        size_t bloques = (bytes + BLOQUE - 1) / BLOQUE;
+        size_t entregados = 0;
+        if (usarUring && !leerUring(bloques, entregados, entregar)) {
+            if (!mensaje.empty()) return false;
+            // el kernel no acepta IORING_OP_READ: se sigue con pread
+            cerrarAnillo();
+            usarUring = false;
+        }
+        for (; entregados < bloques; entregados++) {
+            size_t n = tamanoBloque(entregados);
+            if (!leerCompleto(buffers[0], n, entregados * BLOQUE)) return false;
+            entregar((const char*)buffers[0], n);
+        }
+        return true;
+#else
+        (void)entregar;
+        return false;
+#endif
+    }
+
+private:
+    int fd = -1;
+    size_t bytes = 0;
+    bool usarUring = false;
+    std::string mensaje;
+    char* buffers[EN_VUELO] = {};
+
+#if defined(__linux__)
+    // Anillo de io_uring: colas de envío (SQ) y de respuestas (CQ)
+    int anillo = -1;
+    void* mapaSq = nullptr;
+    void* mapaCq = nullptr;
+    size_t tamSq = 0, tamCq = 0;
+    struct io_uring_sqe* sqes = nullptr;
+    size_t tamSqes = 0;
+    unsigned *sqCabeza = nullptr, *sqCola = nullptr, *sqMascara = nullptr, *sqArreglo = nullptr;
+    unsigned *cqCabeza = nullptr, *cqCola = nullptr, *cqMascara = nullptr;
+    struct io_uring_cqe* cqes = nullptr;
+    unsigned enVuelo = 0;       // enviadas al kernel y aún sin respuesta
+
+    size_t tamanoBloque(size_t b) const { return b * BLOQUE + BLOQUE <= bytes ? BLOQUE : bytes - b * BLOQUE; }
+
+    bool leerCompleto(char* destino, size_t n, size_t desde) {
+        while (n > 0) {
+            ssize_t r = pread(fd, destino, n, (off_t)desde);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) {
+                mensaje = r < 0 ? std::strerror(errno) : "el archivo se acortó mientras se leía";
+                return false;
+            }
+            destino += r;
+            desde += (size_t)r;
+            n -= (size_t)r;
+        }
+        return true;
+    }
+
+    /*
+     * prepararAnillo
+     * io_uring_setup y el mapeo de las dos colas y del arreglo de SQEs.
+     */
+    bool prepararAnillo() {
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+        struct io_uring_params p;
+        std::memset(&p, 0, sizeof(p));
+        anillo = (int)syscall(__NR_io_uring_setup, EN_VUELO, &p);
+        if (anillo < 0) {
+            mensaje = std::string("io_uring: ") + std::strerror(errno);
+            return false;
+        }
+        tamSq = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        tamCq = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+        bool unMapa = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (unMapa) tamSq = tamCq = tamSq > tamCq ? tamSq : tamCq;
+        mapaSq = mmap(nullptr, tamSq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, anillo, IORING_OFF_SQ_RING);
+        if (mapaSq == MAP_FAILED) return fallaAnillo();
+        mapaCq = unMapa ? mapaSq
+                        : mmap(nullptr, tamCq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, anillo,
+                               IORING_OFF_CQ_RING);
+        if (mapaCq == MAP_FAILED) return fallaAnillo();
+        tamSqes = p.sq_entries * sizeof(struct io_uring_sqe);
+        void* s = mmap(nullptr, tamSqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, anillo, IORING_OFF_SQES);
+        if (s == MAP_FAILED) return fallaAnillo();
+        sqes = (struct io_uring_sqe*)s;
+
+        char* sq = (char*)mapaSq;
+        sqCabeza = (unsigned*)(sq + p.sq_off.head);
+        sqCola = (unsigned*)(sq + p.sq_off.tail);
+        sqMascara = (unsigned*)(sq + p.sq_off.ring_mask);
+        sqArreglo = (unsigned*)(sq + p.sq_off.array);
+        char* cq = (char*)mapaCq;
+        cqCabeza = (unsigned*)(cq + p.cq_off.head);
+        cqCola = (unsigned*)(cq + p.cq_off.tail);
+        cqMascara = (unsigned*)(cq + p.cq_off.ring_mask);
+        cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+        mensaje.clear();
+        return true;
+#else
+        mensaje = "io_uring no existe en estos encabezados";
+        return false;
+#endif
+    }
+
+    bool fallaAnillo() {
+        mensaje = std::string("io_uring mmap: ") + std::strerror(errno);
+        cerrarAnillo();
+        return false;
+    }
+
+    /*
+     * pedir
+     * Pone en la cola de envío la lectura del bloque b sobre su casilla.
+     * No llama al kernel: eso lo hace enviar().
+     */
+    void pedir(size_t b) {
+        unsigned cola = *sqCola;
+        unsigned i = cola & *sqMascara;
+        struct io_uring_sqe* sqe = &sqes[i];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = fd;
+        sqe->addr = (uint64_t)(uintptr_t)buffers[b % EN_VUELO];
+        sqe->len = (uint32_t)tamanoBloque(b);
+        sqe->off = (uint64_t)(b * BLOQUE);
+        sqe->user_data = b;
+        sqArreglo[i] = i;
+        __atomic_store_n(sqCola, cola + 1, __ATOMIC_RELEASE);
+    }
+
+    int enviar(unsigned nuevos, unsigned esperar) {
+        unsigned banderas = esperar ? IORING_ENTER_GETEVENTS : 0;
+        int r;
+        do {
+            r = (int)syscall(__NR_io_uring_enter, anillo, nuevos, esperar, banderas, nullptr, 0);
+        } while (r < 0 && errno == EINTR);
+        return r;
+    }
+
+    /*
+     * leerUring
+     * Mantiene EN_VUELO lecturas pendientes y entrega en orden. Si el
+     * kernel rechaza la operación (EINVAL) devuelve false con mensaje vacío
+     * para que leer() siga con pread desde 'entregados'.
+     */
+    template <class F>
+    bool leerUring(size_t bloques, size_t& entregados, F& entregar) {
+        long listo[EN_VUELO];      // bytes leídos por casilla; -1 = pendiente
+        size_t pedidos = 0;
+        unsigned porEnviar = 0;
+        for (; pedidos < bloques && pedidos < EN_VUELO; pedidos++, porEnviar++) {
+            listo[pedidos % EN_VUELO] = -1;
+            pedir(pedidos);
+        }
+        while (entregados < bloques) {
+            unsigned casilla = (unsigned)(entregados % EN_VUELO);
+            while (listo[casilla] < 0) {
+                if (enviar(porEnviar, 1) < 0) {
+                    mensaje = std::string("io_uring_enter: ") + std::strerror(errno);
+                    return false;
+                }
+                enVuelo += porEnviar;
+                porEnviar = 0;
+                int fallo = 0;
+                unsigned cabeza = *cqCabeza;
+                unsigned cola = __atomic_load_n(cqCola, __ATOMIC_ACQUIRE);
+                for (; cabeza != cola; cabeza++, enVuelo--) {
+                    const struct io_uring_cqe& cqe = cqes[cabeza & *cqMascara];
+                    if (cqe.res < 0) fallo = -cqe.res;
+                    else listo[cqe.user_data % EN_VUELO] = cqe.res;
+                }
+                __atomic_store_n(cqCabeza, cabeza, __ATOMIC_RELEASE);
+                if (fallo) {
+                    esperarPendientes();
+                    if (fallo != EINVAL && fallo != EOPNOTSUPP)
+                        mensaje = std::string("lectura: ") + std::strerror(fallo);
+                    return false;
+                }
+            }
+            size_t n = tamanoBloque(entregados);
+            char* datos = buffers[casilla];
+            // lectura corta (poco común en archivos regulares): se completa con pread
+            size_t leidos = (size_t)listo[casilla];
+            if (leidos < n && !leerCompleto(datos + leidos, n - leidos, entregados * BLOQUE + leidos)) {
+                esperarPendientes();
+                return false;
+            }
+            entregar((const char*)datos, n);
+            entregados++;
+            if (pedidos < bloques) {
+                listo[pedidos % EN_VUELO] = -1;
+                pedir(pedidos++);
+                porEnviar++;
+            }
+        }
+        return true;
+    }
+
+    /*
+     * esperarPendientes
+     * Antes de reutilizar o liberar los buffers hay que recoger las
+     * lecturas que siguen en vuelo: el kernel todavía puede escribirlos.
+     */
+    void esperarPendientes() {
+        while (enVuelo > 0 && enviar(0, 1) >= 0) {
+            unsigned cabeza = *cqCabeza;
+            unsigned cola = __atomic_load_n(cqCola, __ATOMIC_ACQUIRE);
+            for (; cabeza != cola; cabeza++) enVuelo--;
+            __atomic_store_n(cqCabeza, cabeza, __ATOMIC_RELEASE);
+        }
+    }
+
+    void cerrarAnillo() {
+        if (sqes) munmap(sqes, tamSqes);
+        if (mapaCq && mapaCq != MAP_FAILED && mapaCq != mapaSq) munmap(mapaCq, tamCq);
+        if (mapaSq && mapaSq != MAP_FAILED) munmap(mapaSq, tamSq);
+        if (anillo >= 0) close(anillo);
+        sqes = nullptr;
+        mapaSq = mapaCq = nullptr;
+        anillo = -1;
+        enVuelo = 0;
+    }
+#endif
+
+    void cerrar() {
+#if defined(__linux__)
+        cerrarAnillo();
+        if (fd >= 0) close(fd);
+        fd = -1;
+#endif
+        for (char*& b : buffers) {
+            std::free(b);
+            b = nullptr;
+        }
+        bytes = 0;
+        usarUring = false;
+    }
+};
+
+} // namespace comun
+
+#endif
@@ -0,0 +1,163 @@
+/*
+    Descripción: Mezcla de k flujos ordenados con un árbol de perdedores,
+    para leer como uno solo un juego de bitácoras rotadas.
+
+    En producción bitacora.txt se rota a bitacora.txt.1, .2, ... (el número
+    más alto es el más viejo). Cada archivo viene casi en orden de tiempo,
+    así que en lugar de juntar todo y ordenar de nuevo, cada archivo se
+    procesa por separado (en paralelo) y los k flujos se mezclan:
+
+        bitacora.txt.2 ─┐
+        bitacora.txt.1 ─┼─ árbol de perdedores ─▶ un solo flujo en orden
+        bitacora.txt   ─┘
+
+    El árbol de perdedores (Knuth, TAOCP 5.4.1) guarda en cada nodo interno
+    al perdedor del partido y arriba al ganador. Al sacar al ganador solo se
+    rejuega el camino de su hoja a la raíz: log2(k) partidos, uno por nivel,
+    contra el perdedor guardado (un montículo compara con los dos hijos en
+    cada nivel).
+
+    Los empates los gana la fuente de menor índice: si las fuentes van de la
+    más vieja a la más nueva, la mezcla es estable.
+*/
+
+#ifndef COMUN_MEZCLA_H
+#define COMUN_MEZCLA_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+
+namespace comun {
+
+// ---------------- 1. ARCHIVOS ROTADOS ----------------
+
+/*
+ * 1.1 archivosRotados
+ * Juego de archivos de ruta: ruta.N, ..., ruta.1, ruta (del más viejo al
+ * más nuevo), con N el último número consecutivo que existe. Cuenta
+ * también los comprimidos (ruta.2.gz, como los deja logrotate): se
+ * devuelven sin .gz y quien los abre lo resuelve (rutaEntrada en gzip.h).
+ * Si no existe ninguno devuelve solo ruta, para que el error salga al
+ * abrirlo.
+ * Complejidad: O(N) llamadas a stat.
+ */
+inline std::vector<std::string> archivosRotados(const std::string& ruta) {
+    auto existe = [](const std::string& r) {
+        struct stat st;
+        return stat(r.c_str(), &st) == 0 || stat((r + ".gz").c_str(), &st) == 0;
+    };
+    std::vector<std::string> rutas;
+    for (int i = 1;; i++) {
+        std::string r = ruta + "." + std::to_string(i);
+        if (!existe(r)) break;
+        rutas.push_back(r);
+    }
+    if (existe(ruta) || rutas.empty()) rutas.insert(rutas.begin(), ruta);
+    std::vector<std::string> deViejoANuevo(rutas.rbegin(), rutas.rend());
+    return deViejoANuevo;
+}
+
+// ---------------- 2. ÁRBOL DE PERDEDORES ----------------
+
+/*
+ * 2.1 ArbolPerdedores
+ * Torneo sobre k fuentes identificadas por índice. El árbol no guarda los
+ * elementos: menor(a, b) compara la cabeza actual de las fuentes a y b, y
+ * quien usa el árbol avanza la fuente ganadora y avisa con avanzar().
+ *     ArbolPerdedores<decltype(menor)> arbol(k, menor);
+ *     arbol.iniciar([&](size_t i) { return fuente i está vacía; });
+ *     while (!arbol.vacio()) {
+ *         size_t w = arbol.ganador();
+ *         ... usar la cabeza de w y avanzarla ...
+ *         arbol.avanzar(fuente w quedó vacía);
+ *     }
+ * Las hojas van en las posiciones k..2k-1 y los nodos internos en 1..k-1
+ * (hijos 2n y 2n+1), lo que sirve para cualquier k, no solo potencias de 2.
+ * Complejidad: iniciar O(k); avanzar O(log k).
+ */
+template <class Menor>
+class ArbolPerdedores {
+public:
+    ArbolPerdedores(size_t k, Menor menor) : k(k), menor(menor), perdedor(k > 0 ? k : 1), agotada(k, 1) {}
+
+    template <class Vacia>
+    void iniciar(Vacia vacia) {
+        if (k == 0) return;
+        std::vector<size_t> ganadorDe(2 * k);
+        for (size_t i = 0; i < k; i++) {
+            agotada[i] = vacia(i) ? 1 : 0;
+            ganadorDe[k + i] = i;
+        }
+        for (size_t n = k - 1; n >= 1; n--) {
+            size_t a = ganadorDe[2 * n], b = ganadorDe[2 * n + 1];
+            if (gana(a, b)) {
+                ganadorDe[n] = a;
+                perdedor[n] = b;
+            } else {
+                ganadorDe[n] = b;
+                perdedor[n] = a;
+            }
+        }
+        perdedor[0] = ganadorDe[1];
+    }
+
+    bool vacio() const { return k == 0 || agotada[perdedor[0]]; }
+    size_t ganador() const { return perdedor[0]; }
+
+    /*
+     * avanzar
+     * La fuente ganadora ya tiene nueva cabeza (o se acabó): se rejuega su
+     * camino hasta la raíz.
+     */
+    void avanzar(bool seAcabo) {
+        size_t w = perdedor[0];
+        if (seAcabo) agotada[w] = 1;
+        for (size_t n = (k + w) / 2; n >= 1; n /= 2) {
+            if (gana(perdedor[n], w)) std::swap(perdedor[n], w);
+        }
+        perdedor[0] = w;
+    }
+
+private:
+    size_t k;
+    Menor menor;
+    std::vector<size_t> perdedor;   // [0] = ganador del torneo
+    std::vector<char> agotada;
+
+    // a le gana a b si b ya se acabó, o si a va antes (empate: menor índice)
+    bool gana(size_t a, size_t b) {
+        if (agotada[b]) return !agotada[a] || a < b;
+        if (agotada[a]) return false;
+        if (menor(a, b)) return true;
+        if (menor(b, a)) return false;
+        return a < b;
+    }
+};
+
+// ---------------- 3. TRAMOS ORDENADOS ----------------
+
+/*
+ * 3.1 tramosAscendentes
+ * Posiciones donde empieza cada tramo no decreciente de [ini, fin) según
+ * menor (la primera siempre es 0). Un archivo casi en orden (unas cuantas
+ * líneas que llegaron tarde) tiene pocos tramos y se puede mezclar sin
+ * ordenarlo; uno revuelto tiene del orden de n/2.
+ * Complejidad: O(n) comparaciones.
+ */
+template <class It, class Menor>
+std::vector<size_t> tramosAscendentes(It ini, It fin, Menor menor) {
+    std::vector<size_t> inicios;
+    if (ini == fin) return inicios;
+    inicios.push_back(0);
+    size_t i = 1;
+    for (It p = ini + 1; p != fin; ++p, ++i)
+        if (menor(*p, *(p - 1))) inicios.push_back(i);
+    return inicios;
+}
+
+} // namespace comun
+
+#endif
@@ -0,0 +1,247 @@
+/*
+    Descripción: Memoria respaldada por páginas grandes (2 MiB) para las
+    estructuras grandes de acceso aleatorio: tablas hash de millones de
+    casillas, columnas de la tabla y arreglos de llaves para ordenar.
+
+    Con páginas de 4 KiB cada acceso al azar sobre cientos de MB cae casi
+    siempre en una página distinta y la TLB (~1.5K entradas) no alcanza: se
+    paga un recorrido de la tabla de páginas por acceso. Con páginas de
+    2 MiB la misma TLB cubre 3 GB.
+
+    Tres formas, de la más fuerte a la más débil:
+        hugetlb   mmap con MAP_HUGETLB; necesita páginas reservadas por el
+                  administrador (vm.nr_hugepages), si no falla.
+        thp       mapeo alineado a 2 MiB con madvise(MADV_HUGEPAGE): el
+                  kernel usa páginas grandes al ir tocando la memoria si
+                  hay memoria contigua (transparent_hugepage = madvise o
+                  always).
+        normales  madvise(MADV_NOHUGEPAGE), para comparar.
+    Si la forma pedida no se puede se usa la siguiente, sin avisar: el
+    programa funciona igual, solo más lento.
+
+    La política es global (como el nivel SIMD de filtros_simd.h); los
+    programas la cambian con --paginas. Por omisión, thp.
+*/
+
+#ifndef COMUN_PAGINAS_H
+#define COMUN_PAGINAS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/mman.h>
+
+namespace comun {
+
+// ---------------- 1. POLÍTICA ----------------
+
+/*
+ * 1.1 TipoPaginas
+ * Forma de respaldar la memoria grande.
+ */
+enum TipoPaginas { PAGINAS_NORMALES = 0, PAGINAS_TRANSPARENTES = 1, PAGINAS_EXPLICITAS = 2 };
+
+const size_t PAGINA_GRANDE = 2u << 20;
+const size_t UMBRAL_PAGINAS = PAGINA_GRANDE;    // menos que esto va al heap normal
+
+inline const char* nombrePaginas(TipoPaginas t) {
+    return t == PAGINAS_EXPLICITAS ? "hugetlb" : t == PAGINAS_TRANSPARENTES ? "thp" : "normales";
+}
+
+inline bool leerTipoPaginas(const std::string& s, TipoPaginas& t) {
+    for (int k = PAGINAS_NORMALES; k <= PAGINAS_EXPLICITAS; k++)
+        if (s == nombrePaginas((TipoPaginas)k)) {
+            t = (TipoPaginas)k;
+            return true;
+        }
+    return false;
+}
+
+/*
+ * 1.2 politicaPaginas / fijarPoliticaPaginas
+ * Forma que usan AsignadorGrande y sugerirPaginasGrandes.
+ */
+inline TipoPaginas& politicaActiva() {
+    static TipoPaginas politica = PAGINAS_TRANSPARENTES;
+    return politica;
+}
+
+inline TipoPaginas politicaPaginas() { return politicaActiva(); }
+inline void fijarPoliticaPaginas(TipoPaginas t) { politicaActiva() = t; }
+
+// ---------------- 2. MAPEOS ----------------
+
+inline size_t redondearPaginaGrande(size_t bytes) { return (bytes + PAGINA_GRANDE - 1) & ~(PAGINA_GRANDE - 1); }
+
+/*
+ * 2.1 mapearGrande
+ * Mapeo anónimo de al menos 'bytes', alineado a 2 MiB y de largo múltiplo
+ * de 2 MiB (así liberarGrande no necesita saber qué forma se obtuvo). Para
+ * alinear se pide 2 MiB de más y se recortan las orillas. Deja en
+ * 'obtenido' la forma que se consiguió; nullptr si no hay memoria.
+ * Complejidad: O(1) llamadas al sistema; las páginas se llenan al tocarlas.
+ */
+inline void* mapearGrande(size_t bytes, TipoPaginas pedido, TipoPaginas* obtenido = nullptr) {
+    size_t largo = redondearPaginaGrande(bytes == 0 ? 1 : bytes);
+    const int prot = PROT_READ | PROT_WRITE, banderas = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_HUGETLB
+    if (pedido == PAGINAS_EXPLICITAS) {
+        void* p = mmap(nullptr, largo, prot, banderas | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            if (obtenido) *obtenido = PAGINAS_EXPLICITAS;
+            return p;
+        }
+    }
+#endif
+    if (pedido == PAGINAS_EXPLICITAS) pedido = PAGINAS_TRANSPARENTES;
+    void* crudo = mmap(nullptr, largo + PAGINA_GRANDE, prot, banderas, -1, 0);
+    if (crudo == MAP_FAILED) return nullptr;
+    uintptr_t ini = (uintptr_t)crudo, a = (ini + PAGINA_GRANDE - 1) & ~(uintptr_t)(PAGINA_GRANDE - 1);
+    if (a > ini) munmap(crudo, a - ini);
+    munmap((void*)(a + largo), ini + PAGINA_GRANDE - a);
+    TipoPaginas tipo = PAGINAS_NORMALES;
+    if (pedido == PAGINAS_TRANSPARENTES && madvise((void*)a, largo, MADV_HUGEPAGE) == 0) tipo = PAGINAS_TRANSPARENTES;
+    else madvise((void*)a, largo, MADV_NOHUGEPAGE);
+    if (obtenido) *obtenido = tipo;
+    return (void*)a;
+}
+
+inline void liberarGrande(void* p, size_t bytes) {
+    if (p) munmap(p, redondearPaginaGrande(bytes == 0 ? 1 : bytes));
+}
+
+/*
+ * 2.2 sugerirPaginasGrandes
+ * Para memoria que ya existe (arreglos globales, búferes de vector): marca
+ * con MADV_HUGEPAGE las páginas de 2 MiB completas dentro de [p, p+bytes).
+ * Lo que aún no se ha tocado se llena con páginas grandes; con 'colapsar'
+ * también se juntan en el momento las páginas ya tocadas (MADV_COLLAPSE,
+ * Linux 6.1+; en kernels viejos khugepaged lo hace después, poco a poco).
+ * Con la política en normales no hace nada. Devuelve los bytes marcados.
+ * Complejidad: O(1) llamadas; colapsar copia la memoria ya tocada.
+ */
+inline size_t sugerirPaginasGrandes(void* p, size_t bytes, bool colapsar = false) {
+    if (politicaPaginas() == PAGINAS_NORMALES || bytes < PAGINA_GRANDE) return 0;
+    uintptr_t ini = ((uintptr_t)p + PAGINA_GRANDE - 1) & ~(uintptr_t)(PAGINA_GRANDE - 1);
+    uintptr_t fin = ((uintptr_t)p + bytes) & ~(uintptr_t)(PAGINA_GRANDE - 1);
+    if (fin <= ini || madvise((void*)ini, fin - ini, MADV_HUGEPAGE) != 0) return 0;
+#ifdef MADV_COLLAPSE
+    if (colapsar) madvise((void*)ini, fin - ini, MADV_COLLAPSE);
+#else
+    (void)colapsar;
+#endif
+    return fin - ini;
+}
+
+/*
+ * 2.3 kbEnPaginasGrandes
+ * KiB del mapeo que contiene p que de verdad están en páginas grandes
+ * (AnonHugePages + Private_Hugetlb de /proc/self/smaps); -1 si no se
+ * puede leer. Sirve para verificar que la sugerencia surtió efecto.
+ * Complejidad: O(mapeos del proceso).
+ */
+inline long kbEnPaginasGrandes(const void* p) {
+    std::FILE* f = std::fopen("/proc/self/smaps", "r");
+    if (!f) return -1;
+    char linea[512];
+    bool dentro = false;
+    long kb = 0;
+    while (std::fgets(linea, sizeof(linea), f)) {
+        unsigned long a, b, v;
+        if (std::sscanf(linea, "%lx-%lx ", &a, &b) == 2) {
+            if (dentro) break;
+            dentro = (uintptr_t)p >= a && (uintptr_t)p < b;
+        } else if (dentro && (std::sscanf(linea, "AnonHugePages: %lu kB", &v) == 1 ||
+                              std::sscanf(linea, "Private_Hugetlb: %lu kB", &v) == 1)) {
+            kb += (long)v;
+        }
+    }
+    std::fclose(f);
+    return kb;
+}
+
+// ---------------- 3. MEMORIA Y ASIGNADOR ----------------
+
+/*
+ * 3.1 MemoriaGrande
+ * Dueño de un mapeo de mapearGrande (se libera al destruirse).
+ */
+class MemoriaGrande {
+public:
+    MemoriaGrande() {}
+    explicit MemoriaGrande(size_t bytes, TipoPaginas pedido = politicaPaginas()) : largo(bytes) {
+        p = mapearGrande(bytes, pedido, &tipo);
+    }
+    ~MemoriaGrande() { liberarGrande(p, largo); }
+
+    MemoriaGrande(MemoriaGrande&& o) noexcept { *this = std::move(o); }
+    MemoriaGrande& operator=(MemoriaGrande&& o) noexcept {
+        if (this != &o) {
+            liberarGrande(p, largo);
+            p = std::exchange(o.p, nullptr);
+            largo = std::exchange(o.largo, 0);
+            tipo = o.tipo;
+        }
+        return *this;
+    }
+    MemoriaGrande(const MemoriaGrande&) = delete;
+    MemoriaGrande& operator=(const MemoriaGrande&) = delete;
+
+    void* datos() const { return p; }
+    size_t bytes() const { return largo; }
+    TipoPaginas obtenido() const { return tipo; }
+    explicit operator bool() const { return p != nullptr; }
+
+private:
+    void* p = nullptr;
+    size_t largo = 0;
+    TipoPaginas tipo = PAGINAS_NORMALES;
+};
+
+/*
+ * 3.2 AsignadorGrande
+ * Asignador para contenedores estándar: los bloques de UMBRAL_PAGINAS o
+ * más se mapean según la política activa; los chicos van al heap. La
+ * decisión depende solo del tamaño, así que deallocate la repite sin
+ * guardar nada.
+ *     VectorGrande<uint32_t> llaves(100000000);
+ */
+template <class T>
+struct AsignadorGrande {
+    typedef T value_type;
+
+    AsignadorGrande() noexcept {}
+    template <class U>
+    AsignadorGrande(const AsignadorGrande<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        size_t bytes = n * sizeof(T);
+        if (bytes < UMBRAL_PAGINAS) return static_cast<T*>(::operator new(bytes));
+        void* p = mapearGrande(bytes, politicaPaginas());
+        if (!p) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        size_t bytes = n * sizeof(T);
+        if (bytes < UMBRAL_PAGINAS) ::operator delete(p);
+        else liberarGrande(p, bytes);
+    }
+
+    template <class U>
+    bool operator==(const AsignadorGrande<U>&) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const AsignadorGrande<U>&) const noexcept { return false; }
+};
+
+template <class T>
+using VectorGrande = std::vector<T, AsignadorGrande<T>>;
+
+} // namespace comun
+
+#endif
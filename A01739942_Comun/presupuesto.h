@@ -0,0 +1,444 @@
+/*
+    Descripción: Presupuesto global de memoria (--mem=4G) y las estructuras
+    que, al no caber en él, se derraman a disco en lugar de seguir pidiendo
+    memoria hasta que el sistema mate al proceso.
+
+    Presupuesto::global() lleva la cuenta de los bytes vivos de todo lo que
+    se le carga: los contenedores con AsignadorContado se cargan solos y el
+    resto (p.ej. el texto de un string) se carga a mano con cargar/descargar.
+    Sin --mem el límite es 0 (sin límite) y nada se derrama.
+
+    Modos de derrame:
+        OrdenExterno        orden externo: tramos ordenados en archivos
+                            temporales y una mezcla k-aria al final
+                            (árbol de perdedores de mezcla.h).
+        ConteoParticionado  agrupación por llave: la tabla de conteos se
+                            vacía a P archivos por hash de la llave y al
+                            final cada partición se agrega por separado.
+    Ambos dan el mismo resultado exacto que en memoria; solo cambia cuánta
+    memoria usan y cuánto escriben a disco (bytes_derramados en --stats).
+
+    Los temporales se crean en $TMPDIR (o /tmp) y se borran del directorio
+    al crearlos: desaparecen solos aunque el programa termine mal.
+*/
+
+#ifndef COMUN_PRESUPUESTO_H
+#define COMUN_PRESUPUESTO_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+#include "estadisticas.h"
+#include "mezcla.h"
+
+namespace comun {
+
+// ---------------- 1. PRESUPUESTO ----------------
+
+/*
+ * 1.1 leerTamano
+ * "4G", "512M", "1.5g", "64KiB", "1000000" (bytes). Unidades binarias.
+ */
+inline bool leerTamano(const char* s, size_t& bytes) {
+    char* fin = nullptr;
+    double v = std::strtod(s, &fin);
+    if (fin == s || v < 0) return false;
+    double mult = 1;
+    switch (*fin) {
+    case 'k': case 'K': mult = 1024.0; fin++; break;
+    case 'm': case 'M': mult = 1024.0 * 1024; fin++; break;
+    case 'g': case 'G': mult = 1024.0 * 1024 * 1024; fin++; break;
+    case 't': case 'T': mult = 1024.0 * 1024 * 1024 * 1024; fin++; break;
+    default: break;
+    }
+    if (*fin == 'i') fin++;
+    if (*fin == 'B' || *fin == 'b') fin++;
+    if (*fin != '\0') return false;
+    bytes = (size_t)(v * mult);
+    return true;
+}
+
+/*
+ * 1.2 Presupuesto
+ * Bytes cargados contra un límite compartido por todo el proceso. Las
+ * cuentas son atómicas (relaxed): varias etapas pueden cargar desde
+ * distintos hilos y solo importa la suma.
+ */
+class Presupuesto {
+public:
+    static Presupuesto& global() {
+        static Presupuesto p;
+        return p;
+    }
+
+    void fijarLimite(size_t bytes) { limite = bytes; }
+    size_t limiteBytes() const { return limite; }
+    bool conLimite() const { return limite > 0; }
+
+    void cargar(size_t n) {
+        int64_t v = usados.fetch_add((int64_t)n, std::memory_order_relaxed) + (int64_t)n;
+        int64_t p = pico.load(std::memory_order_relaxed);
+        while (v > p && !pico.compare_exchange_weak(p, v, std::memory_order_relaxed)) {}
+    }
+    void descargar(size_t n) { usados.fetch_sub((int64_t)n, std::memory_order_relaxed); }
+
+    size_t usado() const { return (size_t)std::max<int64_t>(0, usados.load(std::memory_order_relaxed)); }
+    size_t picoUsado() const { return (size_t)std::max<int64_t>(0, pico.load(std::memory_order_relaxed)); }
+
+    // ¿caben n bytes más?
+    bool cabe(size_t n) const { return limite == 0 || usado() + n <= limite; }
+    bool excedido() const { return limite > 0 && usado() > limite; }
+
+    /*
+     * habilitarSiSePide
+     * Busca "--mem=4G" o "--mem 4G" en los argumentos y los quita de argv
+     * (como Estadisticas::habilitarSiSePide). Devuelve false si el tamaño
+     * no se entiende.
+     */
+    bool habilitarSiSePide(int& argc, char* argv[]) {
+        int j = 1;
+        bool ok = true;
+        for (int i = 1; i < argc; i++) {
+            const char* valor = nullptr;
+            if (std::strncmp(argv[i], "--mem=", 6) == 0) valor = argv[i] + 6;
+            else if (std::strcmp(argv[i], "--mem") == 0 && i + 1 < argc) valor = argv[++i];
+            else {
+                argv[j++] = argv[i];
+                continue;
+            }
+            size_t bytes;
+            if (leerTamano(valor, bytes)) fijarLimite(bytes);
+            else {
+                std::fprintf(stderr, "Tamaño de --mem inválido: %s (p.ej. 4G, 512M)\n", valor);
+                ok = false;
+            }
+        }
+        argc = j;
+        return ok;
+    }
+
+private:
+    size_t limite = 0;
+    std::atomic<int64_t> usados{0};
+    std::atomic<int64_t> pico{0};
+};
+
+/*
+ * 1.3 AsignadorContado
+ * Asignador para contenedores estándar que carga al presupuesto global
+ * cada bloque que pide. No niega memoria: quien usa el contenedor revisa
+ * cabe()/excedido() y decide derramar.
+ *     std::vector<Registro, AsignadorContado<Registro>> v;
+ */
+template <class T>
+struct AsignadorContado {
+    typedef T value_type;
+
+    AsignadorContado() noexcept {}
+    template <class U>
+    AsignadorContado(const AsignadorContado<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        T* p = static_cast<T*>(::operator new(n * sizeof(T)));
+        Presupuesto::global().cargar(n * sizeof(T));
+        return p;
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        Presupuesto::global().descargar(n * sizeof(T));
+        ::operator delete(p);
+    }
+
+    template <class U>
+    bool operator==(const AsignadorContado<U>&) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const AsignadorContado<U>&) const noexcept { return false; }
+};
+
+template <class T>
+using VectorContado = std::vector<T, AsignadorContado<T>>;
+
+// ---------------- 2. ARCHIVOS TEMPORALES ----------------
+
+/*
+ * 2.1 ArchivoTemporal
+ * Archivo anónimo de lectura y escritura: se crea con mkstemp y se borra
+ * del directorio en el momento, así que se libera al cerrarlo (o al morir
+ * el proceso). Se escribe de corrido, se rebobina y se lee de corrido.
+ */
+class ArchivoTemporal {
+public:
+    ArchivoTemporal() {
+        const char* dir = std::getenv("TMPDIR");
+        std::string plantilla = std::string(dir && *dir ? dir : "/tmp") + "/derrame.XXXXXX";
+        std::vector<char> nombre(plantilla.begin(), plantilla.end());
+        nombre.push_back('\0');
+        int fd = mkstemp(nombre.data());
+        if (fd < 0) return;
+        unlink(nombre.data());
+        f = fdopen(fd, "w+b");
+        if (!f) close(fd);
+    }
+    ~ArchivoTemporal() {
+        if (f) std::fclose(f);
+    }
+
+    ArchivoTemporal(ArchivoTemporal&& o) noexcept : f(std::exchange(o.f, nullptr)), escritos(o.escritos) {}
+    ArchivoTemporal& operator=(ArchivoTemporal&& o) noexcept {
+        if (this != &o) {
+            if (f) std::fclose(f);
+            f = std::exchange(o.f, nullptr);
+            escritos = o.escritos;
+        }
+        return *this;
+    }
+    ArchivoTemporal(const ArchivoTemporal&) = delete;
+    ArchivoTemporal& operator=(const ArchivoTemporal&) = delete;
+
+    bool abierto() const { return f != nullptr; }
+    size_t bytes() const { return escritos; }
+
+    void cerrar() {
+        if (f) std::fclose(f);
+        f = nullptr;
+    }
+
+    bool escribir(const void* p, size_t n) {
+        if (!f || std::fwrite(p, 1, n, f) != n) return false;
+        escritos += n;
+        Estadisticas::global().contar("bytes_derramados", n);
+        return true;
+    }
+
+    bool rebobinar() { return f && std::fflush(f) == 0 && std::fseek(f, 0, SEEK_SET) == 0; }
+
+    size_t leer(void* p, size_t n) { return f ? std::fread(p, 1, n, f) : 0; }
+
+private:
+    std::FILE* f = nullptr;
+    size_t escritos = 0;
+};
+
+// ---------------- 3. ORDEN EXTERNO ----------------
+
+/*
+ * 3.1 OrdenExterno
+ * Ordena (de forma estable) elementos de tipo T trivialmente copiable con
+ * el comparador menor, sin pasar del presupuesto: el búfer en memoria
+ * crece mientras quepa; cuando ya no, se ordena y se escribe como un
+ * tramo en un temporal y se vuelve a llenar. Al terminar, los tramos y lo
+ * que quedó en memoria se mezclan con un árbol de perdedores leyendo cada
+ * tramo por bloques de LECTURA bytes.
+ *     OrdenExterno<Fila, decltype(menor)> orden(menor);
+ *     for (...) orden.agregar(fila);
+ *     orden.terminar([&](const Fila& f) { ...; return seguir; });
+ * Los empates salen en el orden en que se agregaron: los tramos se
+ * escriben en orden, cada tramo se ordena con stable_sort y el árbol da
+ * el empate a la fuente de menor índice (el tramo más viejo).
+ * El búfer siempre puede llegar a MINIMO bytes, aunque el presupuesto ya
+ * esté lleno por otras etapas (si no, derramaría un elemento por tramo).
+ * Complejidad: O(n log n) comparaciones; con t tramos, cada elemento se
+ * escribe y se lee una vez (O(n) E/S) y la mezcla cuesta O(n log t).
+ */
+template <class T, class Menor>
+class OrdenExterno {
+    static_assert(std::is_trivially_copyable<T>::value, "OrdenExterno guarda los elementos en disco tal cual");
+
+public:
+    static constexpr size_t MINIMO = 1u << 20;
+    static constexpr size_t LECTURA = 64u << 10;
+
+    explicit OrdenExterno(Menor menor) : menor(menor) {}
+
+    void agregar(const T& x) {
+        if (bufer.size() == bufer.capacity() && bufer.size() * sizeof(T) >= MINIMO &&
+            !Presupuesto::global().cabe(bufer.capacity() * sizeof(T)))
+            derramar();
+        bufer.push_back(x);
+        total++;
+    }
+
+    size_t size() const { return total; }
+    size_t tramos() const { return archivos.size(); }
+    bool fallo() const { return error; }
+
+    /*
+     * terminar
+     * Entrega los elementos en orden a emitir(x), que devuelve false para
+     * detenerse (p.ej. al llegar al límite). Devuelve false si falló la
+     * escritura o la lectura de algún temporal.
+     */
+    template <class Emitir>
+    bool terminar(Emitir emitir) {
+        std::stable_sort(bufer.begin(), bufer.end(), menor);
+        if (archivos.empty()) {
+            for (const T& x : bufer)
+                if (!emitir(x)) break;
+            return !error;
+        }
+        Temporizador mezcla("mezcla_externa");
+        // fuentes 0..t-1: tramos en disco (del más viejo al más nuevo); t: el búfer
+        size_t t = archivos.size(), porBloque = std::max<size_t>(1, LECTURA / sizeof(T));
+        std::vector<VectorContado<T>> bloques(t);
+        std::vector<size_t> pos(t + 1, 0);
+        auto rellenar = [&](size_t i) {
+            bloques[i].resize(porBloque);
+            size_t n = archivos[i].leer(bloques[i].data(), porBloque * sizeof(T)) / sizeof(T);
+            bloques[i].resize(n);
+            pos[i] = 0;
+            return n > 0;
+        };
+        for (size_t i = 0; i < t; i++)
+            if (!archivos[i].rebobinar()) error = true;
+        for (size_t i = 0; i < t; i++) rellenar(i);
+        auto cabeza = [&](size_t i) -> const T& { return i < t ? bloques[i][pos[i]] : bufer[pos[i]]; };
+        auto vacia = [&](size_t i) { return i < t ? pos[i] >= bloques[i].size() : pos[i] >= bufer.size(); };
+        auto menorFuente = [&](size_t a, size_t b) { return menor(cabeza(a), cabeza(b)); };
+        ArbolPerdedores<decltype(menorFuente)> arbol(t + 1, menorFuente);
+        arbol.iniciar(vacia);
+        while (!arbol.vacio()) {
+            size_t w = arbol.ganador();
+            if (!emitir(cabeza(w))) break;
+            pos[w]++;
+            if (w < t && pos[w] >= bloques[w].size()) rellenar(w);
+            arbol.avanzar(vacia(w));
+        }
+        return !error;
+    }
+
+private:
+    Menor menor;
+    VectorContado<T> bufer;
+    std::vector<ArchivoTemporal> archivos;
+    size_t total = 0;
+    bool error = false;
+
+    void derramar() {
+        std::stable_sort(bufer.begin(), bufer.end(), menor);
+        ArchivoTemporal a;
+        if (!a.abierto() || !a.escribir(bufer.data(), bufer.size() * sizeof(T))) error = true;
+        archivos.push_back(std::move(a));
+        Estadisticas::global().contar("tramos_derramados");
+        bufer.clear();      // conserva la capacidad: el siguiente tramo la reutiliza
+    }
+};
+
+// ---------------- 4. CONTEO PARTICIONADO ----------------
+
+/*
+ * 4.1 ConteoParticionado
+ * Cuenta ocurrencias por llave (K trivialmente copiable, con std::hash).
+ * Mientras cabe es una tabla hash en memoria; si el presupuesto se excede
+ * y la tabla ya tiene al menos MINIMO llaves, se vacía: cada par (llave,
+ * conteo) va a una de PARTICIONES archivos según bits altos del hash, y
+ * la tabla se libera. Una misma llave puede quedar repetida en su
+ * partición, pero nunca en dos particiones distintas.
+ * recorrer(f) entrega cada llave con su conteo total, una vez: sin
+ * derrames, directo de la tabla; con derrames, partición por partición
+ * (cada una cabe en memoria si las llaves se reparten parejo).
+ * El presupuesto se puede pasar por lo que pida el último rehash.
+ * Complejidad: O(1) esperado por llave; con derrames, O(pares escritos)
+ * de E/S secuencial.
+ */
+template <class K>
+class ConteoParticionado {
+    static_assert(std::is_trivially_copyable<K>::value, "las llaves se escriben tal cual a disco");
+
+public:
+    static constexpr size_t PARTICIONES = 64;
+    static constexpr size_t MINIMO = 1u << 14;
+    static constexpr size_t LECTURA = 64u << 10;
+
+    struct Par {
+        K llave;
+        uint64_t conteo;
+    };
+
+    void sumar(const K& llave, uint64_t n = 1) {
+        tabla[llave] += n;
+        if (tabla.size() >= MINIMO && Presupuesto::global().excedido()) derramar();
+    }
+
+    bool derramado() const { return !particiones.empty(); }
+    bool fallo() const { return error; }
+
+    /*
+     * recorrer
+     * Llama f(llave, conteo) por cada llave distinta. Consume la
+     * estructura. Devuelve false si falló algún temporal.
+     */
+    template <class F>
+    bool recorrer(F f) {
+        if (particiones.empty()) {
+            for (auto& par : tabla) f(par.first, par.second);
+            Tabla().swap(tabla);
+            return true;
+        }
+        derramar();
+        std::vector<Par> pares(std::max<size_t>(1, LECTURA / sizeof(Par)));
+        for (ArchivoTemporal& a : particiones) {
+            if (!a.rebobinar()) error = true;
+            size_t n;
+            while ((n = a.leer(pares.data(), pares.size() * sizeof(Par)) / sizeof(Par)) > 0)
+                for (size_t i = 0; i < n; i++) tabla[pares[i].llave] += pares[i].conteo;
+            for (auto& par : tabla) f(par.first, par.second);
+            Tabla().swap(tabla);
+            a.cerrar();
+        }
+        return !error;
+    }
+
+private:
+    typedef std::unordered_map<K, uint64_t, std::hash<K>, std::equal_to<K>,
+                               AsignadorContado<std::pair<const K, uint64_t>>> Tabla;
+
+    Tabla tabla;
+    std::vector<ArchivoTemporal> particiones;
+    bool error = false;
+
+    static_assert(PARTICIONES == 64, "particion() toma 6 bits del hash");
+
+    static size_t particion(const K& llave) {
+        // bits altos de un hash multiplicativo: no se correlacionan con las
+        // cubetas de la tabla (std::hash de un entero es la identidad)
+        return (size_t)(((uint64_t)std::hash<K>()(llave) * 0x9E3779B97F4A7C15ull) >> 58);
+    }
+
+    void derramar() {
+        if (particiones.empty()) particiones.resize(PARTICIONES);
+        // un búfer chico por partición: derramar no duplica la tabla
+        std::vector<std::vector<Par>> porParticion(PARTICIONES);
+        size_t porBufer = std::max<size_t>(1, LECTURA / sizeof(Par) / 16);
+        auto vaciar = [&](size_t p) {
+            std::vector<Par>& v = porParticion[p];
+            if (!particiones[p].abierto() || !particiones[p].escribir(v.data(), v.size() * sizeof(Par))) error = true;
+            v.clear();
+        };
+        for (auto& par : tabla) {
+            size_t p = particion(par.first);
+            porParticion[p].push_back({par.first, par.second});
+            if (porParticion[p].size() >= porBufer) vaciar(p);
+        }
+        Tabla().swap(tabla);
+        for (size_t p = 0; p < PARTICIONES; p++)
+            if (!porParticion[p].empty()) vaciar(p);
+        Estadisticas::global().contar("derrames_conteo");
+    }
+};
+
+} // namespace comun
+
+#endif
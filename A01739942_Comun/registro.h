@@ -0,0 +1,625 @@
+/*
+    Descripción: Representación compacta y columnar de los registros de bitácora,
+    compartida por los programas nuevos (consultas, benchmarks).
+
+    Cada línea "Mon DD HH:MM:SS a.b.c.d:port reason" se reduce a:
+        tiempo  -> uint32 (misma clave que total_time de las actividades)
+        ip      -> uint32 (a<<24 | b<<16 | c<<8 | d)
+        puerto  -> uint16
+        razon   -> uint8 (id en el diccionario de razones distintas)
+
+    A diferencia de las actividades, el parseo no crea substrings: se recorre
+    la línea una sola vez sobre el buffer leído del archivo. El archivo se
+    lee por bloques con io_uring (lector_asincrono.h) y se parsea en una
+    tubería de hilos (tuberia.h) mientras el kernel lee los siguientes.
+*/
+
+#ifndef COMUN_REGISTRO_H
+#define COMUN_REGISTRO_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+
+#include "estadisticas.h"
+#include "hilos.h"
+#include "lector_asincrono.h"
+#include "mezcla.h"
+#include "paginas.h"
+#include "tuberia.h"
+
+namespace comun {
+
+// ---------------- 1. TIEMPO ----------------
+
+/*
+ * 1.1 MESES
+ * Abreviaturas de mes tal como aparecen en la bitácora (índice 0 = Jan).
+ */
+inline const char* const MESES[12] = {"Jan","Feb","Mar","Apr","May","Jun",
+                                      "Jul","Aug","Sep","Oct","Nov","Dec"};
+
+/*
+ * 1.2 mesANumero
+ * Convierte las tres letras del mes en número (1-12); -1 si no es válido.
+ * Complejidad: O(1).
+ */
+inline int mesANumero(const char* p) {
+    for (int i = 0; i < 12; i++)
+        if (p[0] == MESES[i][0] && p[1] == MESES[i][1] && p[2] == MESES[i][2])
+            return i + 1;
+    return -1;
+}
+
+/*
+ * 1.3 claveTiempo
+ * Segundos desde el 1 de enero del año base (Calendario), en 32 bits.
+ * La bitácora no trae año y el enunciado supone meses de 31 días (hay
+ * líneas con "Feb 30" o "Sep 31"), así que el año tiene 12*31 días y un
+ * mes/día/hora cualquiera se ordena igual que con total_time de las
+ * actividades. Un año ocupa SEGUNDOS_ANIO < 2^25 y la clave alcanza para
+ * 133 años a partir del base; anio es relativo a él (0 = año base).
+ * Complejidad: O(1).
+ */
+const uint32_t SEGUNDOS_DIA = 86400;
+const uint32_t SEGUNDOS_MES = 31 * SEGUNDOS_DIA;
+const uint32_t DIAS_ANIO = 12 * 31;
+const uint32_t SEGUNDOS_ANIO = DIAS_ANIO * SEGUNDOS_DIA;
+const uint32_t ANIOS_MAX = UINT32_MAX / SEGUNDOS_ANIO;
+
+inline uint32_t claveTiempo(int mes, int dia, int hora, int minuto, int segundo, uint32_t anio = 0) {
+    return anio * SEGUNDOS_ANIO +
+           (uint32_t)((((mes - 1) * 31 + dia - 1) * 24 + hora) * 60 + minuto) * 60 + (uint32_t)segundo;
+}
+
+/*
+ * 1.4 Descomposición de la clave de tiempo
+ * Operaciones inversas de claveTiempo. mesAbsoluto cuenta los meses desde
+ * el año base (1 = enero del año base), para índices que deben distinguir
+ * el marzo de un año del del siguiente.
+ * Complejidad: O(1).
+ */
+inline uint32_t anioDe(uint32_t t)      { return t / SEGUNDOS_ANIO; }
+inline uint32_t diaDelAnio(uint32_t t)  { return t % SEGUNDOS_ANIO / SEGUNDOS_DIA; }
+inline uint32_t mesAbsoluto(uint32_t t) { return t / SEGUNDOS_MES + 1; }
+inline int mesDe(uint32_t t)     { return (int)(diaDelAnio(t) / 31) + 1; }
+inline int diaDe(uint32_t t)     { return (int)(diaDelAnio(t) % 31) + 1; }
+inline int horaDe(uint32_t t)    { return (int)(t / 3600 % 24); }
+inline int minutoDe(uint32_t t)  { return (int)(t / 60 % 60); }
+inline int segundoDe(uint32_t t) { return (int)(t % 60); }
+
+/*
+ * 1.5 Calendario
+ * Configuración global del tiempo:
+ *   anioBase    año de la clave 0 (solo cambia cómo se imprime el año)
+ *   cambioAnio  inferir el año al leer: la bitácora no lo trae, así que en
+ *               una bitácora en orden (o un juego rotado) que pasa de
+ *               diciembre a enero hay que sumar uno para que enero quede
+ *               después. Apagado por omisión: en una bitácora revuelta
+ *               cada salto de diciembre a enero cambiaría de año.
+ * habilitarSiSePide entiende "--anio-base=AAAA" (o "--anio-base AAAA") y
+ * "--cambio-anio" y los quita de argv.
+ */
+struct Calendario {
+    static constexpr uint32_t ANIO_BASE = 2025;
+
+    uint32_t anioBase = ANIO_BASE;
+    bool cambioAnio = false;
+
+    static Calendario& global() {
+        static Calendario c;
+        return c;
+    }
+
+    bool habilitarSiSePide(int& argc, char* argv[]) {
+        int j = 1;
+        bool ok = true;
+        for (int i = 1; i < argc; i++) {
+            const char* valor = nullptr;
+            if (std::strcmp(argv[i], "--cambio-anio") == 0) {
+                cambioAnio = true;
+                continue;
+            }
+            if (std::strncmp(argv[i], "--anio-base=", 12) == 0) valor = argv[i] + 12;
+            else if (std::strcmp(argv[i], "--anio-base") == 0 && i + 1 < argc) valor = argv[++i];
+            else {
+                argv[j++] = argv[i];
+                continue;
+            }
+            char* fin;
+            unsigned long anio = std::strtoul(valor, &fin, 10);
+            if (*fin == '\0' && fin != valor && anio <= 9999) anioBase = (uint32_t)anio;
+            else {
+                std::fprintf(stderr, "Año de --anio-base inválido: %s\n", valor);
+                ok = false;
+            }
+        }
+        argc = j;
+        return ok;
+    }
+};
+
+/*
+ * 1.6 InferenciaAnio
+ * Asigna el año a las claves de una bitácora leída en orden (la del
+ * parseo siempre es del año 0). Un salto hacia atrás de más de 6 meses
+ * (diciembre -> enero) avanza el año. Una línea que salta más de 6 meses
+ * hacia adelante puede ser un rezagado (un diciembre después de enero) o
+ * un hueco en la bitácora (enero y luego agosto): se queda en el año
+ * anterior, pero si CONFIRMAR líneas seguidas saltan igual era un hueco,
+ * el mes nuevo pasa a ser el actual y reasignados() dice cuántas de las
+ * líneas anteriores (las últimas entregadas) son en realidad del año
+ * actual. Inactiva, ajustar no cambia nada.
+ *     InferenciaAnio anios(Calendario::global().cambioAnio);
+ *     r.tiempo = anios.ajustar(r.tiempo);
+ *     // las últimas anios.reasignados() claves: + SEGUNDOS_ANIO
+ * avisarSiSospechosa escribe un aviso si el año llegó a ANIOS_MAX o cambia
+ * demasiado seguido (una bitácora revuelta, no en orden de tiempo).
+ * Complejidad: O(1) por clave.
+ */
+class InferenciaAnio {
+public:
+    static constexpr uint32_t CONFIRMAR = 8;
+
+    explicit InferenciaAnio(bool activa = false) : encendida(activa) {}
+
+    uint32_t ajustar(uint32_t t) {
+        if (!encendida) return t;
+        vistas++;
+        reasignar = 0;
+        int mes = mesDe(t);
+        if (mesAnterior > 0 && mesAnterior - mes > 6) {
+            saltos++;
+            if (actual < ANIOS_MAX - 1) actual++;
+            else saturada = true;
+            mesAnterior = mes;
+            adelantadas = 0;
+        } else if (mesAnterior > 0 && mes - mesAnterior > 6) {
+            if (++adelantadas < CONFIRMAR) return t + (actual > 0 ? actual - 1 : 0) * SEGUNDOS_ANIO;
+            // CONFIRMAR seguidas: un hueco, no rezagados
+            if (actual > 0) reasignar = adelantadas - 1;
+            huecos++;
+            mesAnterior = mes;
+            adelantadas = 0;
+        } else {
+            mesAnterior = mes;
+            adelantadas = 0;
+        }
+        return t + actual * SEGUNDOS_ANIO;
+    }
+
+    bool activa() const { return encendida; }
+    uint32_t anio() const { return actual; }
+    // líneas seguidas que saltaron hacia adelante y esperan confirmación
+    uint32_t pendientes() const { return adelantadas; }
+    uint32_t reasignados() const { return reasignar; }
+
+    /*
+     * avisarSiSospechosa
+     * Aviso en stderr si desde 'inicio' (el estado con que empezó el
+     * archivo) el año se saturó o hubo al menos 3 cambios de año y más de
+     * uno cada 1000 líneas: una bitácora en orden cambia de año una vez
+     * por año de registros.
+     */
+    void avisarSiSospechosa(const std::string& origen, const InferenciaAnio& inicio = InferenciaAnio()) const {
+        if (!encendida) return;
+        uint64_t n = vistas - inicio.vistas, cambios = saltos - inicio.saltos;
+        if (saturada && !inicio.saturada)
+            std::fprintf(stderr, "Aviso: --cambio-anio en %s: el año llegó al máximo (%u años desde el base); "
+                                 "¿la bitácora no está en orden de tiempo?\n", origen.c_str(), ANIOS_MAX - 1);
+        else if (cambios >= 3 && cambios * 1000 > n)
+            std::fprintf(stderr, "Aviso: --cambio-anio en %s: %llu cambios de año en %llu líneas; "
+                                 "¿la bitácora no está en orden de tiempo?\n", origen.c_str(),
+                         (unsigned long long)cambios, (unsigned long long)n);
+    }
+
+private:
+    bool encendida;
+    bool saturada = false;
+    uint32_t actual = 0;
+    int mesAnterior = 0;
+    uint32_t adelantadas = 0, reasignar = 0;
+    uint64_t vistas = 0, saltos = 0, huecos = 0;
+};
+
+// ---------------- 2. PARSEO DE CAMPOS ----------------
+
+/*
+ * 2.1 leerNumero
+ * Lee dígitos decimales desde p (sin pasar de fin) y avanza p.
+ * Devuelve false si no había ningún dígito.
+ * Complejidad: O(d), d = número de dígitos.
+ */
+inline bool leerNumero(const char*& p, const char* fin, uint32_t& v) {
+    const char* ini = p;
+    v = 0;
+    while (p < fin && (unsigned)(*p - '0') < 10) {
+        v = v * 10 + (uint32_t)(*p - '0');
+        ++p;
+    }
+    return p != ini;
+}
+
+/*
+ * 2.2 parsearIp
+ * Lee "a.b.c.d" desde p y deja en ip el valor de 32 bits.
+ * Complejidad: O(k), k < 16 caracteres.
+ */
+inline bool parsearIp(const char*& p, const char* fin, uint32_t& ip) {
+    ip = 0;
+    for (int k = 0; k < 4; k++) {
+        uint32_t oct;
+        if (!leerNumero(p, fin, oct) || oct > 255) return false;
+        ip = (ip << 8) | oct;
+        if (k < 3) {
+            if (p >= fin || *p != '.') return false;
+            ++p;
+        }
+    }
+    return true;
+}
+
+/*
+ * 2.3 parsearIpTexto
+ * Versión para cadenas completas (consultas, argumentos).
+ */
+inline bool parsearIpTexto(const std::string& s, uint32_t& ip) {
+    const char* p = s.data();
+    const char* fin = p + s.size();
+    return parsearIp(p, fin, ip) && p == fin;
+}
+
+/*
+ * 2.4 ipATexto
+ * Escribe la IP en formato punteado sobre buf (mínimo 16 bytes).
+ * Devuelve el número de caracteres escritos.
+ */
+inline int ipATexto(uint32_t ip, char* buf) {
+    return std::snprintf(buf, 16, "%u.%u.%u.%u",
+                         ip >> 24, (ip >> 16) & 255, (ip >> 8) & 255, ip & 255);
+}
+
+inline std::string ipATexto(uint32_t ip) {
+    char buf[16];
+    return std::string(buf, ipATexto(ip, buf));
+}
+
+// ---------------- 3. DICCIONARIO DE RAZONES ----------------
+
+/*
+ * 3.1 DiccionarioRazones
+ * Asigna un id pequeño a cada texto de razón distinto. La bitácora tiene
+ * muy pocos mensajes distintos, así que cada registro guarda solo un byte.
+ * Los textos viven en un deque para que los string_view del índice no se
+ * invaliden al crecer.
+ */
+class DiccionarioRazones {
+public:
+    static const int MAX_RAZONES = 256;
+
+    /*
+     * idDe: devuelve el id del texto, agregándolo si es nuevo.
+     * Devuelve -1 si ya hay MAX_RAZONES textos distintos.
+     * Complejidad: O(L) promedio (hash del texto).
+     */
+    int idDe(std::string_view texto) {
+        auto it = ids.find(texto);
+        if (it != ids.end()) return it->second;
+        if ((int)textos.size() >= MAX_RAZONES) return -1;
+        textos.emplace_back(texto);
+        int id = (int)textos.size() - 1;
+        ids.emplace(std::string_view(textos.back()), id);
+        return id;
+    }
+
+    /*
+     * buscar: como idDe pero sin insertar; -1 si el texto no existe.
+     */
+    int buscar(std::string_view texto) const {
+        auto it = ids.find(texto);
+        return it == ids.end() ? -1 : it->second;
+    }
+
+    const std::string& texto(int id) const { return textos[id]; }
+    int size() const { return (int)textos.size(); }
+
+private:
+    std::deque<std::string> textos;
+    std::unordered_map<std::string_view, int> ids;
+};
+
+// ---------------- 4. TABLA COLUMNAR ----------------
+
+/*
+ * 4.1 Registro
+ * Un renglón ya parseado (usado solo como valor temporal al construir la tabla).
+ */
+struct Registro {
+    uint32_t tiempo;
+    uint32_t ip;
+    uint16_t puerto;
+    uint8_t razon;
+};
+
+/*
+ * 4.2 TablaRegistros
+ * Guarda cada campo en su propio arreglo contiguo (columna) para que los
+ * filtros recorran solo los bytes que necesitan.
+ * Espacio: 11 bytes por registro + diccionario de razones.
+ * reservar pide páginas grandes para las columnas (paginas.h): los
+ * filtros las recorren completas y los índices saltan al azar entre ellas.
+ */
+struct TablaRegistros {
+    std::vector<uint32_t> tiempo;
+    std::vector<uint32_t> ip;
+    std::vector<uint16_t> puerto;
+    std::vector<uint8_t> razon;
+    DiccionarioRazones razones;
+
+    size_t size() const { return tiempo.size(); }
+
+    void reservar(size_t n) {
+        tiempo.reserve(n);
+        ip.reserve(n);
+        puerto.reserve(n);
+        razon.reserve(n);
+        sugerirPaginasGrandes(tiempo.data(), n * sizeof(uint32_t));
+        sugerirPaginasGrandes(ip.data(), n * sizeof(uint32_t));
+        sugerirPaginasGrandes(puerto.data(), n * sizeof(uint16_t));
+        sugerirPaginasGrandes(razon.data(), n);
+    }
+
+    void agregar(const Registro& r) {
+        tiempo.push_back(r.tiempo);
+        ip.push_back(r.ip);
+        puerto.push_back(r.puerto);
+        razon.push_back(r.razon);
+    }
+};
+
+// ---------------- 5. PARSEO DE LÍNEAS ----------------
+
+/*
+ * 5.1 parsearCampos / parsearLinea
+ * Parsea una línea [ini, fin) sin crear strings intermedios.
+ * Devuelve false si la línea está mal formada (se omite, como en Act4.3).
+ * parsearCampos no toca el diccionario (la razón queda como texto), así
+ * que puede correr en varios hilos a la vez; parsearLinea además asigna el
+ * id de la razón.
+ * Complejidad: O(L), L = longitud de la línea.
+ */
+inline bool parsearCampos(const char* ini, const char* fin, Registro& r, std::string_view& razon) {
+    if (fin > ini && fin[-1] == '\r') --fin;
+    const char* p = ini;
+    if (fin - p < 4) return false;
+    int mes = mesANumero(p);
+    if (mes < 0) return false;
+    p += 3;
+    while (p < fin && *p == ' ') ++p;
+
+    uint32_t dia, h, mi, s;
+    if (!leerNumero(p, fin, dia)) return false;
+    while (p < fin && *p == ' ') ++p;
+    if (!leerNumero(p, fin, h) || p >= fin || *p++ != ':') return false;
+    if (!leerNumero(p, fin, mi) || p >= fin || *p++ != ':') return false;
+    if (!leerNumero(p, fin, s)) return false;
+    while (p < fin && *p == ' ') ++p;
+
+    uint32_t ip, puerto = 0;
+    if (!parsearIp(p, fin, ip)) return false;
+    if (p < fin && *p == ':') {
+        ++p;
+        leerNumero(p, fin, puerto);
+    }
+    if (p < fin && *p == ' ') ++p;
+
+    razon = std::string_view(p, (size_t)(fin - p));
+    r.tiempo = claveTiempo(mes, (int)dia, (int)h, (int)mi, (int)s);
+    r.ip = ip;
+    r.puerto = (uint16_t)puerto;
+    return true;
+}
+
+inline bool parsearLinea(const char* ini, const char* fin, Registro& r,
+                         DiccionarioRazones& razones) {
+    std::string_view razon;
+    if (!parsearCampos(ini, fin, r, razon)) return false;
+    int id = razones.idDe(razon);
+    if (id < 0) return false;
+    r.razon = (uint8_t)id;
+    return true;
+}
+
+/*
+ * 5.2 parsearBuffer
+ * Recorre un buffer con varias líneas y agrega cada registro válido a la tabla.
+ * Devuelve el número de líneas omitidas por estar mal formadas.
+ * Complejidad: O(n), n = bytes del buffer.
+ */
+inline size_t parsearBuffer(const char* datos, size_t n, TablaRegistros& t) {
+    const char* p = datos;
+    const char* fin = datos + n;
+    size_t omitidas = 0;
+    while (p < fin) {
+        const char* nl = (const char*)std::memchr(p, '\n', (size_t)(fin - p));
+        const char* finLinea = nl ? nl : fin;
+        if (finLinea > p) {
+            Registro r;
+            if (parsearLinea(p, finLinea, r, t.razones)) t.agregar(r);
+            else ++omitidas;
+        }
+        p = nl ? nl + 1 : fin;
+    }
+    return omitidas;
+}
+
+/*
+ * 5.3 cargarBitacora
+ * Ingesta en tuberia (tuberia.h): un hilo lee por bloques, los parsers
+ * convierten los trozos en paralelo y este hilo agrega los registros a la
+ * tabla en el orden del archivo. La razón se traduce a id al agregar: el
+ * diccionario no es seguro entre hilos y así los ids salen en el mismo
+ * orden que con una lectura secuencial.
+ * Devuelve false si no se pudo abrir o leer el archivo.
+ * parsers = 0 usa los núcleos libres (ver OpcionesIngesta).
+ * Complejidad: O(n) en tiempo; memoria acotada por los lotes de la tubería.
+ */
+struct RegistroCrudo {
+    Registro r;
+    std::string_view razon;     // apunta al texto del lote
+};
+
+inline bool cargarBitacora(const std::string& ruta, TablaRegistros& t,
+                           LectorAsincrono::Modo modo = LectorAsincrono::AUTOMATICO, unsigned parsers = 0) {
+    Temporizador ingesta("ingesta");
+    OpcionesIngesta op;
+    op.modo = modo;
+    op.parsers = parsers;
+    size_t invalidas = 0;
+    // ~59 bytes por línea en promedio: reservar evita copias al crecer
+    struct stat st;
+    if (stat(ruta.c_str(), &st) == 0) t.reservar((size_t)st.st_size / 48 + 1);
+    ResultadoIngesta res = ingestarArchivo<RegistroCrudo>(
+        ruta,
+        [](const char* ini, const char* fin, RegistroCrudo& c) { return parsearCampos(ini, fin, c.r, c.razon); },
+        [&](RegistroCrudo& c) {
+            int id = t.razones.idDe(c.razon);
+            if (id < 0) {
+                invalidas++;
+                return;
+            }
+            c.r.razon = (uint8_t)id;
+            t.agregar(c.r);
+        },
+        op);
+    if (!res.ok) return false;
+    Estadisticas::global().contar("bytes", res.bytes);
+    if (res.texto != res.bytes) Estadisticas::global().contar("bytes_descomprimidos", res.texto);
+    Estadisticas::global().contar("lineas", t.size());
+    Estadisticas::global().contar("lotes", res.lotes);
+    size_t omitidas = res.omitidas + invalidas;
+    if (omitidas > 0)
+        std::cerr << "Aviso: " << omitidas << " líneas mal formadas omitidas\n";
+    return true;
+}
+
+/*
+ * 5.4 inferirAnios
+ * Pasa la columna de tiempo, en el orden del archivo, por la inferencia de
+ * año. Se hace después de la ingesta y no dentro de ella porque en un
+ * juego rotado el año con que empieza un archivo depende de todos los
+ * anteriores, que se ingestan a la vez.
+ * Complejidad: O(n), solo si la inferencia está activa.
+ */
+inline void inferirAnios(TablaRegistros& t, InferenciaAnio& anios) {
+    if (!anios.activa()) return;
+    for (size_t i = 0; i < t.size(); i++) {
+        t.tiempo[i] = anios.ajustar(t.tiempo[i]);
+        for (size_t k = 1; k <= anios.reasignados() && k <= i; k++) t.tiempo[i - k] += SEGUNDOS_ANIO;
+    }
+}
+
+/*
+ * 5.5 cargarBitacoras
+ * Carga un juego de bitácoras rotadas (ver archivosRotados en mezcla.h,
+ * del más viejo al más nuevo) como una sola tabla. Cada archivo se ingesta
+ * en su propia tarea, con su parte de los núcleos, y las tablas se mezclan
+ * por tiempo con un árbol de perdedores; en un empate va primero el
+ * archivo más viejo. Los ids de razón se vuelven a asignar en el orden de
+ * la mezcla. Con un solo archivo es cargarBitacora. Con --cambio-anio
+ * (Calendario) los años se infieren archivo por archivo, del más viejo al
+ * más nuevo, antes de mezclar.
+ * Complejidad: O(n log k) para la mezcla; memoria: el doble de la tabla
+ * mientras se mezcla.
+ */
+inline bool cargarBitacoras(const std::vector<std::string>& rutas, TablaRegistros& t) {
+    InferenciaAnio anios(Calendario::global().cambioAnio);
+    if (rutas.size() == 1) {
+        if (!cargarBitacora(rutas[0], t)) return false;
+        inferirAnios(t, anios);
+        anios.avisarSiSospechosa(rutas[0]);
+        return true;
+    }
+    size_t k = rutas.size();
+    std::vector<TablaRegistros> partes(k);
+    std::unique_ptr<bool[]> ok(new bool[k]);
+    unsigned parsers = std::max(1u, (std::thread::hardware_concurrency() - 1) / (unsigned)k);
+    GrupoTareas g;
+    for (size_t i = 0; i < k; i++)
+        g.lanzar([&, i] { ok[i] = cargarBitacora(rutas[i], partes[i], LectorAsincrono::AUTOMATICO, parsers); });
+    g.esperar();
+    for (size_t i = 0; i < k; i++)
+        if (!ok[i]) return false;
+    for (size_t i = 0; i < k; i++) {
+        InferenciaAnio inicio = anios;
+        inferirAnios(partes[i], anios);
+        anios.avisarSiSospechosa(rutas[i], inicio);
+    }
+
+    Temporizador mezcla("mezcla");
+    size_t total = 0;
+    for (const TablaRegistros& p : partes) total += p.size();
+    t.reservar(total);
+    std::vector<size_t> pos(k, 0);
+    std::vector<std::vector<int>> idGlobal(k);      // id de razón en la parte -> en t
+    for (size_t i = 0; i < k; i++) idGlobal[i].assign((size_t)partes[i].razones.size(), -1);
+    auto menor = [&](size_t a, size_t b) { return partes[a].tiempo[pos[a]] < partes[b].tiempo[pos[b]]; };
+    ArbolPerdedores<decltype(menor)> arbol(k, menor);
+    arbol.iniciar([&](size_t i) { return partes[i].size() == 0; });
+    size_t invalidas = 0;
+    while (!arbol.vacio()) {
+        size_t w = arbol.ganador();
+        const TablaRegistros& p = partes[w];
+        size_t j = pos[w]++;
+        int& id = idGlobal[w][p.razon[j]];
+        if (id < 0) id = t.razones.idDe(p.razones.texto(p.razon[j]));
+        if (id >= 0) t.agregar(Registro{p.tiempo[j], p.ip[j], p.puerto[j], (uint8_t)id});
+        else invalidas++;
+        arbol.avanzar(pos[w] == p.size());
+    }
+    if (invalidas > 0)
+        std::cerr << "Aviso: " << invalidas << " líneas omitidas (más de "
+                  << DiccionarioRazones::MAX_RAZONES << " razones distintas)\n";
+    Estadisticas::global().contar("archivos", k);
+    return true;
+}
+
+// ---------------- 6. FORMATO ----------------
+
+/*
+ * 6.1 formatearLinea
+ * Reconstruye la línea original del registro i sobre buf.
+ * Los días y horas van con dos dígitos como en la bitácora.
+ * Devuelve el número de caracteres escritos (sin '\n').
+ * La versión con Registro y razón en texto sirve para registros que no
+ * están en una tabla (p.ej. los de generador.h).
+ */
+inline int formatearLinea(const Registro& r, std::string_view razon, char* buf, size_t cap) {
+    uint32_t tt = r.tiempo;
+    uint32_t ip = r.ip;
+    int n = std::snprintf(buf, cap, "%s %02d %02d:%02d:%02d %u.%u.%u.%u:%u %.*s",
+                         MESES[mesDe(tt) - 1], diaDe(tt), horaDe(tt), minutoDe(tt), segundoDe(tt),
+                         ip >> 24, (ip >> 16) & 255, (ip >> 8) & 255, ip & 255,
+                         (unsigned)r.puerto, (int)razon.size(), razon.data());
+    return n < (int)cap ? n : (int)cap - 1; // razones muy largas se truncan
+}
+
+inline int formatearLinea(const TablaRegistros& t, size_t i, char* buf, size_t cap) {
+    Registro r{t.tiempo[i], t.ip[i], t.puerto[i], t.razon[i]};
+    return formatearLinea(r, t.razones.texto(t.razon[i]), buf, cap);
+}
+
+} // namespace comun
+
+#endif
@@ -0,0 +1,341 @@
+/*
+    Descripción: Mapa de bits comprimido tipo "roaring" sobre ids de registro
+    (uint32). El espacio de ids se divide en bloques de 2^16 según los 16 bits
+    altos; cada bloque no vacío es un contenedor que guarda los 16 bits bajos:
+
+        - arreglo:  uint16 ordenados, cuando hay <= 4096 elementos (2 bytes c/u)
+        - bitmap:   1024 palabras de 64 bits (8 KB fijos), cuando hay más
+
+    Así un conjunto disperso ocupa poco y uno denso no pasa de 1 bit por id.
+    Las operaciones AND/OR trabajan contenedor por contenedor y eligen el
+    algoritmo según los tipos (mezcla o galope entre arreglos, prueba de bit
+    entre arreglo y bitmap, AND/OR de palabras entre bitmaps).
+*/
+
+#ifndef COMUN_ROARING_H
+#define COMUN_ROARING_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace comun {
+
+class BitmapRoaring {
+public:
+    static const uint32_t MAX_ARREGLO = 4096;   // límite arreglo -> bitmap
+    static const uint32_t PALABRAS = 1024;      // 65536 bits / 64
+
+    /*
+     * Contenedor
+     * Ids con los mismos 16 bits altos (clave). Solo uno de arreglo / bits
+     * está en uso; bits no vacío indica que es bitmap.
+     */
+    struct Contenedor {
+        uint16_t clave = 0;
+        uint32_t cardinalidad = 0;
+        std::vector<uint16_t> arreglo;
+        std::vector<uint64_t> bits;
+
+        bool esBitmap() const { return !bits.empty(); }
+
+        bool contiene(uint16_t v) const {
+            if (esBitmap()) return (bits[v >> 6] >> (v & 63)) & 1;
+            return std::binary_search(arreglo.begin(), arreglo.end(), v);
+        }
+
+        // Convierte el arreglo en bitmap (cuando pasa de MAX_ARREGLO)
+        void aBitmap() {
+            bits.assign(PALABRAS, 0);
+            for (uint16_t v : arreglo) bits[v >> 6] |= 1ull << (v & 63);
+            std::vector<uint16_t>().swap(arreglo);
+        }
+
+        // Convierte el bitmap en arreglo (cuando baja de MAX_ARREGLO)
+        void aArreglo() {
+            arreglo.clear();
+            arreglo.reserve(cardinalidad);
+            for (uint32_t w = 0; w < PALABRAS; w++) {
+                uint64_t b = bits[w];
+                while (b) {
+                    arreglo.push_back((uint16_t)(w * 64 + (uint32_t)__builtin_ctzll(b)));
+                    b &= b - 1;
+                }
+            }
+            std::vector<uint64_t>().swap(bits);
+        }
+
+        /*
+         * agregar: O(1) si v es mayor que el último (caso de ingesta en orden),
+         * O(k) con inserción en medio del arreglo.
+         */
+        void agregar(uint16_t v) {
+            if (esBitmap()) {
+                uint64_t& w = bits[v >> 6];
+                uint64_t m = 1ull << (v & 63);
+                cardinalidad += (w & m) == 0;
+                w |= m;
+                return;
+            }
+            if (arreglo.empty() || arreglo.back() < v) {
+                arreglo.push_back(v);
+            } else {
+                auto it = std::lower_bound(arreglo.begin(), arreglo.end(), v);
+                if (*it == v) return;
+                arreglo.insert(it, v);
+            }
+            if (++cardinalidad > MAX_ARREGLO) aBitmap();
+        }
+
+        /*
+         * aPalabras: escribe el contenedor como 1024 palabras de 64 bits.
+         */
+        void aPalabras(uint64_t* palabras) const {
+            if (esBitmap()) {
+                std::copy(bits.begin(), bits.end(), palabras);
+                return;
+            }
+            std::fill(palabras, palabras + PALABRAS, 0);
+            for (uint16_t v : arreglo) palabras[v >> 6] |= 1ull << (v & 63);
+        }
+    };
+
+    // ---------------- Construcción y consulta ----------------
+
+    /*
+     * agregar
+     * Inserta el id x. Los ids crecientes (ingesta secuencial) siempre caen
+     * en el último contenedor y cuestan O(1).
+     */
+    void agregar(uint32_t x) {
+        uint16_t clave = (uint16_t)(x >> 16);
+        Contenedor* c;
+        if (!cont.empty() && cont.back().clave == clave) {
+            c = &cont.back();
+        } else if (cont.empty() || cont.back().clave < clave) {
+            cont.emplace_back();
+            c = &cont.back();
+            c->clave = clave;
+        } else {
+            auto it = std::lower_bound(cont.begin(), cont.end(), clave,
+                                       [](const Contenedor& a, uint16_t k) { return a.clave < k; });
+            if (it == cont.end() || it->clave != clave) {
+                it = cont.insert(it, Contenedor());
+                it->clave = clave;
+            }
+            c = &*it;
+        }
+        c->agregar((uint16_t)(x & 0xFFFF));
+    }
+
+    bool contiene(uint32_t x) const {
+        uint16_t clave = (uint16_t)(x >> 16);
+        auto it = std::lower_bound(cont.begin(), cont.end(), clave,
+                                   [](const Contenedor& a, uint16_t k) { return a.clave < k; });
+        return it != cont.end() && it->clave == clave && it->contiene((uint16_t)(x & 0xFFFF));
+    }
+
+    uint64_t cardinalidad() const {
+        uint64_t total = 0;
+        for (const Contenedor& c : cont) total += c.cardinalidad;
+        return total;
+    }
+
+    bool vacio() const { return cont.empty(); }
+
+    const std::vector<Contenedor>& contenedores() const { return cont; }
+
+    /*
+     * bytes
+     * Memoria aproximada ocupada por los contenedores.
+     */
+    size_t bytes() const {
+        size_t total = cont.capacity() * sizeof(Contenedor);
+        for (const Contenedor& c : cont) total += c.arreglo.capacity() * 2 + c.bits.capacity() * 8;
+        return total;
+    }
+
+    /*
+     * concatenar
+     * Agrega al final los contenedores de otro, cuyas claves deben ser todas
+     * mayores que las de este. Sirve para unir los índices construidos en
+     * paralelo sobre rangos de ids consecutivos alineados a 2^16.
+     * Complejidad: O(contenedores de otro).
+     */
+    void concatenar(BitmapRoaring&& otro) {
+        for (Contenedor& c : otro.cont) cont.push_back(std::move(c));
+        otro.cont.clear();
+    }
+
+    /*
+     * paraCada
+     * Llama f(id) para cada id en orden ascendente.
+     */
+    template <typename F>
+    void paraCada(F f) const {
+        for (const Contenedor& c : cont) {
+            uint32_t alto = (uint32_t)c.clave << 16;
+            if (c.esBitmap()) {
+                for (uint32_t w = 0; w < PALABRAS; w++) {
+                    uint64_t b = c.bits[w];
+                    while (b) {
+                        f(alto | (w * 64 + (uint32_t)__builtin_ctzll(b)));
+                        b &= b - 1;
+                    }
+                }
+            } else {
+                for (uint16_t v : c.arreglo) f(alto | v);
+            }
+        }
+    }
+
+    // ---------------- Operaciones de conjuntos ----------------
+
+    /*
+     * interseccion (AND)
+     * Recorre ambas listas de contenedores como una mezcla por clave; solo
+     * las claves comunes producen trabajo.
+     * Complejidad: O(contenedores) + costo de cada par (ver andContenedores).
+     */
+    static BitmapRoaring interseccion(const BitmapRoaring& a, const BitmapRoaring& b) {
+        BitmapRoaring r;
+        size_t i = 0, j = 0;
+        while (i < a.cont.size() && j < b.cont.size()) {
+            uint16_t ka = a.cont[i].clave, kb = b.cont[j].clave;
+            if (ka < kb) { i++; continue; }
+            if (kb < ka) { j++; continue; }
+            Contenedor c = andContenedores(a.cont[i], b.cont[j]);
+            if (c.cardinalidad > 0) r.cont.push_back(std::move(c));
+            i++;
+            j++;
+        }
+        return r;
+    }
+
+    /*
+     * unir (OR)
+     * Mezcla por clave; las claves de un solo lado se copian tal cual.
+     */
+    static BitmapRoaring unir(const BitmapRoaring& a, const BitmapRoaring& b) {
+        BitmapRoaring r;
+        size_t i = 0, j = 0;
+        while (i < a.cont.size() || j < b.cont.size()) {
+            if (j == b.cont.size() || (i < a.cont.size() && a.cont[i].clave < b.cont[j].clave)) {
+                r.cont.push_back(a.cont[i++]);
+            } else if (i == a.cont.size() || b.cont[j].clave < a.cont[i].clave) {
+                r.cont.push_back(b.cont[j++]);
+            } else {
+                r.cont.push_back(orContenedores(a.cont[i++], b.cont[j++]));
+            }
+        }
+        return r;
+    }
+
+    void operator&=(const BitmapRoaring& o) { *this = interseccion(*this, o); }
+    void operator|=(const BitmapRoaring& o) { *this = unir(*this, o); }
+
+private:
+    std::vector<Contenedor> cont;   // ordenados por clave
+
+    /*
+     * galopar
+     * Primera posición >= v en a[desde..), avanzando en saltos 1,2,4,... y
+     * luego búsqueda binaria. Es O(log d) con d = distancia recorrida, lo que
+     * hace barata la intersección de un arreglo chico con uno grande.
+     */
+    static size_t galopar(const std::vector<uint16_t>& a, size_t desde, uint16_t v) {
+        size_t paso = 1, lo = desde, hi = desde;
+        while (hi < a.size() && a[hi] < v) {
+            lo = hi + 1;
+            hi += paso;
+            paso <<= 1;
+        }
+        if (hi > a.size()) hi = a.size();
+        return (size_t)(std::lower_bound(a.begin() + (long)lo, a.begin() + (long)hi, v) - a.begin());
+    }
+
+    /*
+     * andContenedores
+     *  - arreglo/arreglo: mezcla lineal, o galope si uno es 32x más chico
+     *  - arreglo/bitmap:  se prueba cada elemento del arreglo en el bitmap
+     *  - bitmap/bitmap:   AND de 1024 palabras; si quedan <= 4096 se vuelve arreglo
+     */
+    static Contenedor andContenedores(const Contenedor& a, const Contenedor& b) {
+        Contenedor r;
+        r.clave = a.clave;
+        if (a.esBitmap() && b.esBitmap()) {
+            r.bits.resize(PALABRAS);
+            uint32_t card = 0;
+            for (uint32_t w = 0; w < PALABRAS; w++) {
+                r.bits[w] = a.bits[w] & b.bits[w];
+                card += (uint32_t)__builtin_popcountll(r.bits[w]);
+            }
+            r.cardinalidad = card;
+            if (card <= MAX_ARREGLO) r.aArreglo();
+            return r;
+        }
+        if (a.esBitmap() || b.esBitmap()) {
+            const Contenedor& arr = a.esBitmap() ? b : a;
+            const Contenedor& bmp = a.esBitmap() ? a : b;
+            for (uint16_t v : arr.arreglo)
+                if ((bmp.bits[v >> 6] >> (v & 63)) & 1) r.arreglo.push_back(v);
+            r.cardinalidad = (uint32_t)r.arreglo.size();
+            return r;
+        }
+        const std::vector<uint16_t>& x = a.arreglo.size() <= b.arreglo.size() ? a.arreglo : b.arreglo;
+        const std::vector<uint16_t>& y = a.arreglo.size() <= b.arreglo.size() ? b.arreglo : a.arreglo;
+        if (x.size() * 32 < y.size()) {
+            size_t j = 0;
+            for (uint16_t v : x) {
+                j = galopar(y, j, v);
+                if (j == y.size()) break;
+                if (y[j] == v) r.arreglo.push_back(v);
+            }
+        } else {
+            size_t i = 0, j = 0;
+            while (i < x.size() && j < y.size()) {
+                if (x[i] < y[j]) i++;
+                else if (y[j] < x[i]) j++;
+                else { r.arreglo.push_back(x[i]); i++; j++; }
+            }
+        }
+        r.cardinalidad = (uint32_t)r.arreglo.size();
+        return r;
+    }
+
+    /*
+     * orContenedores
+     *  - arreglo/arreglo: mezcla; si pasa de 4096 se vuelve bitmap
+     *  - con algún bitmap: OR sobre un bitmap y recuento de bits
+     */
+    static Contenedor orContenedores(const Contenedor& a, const Contenedor& b) {
+        Contenedor r;
+        r.clave = a.clave;
+        if (!a.esBitmap() && !b.esBitmap()) {
+            r.arreglo.resize(a.arreglo.size() + b.arreglo.size());
+            auto fin = std::set_union(a.arreglo.begin(), a.arreglo.end(), b.arreglo.begin(),
+                                      b.arreglo.end(), r.arreglo.begin());
+            r.arreglo.resize((size_t)(fin - r.arreglo.begin()));
+            r.cardinalidad = (uint32_t)r.arreglo.size();
+            if (r.cardinalidad > MAX_ARREGLO) r.aBitmap();
+            return r;
+        }
+        r.bits.assign(PALABRAS, 0);
+        for (const Contenedor* c : {&a, &b}) {
+            if (c->esBitmap()) {
+                for (uint32_t w = 0; w < PALABRAS; w++) r.bits[w] |= c->bits[w];
+            } else {
+                for (uint16_t v : c->arreglo) r.bits[v >> 6] |= 1ull << (v & 63);
+            }
+        }
+        uint32_t card = 0;
+        for (uint32_t w = 0; w < PALABRAS; w++) card += (uint32_t)__builtin_popcountll(r.bits[w]);
+        r.cardinalidad = card;
+        return r;
+    }
+};
+
+} // namespace comun
+
+#endif
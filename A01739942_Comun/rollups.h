@@ -0,0 +1,371 @@
+/*
+    Descripción: Conteos precalculados en el tiempo ("rollups") por razón y
+    por red /16, para contestar series de tiempo sin recorrer la tabla.
+
+    Se construyen junto con los índices, en una pasada sobre la tabla, y
+    tienen tres niveles: minuto, hora y día (los dos últimos se derivan del
+    anterior). Cada nivel guarda solo las cubetas de tiempo con registros,
+    en orden, y por cada una (formato CSR: inicioX[c] es donde empieza la
+    lista de la cubeta c)
+        razon       las razones que aparecen en la cubeta, con su conteo
+        red         las redes /16 que aparecen en la cubeta, con su conteo
+    Un arreglo denso [cubeta][razón] crece con el lapso de tiempo y no con
+    los registros: con --cambio-anio y una bitácora desordenada el lapso
+    llega a 132 años (70 millones de minutos). Así cada nivel ocupa a lo
+    más del orden de n.
+
+    Un rango de tiempo alineado a minutos se parte en el menor número de
+    cubetas: minutos sueltos en las orillas, horas completas y días
+    completos en medio (recorrer), saltando los tramos sin registros.
+    "count where reason = X and time between Mar 01 and Mar 31" suma 31
+    cubetas de día en vez de visitar 20 000 registros.
+
+    Archivo (bitacora.txt.rollup, junto a la copia columnar): encabezado de
+    filtro_ip.h con firma ROLLUPS2 y el nivel de minutos; la hora y el día
+    se vuelven a derivar al cargar.
+*/
+
+#ifndef COMUN_ROLLUPS_H
+#define COMUN_ROLLUPS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "filtro_ip.h"
+#include "registro.h"
+
+namespace comun {
+
+// ---------------- 1. NIVEL ----------------
+
+/*
+ * 1.1 NivelRollup
+ * Conteos de un nivel (minuto, hora o día). La posición c de los arreglos
+ * es la cubeta de tiempo cubeta[c], que empieza en cubeta[c] * segundos;
+ * las cubetas sin registros no se guardan.
+ * Espacio: 12 bytes por cubeta + 5 por par (cubeta, razón) + 6 por par
+ * (cubeta, red); cada lista tiene a lo más n pares.
+ */
+struct NivelRollup {
+    uint32_t segundos = 60;
+    std::vector<uint32_t> cubeta;       // cubetas con registros, ascendentes
+    std::vector<uint32_t> inicioRazon;  // cubetas + 1 posiciones en razon/conteoRazon
+    std::vector<uint8_t> razon;         // razones de cada cubeta, ascendentes
+    std::vector<uint32_t> conteoRazon;
+    std::vector<uint32_t> inicioRed;    // cubetas + 1 posiciones en red/conteoRed
+    std::vector<uint16_t> red;          // redes de cada cubeta, ascendentes
+    std::vector<uint32_t> conteoRed;
+
+    size_t cubetas() const { return cubeta.size(); }
+
+    /*
+     * posicion
+     * Primera posición, desde 'desde', con cubeta >= k (búsqueda binaria).
+     * Complejidad: O(log cubetas).
+     */
+    size_t posicion(uint32_t k, size_t desde) const {
+        return (size_t)(std::lower_bound(cubeta.begin() + (std::ptrdiff_t)desde, cubeta.end(), k) - cubeta.begin());
+    }
+
+    /*
+     * conteoDeRed
+     * Registros de la red en la cubeta c (búsqueda binaria en su lista).
+     * Complejidad: O(log r), r = redes de la cubeta.
+     */
+    uint32_t conteoDeRed(size_t c, uint16_t r) const {
+        const uint16_t* ini = red.data() + inicioRed[c];
+        const uint16_t* fin = red.data() + inicioRed[c + 1];
+        const uint16_t* p = std::lower_bound(ini, fin, r);
+        return p != fin && *p == r ? conteoRed[(size_t)(p - red.data())] : 0;
+    }
+
+    size_t bytes() const {
+        return cubeta.capacity() * 4 + inicioRazon.capacity() * 4 + razon.capacity() + conteoRazon.capacity() * 4 +
+               inicioRed.capacity() * 4 + red.capacity() * 2 + conteoRed.capacity() * 4;
+    }
+};
+
+// ---------------- 2. ROLLUPS ----------------
+
+class Rollups {
+public:
+    enum Nivel { MINUTO, HORA, DIA, NIVELES };
+
+    /*
+     * 2.1 construir
+     * Nivel de minutos desde la tabla (en cualquier orden) y los demás
+     * derivados de él. Cada registro se vuelve una llave minuto | red |
+     * razón de 64 bits; ordenadas, los registros de un minuto quedan juntos
+     * y dentro de él los de cada red, así que basta una pasada para cerrar
+     * las cubetas. No depende del lapso de tiempo.
+     * Complejidad: O(n log n).
+     */
+    void construir(const TablaRegistros& t) {
+        size_t n = t.size();
+        total = n;
+        nRazones = (uint32_t)t.razones.size();
+        std::vector<uint64_t> llaves(n);
+        for (size_t i = 0; i < n; i++)
+            llaves[i] = (uint64_t)(t.tiempo[i] / 60) << 24 | (uint64_t)(t.ip[i] >> 16) << 8 | t.razon[i];
+        std::sort(llaves.begin(), llaves.end());
+
+        NivelRollup& m = niveles[MINUTO];
+        m = NivelRollup();
+        m.inicioRazon.assign(1, 0);
+        m.inicioRed.assign(1, 0);
+        Acumulador acum;
+        for (size_t i = 0; i < n;) {
+            uint64_t minuto = llaves[i] >> 24;
+            while (i < n && llaves[i] >> 24 == minuto) {
+                size_t j = i;
+                for (; j < n && llaves[j] >> 8 == llaves[i] >> 8; j++) acum.sumarRazon((uint8_t)llaves[j], 1);
+                acum.sumarRed((uint16_t)(llaves[i] >> 8), (uint32_t)(j - i));
+                i = j;
+            }
+            acum.cerrar(m, (uint32_t)minuto);
+        }
+        llaves = std::vector<uint64_t>();
+        m.cubeta.shrink_to_fit();
+        m.inicioRazon.shrink_to_fit();
+        m.razon.shrink_to_fit();
+        m.conteoRazon.shrink_to_fit();
+        m.inicioRed.shrink_to_fit();
+        m.red.shrink_to_fit();
+        m.conteoRed.shrink_to_fit();
+        derivar(HORA, 60);
+        derivar(DIA, 24);
+    }
+
+    const NivelRollup& nivel(Nivel k) const { return niveles[k]; }
+    uint32_t razones() const { return nRazones; }
+    size_t registros() const { return (size_t)total; }
+
+    size_t bytes() const {
+        size_t b = 0;
+        for (const NivelRollup& nv : niveles) b += nv.bytes();
+        return b;
+    }
+
+    /*
+     * 2.2 recorrer
+     * Parte [lo, hi] en cubetas de a lo más el nivel 'maximo' y llama
+     * f(nivel, c, inicio) por cada cubeta con datos: c es la posición en
+     * los arreglos del nivel e inicio el tiempo en que empieza la cubeta.
+     * Los minutos sin registros se saltan de una vez hasta el siguiente con
+     * registros (o el inicio de su día u hora, si no queda antes de donde
+     * va), así un rango de años con pocos registros no visita cada día.
+     * Requiere lo múltiplo de 60 y hi + 1 múltiplo de 60 (rango de minutos
+     * completos); un hi de UINT32_MAX también se acepta.
+     * Complejidad: O((días + 2 * (23 + 59)) * log cubetas), días = días
+     * con registros en el rango.
+     */
+    template <class F>
+    void recorrer(uint32_t lo, uint32_t hi, Nivel maximo, F f) const {
+        const NivelRollup& m = niveles[MINUTO];
+        uint64_t a = lo / 60;
+        uint64_t b = ((uint64_t)hi + 1) / 60;
+        size_t pos[NIVELES] = {0, 0, 0};
+        while (a < b) {
+            pos[MINUTO] = m.posicion((uint32_t)a, pos[MINUTO]);
+            if (pos[MINUTO] == m.cubetas() || m.cubeta[pos[MINUTO]] >= b) break;
+            uint64_t s = m.cubeta[pos[MINUTO]];
+            if (maximo >= DIA && s - s % 1440 >= a) s -= s % 1440;
+            else if (maximo >= HORA && s - s % 60 >= a) s -= s % 60;
+            a = s;
+
+            Nivel k = MINUTO;
+            uint64_t largo = 1;
+            if (maximo >= DIA && a % 1440 == 0 && a + 1440 <= b) {
+                k = DIA;
+                largo = 1440;
+            } else if (maximo >= HORA && a % 60 == 0 && a + 60 <= b) {
+                k = HORA;
+                largo = 60;
+            }
+            const NivelRollup& nv = niveles[k];
+            uint32_t clave = (uint32_t)(a / largo);
+            pos[k] = nv.posicion(clave, pos[k]);
+            if (pos[k] < nv.cubetas() && nv.cubeta[pos[k]] == clave) f(nv, pos[k], (uint32_t)(a * 60));
+            a += largo;
+        }
+    }
+
+    /*
+     * 2.3 guardar / cargar
+     * Parámetros del encabezado: registros, razones, cubetas del nivel de
+     * minutos, pares (cubeta, razón), pares (cubeta, red) y si los años se
+     * infirieron (--cambio-anio, como en columnar.h). Cada arreglo se
+     * escribe directo al archivo. Al cargar se revisa que los tamaños
+     * cuadren con el archivo y las listas entre sí antes de derivar la hora
+     * y el día.
+     */
+    bool guardar(const std::string& ruta) const {
+        const NivelRollup& m = niveles[MINUTO];
+        uint64_t anios = Calendario::global().cambioAnio;
+        std::ofstream out;
+        if (!abrirArchivo(out, ruta, FIRMA, {total, nRazones, m.cubetas(), m.razon.size(), m.red.size(), anios}))
+            return false;
+        escribirBytes(out, m.cubeta.data(), m.cubeta.size() * 4);
+        escribirBytes(out, m.inicioRazon.data(), m.inicioRazon.size() * 4);
+        escribirBytes(out, m.razon.data(), m.razon.size());
+        escribirBytes(out, m.conteoRazon.data(), m.conteoRazon.size() * 4);
+        escribirBytes(out, m.inicioRed.data(), m.inicioRed.size() * 4);
+        escribirBytes(out, m.red.data(), m.red.size() * 2);
+        escribirBytes(out, m.conteoRed.data(), m.conteoRed.size() * 4);
+        return (bool)out;
+    }
+
+    bool cargar(const std::string& ruta) {
+        std::ifstream in(ruta, std::ios::binary);
+        std::vector<uint64_t> params;
+        if (!in.is_open() || !leerEncabezado(in, FIRMA, params) || params.size() != 6) return false;
+        if (params[1] > (uint64_t)DiccionarioRazones::MAX_RAZONES ||
+            params[5] != (uint64_t)Calendario::global().cambioAnio)
+            return false;
+        // los tamaños del encabezado deben ser justo lo que queda del archivo
+        std::streampos aqui = in.tellg();
+        in.seekg(0, std::ios::end);
+        uint64_t resto = (uint64_t)(in.tellg() - aqui);
+        in.seekg(aqui);
+        uint64_t nc = params[2], nr = params[3], nd = params[4];
+        if (nc > params[0] || nr > params[0] || nd > params[0] || nc > resto || nr > resto || nd > resto ||
+            nc * 12 + 8 + nr * 5 + nd * 6 != resto)
+            return false;
+        NivelRollup m;
+        m.cubeta.resize(nc);
+        m.inicioRazon.resize(nc + 1);
+        m.razon.resize(nr);
+        m.conteoRazon.resize(nr);
+        m.inicioRed.resize(nc + 1);
+        m.red.resize(nd);
+        m.conteoRed.resize(nd);
+        if (!leerBytes(in, m.cubeta.data(), m.cubeta.size() * 4) ||
+            !leerBytes(in, m.inicioRazon.data(), m.inicioRazon.size() * 4) ||
+            !leerBytes(in, m.razon.data(), m.razon.size()) ||
+            !leerBytes(in, m.conteoRazon.data(), m.conteoRazon.size() * 4) ||
+            !leerBytes(in, m.inicioRed.data(), m.inicioRed.size() * 4) ||
+            !leerBytes(in, m.red.data(), m.red.size() * 2) ||
+            !leerBytes(in, m.conteoRed.data(), m.conteoRed.size() * 4))
+            return false;
+        if (!listaValida(m.inicioRazon, m.razon) || !listaValida(m.inicioRed, m.red)) return false;
+        for (size_t c = 0; c < m.cubetas(); c++)
+            if ((c > 0 && m.cubeta[c] <= m.cubeta[c - 1]) || m.cubeta[c] > UINT32_MAX / 60) return false;
+        uint64_t porRazon = 0, porRed = 0;
+        for (size_t j = 0; j < m.razon.size(); j++) {
+            if (m.razon[j] >= params[1]) return false;
+            porRazon += m.conteoRazon[j];
+        }
+        for (uint32_t x : m.conteoRed) porRed += x;
+        if (porRazon != params[0] || porRed != params[0]) return false;
+        total = params[0];
+        nRazones = (uint32_t)params[1];
+        niveles[MINUTO] = std::move(m);
+        derivar(HORA, 60);
+        derivar(DIA, 24);
+        return true;
+    }
+
+private:
+    static constexpr char FIRMA[8] = {'R', 'O', 'L', 'L', 'U', 'P', 'S', '2'};
+
+    uint64_t total = 0;
+    uint32_t nRazones = 0;
+    NivelRollup niveles[NIVELES];
+
+    /*
+     * 2.4 Acumulador
+     * Conteos de la cubeta que se está armando, en arreglos densos por
+     * razón (256) y por red (65536); cerrar ordena y limpia solo las que
+     * aparecieron y agrega la cubeta al final del nivel.
+     */
+    struct Acumulador {
+        std::vector<uint32_t> porRazon = std::vector<uint32_t>(256, 0);
+        std::vector<uint32_t> porRed = std::vector<uint32_t>(65536, 0);
+        std::vector<uint8_t> razones;
+        std::vector<uint16_t> redes;
+
+        void sumarRazon(uint8_t r, uint32_t n) {
+            if (porRazon[r] == 0) razones.push_back(r);
+            porRazon[r] += n;
+        }
+
+        void sumarRed(uint16_t r, uint32_t n) {
+            if (porRed[r] == 0) redes.push_back(r);
+            porRed[r] += n;
+        }
+
+        void cerrar(NivelRollup& nv, uint32_t c) {
+            std::sort(razones.begin(), razones.end());
+            std::sort(redes.begin(), redes.end());
+            nv.cubeta.push_back(c);
+            for (uint8_t r : razones) {
+                nv.razon.push_back(r);
+                nv.conteoRazon.push_back(porRazon[r]);
+                porRazon[r] = 0;
+            }
+            for (uint16_t r : redes) {
+                nv.red.push_back(r);
+                nv.conteoRed.push_back(porRed[r]);
+                porRed[r] = 0;
+            }
+            nv.inicioRazon.push_back((uint32_t)nv.razon.size());
+            nv.inicioRed.push_back((uint32_t)nv.red.size());
+            razones.clear();
+            redes.clear();
+        }
+    };
+
+    /*
+     * 2.5 derivar
+     * Nivel k a partir del k - 1: las cubetas finas que caen en la misma
+     * gruesa están juntas, así que se acumulan y se cierra al cambiar.
+     * Complejidad: O(pares (cubeta, razón) + pares (cubeta, red)).
+     */
+    void derivar(Nivel k, uint32_t factor) {
+        const NivelRollup& fino = niveles[k - 1];
+        NivelRollup& g = niveles[k];
+        g = NivelRollup();
+        g.segundos = fino.segundos * factor;
+        g.inicioRazon.assign(1, 0);
+        g.inicioRed.assign(1, 0);
+        Acumulador acum;
+        for (size_t i = 0; i < fino.cubetas();) {
+            uint32_t c = fino.cubeta[i] / factor;
+            for (; i < fino.cubetas() && fino.cubeta[i] / factor == c; i++) {
+                for (uint32_t j = fino.inicioRazon[i]; j < fino.inicioRazon[i + 1]; j++)
+                    acum.sumarRazon(fino.razon[j], fino.conteoRazon[j]);
+                for (uint32_t j = fino.inicioRed[i]; j < fino.inicioRed[i + 1]; j++)
+                    acum.sumarRed(fino.red[j], fino.conteoRed[j]);
+            }
+            acum.cerrar(g, c);
+        }
+    }
+
+    // inicio: cubetas + 1 posiciones que crecen; cada lista, ascendente
+    template <class T>
+    static bool listaValida(const std::vector<uint32_t>& inicio, const std::vector<T>& v) {
+        if (inicio.front() != 0 || inicio.back() != v.size()) return false;
+        for (size_t c = 0; c + 1 < inicio.size(); c++) {
+            if (inicio[c] > inicio[c + 1]) return false;
+            for (uint32_t j = inicio[c] + 1; j < inicio[c + 1]; j++)
+                if (v[j] <= v[j - 1]) return false;
+        }
+        return true;
+    }
+
+    static void escribirBytes(std::ofstream& out, const void* p, size_t n) {
+        out.write((const char*)p, (std::streamsize)n);
+    }
+
+    static bool leerBytes(std::ifstream& in, void* p, size_t n) {
+        return (bool)in.read((char*)p, (std::streamsize)n);
+    }
+};
+
+} // namespace comun
+
+#endif
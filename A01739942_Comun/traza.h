@@ -0,0 +1,171 @@
+/*
+    Descripción: Línea de tiempo de las etapas en formato Chrome trace-event
+    (se abre en chrome://tracing o en ui.perfetto.dev).
+
+    Con --traza archivo.json cada etapa medida (Temporizador) y cada tramo de
+    trabajo de un hilo (EventoTraza) deja un evento de inicio "B" y uno de
+    fin "E" con su hilo. Así se ven en paralelo los hilos que indexan o
+    parsean, cuánto espera cada uno y qué tan parejo quedó el reparto.
+
+    Cada hilo escribe en su propio buffer (sin candados: un solo escritor);
+    el único candado es al registrar el buffer la primera vez que el hilo
+    traza algo. Los buffers viven hasta el final del proceso aunque el hilo
+    termine, y el archivo JSON se escribe al salir.
+
+    Deshabilitado, cada evento cuesta una comparación.
+*/
+
+#ifndef COMUN_TRAZA_H
+#define COMUN_TRAZA_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace comun {
+
+class Trazador {
+public:
+    /*
+     * 1.1 global
+     */
+    static Trazador& global() {
+        static Trazador instancia;
+        return instancia;
+    }
+
+    /*
+     * 1.2 habilitar
+     * Empieza a registrar eventos; se escribirán en 'ruta' al salir.
+     */
+    void habilitar(const std::string& ruta) {
+        archivo = ruta;
+        activo.store(true, std::memory_order_release);
+        bufferHilo();   // el hilo que habilita (main) queda como "principal"
+    }
+
+    bool habilitado() const { return activo.load(std::memory_order_relaxed); }
+
+    /*
+     * 1.3 nombrarHilo
+     * Nombre con que aparece el hilo actual en la línea de tiempo.
+     */
+    void nombrarHilo(const std::string& nombre) {
+        if (habilitado()) bufferHilo().nombre = nombre;
+    }
+
+    /*
+     * 1.4 iniciar / terminar
+     * Eventos "B" y "E" del hilo actual. 'nombre' debe ser una cadena
+     * literal (se guarda el apuntador, no una copia).
+     * Complejidad: O(1) amortizado.
+     */
+    void iniciar(const char* nombre) { agregar(nombre, 'B'); }
+    void terminar(const char* nombre) { agregar(nombre, 'E'); }
+
+    /*
+     * 1.5 escribir
+     * Vuelca todos los buffers al archivo JSON. Se llama al destruirse el
+     * trazador; para entonces los hilos de trabajo ya terminaron.
+     */
+    bool escribir() const {
+        FILE* f = std::fopen(archivo.c_str(), "w");
+        if (!f) {
+            std::fprintf(stderr, "Error: no se pudo escribir la traza %s\n", archivo.c_str());
+            return false;
+        }
+        std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        const char* sep = "";
+        for (const auto& b : buffers) {
+            std::fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                            "\"args\":{\"name\":\"%s\"}}",
+                         sep, b->tid, b->nombre.c_str());
+            sep = ",\n";
+            for (const Evento& e : b->eventos)
+                std::fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", e.nombre,
+                             e.fase, b->tid, (double)e.ns / 1000.0);
+        }
+        std::fprintf(f, "\n]}\n");
+        std::fclose(f);
+        return true;
+    }
+
+    ~Trazador() {
+        if (habilitado()) escribir();
+    }
+
+private:
+    struct Evento {
+        const char* nombre;
+        uint64_t ns;
+        char fase;
+    };
+
+    struct BufferHilo {
+        unsigned tid;
+        std::string nombre;
+        std::deque<Evento> eventos;     // crece sin mover los eventos ya escritos
+    };
+
+    std::atomic<bool> activo{false};
+    std::string archivo;
+    std::chrono::steady_clock::time_point origen = std::chrono::steady_clock::now();
+    std::mutex candado;
+    std::vector<std::unique_ptr<BufferHilo>> buffers;
+
+    /*
+     * bufferHilo
+     * Buffer del hilo actual; se crea y registra la primera vez.
+     */
+    BufferHilo& bufferHilo() {
+        thread_local BufferHilo* propio = nullptr;
+        if (!propio) {
+            std::lock_guard<std::mutex> g(candado);
+            buffers.push_back(std::unique_ptr<BufferHilo>(new BufferHilo()));
+            propio = buffers.back().get();
+            propio->tid = (unsigned)buffers.size();
+            propio->nombre = propio->tid == 1 ? "principal" : "hilo " + std::to_string(propio->tid - 1);
+        }
+        return *propio;
+    }
+
+    void agregar(const char* nombre, char fase) {
+        if (!habilitado()) return;
+        uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - origen).count();
+        bufferHilo().eventos.push_back(Evento{nombre, ns, fase});
+    }
+};
+
+/*
+ * 2.1 EventoTraza
+ * RAII para un tramo de trabajo (p.ej. el trozo de un hilo):
+ *     { EventoTraza e("indexarTramo"); ... }
+ * terminar() lo cierra antes de salir del bloque.
+ */
+class EventoTraza {
+public:
+    explicit EventoTraza(const char* etapa) : nombre(etapa) { Trazador::global().iniciar(nombre); }
+    ~EventoTraza() { terminar(); }
+    EventoTraza(const EventoTraza&) = delete;
+    EventoTraza& operator=(const EventoTraza&) = delete;
+
+    void terminar() {
+        if (!nombre) return;
+        Trazador::global().terminar(nombre);
+        nombre = nullptr;
+    }
+
+private:
+    const char* nombre;
+};
+
+} // namespace comun
+
+#endif
@@ -0,0 +1,239 @@
+/*
+    Descripción: Ingesta de la bitácora en etapas que corren a la vez:
+
+        lector ──trozos──▶ N parsers ──lotes──▶ consumidor (índice)
+
+    - lector: un hilo lee el archivo por bloques (lector_asincrono.h), lo
+      descomprime si es gzip (gzip.h) y lo corta en trozos de líneas
+      completas.
+    - parsers: N hilos convierten cada línea del trozo en un registro R con
+      la función 'parsear' del programa (debe poder correr en paralelo).
+    - consumidor: el hilo que llama recibe los registros en el orden del
+      archivo y los inserta en su estructura (vector, map, tabla hash...).
+
+    Las etapas se comunican con anillos sin candados (anillos.h). Hay un
+    número fijo de lotes (trozo de texto + sus registros) que circulan: el
+    lector toma uno libre, los parsers lo llenan, el consumidor lo vacía y
+    lo devuelve. Si el consumidor se atrasa se acaban los lotes libres y el
+    lector espera: la memoria queda acotada a LOTES · (TROZO + registros)
+    sin importar el tamaño del archivo.
+
+    Los lotes terminan de parsearse en desorden; el consumidor los reordena
+    con su número de secuencia (a lo más LOTES pendientes).
+
+    Uso (R puede guardar string_view al texto de su línea: sigue vivo
+    hasta que consumir() regresa):
+        ingestarArchivo<Entrada>("bitacora.txt",
+            [](const char* ini, const char* fin, Entrada& e) { ...; return true; },
+            [&](Entrada& e) { indice.insertar(e); });
+*/
+
+#ifndef COMUN_TUBERIA_H
+#define COMUN_TUBERIA_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "anillos.h"
+#include "estadisticas.h"
+#include "gzip.h"
+#include "lector_asincrono.h"
+
+namespace comun {
+
+// ---------------- 1. PARÁMETROS ----------------
+
+/*
+ * 1.1 OpcionesIngesta
+ * parsers = 0 usa los núcleos que quedan libres (al menos 1).
+ */
+struct OpcionesIngesta {
+    unsigned parsers = 0;
+    size_t trozo = 256u << 10;      // bytes de texto por lote
+    unsigned lotes = 0;             // 0 = 4 por parser
+    LectorAsincrono::Modo modo = LectorAsincrono::AUTOMATICO;
+};
+
+/*
+ * 1.2 ResultadoIngesta
+ */
+struct ResultadoIngesta {
+    bool ok = false;
+    size_t bytes = 0, lineas = 0, omitidas = 0, lotes = 0;
+    size_t texto = 0;               // bytes ya descomprimidos (= bytes en texto plano)
+};
+
+// ---------------- 2. TUBERÍA ----------------
+
+/*
+ * 2.1 LoteIngesta
+ * Un trozo de líneas completas y los registros que salieron de él.
+ */
+template <class R>
+struct LoteIngesta {
+    uint64_t secuencia = 0;
+    std::vector<char> texto;
+    std::vector<R> registros;
+    size_t lineas = 0, omitidas = 0;
+};
+
+/*
+ * 2.2 ingestarArchivo
+ * Corre las tres etapas y regresa cuando el consumidor recibió todos los
+ * registros. parsear(ini, fin, r) recibe la línea sin '\n' y devuelve false
+ * para omitirla; las líneas se cortan como getline (la última puede no
+ * terminar en '\n').
+ * Complejidad: O(n) en total; memoria O(lotes · trozo).
+ */
+template <class R, class Parsear, class Consumir>
+ResultadoIngesta ingestarArchivo(const std::string& ruta, Parsear parsear, Consumir consumir,
+                                 OpcionesIngesta op = OpcionesIngesta()) {
+    ResultadoIngesta res;
+    LectorAsincrono lector;
+    if (!lector.abrir(rutaEntrada(ruta), op.modo)) {
+        std::cerr << "Error: no se pudo abrir el archivo " << ruta << " (" << lector.error() << ")\n";
+        return res;
+    }
+    res.bytes = lector.tamano();
+    if (op.parsers == 0) op.parsers = std::max(1u, std::thread::hardware_concurrency() - 1);
+    if (op.lotes == 0) op.lotes = 4 * op.parsers;
+    op.lotes = (unsigned)potenciaDe2(std::max(2u, op.lotes));
+
+    std::vector<std::unique_ptr<LoteIngesta<R>>> lotes(op.lotes);
+    AnilloSpsc<LoteIngesta<R>*> libres(op.lotes);       // consumidor -> lector
+    AnilloMpmc<LoteIngesta<R>*> trozos(op.lotes);       // lector -> parsers
+    AnilloMpmc<LoteIngesta<R>*> listos(op.lotes);       // parsers -> consumidor
+    for (auto& l : lotes) {
+        l.reset(new LoteIngesta<R>());
+        l->texto.reserve(op.trozo + LectorAsincrono::BLOQUE);
+        libres.intentarMeter(l.get());
+    }
+    std::atomic<uint64_t> totalLotes{UINT64_MAX};       // se conoce al terminar de leer
+    std::atomic<bool> lecturaTerminada{false}, falloLectura{false};
+
+    // Etapa 1: lector
+    std::thread hiloLector([&] {
+        Trazador::global().nombrarHilo("lector");
+        EventoTraza e("leerTrozos");
+        uint64_t secuencia = 0;
+        unsigned intentos = 0;
+        LoteIngesta<R>* actual = nullptr;
+        auto tomarLibre = [&] {
+            LoteIngesta<R>* l;
+            while (!libres.intentarSacar(l)) esperarTurno(intentos);
+            intentos = 0;
+            l->texto.clear();
+            return l;
+        };
+        auto enviar = [&](LoteIngesta<R>* l) {
+            l->secuencia = secuencia++;
+            while (!trozos.intentarMeter(l)) esperarTurno(intentos);
+            intentos = 0;
+        };
+        actual = tomarLibre();
+        std::string error;
+        bool ok = leerDescomprimido(lector, [&](const char* datos, size_t n) {
+            actual->texto.insert(actual->texto.end(), datos, datos + n);
+            if (actual->texto.size() < op.trozo) return;
+            // se corta en el último '\n'; lo que sigue pasa al próximo lote
+            const char* ini = actual->texto.data();
+            const char* corte = ini + actual->texto.size();
+            while (corte > ini && corte[-1] != '\n') --corte;
+            if (corte == ini) return;       // una línea más larga que el trozo
+            LoteIngesta<R>* siguiente = tomarLibre();
+            siguiente->texto.assign(corte, ini + actual->texto.size());
+            actual->texto.resize((size_t)(corte - ini));
+            enviar(actual);
+            actual = siguiente;
+        }, error, &res.texto);
+        if (!actual->texto.empty()) enviar(actual);
+        if (!ok) {
+            std::cerr << "Error: falló la lectura de " << ruta << " (" << error << ")\n";
+            falloLectura.store(true);
+        }
+        totalLotes.store(secuencia, std::memory_order_release);
+        lecturaTerminada.store(true, std::memory_order_release);
+    });
+
+    // Etapa 2: parsers
+    std::vector<std::thread> hilosParser;
+    for (unsigned p = 0; p < op.parsers; p++) {
+        hilosParser.emplace_back([&, p] {
+            Trazador::global().nombrarHilo("parser " + std::to_string(p + 1));
+            unsigned intentos = 0;
+            for (;;) {
+                LoteIngesta<R>* l = nullptr;
+                if (!trozos.intentarSacar(l)) {
+                    if (!lecturaTerminada.load(std::memory_order_acquire)) {
+                        esperarTurno(intentos);
+                        continue;
+                    }
+                    // se revisa la cola otra vez después de ver el fin: el
+                    // último trozo pudo entrar entre las dos lecturas
+                    if (!trozos.intentarSacar(l)) return;
+                }
+                intentos = 0;
+                EventoTraza e("parsearTrozo");
+                l->registros.clear();
+                l->lineas = l->omitidas = 0;
+                const char* q = l->texto.data();
+                const char* fin = q + l->texto.size();
+                while (q < fin) {
+                    const char* nl = (const char*)std::memchr(q, '\n', (size_t)(fin - q));
+                    const char* finLinea = nl ? nl : fin;
+                    l->registros.emplace_back();
+                    if (parsear(q, finLinea, l->registros.back())) l->lineas++;
+                    else {
+                        l->registros.pop_back();
+                        l->omitidas++;
+                    }
+                    q = nl ? nl + 1 : fin;
+                }
+                while (!listos.intentarMeter(l)) esperarTurno(intentos);
+                intentos = 0;
+            }
+        });
+    }
+
+    // Etapa 3: consumidor (este hilo), en orden de secuencia
+    {
+        EventoTraza e("consumir");
+        std::vector<LoteIngesta<R>*> pendientes(op.lotes, nullptr);
+        uint64_t siguiente = 0;
+        unsigned intentos = 0;
+        while (siguiente < totalLotes.load(std::memory_order_acquire)) {
+            LoteIngesta<R>* l;
+            if (!listos.intentarSacar(l)) {
+                esperarTurno(intentos);
+                continue;
+            }
+            intentos = 0;
+            pendientes[l->secuencia & (op.lotes - 1)] = l;
+            // a lo más op.lotes en circulación: la casilla de cada secuencia es única
+            while (LoteIngesta<R>* t = pendientes[siguiente & (op.lotes - 1)]) {
+                pendientes[siguiente & (op.lotes - 1)] = nullptr;
+                for (R& r : t->registros) consumir(r);
+                res.lineas += t->lineas;
+                res.omitidas += t->omitidas;
+                res.lotes++;
+                siguiente++;
+                libres.intentarMeter(t);
+            }
+        }
+    }
+    hiloLector.join();
+    for (std::thread& h : hilosParser) h.join();
+    res.ok = !falloLectura.load();
+    return res;
+}
+
+} // namespace comun
+
+#endif
@@ -0,0 +1,1742 @@
+/*
+    Descripción: Motor de consultas sobre la bitácora. En lugar de escribir un
+    programa nuevo por cada pregunta (rango de fechas en Act1.3, rango de IPs en
+    Act2.3, top de IPs en Act3_4, etc.), este programa carga bitacora.txt una
+    sola vez en una tabla columnar y ejecuta consultas escritas en un lenguaje
+    pequeño de filtros y agregados.
+
+    Lenguaje (palabras clave sin distinguir mayúsculas):
+
+        [count] [where <cond> {and <cond>}] [group by <campo>]
+        [order by <campo> [asc|desc]] [limit <n>]
+
+        <cond> :=  time between "Mon DD[ AAAA][ HH:MM:SS]" and "Mon DD[ AAAA][ HH:MM:SS]"
+                |  time (>= | <= | > | <) "Mon DD[ AAAA][ HH:MM:SS]"
+                |  month = Mon
+                |  ip in a.b.c.d/n   |  ip = a.b.c.d  |  ip between a.b.c.d and a.b.c.d
+                |  reason = "texto"  |  reason has "palabra [palabra ...]"
+                |  port = n          |  port between n and m
+
+        <campo> := time | ip | net | port | reason | month | day | hour | minute | dayhour | count
+
+    Sin "group by" se imprimen las líneas que cumplen los filtros (en el mismo
+    formato de bitacora.txt). Con "group by" se imprime "<clave> <conteo>".
+
+    El tiempo se guarda en segundos desde el año base (registro.h). La
+    bitácora no trae año: con --cambio-anio se infiere al leer (un salto de
+    diciembre a enero es el año siguiente), "group by day" imprime el año y
+    las fechas sin año, como "month = Mon", son del año base (--anio-base).
+
+    Ejemplos:
+        where time between "Mar 01" and "Mar 02" order by time
+        where ip in 10.0.0.0/8 and reason = "Failed password for root"
+        count where reason has "illegal" and month = Mar
+        group by ip order by count desc limit 5
+        count where port between 1000 and 2000
+
+    Al cargar se construyen índices roaring por razón, mes y cubeta de puertos,
+    y un índice invertido de palabras de la razón; los filtros sobre esos
+    campos se contestan intersectando índices y solo se visitan los lotes con
+    candidatos.
+
+    También se precalculan conteos por minuto (y por hora y día) de cada
+    razón y cada red /16 (rollups.h). Las series de tiempo como
+        count where reason = "Illegal user" and time between "Mar 01" and "Mar 31"
+        where ip in 10.20.0.0/16 group by dayhour
+        where reason has "password" group by minute order by count desc limit 10
+    se contestan sumando cubetas, sin recorrer la tabla (ver 4.10). Con
+    --columnar se guardan en bitacora.txt.rollup junto a la copia columnar.
+
+    También se construye un filtro de pertenencia de IPs (binary fuse, ~9 bits
+    por IP): "where ip = a.b.c.d" con una IP que nunca apareció se contesta sin
+    recorrer la tabla. Con --guardar-filtros se guardan junto a la bitácora
+    (bitacora.txt.fusion y bitacora.txt.bloom) y "--existe a.b.c.d" contesta
+    "¿esta IP nos ha visitado?" leyendo solo el filtro guardado.
+
+    Con --columnar la tabla se guarda comprimida por bloques junto a la
+    bitácora (bitacora.txt.col, columnar.h, ~6-9 bytes por registro) y las
+    siguientes corridas la cargan de ahí sin parsear el texto, mientras el
+    .col sea más nuevo que la bitácora. La tabla queda en orden de tiempo,
+    así que las líneas sin "order by" también salen en ese orden.
+
+    Uso:
+        ./consultas [-f bitacora.txt] [--sin-indices] [--guardar-filtros] [--columnar] [--hilos n]
+                    [--fijar-nucleos] [--paginas normales|thp|hugetlb] [--flujo] [--mem=4G]
+                    [--anio-base=AAAA] [--cambio-anio]
+                    [--stats | --stats-hw] [--traza t.json] ["consulta" ...]
+        ./consultas [-f bitacora.txt] --existe a.b.c.d
+        ./consultas [-f bitacora.txt] [--columnar] [--flujo] [--detectar N/T] [--escaneos P/T]
+    Si no se dan consultas como argumentos se lee una consulta por línea de stdin.
+    Con --stats se imprime en stderr (JSON) el tiempo y memoria por etapa;
+    --stats-hw agrega contadores de hardware (ciclos, fallos de caché/TLB).
+    Con --traza t.json se escribe la línea de tiempo de etapas e hilos en
+    formato Chrome trace-event (chrome://tracing, ui.perfetto.dev).
+    --hilos n limita el conjunto de hilos (por omisión, los núcleos del CPU)
+    y --fijar-nucleos fija cada trabajador a un núcleo. --paginas elige cómo
+    se respaldan las columnas de la tabla (paginas.h; por omisión thp).
+    Con --flujo no se carga la tabla: cada consulta lee la bitácora al vuelo
+    (generador.h) y, con limit y sin orden, se detiene en cuanto junta las
+    líneas. group by y order by también se contestan en flujo, con conteos y
+    un orden que se derraman a disco si no caben (presupuesto.h).
+    --mem=4G fija el presupuesto de memoria: si la tabla estimada no cabe en
+    él, las consultas se contestan en flujo (con un aviso en stderr).
+    Si la bitácora está rotada (bitacora.txt.1, .2, ...) se leen todos los
+    archivos y se mezclan por tiempo como si fueran uno solo.
+
+    Con --detectar N/T se buscan ataques de fuerza bruta en lugar de
+    contestar consultas: los fallos de acceso ("Failed password ..." y "Too
+    many login attempts") pasan en orden de tiempo por un detector en flujo
+    (detector.h) y se imprime una línea por cada IP que junta N fallos en
+    menos de T segundos:
+        Mar 05 13:20:01 10.1.2.3 5 fallos en 37 s (desde Mar 05 13:19:24)
+    Una IP vuelve a avisar solo tras N fallos nuevos.
+
+    Con --escaneos P/T se buscan escaneos de puertos: los puertos distintos
+    de cada IP se cuentan por ventanas de T segundos, exactos hasta unos
+    cuantos y con un bosquejo HyperLogLog después (escaneo.h, memoria
+    acotada). Se imprime una línea por IP y ventana al llegar a P puertos
+    y, tras una línea en blanco, los mayores escaneos ("~" = estimado).
+
+    Compilación: g++ -O2 -std=c++20 -pthread main.cpp -o consultas
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../A01739942_Comun/columnar.h"
+#include "../A01739942_Comun/detector.h"
+#include "../A01739942_Comun/escaneo.h"
+#include "../A01739942_Comun/filtro_ip.h"
+#include "../A01739942_Comun/filtros_simd.h"
+#include "../A01739942_Comun/formato.h"
+#include "../A01739942_Comun/generador.h"
+#include "../A01739942_Comun/hilos.h"
+#include "../A01739942_Comun/indice_invertido.h"
+#include "../A01739942_Comun/indices.h"
+#include "../A01739942_Comun/presupuesto.h"
+#include "../A01739942_Comun/registro.h"
+#include "../A01739942_Comun/rollups.h"
+
+using namespace std;
+using namespace comun;
+
+// ---------------- 1. ESTRUCTURAS DE LA CONSULTA ----------------
+
+/*
+ * 1.1 Campo
+ * Columnas (o valores derivados de ellas) que pueden usarse para agrupar u ordenar.
+ */
+enum Campo {
+    CAMPO_NINGUNO,
+    CAMPO_TIEMPO,
+    CAMPO_IP,
+    CAMPO_RED,      // primeros dos octetos (como en Act4.3 y Act5.2)
+    CAMPO_PUERTO,
+    CAMPO_RAZON,
+    CAMPO_MES,
+    CAMPO_DIA,      // fecha "Mon DD"
+    CAMPO_HORA,     // hora del día 0-23
+    CAMPO_MINUTO,   // "Mon DD HH:MM" (serie de tiempo por minuto)
+    CAMPO_HORA_FECHA, // "Mon DD HH" (serie de tiempo por hora)
+    CAMPO_CONTEO
+};
+
+/*
+ * 1.2 Predicado
+ * Un filtro sobre una columna. Hay tres formas:
+ *  - RANGO:    lo <= valor <= hi
+ *  - MASCARA:  (valor & mascara) == lo      (CIDR sobre la IP)
+ *  - CONJUNTO: el id de razón está en conjunto (reason has "palabras");
+ *              palabras se conserva para buscar en el índice invertido
+ * La igualdad es un rango con lo == hi.
+ * Sin tabla (--flujo) no hay ids de razón: reason = "texto" guarda el texto
+ * y reason has solo las palabras; se comparan contra la razón de cada línea.
+ */
+struct Predicado {
+    enum Tipo { RANGO, MASCARA, CONJUNTO };
+    Tipo tipo;
+    Campo campo;    // CAMPO_TIEMPO, CAMPO_IP, CAMPO_PUERTO o CAMPO_RAZON
+    uint32_t lo, hi;
+    uint32_t mascara;
+    uint64_t conjunto[4] = {0, 0, 0, 0};
+    vector<string> palabras;
+    string texto;
+};
+
+/*
+ * 1.3 Consulta
+ * Resultado del análisis del texto de la consulta.
+ * vacia indica que algún filtro no puede cumplirse (p.ej. una razón que no
+ * existe en la bitácora), así que no hace falta recorrer la tabla.
+ */
+struct Consulta {
+    bool soloConteo = false;
+    vector<Predicado> filtros;
+    Campo agrupar = CAMPO_NINGUNO;
+    Campo ordenar = CAMPO_NINGUNO;
+    bool descendente = false;
+    long long limite = -1;
+    bool vacia = false;
+};
+
+// ---------------- 2. ANALIZADOR DE CONSULTAS ----------------
+
+/*
+ * 2.1 Token
+ * CADENA: texto entre comillas; OPERADOR: = >= <= > <; PALABRA: lo demás.
+ */
+struct Token {
+    enum Tipo { PALABRA, CADENA, OPERADOR };
+    Tipo tipo;
+    string texto;
+};
+
+/*
+ * 2.2 separarTokens
+ * Divide el texto de la consulta en tokens.
+ * Complejidad: O(L), L = longitud de la consulta.
+ */
+bool separarTokens(const string& s, vector<Token>& tokens, string& error) {
+    size_t i = 0, n = s.size();
+    while (i < n) {
+        char c = s[i];
+        if (isspace((unsigned char)c)) {
+            ++i;
+        } else if (c == '"' || c == '\'') {
+            size_t fin = s.find(c, i + 1);
+            if (fin == string::npos) {
+                error = "comillas sin cerrar";
+                return false;
+            }
+            tokens.push_back({Token::CADENA, s.substr(i + 1, fin - i - 1)});
+            i = fin + 1;
+        } else if (c == '=' || c == '<' || c == '>') {
+            string op(1, c);
+            if (c != '=' && i + 1 < n && s[i + 1] == '=') op += '=';
+            tokens.push_back({Token::OPERADOR, op});
+            i += op.size();
+        } else {
+            size_t ini = i;
+            while (i < n && !isspace((unsigned char)s[i]) && s[i] != '=' && s[i] != '<' &&
+                   s[i] != '>' && s[i] != '"' && s[i] != '\'')
+                ++i;
+            tokens.push_back({Token::PALABRA, s.substr(ini, i - ini)});
+        }
+    }
+    return true;
+}
+
+/*
+ * 2.3 minusculas
+ * Copia del texto en minúsculas (para comparar palabras clave).
+ */
+string minusculas(string s) {
+    for (char& c : s) c = (char)tolower((unsigned char)c);
+    return s;
+}
+
+/*
+ * 2.4 campoDeNombre
+ * Traduce el nombre de un campo del lenguaje a su enum.
+ */
+Campo campoDeNombre(const string& nombre) {
+    string s = minusculas(nombre);
+    if (s == "time") return CAMPO_TIEMPO;
+    if (s == "ip") return CAMPO_IP;
+    if (s == "net") return CAMPO_RED;
+    if (s == "port") return CAMPO_PUERTO;
+    if (s == "reason") return CAMPO_RAZON;
+    if (s == "month") return CAMPO_MES;
+    if (s == "day") return CAMPO_DIA;
+    if (s == "hour") return CAMPO_HORA;
+    if (s == "minute") return CAMPO_MINUTO;
+    if (s == "dayhour") return CAMPO_HORA_FECHA;
+    if (s == "count") return CAMPO_CONTEO;
+    return CAMPO_NINGUNO;
+}
+
+/*
+ * 2.5 parsearFecha
+ * Convierte "Mon DD", "Mon DD AAAA" o cualquiera de los dos seguido de
+ * "HH:MM:SS" a la clave de tiempo. Sin año es el año base; sin hora se usa
+ * 00:00:00 o 23:59:59 según finDeDia, igual que el rango de fechas de Act1.3.
+ */
+bool parsearFecha(const string& s, bool finDeDia, uint32_t& t) {
+    const char* p = s.data();
+    const char* fin = p + s.size();
+    if (s.size() < 5) return false;
+    int mes = mesANumero(p);
+    if (mes < 0) return false;
+    p += 3;
+    while (p < fin && *p == ' ') ++p;
+    uint32_t dia, h = 0, mi = 0, seg = 0, anio = 0;
+    if (!leerNumero(p, fin, dia) || dia < 1 || dia > 31) return false;
+    while (p < fin && *p == ' ') ++p;
+    const char* q = p;
+    uint32_t n;
+    if (leerNumero(q, fin, n) && (q == fin || *q == ' ')) {
+        uint32_t base = Calendario::global().anioBase;
+        if (n < base || n - base >= ANIOS_MAX) return false;
+        anio = n - base;
+        p = q;
+        while (p < fin && *p == ' ') ++p;
+    }
+    if (p == fin) {
+        if (finDeDia) { h = 23; mi = 59; seg = 59; }
+    } else {
+        if (!leerNumero(p, fin, h) || p >= fin || *p++ != ':') return false;
+        if (!leerNumero(p, fin, mi) || p >= fin || *p++ != ':') return false;
+        if (!leerNumero(p, fin, seg) || p != fin) return false;
+        if (h > 23 || mi > 59 || seg > 59) return false;
+    }
+    t = claveTiempo(mes, (int)dia, (int)h, (int)mi, (int)seg, anio);
+    return true;
+}
+
+/*
+ * 2.6 Analizador
+ * Analizador descendente recursivo sobre la lista de tokens.
+ * Cada método devuelve false y deja el mensaje en error si la consulta no es válida.
+ * tabla es nullptr cuando la consulta se contesta en flujo, sin diccionario
+ * de razones.
+ */
+class Analizador {
+public:
+    Analizador(const vector<Token>& t, const TablaRegistros* tabla)
+        : tokens(t), tabla(tabla), pos(0) {}
+
+    bool analizar(Consulta& q, string& error) {
+        if (palabra("count")) q.soloConteo = true;
+        if (palabra("where")) {
+            do {
+                if (!condicion(q, error)) return false;
+            } while (palabra("and"));
+        }
+        if (palabra("group")) {
+            if (!palabra("by")) return falla(error, "se esperaba 'by' después de 'group'");
+            if (!campo(q.agrupar, error)) return false;
+            if (q.agrupar == CAMPO_CONTEO || q.agrupar == CAMPO_TIEMPO)
+                return falla(error, "no se puede agrupar por ese campo");
+        }
+        if (palabra("order")) {
+            if (!palabra("by")) return falla(error, "se esperaba 'by' después de 'order'");
+            if (!campo(q.ordenar, error)) return false;
+            if (palabra("desc")) q.descendente = true;
+            else palabra("asc");
+        }
+        if (palabra("limit")) {
+            uint32_t n;
+            if (!numero(n)) return falla(error, "se esperaba un número después de 'limit'");
+            q.limite = n;
+        }
+        if (pos < tokens.size()) return falla(error, "token inesperado: " + tokens[pos].texto);
+        if (q.ordenar == CAMPO_CONTEO && q.agrupar == CAMPO_NINGUNO)
+            return falla(error, "'order by count' requiere 'group by'");
+        return true;
+    }
+
+private:
+    const vector<Token>& tokens;
+    const TablaRegistros* tabla;
+    size_t pos;
+
+    bool falla(string& error, const string& msg) {
+        error = msg;
+        return false;
+    }
+
+    // Consume la palabra clave si es la siguiente
+    bool palabra(const char* clave) {
+        if (pos < tokens.size() && tokens[pos].tipo == Token::PALABRA &&
+            minusculas(tokens[pos].texto) == clave) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool operador(string& op) {
+        if (pos < tokens.size() && tokens[pos].tipo == Token::OPERADOR) {
+            op = tokens[pos++].texto;
+            return true;
+        }
+        return false;
+    }
+
+    bool valor(string& v) {
+        if (pos < tokens.size() && tokens[pos].tipo != Token::OPERADOR) {
+            v = tokens[pos++].texto;
+            return true;
+        }
+        return false;
+    }
+
+    bool numero(uint32_t& n) {
+        string v;
+        if (!valor(v)) return false;
+        const char* p = v.data();
+        return leerNumero(p, p + v.size(), n) && p == v.data() + v.size();
+    }
+
+    bool campo(Campo& c, string& error) {
+        string nombre;
+        if (!valor(nombre)) return falla(error, "se esperaba un campo");
+        c = campoDeNombre(nombre);
+        if (c == CAMPO_NINGUNO) return falla(error, "campo desconocido: " + nombre);
+        return true;
+    }
+
+    void agregarRango(Consulta& q, Campo c, uint32_t lo, uint32_t hi) {
+        if (lo > hi) swap(lo, hi);
+        Predicado p;
+        p.tipo = Predicado::RANGO;
+        p.campo = c;
+        p.lo = lo;
+        p.hi = hi;
+        p.mascara = 0;
+        q.filtros.push_back(p);
+    }
+
+    // port: la columna es de 16 bits, así que un rango que empieza después
+    // de 65535 no tiene renglones y solo se recorta el fin
+    void agregarPuertos(Consulta& q, uint32_t lo, uint32_t hi) {
+        if (lo > hi) swap(lo, hi);
+        if (lo > 65535) {
+            q.vacia = true;
+            return;
+        }
+        agregarRango(q, CAMPO_PUERTO, lo, min<uint32_t>(hi, 65535));
+    }
+
+    // reason has "...": razones del diccionario que contienen todas las palabras
+    bool agregarPalabras(Consulta& q, const string& texto, string& error) {
+        Predicado p;
+        p.tipo = Predicado::CONJUNTO;
+        p.campo = CAMPO_RAZON;
+        p.lo = p.hi = p.mascara = 0;
+        tokenizarRazon(texto, p.palabras);
+        if (p.palabras.empty()) return falla(error, "reason has requiere al menos una palabra");
+        if (!tabla) {
+            q.filtros.push_back(p);
+            return true;
+        }
+        bool alguna = false;
+        vector<string> deRazon;
+        for (int r = 0; r < tabla->razones.size(); r++) {
+            deRazon.clear();
+            tokenizarRazon(tabla->razones.texto(r), deRazon);
+            bool todas = true;
+            for (const string& w : p.palabras)
+                todas = todas && find(deRazon.begin(), deRazon.end(), w) != deRazon.end();
+            if (todas) {
+                p.conjunto[r >> 6] |= 1ull << (r & 63);
+                alguna = true;
+            }
+        }
+        if (!alguna) q.vacia = true;
+        else q.filtros.push_back(p);
+        return true;
+    }
+
+    // Convierte un operador de comparación a un rango [lo, hi] sobre v
+    bool rangoDeOperador(const string& op, uint32_t v, uint32_t& lo, uint32_t& hi) {
+        lo = 0;
+        hi = UINT32_MAX;
+        if (op == "=") lo = hi = v;
+        else if (op == ">=") lo = v;
+        else if (op == "<=") hi = v;
+        else if (op == ">") { if (v == UINT32_MAX) return false; lo = v + 1; }
+        else if (op == "<") { if (v == 0) return false; hi = v - 1; }
+        return true;
+    }
+
+    bool condicion(Consulta& q, string& error) {
+        Campo c;
+        if (!campo(c, error)) return false;
+        string op, a, b;
+        switch (c) {
+        case CAMPO_TIEMPO: {
+            uint32_t lo, hi;
+            if (palabra("between")) {
+                if (!valor(a) || !palabra("and") || !valor(b))
+                    return falla(error, "uso: time between \"Mon DD\" and \"Mon DD\"");
+                if (!parsearFecha(a, false, lo) || !parsearFecha(b, true, hi))
+                    return falla(error, "fecha inválida");
+                agregarRango(q, c, lo, hi);
+                return true;
+            }
+            if (!operador(op) || !valor(a)) return falla(error, "uso: time >= \"Mon DD HH:MM:SS\"");
+            uint32_t t;
+            bool finDeDia = (op == "<=" || op == ">");
+            if (!parsearFecha(a, finDeDia, t)) return falla(error, "fecha inválida: " + a);
+            if (op == "=") {
+                // "time = Mon DD" es todo el día
+                if (!parsearFecha(a, false, lo) || !parsearFecha(a, true, hi))
+                    return falla(error, "fecha inválida: " + a);
+            } else if (!rangoDeOperador(op, t, lo, hi)) {
+                q.vacia = true;
+                return true;
+            }
+            agregarRango(q, c, lo, hi);
+            return true;
+        }
+        case CAMPO_MES: {
+            if (!operador(op) || op != "=" || !valor(a) || a.size() != 3 || mesANumero(a.data()) < 0)
+                return falla(error, "uso: month = Mon");
+            int m = mesANumero(a.data());
+            agregarRango(q, CAMPO_TIEMPO, claveTiempo(m, 1, 0, 0, 0), claveTiempo(m, 31, 23, 59, 59));
+            return true;
+        }
+        case CAMPO_IP: {
+            uint32_t ip1, ip2;
+            if (palabra("in")) {
+                if (!valor(a)) return falla(error, "uso: ip in a.b.c.d/n");
+                size_t barra = a.find('/');
+                uint32_t bits = 32;
+                if (barra != string::npos) {
+                    const char* p = a.data() + barra + 1;
+                    if (!leerNumero(p, a.data() + a.size(), bits) || bits > 32)
+                        return falla(error, "prefijo CIDR inválido: " + a);
+                }
+                if (!parsearIpTexto(a.substr(0, barra), ip1)) return falla(error, "IP inválida: " + a);
+                uint32_t mascara = bits == 0 ? 0 : UINT32_MAX << (32 - bits);
+                Predicado p;
+                p.tipo = Predicado::MASCARA;
+                p.campo = c;
+                p.lo = ip1 & mascara;
+                p.hi = 0;
+                p.mascara = mascara;
+                q.filtros.push_back(p);
+                return true;
+            }
+            if (palabra("between")) {
+                if (!valor(a) || !palabra("and") || !valor(b) ||
+                    !parsearIpTexto(a, ip1) || !parsearIpTexto(b, ip2))
+                    return falla(error, "uso: ip between a.b.c.d and a.b.c.d");
+                agregarRango(q, c, ip1, ip2);
+                return true;
+            }
+            if (!operador(op) || op != "=" || !valor(a) || !parsearIpTexto(a, ip1))
+                return falla(error, "uso: ip = a.b.c.d");
+            agregarRango(q, c, ip1, ip1);
+            return true;
+        }
+        case CAMPO_PUERTO: {
+            uint32_t p1, p2;
+            if (palabra("between")) {
+                if (!numero(p1) || !palabra("and") || !numero(p2))
+                    return falla(error, "uso: port between n and m");
+                agregarPuertos(q, p1, p2);
+                return true;
+            }
+            if (!operador(op) || !numero(p1)) return falla(error, "uso: port = n");
+            uint32_t lo, hi;
+            if (!rangoDeOperador(op, p1, lo, hi)) {
+                q.vacia = true;
+                return true;
+            }
+            agregarPuertos(q, lo, hi);
+            return true;
+        }
+        case CAMPO_RAZON: {
+            if (palabra("has")) {
+                if (!valor(a)) return falla(error, "uso: reason has \"palabra [palabra ...]\"");
+                return agregarPalabras(q, a, error);
+            }
+            if (!operador(op) || op != "=" || !valor(a)) return falla(error, "uso: reason = \"texto\"");
+            if (!tabla) {
+                agregarRango(q, c, 0, 0);
+                q.filtros.back().texto = a;
+                return true;
+            }
+            int id = tabla->razones.buscar(a);
+            if (id < 0) q.vacia = true;
+            else agregarRango(q, c, (uint32_t)id, (uint32_t)id);
+            return true;
+        }
+        default:
+            return falla(error, "no se puede filtrar por ese campo");
+        }
+    }
+};
+
+// ---------------- 3. OPERADORES VECTORIZADOS ----------------
+
+/*
+ * Tamaño de lote: los filtros trabajan sobre bloques de TAM_LOTE renglones.
+ * Cada predicado produce un mapa de bits del lote con los kernels SIMD de
+ * filtros_simd.h; los mapas se combinan con AND y al final se convierten en
+ * un vector de selección con las posiciones (relativas al lote) que cumplen.
+ * Un lote de 1024 valores de 32 bits ocupa 4 KB y cabe en caché L1.
+ */
+const int TAM_LOTE = 1024;
+const int PALABRAS_LOTE = TAM_LOTE / 64;
+
+/*
+ * 3.1 evaluarPredicado
+ * Escribe en bits el mapa del predicado sobre el lote [base, base+n).
+ * Complejidad: O(n), 8-32 valores por instrucción con AVX2.
+ */
+void evaluarPredicado(const TablaRegistros& t, const Predicado& p, size_t base, int n, uint64_t* bits) {
+    if (p.tipo == Predicado::MASCARA) {
+        filtroMascara(t.ip.data() + base, (size_t)n, p.mascara, p.lo, bits);
+        return;
+    }
+    if (p.tipo == Predicado::CONJUNTO) {
+        filtroConjunto(t.razon.data() + base, (size_t)n, p.conjunto, bits);
+        return;
+    }
+    switch (p.campo) {
+    case CAMPO_TIEMPO: filtroRango(t.tiempo.data() + base, (size_t)n, p.lo, p.hi, bits); break;
+    case CAMPO_IP:     filtroRango(t.ip.data() + base, (size_t)n, p.lo, p.hi, bits); break;
+    case CAMPO_PUERTO: filtroRango(t.puerto.data() + base, (size_t)n, p.lo, p.hi, bits); break;
+    case CAMPO_RAZON:  filtroRango(t.razon.data() + base, (size_t)n, p.lo, p.hi, bits); break;
+    default: break;
+    }
+}
+
+/*
+ * 3.2 cumpleValor / cumplePredicado
+ * Evaluación escalar de un predicado sobre un solo renglón. Se usa cuando el
+ * índice dejó tan pocos candidatos en el lote que no vale la pena recorrer
+ * las columnas completas con los kernels, y en las consultas en flujo.
+ */
+bool cumpleValor(const Predicado& p, uint32_t v) {
+    if (p.tipo == Predicado::MASCARA) return (v & p.mascara) == p.lo;
+    if (p.tipo == Predicado::CONJUNTO) return (p.conjunto[v >> 6] >> (v & 63)) & 1;
+    return v - p.lo <= p.hi - p.lo;
+}
+
+bool cumplePredicado(const TablaRegistros& t, const Predicado& p, size_t i) {
+    switch (p.campo) {
+    case CAMPO_TIEMPO: return cumpleValor(p, t.tiempo[i]);
+    case CAMPO_IP:     return cumpleValor(p, t.ip[i]);
+    case CAMPO_PUERTO: return cumpleValor(p, t.puerto[i]);
+    case CAMPO_RAZON:  return cumpleValor(p, t.razon[i]);
+    default: return true;
+    }
+}
+
+/*
+ * 3.3 filtrarLote
+ * Evalúa los filtros sobre el lote [base, base+n) y deja en sel las
+ * posiciones seleccionadas. Devuelve el tamaño de la selección.
+ *  - Sin candidatos: se evalúa cada filtro con los kernels SIMD y se combinan
+ *    los mapas con AND; si el lote queda vacío ya no se evalúan los demás.
+ *  - Con candidatos (mapa del lote obtenido de los índices): si son pocos se
+ *    revisan solo esos renglones; si son muchos se parte del mapa de
+ *    candidatos en lugar de un lote lleno.
+ */
+int filtrarLote(const TablaRegistros& t, const vector<Predicado>& filtros,
+                size_t base, int n, uint16_t* sel, const uint64_t* candidatos = nullptr) {
+    size_t palabras = palabrasPara((size_t)n);
+    if (filtros.empty()) {
+        if (candidatos) return (int)bitsASeleccion(candidatos, palabras, sel);
+        for (int j = 0; j < n; j++) sel[j] = (uint16_t)j;
+        return n;
+    }
+    uint64_t acumulado[PALABRAS_LOTE], bits[PALABRAS_LOTE];
+    size_t f = 0;
+    if (candidatos) {
+        if (bitsContar(candidatos, palabras) < (size_t)TAM_LOTE / 16) {
+            int k = (int)bitsASeleccion(candidatos, palabras, sel), m = 0;
+            for (int j = 0; j < k; j++) {
+                bool ok = true;
+                for (const Predicado& p : filtros) ok = ok && cumplePredicado(t, p, base + sel[j]);
+                sel[m] = sel[j];
+                m += ok;
+            }
+            return m;
+        }
+        copy(candidatos, candidatos + palabras, acumulado);
+    } else {
+        evaluarPredicado(t, filtros[0], base, n, acumulado);
+        f = 1;
+    }
+    for (; f < filtros.size(); f++) {
+        if (bitsVacio(acumulado, palabras)) return 0;
+        evaluarPredicado(t, filtros[f], base, n, bits);
+        bitsAnd(acumulado, bits, palabras);
+    }
+    return (int)bitsASeleccion(acumulado, palabras, sel);
+}
+
+/*
+ * 3.4 claveDeTiempo / claveDe
+ * claveDeTiempo: valor de un campo derivado del tiempo t (también lo usan
+ * los rollups con el inicio de cada cubeta). El día es el día del año, o
+ * con --cambio-anio el día contado desde el año base, para no juntar el
+ * mismo día de dos años.
+ * claveDe: valor del campo para el renglón i (usado para agrupar y ordenar).
+ */
+uint32_t claveDeTiempo(Campo c, uint32_t t) {
+    switch (c) {
+    case CAMPO_TIEMPO:     return t;
+    case CAMPO_MES:        return (uint32_t)mesDe(t);
+    case CAMPO_DIA:        return Calendario::global().cambioAnio ? t / SEGUNDOS_DIA : diaDelAnio(t);
+    case CAMPO_HORA:       return (uint32_t)horaDe(t);
+    case CAMPO_MINUTO:     return t / 60;
+    case CAMPO_HORA_FECHA: return t / 3600;
+    default:               return 0;
+    }
+}
+
+uint32_t claveDe(const TablaRegistros& t, Campo c, size_t i) {
+    switch (c) {
+    case CAMPO_IP:     return t.ip[i];
+    case CAMPO_RED:    return t.ip[i] >> 16;
+    case CAMPO_PUERTO: return t.puerto[i];
+    case CAMPO_RAZON:  return t.razon[i];
+    default:           return claveDeTiempo(c, t.tiempo[i]);
+    }
+}
+
+/*
+ * 3.5 claveDeRegistro
+ * Lo mismo que claveDe para un registro suelto (consultas en flujo).
+ */
+uint32_t claveDeRegistro(const Registro& r, Campo c) {
+    switch (c) {
+    case CAMPO_IP:     return r.ip;
+    case CAMPO_RED:    return r.ip >> 16;
+    case CAMPO_PUERTO: return r.puerto;
+    case CAMPO_RAZON:  return r.razon;
+    default:           return claveDeTiempo(c, r.tiempo);
+    }
+}
+
+/*
+ * 3.6 tamDominio
+ * Número de valores distintos posibles de la clave; si es pequeño el
+ * agregado usa un arreglo denso en vez de una tabla hash.
+ * Devuelve 0 para la IP completa (dominio de 2^32).
+ */
+size_t tamDominio(Campo c) {
+    switch (c) {
+    case CAMPO_RED:
+    case CAMPO_PUERTO: return 65536;
+    case CAMPO_RAZON:  return DiccionarioRazones::MAX_RAZONES;
+    case CAMPO_MES:    return 13;
+    case CAMPO_DIA:    return Calendario::global().cambioAnio ? 0 : DIAS_ANIO;
+    case CAMPO_HORA:   return 24;
+    default:           return 0;
+    }
+}
+
+/*
+ * 3.7 textoFecha / textoClave
+ * textoFecha: "Mon DD" del tiempo t, con el año si se infieren (--cambio-anio).
+ * textoClave: representación de una clave de agrupación para imprimirla;
+ * las razones se buscan en el diccionario de la tabla (o el local, en flujo).
+ */
+int textoFecha(uint32_t t, char* buf, size_t cap) {
+    if (Calendario::global().cambioAnio)
+        return snprintf(buf, cap, "%s %02d %u", MESES[mesDe(t) - 1], diaDe(t), Calendario::global().anioBase + anioDe(t));
+    return snprintf(buf, cap, "%s %02d", MESES[mesDe(t) - 1], diaDe(t));
+}
+
+string textoClave(const DiccionarioRazones& razones, Campo c, uint32_t k) {
+    char buf[48];
+    switch (c) {
+    case CAMPO_IP:
+        return ipATexto(k);
+    case CAMPO_RED:
+        snprintf(buf, sizeof buf, "%u.%u", k >> 8, k & 255);
+        return buf;
+    case CAMPO_RAZON:
+        return razones.texto((int)k);
+    case CAMPO_MES:
+        return MESES[k - 1];
+    case CAMPO_DIA:
+        textoFecha(k * SEGUNDOS_DIA, buf, sizeof buf);
+        return buf;
+    case CAMPO_HORA:
+        snprintf(buf, sizeof buf, "%02u", k);
+        return buf;
+    case CAMPO_MINUTO: {
+        int n = textoFecha(k * 60, buf, sizeof buf);
+        snprintf(buf + n, sizeof buf - (size_t)n, " %02d:%02d", horaDe(k * 60), minutoDe(k * 60));
+        return buf;
+    }
+    case CAMPO_HORA_FECHA: {
+        int n = textoFecha(k * 3600, buf, sizeof buf);
+        snprintf(buf + n, sizeof buf - (size_t)n, " %02d", horaDe(k * 3600));
+        return buf;
+    }
+    default:
+        return to_string(k);
+    }
+}
+
+// ---------------- 4. EJECUCIÓN ----------------
+
+/*
+ * 4.1 BaseDatos
+ * Tabla cargada más los índices construidos durante la ingesta.
+ */
+struct BaseDatos {
+    TablaRegistros tabla;
+    IndicesSecundarios indices;
+    IndiceInvertido invertido;
+    FiltroFusionBinaria filtroIp;
+    Rollups rollups;
+    bool conIndices = false;
+};
+
+/*
+ * 4.2 Plan
+ * Forma de recorrer la tabla para una consulta:
+ *  - candidatos: intersección de los índices que aplican (si conIndice)
+ *  - residuales: filtros que aún hay que evaluar sobre las columnas
+ */
+struct Plan {
+    bool conIndice = false;
+    BitmapRoaring candidatos;
+    vector<Predicado> residuales;
+};
+
+/*
+ * 4.3 planificar
+ * Decide qué filtros se contestan con los índices:
+ *  - reason: exacto (OR de los ids de razón del rango)
+ *  - reason has: exacto (listas del índice invertido)
+ *  - time:   meses que toca el rango (mesAbsoluto, de cualquier año);
+ *            exacto si cubre meses completos
+ *  - port:   cubetas que toca el rango; exacto si está alineado a cubetas
+ *  - ip:     sin índice, siempre residual (ip = x se descarta antes con el
+ *            filtro de pertenencia si x nunca aparece)
+ * Los filtros no exactos quedan como residuales sobre los candidatos.
+ */
+Plan planificar(const BaseDatos& db, const Consulta& q) {
+    Plan plan;
+    const IndicesSecundarios& ix = db.indices;
+    for (const Predicado& p : q.filtros) {
+        BitmapRoaring mapa;
+        bool usado = false, exacto = false;
+        if (db.conIndices && p.campo == CAMPO_IP && p.tipo == Predicado::RANGO && p.lo == p.hi &&
+            !db.filtroIp.contiene(p.lo)) {
+            usado = exacto = true;  // la IP no está: candidatos vacíos
+        } else if (db.conIndices && p.tipo == Predicado::CONJUNTO) {
+            vector<uint32_t> ids;
+            db.invertido.buscar(p.palabras, db.tabla, ids);
+            for (uint32_t id : ids) mapa.agregar(id);
+            usado = exacto = true;
+        } else if (db.conIndices && p.tipo == Predicado::RANGO) {
+            if (p.campo == CAMPO_RAZON) {
+                mapa = IndicesSecundarios::unirRango(ix.porRazon, p.lo, p.hi);
+                usado = exacto = true;
+            } else if (p.campo == CAMPO_TIEMPO) {
+                size_t m1 = mesAbsoluto(p.lo), m2 = min<size_t>(mesAbsoluto(p.hi), ix.porMes.size() - 1);
+                if (m1 <= m2) {
+                    mapa = IndicesSecundarios::unirRango(ix.porMes, m1, m2);
+                    usado = true;
+                    exacto = p.lo <= (m1 - 1) * SEGUNDOS_MES && p.hi >= m2 * SEGUNDOS_MES - 1;
+                }
+            } else if (p.campo == CAMPO_PUERTO) {
+                uint32_t c1 = p.lo / TAM_CUBETA_PUERTO, c2 = min(p.hi, 65535u) / TAM_CUBETA_PUERTO;
+                mapa = IndicesSecundarios::unirRango(ix.porPuerto, c1, c2);
+                usado = true;
+                exacto = p.lo % TAM_CUBETA_PUERTO == 0 &&
+                         (p.hi >= 65535 || (p.hi + 1) % TAM_CUBETA_PUERTO == 0);
+            }
+        }
+        if (usado) {
+            if (plan.conIndice) plan.candidatos &= mapa;
+            else plan.candidatos = move(mapa);
+            plan.conIndice = true;
+        }
+        if (!exacto) plan.residuales.push_back(p);
+    }
+    return plan;
+}
+
+/*
+ * 4.4 recorrerLotes
+ * Llama alLote(base, sel, k) por cada lote con renglones seleccionados, en
+ * orden de id. Con índice solo se visitan los lotes que tienen candidatos:
+ * cada contenedor roaring cubre 64 lotes y se expande a palabras una vez.
+ * alLote devuelve false para detener el recorrido (p.ej. al llegar al límite).
+ */
+template <typename F>
+void recorrerLotes(const TablaRegistros& t, const Plan& plan, F alLote) {
+    uint16_t sel[TAM_LOTE];
+    size_t total = t.size();
+    if (!plan.conIndice) {
+        for (size_t base = 0; base < total; base += TAM_LOTE) {
+            int n = (int)min<size_t>(TAM_LOTE, total - base);
+            int k = filtrarLote(t, plan.residuales, base, n, sel);
+            if (k > 0 && !alLote(base, sel, k)) return;
+        }
+        return;
+    }
+    vector<uint64_t> palabras(BitmapRoaring::PALABRAS);
+    for (const BitmapRoaring::Contenedor& c : plan.candidatos.contenedores()) {
+        c.aPalabras(palabras.data());
+        size_t inicioBloque = (size_t)c.clave << 16;
+        for (size_t b = 0; b < 65536 / TAM_LOTE; b++) {
+            size_t base = inicioBloque + b * TAM_LOTE;
+            if (base >= total) break;
+            const uint64_t* cand = palabras.data() + b * PALABRAS_LOTE;
+            if (bitsVacio(cand, PALABRAS_LOTE)) continue;
+            int n = (int)min<size_t>(TAM_LOTE, total - base);
+            int k = filtrarLote(t, plan.residuales, base, n, sel, cand);
+            if (k > 0 && !alLote(base, sel, k)) return;
+        }
+    }
+}
+
+/*
+ * 4.5 Grupo
+ * Clave de agrupación y número de registros que la comparten.
+ */
+struct Grupo {
+    uint32_t clave;
+    uint64_t conteo;
+};
+
+/*
+ * OrdenGrupos
+ * Orden de salida de los grupos: por clave ascendente (descendente con
+ * desc), o por conteo si se pidió order by count; empates de conteo por
+ * clave.
+ */
+struct OrdenGrupos {
+    bool porConteo, desc;
+
+    explicit OrdenGrupos(const Consulta& q) : porConteo(q.ordenar == CAMPO_CONTEO), desc(q.descendente) {}
+
+    bool operator()(const Grupo& a, const Grupo& b) const {
+        if (porConteo && a.conteo != b.conteo) return desc ? a.conteo > b.conteo : a.conteo < b.conteo;
+        return (desc && !porConteo) ? a.clave > b.clave : a.clave < b.clave;
+    }
+};
+
+/*
+ * 4.6 ordenarYRecortar
+ * Ordena v con el comparador dado y deja solo los primeros limite elementos.
+ * Con límite se usa partial_sort: O(n log k) en vez de O(n log n).
+ */
+template <typename T, typename Comp>
+void ordenarYRecortar(vector<T>& v, long long limite, Comp menor) {
+    if (limite >= 0 && (size_t)limite < v.size()) {
+        partial_sort(v.begin(), v.begin() + limite, v.end(), menor);
+        v.resize((size_t)limite);
+    } else {
+        sort(v.begin(), v.end(), menor);
+    }
+}
+
+/*
+ * 4.7 imprimirGrupos / ejecutarAgrupado
+ * imprimirGrupos: junta los grupos con conteo del arreglo denso (o de la
+ * tabla hash), los ordena, recorta al límite y los imprime.
+ * ejecutarAgrupado: group by; cuenta registros por clave. Por cada lote se
+ * calculan primero las claves de la selección y luego se acumulan, sin
+ * mezclar ambos ciclos.
+ * Complejidad: O(n) + O(g log g) para ordenar g grupos.
+ */
+void imprimirGrupos(const TablaRegistros& t, const Consulta& q, const vector<uint64_t>& denso,
+                    const unordered_map<uint32_t, uint64_t>& disperso, ostream& out) {
+    vector<Grupo> grupos;
+    if (!denso.empty()) {
+        for (size_t c = 0; c < denso.size(); c++)
+            if (denso[c] > 0) grupos.push_back({(uint32_t)c, denso[c]});
+    } else {
+        grupos.reserve(disperso.size());
+        for (auto& par : disperso) grupos.push_back({par.first, par.second});
+    }
+
+    ordenarYRecortar(grupos, q.limite, OrdenGrupos(q));
+
+    for (const Grupo& g : grupos) out << textoClave(t.razones, q.agrupar, g.clave) << " " << g.conteo << "\n";
+}
+
+void ejecutarAgrupado(const TablaRegistros& t, const Consulta& q, const Plan& plan, ostream& out) {
+    size_t dominio = tamDominio(q.agrupar);
+    vector<uint64_t> denso(dominio, 0);
+    unordered_map<uint32_t, uint64_t> disperso;
+    uint32_t claves[TAM_LOTE];
+
+    recorrerLotes(t, plan, [&](size_t base, const uint16_t* sel, int k) {
+        for (int j = 0; j < k; j++) claves[j] = claveDe(t, q.agrupar, base + sel[j]);
+        if (dominio > 0) {
+            for (int j = 0; j < k; j++) denso[claves[j]]++;
+        } else {
+            for (int j = 0; j < k; j++) disperso[claves[j]]++;
+        }
+        return true;
+    });
+
+    imprimirGrupos(t, q, denso, disperso, out);
+}
+
+/*
+ * 4.8 rangoRazones
+ * Posición de cada id de razón en orden alfabético de su texto, para
+ * desempatar por razón sin comparar strings en cada comparación.
+ */
+vector<int> rangoRazones(const TablaRegistros& t) {
+    vector<int> ids(t.razones.size());
+    for (int i = 0; i < (int)ids.size(); i++) ids[i] = i;
+    sort(ids.begin(), ids.end(), [&](int a, int b) { return t.razones.texto(a) < t.razones.texto(b); });
+    vector<int> rango(ids.size());
+    for (int i = 0; i < (int)ids.size(); i++) rango[ids[i]] = i;
+    return rango;
+}
+
+/*
+ * 4.9 ejecutarRenglones
+ * Sin agrupación: junta los ids que cumplen los filtros, ordena si se pidió
+ * y escribe las líneas. Sin orden y con límite se detiene en cuanto junta
+ * suficientes renglones.
+ * Complejidad: O(n) + O(s log s) si hay orden (s = seleccionados).
+ */
+void ejecutarRenglones(const TablaRegistros& t, const Consulta& q, const Plan& plan, ostream& out) {
+    vector<uint32_t> ids;
+    bool cortarTemprano = (q.ordenar == CAMPO_NINGUNO && q.limite >= 0 && !q.soloConteo);
+    uint64_t total = 0;
+
+    if (q.soloConteo && plan.conIndice && plan.residuales.empty()) {
+        // Los índices contestan la consulta completa
+        out << plan.candidatos.cardinalidad() << "\n";
+        return;
+    }
+    recorrerLotes(t, plan, [&](size_t base, const uint16_t* sel, int k) {
+        total += (uint64_t)k;
+        if (q.soloConteo) return true;
+        for (int j = 0; j < k; j++) ids.push_back((uint32_t)(base + sel[j]));
+        return !(cortarTemprano && ids.size() >= (size_t)q.limite);
+    });
+
+    if (q.soloConteo) {
+        out << total << "\n";
+        return;
+    }
+
+    if (q.ordenar != CAMPO_NINGUNO) {
+        // Se ordena por la clave; los empates siguen el orden de lessEntry de
+        // Act1.3 (tiempo, IP, puerto, texto de la razón) y al final la posición
+        vector<pair<uint32_t, uint32_t>> orden(ids.size());
+        for (size_t j = 0; j < ids.size(); j++) orden[j] = {claveDe(t, q.ordenar, ids[j]), ids[j]};
+        vector<int> rango = rangoRazones(t);
+        bool desc = q.descendente;
+        ordenarYRecortar(orden, q.limite, [&](const pair<uint32_t, uint32_t>& a,
+                                              const pair<uint32_t, uint32_t>& b) {
+            if (a.first != b.first) return desc ? a.first > b.first : a.first < b.first;
+            uint32_t x = a.second, y = b.second;
+            if (t.tiempo[x] != t.tiempo[y]) return t.tiempo[x] < t.tiempo[y];
+            if (t.ip[x] != t.ip[y]) return t.ip[x] < t.ip[y];
+            if (t.puerto[x] != t.puerto[y]) return t.puerto[x] < t.puerto[y];
+            if (t.razon[x] != t.razon[y]) return rango[t.razon[x]] < rango[t.razon[y]];
+            return x < y;
+        });
+        for (size_t j = 0; j < orden.size(); j++) ids[j] = orden[j].second;
+        ids.resize(orden.size());
+    } else if (q.limite >= 0 && ids.size() > (size_t)q.limite) {
+        ids.resize((size_t)q.limite);
+    }
+
+    FormateadorLineas formateador(t.razones);
+    SalidaLineas sal(out);
+    for (uint32_t id : ids) formateador.linea(t, id, sal);
+}
+
+/*
+ * 4.10 contestarConRollups
+ * Contesta con los rollups (rollups.h) un conteo o un group by cuyos
+ * filtros son solo:
+ *  - time en minutos completos (las fechas sin segundos siempre lo son)
+ *  - reason = / reason has (un conjunto de razones), o bien
+ *  - ip in a.b.0.0/16 (una red), pero no las dos cosas a la vez
+ * y que agrupa por tiempo (minute, dayhour, day, hour, month), por razón
+ * (sin filtro de red) o por red (sin filtro de razón). El rango se parte
+ * en cubetas de día, hora y minuto (solo tan gruesas como la agrupación
+ * lo permita) y se suman sus conteos. Devuelve false si la consulta no
+ * tiene esa forma y hay que recorrer la tabla; la salida es la misma.
+ * Complejidad: O(pares (cubeta, razón) o (cubeta, red) visitados), sin
+ * depender del número de registros.
+ */
+bool contestarConRollups(const BaseDatos& db, const Consulta& q, ostream& out) {
+    const Rollups& ru = db.rollups;
+    if (!db.conIndices || (!q.soloConteo && q.agrupar == CAMPO_NINGUNO)) return false;
+    uint64_t lo = 0, hi = UINT32_MAX;
+    uint64_t razones[4] = {~0ull, ~0ull, ~0ull, ~0ull};
+    bool filtroRazon = false, vacia = false;
+    int red = -1;
+    for (const Predicado& p : q.filtros) {
+        if (p.campo == CAMPO_TIEMPO && p.tipo == Predicado::RANGO) {
+            lo = max<uint64_t>(lo, p.lo);
+            hi = min<uint64_t>(hi, p.hi);
+        } else if (p.campo == CAMPO_RAZON && p.tipo == Predicado::RANGO) {
+            uint64_t rango[4] = {0, 0, 0, 0};
+            for (uint32_t r = p.lo; r <= min<uint32_t>(p.hi, DiccionarioRazones::MAX_RAZONES - 1); r++)
+                rango[r >> 6] |= 1ull << (r & 63);
+            for (int w = 0; w < 4; w++) razones[w] &= rango[w];
+            filtroRazon = true;
+        } else if (p.campo == CAMPO_RAZON && p.tipo == Predicado::CONJUNTO) {
+            for (int w = 0; w < 4; w++) razones[w] &= p.conjunto[w];
+            filtroRazon = true;
+        } else if (p.campo == CAMPO_IP && p.tipo == Predicado::MASCARA && p.mascara == 0xFFFF0000u) {
+            if (red >= 0 && (uint32_t)red != p.lo >> 16) vacia = true;
+            red = (int)(p.lo >> 16);
+        } else {
+            return false;
+        }
+    }
+    if (lo % 60 != 0 || (hi != UINT32_MAX && (hi + 1) % 60 != 0)) return false;
+    if (filtroRazon && red >= 0) return false;
+    Rollups::Nivel maximo = Rollups::DIA;
+    switch (q.agrupar) {
+    case CAMPO_NINGUNO: case CAMPO_DIA: case CAMPO_MES: break;
+    case CAMPO_RAZON: if (red >= 0) return false; break;
+    case CAMPO_RED:   if (filtroRazon) return false; break;
+    case CAMPO_HORA: case CAMPO_HORA_FECHA: maximo = Rollups::HORA; break;
+    case CAMPO_MINUTO: maximo = Rollups::MINUTO; break;
+    default: return false;
+    }
+
+    size_t dominio = tamDominio(q.agrupar);
+    vector<uint64_t> denso(dominio, 0);
+    unordered_map<uint32_t, uint64_t> disperso;
+    uint64_t total = 0;
+    auto sumar = [&](uint32_t k, uint64_t n) {
+        if (n == 0) return;
+        total += n;
+        if (q.agrupar == CAMPO_NINGUNO) return;
+        if (dominio > 0) denso[k] += n;
+        else disperso[k] += n;
+    };
+    if (!vacia && lo <= hi) {
+        ru.recorrer((uint32_t)lo, (uint32_t)hi, maximo, [&](const NivelRollup& nv, size_t c, uint32_t inicio) {
+            if (q.agrupar == CAMPO_RED) {
+                for (uint32_t j = nv.inicioRed[c]; j < nv.inicioRed[c + 1]; j++)
+                    if (red < 0 || nv.red[j] == red) sumar(nv.red[j], nv.conteoRed[j]);
+                return;
+            }
+            uint32_t k = claveDeTiempo(q.agrupar, inicio);
+            if (red >= 0) {
+                sumar(k, nv.conteoDeRed(c, (uint16_t)red));
+                return;
+            }
+            uint64_t n = 0;
+            for (uint32_t j = nv.inicioRazon[c]; j < nv.inicioRazon[c + 1]; j++) {
+                uint32_t r = nv.razon[j];
+                if (!(razones[r >> 6] >> (r & 63) & 1)) continue;
+                if (q.agrupar == CAMPO_RAZON) sumar(r, nv.conteoRazon[j]);
+                else n += nv.conteoRazon[j];
+            }
+            if (q.agrupar != CAMPO_RAZON) sumar(k, n);
+        });
+    }
+    Estadisticas::global().contar("consultas_rollup");
+    if (q.agrupar == CAMPO_NINGUNO) out << total << "\n";
+    else imprimirGrupos(db.tabla, q, denso, disperso, out);
+    return true;
+}
+
+/*
+ * 4.11 ejecutarConsulta
+ * Analiza y ejecuta una consulta. Devuelve false si la consulta no es válida.
+ */
+bool ejecutarConsulta(const BaseDatos& db, const string& texto, ostream& out) {
+    const TablaRegistros& t = db.tabla;
+    vector<Token> tokens;
+    string error;
+    Consulta q;
+    if (!separarTokens(texto, tokens, error) || !Analizador(tokens, &t).analizar(q, error)) {
+        cerr << "Error en la consulta: " << error << "\n";
+        return false;
+    }
+    if (q.vacia) {
+        if (q.soloConteo) out << 0 << "\n";
+        return true;
+    }
+    if (contestarConRollups(db, q, out)) return true;
+    Plan plan = planificar(db, q);
+    if (q.agrupar != CAMPO_NINGUNO) ejecutarAgrupado(t, q, plan, out);
+    else ejecutarRenglones(t, q, plan, out);
+    return true;
+}
+
+/*
+ * 4.12 cumpleRazon
+ * Filtros de razón de una consulta en flujo, comparados contra el texto.
+ */
+bool cumpleRazon(const Consulta& q, string_view razon) {
+    vector<string> palabras;
+    for (const Predicado& p : q.filtros) {
+        if (p.campo != CAMPO_RAZON) continue;
+        if (p.tipo == Predicado::RANGO) {
+            if (razon != p.texto) return false;
+            continue;
+        }
+        if (palabras.empty()) tokenizarRazon(razon, palabras);
+        for (const string& w : p.palabras)
+            if (find(palabras.begin(), palabras.end(), w) == palabras.end()) return false;
+    }
+    return true;
+}
+
+/*
+ * 4.13 agruparEnFlujo
+ * group by sobre los registros que cumplen los filtros, sin tabla. Con
+ * dominio pequeño se cuenta en un arreglo denso; por IP, en una tabla que
+ * se derrama a disco por particiones si pasa del presupuesto. Los grupos
+ * se ordenan con un orden externo (también derrama) y se imprimen hasta
+ * el límite, igual que ejecutarAgrupado.
+ * Complejidad: O(n) + O(g log g) para ordenar g grupos.
+ */
+bool agruparEnFlujo(const Consulta& q, Generador<RegistroCrudo>& seleccion, DiccionarioRazones& vistas,
+                    const bool& leido, ostream& out) {
+    size_t dominio = tamDominio(q.agrupar);
+    VectorContado<uint64_t> denso(dominio, 0);
+    ConteoParticionado<uint32_t> disperso;
+    for (const RegistroCrudo& c : seleccion) {
+        Registro r = c.r;
+        r.razon = (uint8_t)vistas.idDe(c.razon);
+        uint32_t k = claveDeRegistro(r, q.agrupar);
+        if (dominio > 0) denso[k]++;
+        else disperso.sumar(k);
+    }
+    if (!leido) return false;
+
+    OrdenGrupos menor(q);
+    OrdenExterno<Grupo, OrdenGrupos> grupos(menor);
+    bool ok = true;
+    if (dominio > 0) {
+        for (size_t k = 0; k < dominio; k++)
+            if (denso[k] > 0) grupos.agregar({(uint32_t)k, denso[k]});
+    } else {
+        ok = disperso.recorrer([&](uint32_t k, uint64_t n) { grupos.agregar({k, n}); });
+    }
+    size_t escritos = 0;
+    ok = grupos.terminar([&](const Grupo& g) {
+        if (q.limite >= 0 && escritos >= (size_t)q.limite) return false;
+        out << textoClave(vistas, q.agrupar, g.clave) << " " << g.conteo << "\n";
+        escritos++;
+        return true;
+    }) && ok;
+    if (!ok) cerr << "Error: no se pudo usar el archivo temporal de derrame\n";
+    return ok;
+}
+
+/*
+ * 4.14 FilaFlujo / ordenarEnFlujo
+ * order by sin tabla: cada renglón que cumple se guarda con su clave y su
+ * número de secuencia (el id que tendría en la tabla) en un orden externo,
+ * que se derrama a disco por tramos si pasa del presupuesto. El orden es
+ * el de ejecutarRenglones: clave, tiempo, IP, puerto, texto de la razón y
+ * al final la posición; la razón viaja como id del diccionario local.
+ * Complejidad: O(s log s) con s los renglones seleccionados.
+ */
+struct FilaFlujo {
+    uint32_t clave;
+    uint32_t secuencia;
+    Registro r;
+};
+
+bool ordenarEnFlujo(const Consulta& q, Generador<RegistroCrudo>& seleccion, DiccionarioRazones& vistas,
+                    const bool& leido, ostream& out) {
+    bool desc = q.descendente;
+    auto menor = [&](const FilaFlujo& a, const FilaFlujo& b) {
+        if (a.clave != b.clave) return desc ? a.clave > b.clave : a.clave < b.clave;
+        if (a.r.tiempo != b.r.tiempo) return a.r.tiempo < b.r.tiempo;
+        if (a.r.ip != b.r.ip) return a.r.ip < b.r.ip;
+        if (a.r.puerto != b.r.puerto) return a.r.puerto < b.r.puerto;
+        if (a.r.razon != b.r.razon) return vistas.texto(a.r.razon) < vistas.texto(b.r.razon);
+        return a.secuencia < b.secuencia;
+    };
+    OrdenExterno<FilaFlujo, decltype(menor)> orden(menor);
+    uint32_t secuencia = 0;
+    for (const RegistroCrudo& c : seleccion) {
+        FilaFlujo f;
+        f.r = c.r;
+        f.r.razon = (uint8_t)vistas.idDe(c.razon);
+        f.clave = claveDeRegistro(f.r, q.ordenar);
+        f.secuencia = secuencia++;
+        orden.agregar(f);
+    }
+    if (!leido) return false;
+
+    FormateadorLineas formateador(vistas);
+    SalidaLineas sal(out);
+    size_t escritos = 0;
+    bool ok = orden.terminar([&](const FilaFlujo& f) {
+        if (q.limite >= 0 && escritos >= (size_t)q.limite) return false;
+        formateador.linea(f.r, sal);
+        escritos++;
+        return true;
+    });
+    if (!ok) cerr << "Error: no se pudo usar el archivo temporal de derrame\n";
+    return ok;
+}
+
+/*
+ * 4.15 ejecutarEnFlujo
+ * Contesta la consulta leyendo la bitácora al vuelo (--flujo), sin cargar
+ * la tabla ni construir índices:
+ *     registrosMezclados(rutas) | filtrar(cumple) | tomar(limite)
+ * Sin orden y con límite se deja de leer el archivo en cuanto se juntan
+ * las líneas: "where ip = x limit 100" cuesta hasta la línea 100 de x, no
+ * la ingesta completa. group by y order by necesitan todos los registros
+ * que cumplen: se pasan a agruparEnFlujo y ordenarEnFlujo, que respetan el
+ * presupuesto de memoria.
+ * La razón de cada línea se busca en un diccionario local (igual que al
+ * cargar, las razones más allá de MAX_RAZONES se omiten) y los filtros de
+ * razón se evalúan una sola vez por razón distinta.
+ * Complejidad: O(k) con k las líneas leídas hasta completar el límite.
+ */
+bool ejecutarEnFlujo(const vector<string>& rutas, const string& texto, ostream& out) {
+    vector<Token> tokens;
+    string error;
+    Consulta q;
+    if (!separarTokens(texto, tokens, error) || !Analizador(tokens, nullptr).analizar(q, error)) {
+        cerr << "Error en la consulta: " << error << "\n";
+        return false;
+    }
+    if (q.vacia) {
+        if (q.soloConteo) out << 0 << "\n";
+        return true;
+    }
+
+    DiccionarioRazones vistas;
+    vector<char> razonCumple;       // por id de vistas
+    auto cumple = [&](const RegistroCrudo& c) {
+        int id = vistas.idDe(c.razon);
+        if (id < 0) return false;
+        if ((size_t)id == razonCumple.size()) razonCumple.push_back(cumpleRazon(q, c.razon));
+        if (!razonCumple[(size_t)id]) return false;
+        for (const Predicado& p : q.filtros) {
+            bool ok = true;
+            switch (p.campo) {
+            case CAMPO_TIEMPO: ok = cumpleValor(p, c.r.tiempo); break;
+            case CAMPO_IP:     ok = cumpleValor(p, c.r.ip); break;
+            case CAMPO_PUERTO: ok = cumpleValor(p, c.r.puerto); break;
+            default: break;
+            }
+            if (!ok) return false;
+        }
+        return true;
+    };
+
+    bool leido = true;
+    Generador<RegistroCrudo> seleccion = registrosMezclados(rutas, &leido) | filtrar(cumple);
+    if (q.agrupar != CAMPO_NINGUNO) return agruparEnFlujo(q, seleccion, vistas, leido, out);
+    if (q.soloConteo) {
+        uint64_t total = 0;
+        for (const RegistroCrudo& c : seleccion) {
+            (void)c;
+            total++;
+        }
+        if (!leido) return false;
+        out << total << "\n";
+        return true;
+    }
+    if (q.ordenar != CAMPO_NINGUNO) return ordenarEnFlujo(q, seleccion, vistas, leido, out);
+    if (q.limite >= 0) seleccion = move(seleccion) | tomar((size_t)q.limite);
+    SalidaLineas sal(out);
+    for (const RegistroCrudo& c : seleccion) escribirLinea(sal, c.r, c.razon);
+    return leido;
+}
+
+/*
+ * 4.16 textoMomento / esFallo / escribirAlerta
+ * textoMomento: "Mon DD HH:MM:SS" (con el año si se infieren).
+ * esFallo: razones que cuentan como fallo de acceso para --detectar.
+ * escribirAlerta: la línea de cada alerta de fuerza bruta:
+ *     Mar 05 13:20:01 10.1.2.3 5 fallos en 37 s (desde Mar 05 13:19:24)
+ */
+string textoMomento(uint32_t t) {
+    char buf[48];
+    int n = textoFecha(t, buf, sizeof buf);
+    snprintf(buf + n, sizeof buf - (size_t)n, " %02d:%02d:%02d", horaDe(t), minutoDe(t), segundoDe(t));
+    return buf;
+}
+
+bool esFallo(string_view razon) {
+    return razon.rfind("Failed password", 0) == 0 || razon == "Too many login attempts";
+}
+
+void escribirAlerta(const Alerta& a, ostream& out) {
+    out << textoMomento(a.tiempo) << " " << ipATexto(a.ip) << " " << a.fallos << " fallos en " << a.tiempo - a.desde
+        << " s (desde " << textoMomento(a.desde) << ")\n";
+}
+
+/*
+ * 4.17 recorrerEnOrden
+ * Llama a f(registro) con los registros cuya razón cumple elegir(texto),
+ * en orden de tiempo, para los detectores en flujo. Con tabla: la copia
+ * columnar ya está en orden; si no, se ordenan (estable) los ids elegidos.
+ * En flujo se toman en el orden de los archivos mezclados, que es el de
+ * tiempo si cada archivo lo está. Devuelve false si no se pudo leer.
+ * Complejidad: O(n) con tabla ordenada o en flujo, O(k log k) si hay que
+ * ordenar los k elegidos.
+ */
+template <class Elegir, class F>
+bool recorrerEnOrden(const BaseDatos& db, const vector<string>& rutas, bool flujo, Elegir elegir, F f) {
+    if (flujo) {
+        bool leido = true;
+        DiccionarioRazones vistas;
+        vector<char> elegida;     // por id de vistas
+        for (const RegistroCrudo& c : registrosMezclados(rutas, &leido)) {
+            int id = vistas.idDe(c.razon);
+            if (id < 0) continue;
+            if ((size_t)id == elegida.size()) elegida.push_back(elegir(c.razon));
+            if (elegida[(size_t)id]) f(c.r);
+        }
+        return leido;
+    }
+    const TablaRegistros& t = db.tabla;
+    vector<char> elegida((size_t)t.razones.size());
+    for (int id = 0; id < t.razones.size(); id++) elegida[(size_t)id] = elegir(t.razones.texto(id));
+    vector<uint32_t> ids;
+    for (size_t i = 0; i < t.size(); i++)
+        if (elegida[t.razon[i]]) ids.push_back((uint32_t)i);
+    if (!is_sorted(t.tiempo.begin(), t.tiempo.end()))
+        stable_sort(ids.begin(), ids.end(), [&](uint32_t a, uint32_t b) { return t.tiempo[a] < t.tiempo[b]; });
+    for (uint32_t i : ids) f(Registro{t.tiempo[i], t.ip[i], t.puerto[i], t.razon[i]});
+    return true;
+}
+
+/*
+ * 4.18 detectarFuerzaBruta
+ * --detectar N/T: pasa los fallos de acceso, en orden de tiempo, por el
+ * detector (detector.h) e imprime una línea por alerta. En flujo avisa
+ * cuántos llegaron fuera de orden.
+ */
+bool detectarFuerzaBruta(const BaseDatos& db, const vector<string>& rutas, bool flujo, uint32_t umbral,
+                         uint32_t ventana, ostream& out) {
+    DetectorFuerzaBruta detector(umbral, ventana);
+    auto alerta = [&](const Alerta& a) { escribirAlerta(a, out); };
+    bool leido;
+    {
+        Temporizador deteccion("deteccion");
+        leido = recorrerEnOrden(db, rutas, flujo, esFallo,
+                                [&](const Registro& r) { detector.fallo(r.ip, r.tiempo, alerta); });
+    }
+    Estadisticas& e = Estadisticas::global();
+    e.contar("detector_eventos", detector.eventos);
+    e.contar("detector_alertas", detector.alertas);
+    e.contar("detector_desalojadas", detector.desalojadas);
+    e.contar("detector_barridos", detector.barridos);
+    e.contar("bytes_detector", detector.bytes());
+    if (detector.desordenados > 0)
+        cerr << "Aviso: " << detector.desordenados << " fallos llegaron fuera de orden de tiempo; "
+             << "las alertas pueden faltar (use la tabla, sin --flujo, para ordenarlos)\n";
+    return leido;
+}
+
+/*
+ * 4.19 escribirEscaneo / detectarEscaneos
+ * --escaneos P/T: cuenta los puertos distintos de cada IP por ventanas de
+ * T segundos (escaneo.h), con todos los registros en orden de tiempo.
+ * Imprime una línea por IP y ventana al llegar a P puertos y, al final,
+ * los mayores escaneos (uno por IP); "~" marca un estimado de bosquejo:
+ *     Mar 05 13:00:00 10.1.2.3 100 puertos
+ *     (línea en blanco)
+ *     Mar 05 13:00:00 10.1.2.3 ~1523 puertos
+ */
+void escribirEscaneo(const Escaneo& e, ostream& out) {
+    out << textoMomento(e.inicio) << " " << ipATexto(e.ip) << " " << (e.exacto ? "" : "~") << e.puertos
+        << " puertos\n";
+}
+
+bool detectarEscaneos(const BaseDatos& db, const vector<string>& rutas, bool flujo, const ConfigEscaneo& config,
+                      ostream& out) {
+    DetectorEscaneo detector(config);
+    auto alerta = [&](const Escaneo& e) { escribirEscaneo(e, out); };
+    bool leido;
+    {
+        Temporizador deteccion("escaneos");
+        leido = recorrerEnOrden(db, rutas, flujo, [](string_view) { return true; },
+                                [&](const Registro& r) { detector.registrar(r.ip, r.tiempo, r.puerto, alerta); });
+        detector.terminar();
+    }
+    out << "\n";
+    for (const Escaneo& e : detector.mayores()) escribirEscaneo(e, out);
+    Estadisticas& e = Estadisticas::global();
+    e.contar("escaneo_eventos", detector.eventos);
+    e.contar("escaneo_alertas", detector.alertas);
+    e.contar("escaneo_bosquejos", detector.bosquejos);
+    e.contar("escaneo_sin_bosquejo", detector.sinBosquejo);
+    e.contar("escaneo_reemplazadas", detector.reemplazadas);
+    e.contar("escaneo_descartados", detector.descartados);
+    e.contar("bytes_escaneo", detector.bytes());
+    if (detector.desordenados > 0)
+        cerr << "Aviso: " << detector.desordenados << " registros llegaron fuera de orden de tiempo; "
+             << "se contaron en la ventana siguiente (use la tabla, sin --flujo, para ordenarlos)\n";
+    return leido;
+}
+
+// ---------------- 5. FUNCIÓN PRINCIPAL ----------------
+
+/*
+ * 5.1 existeIp
+ * Contesta si la IP aparece en la bitácora usando el filtro guardado junto a
+ * ella (.fusion o .bloom); solo si no hay ninguno se carga la bitácora.
+ * Imprime "posible" (puede ser falso positivo, < 1%) o "no" (seguro).
+ */
+int existeIp(const string& ruta, const string& texto) {
+    uint32_t ip;
+    if (!parsearIpTexto(texto, ip)) {
+        cerr << "IP inválida: " << texto << "\n";
+        return 1;
+    }
+    FiltroFusionBinaria fusion;
+    FiltroBloomBloqueado bloom;
+    bool esta;
+    if (fusion.cargar(ruta + ".fusion")) esta = fusion.contiene(ip);
+    else if (bloom.cargar(ruta + ".bloom")) esta = bloom.contiene(ip);
+    else {
+        TablaRegistros t;
+        if (!cargarBitacora(ruta, t)) return 1;
+        esta = find(t.ip.begin(), t.ip.end(), ip) != t.ip.end();
+    }
+    cout << (esta ? "posible" : "no") << "\n";
+    return 0;
+}
+
+/*
+ * 5.2 guardarFiltros
+ * Escribe ambos filtros de IPs junto a la bitácora. El Bloom se llena en
+ * una pasada sobre la columna; el binary fuse ya está construido.
+ */
+bool guardarFiltros(const string& ruta, const BaseDatos& db) {
+    FiltroBloomBloqueado bloom(db.tabla.size());
+    for (uint32_t ip : db.tabla.ip) bloom.agregar(ip);
+    return bloom.guardar(ruta + ".bloom") && db.filtroIp.guardar(ruta + ".fusion");
+}
+
+/*
+ * 5.3 cargarTabla
+ * Sin --columnar parsea la bitácora (o el juego rotado). Con --columnar
+ * usa ruta.col si existe y es al menos tan nuevo como todos los archivos
+ * de texto; si no, parsea y escribe ruta.col para la siguiente corrida.
+ * No poder escribir el .col solo genera un aviso.
+ */
+bool cargarTabla(const string& ruta, const vector<string>& rutas, bool columnar, TablaRegistros& t) {
+    if (!columnar) return cargarBitacoras(rutas, t);
+    string rutaCol = ruta + ".col";
+    BitacoraColumnar col;
+    struct stat stCol, st;
+    bool vigente = stat(rutaCol.c_str(), &stCol) == 0;
+    for (const string& r : rutas)
+        if (vigente && stat(rutaEntrada(r).c_str(), &st) == 0 && st.st_mtime > stCol.st_mtime) vigente = false;
+    if (vigente) {
+        Temporizador carga("columnar");
+        if (col.cargar(rutaCol)) {
+            col.descomprimir(t);
+            Estadisticas::global().contar("bytes_columnar", col.bytes());
+            return true;
+        }
+        cerr << "Aviso: " << rutaCol << " inválido, se vuelve a leer la bitácora\n";
+    }
+    if (!cargarBitacoras(rutas, t)) return false;
+    Temporizador escritura("escritura");
+    col.comprimir(t);
+    if (!col.guardar(rutaCol)) cerr << "Aviso: no se pudo escribir " << rutaCol << "\n";
+    // la tabla se sigue usando en orden de tiempo, igual que al cargar el .col
+    t = TablaRegistros();
+    col.descomprimir(t);
+    return true;
+}
+
+/*
+ * 5.4 prepararRollups
+ * Con --columnar los rollups se guardan en ruta.rollup junto a la copia
+ * columnar y se cargan de ahí mientras sean al menos tan nuevos como el
+ * .col y cuadren con la tabla; si no, se construyen (y se guardan). Sin
+ * --columnar siempre se construyen.
+ */
+void prepararRollups(const string& ruta, bool columnar, const TablaRegistros& t, Rollups& ru) {
+    string rutaRollup = ruta + ".rollup";
+    struct stat stRollup, stCol;
+    if (columnar && stat(rutaRollup.c_str(), &stRollup) == 0 && stat((ruta + ".col").c_str(), &stCol) == 0 &&
+        stRollup.st_mtime >= stCol.st_mtime && ru.cargar(rutaRollup) && ru.registros() == t.size() &&
+        ru.razones() == (uint32_t)t.razones.size()) {
+        Estadisticas::global().contar("bytes_rollups", ru.bytes());
+        return;
+    }
+    ru.construir(t);
+    Estadisticas::global().contar("bytes_rollups", ru.bytes());
+    if (columnar && !ru.guardar(rutaRollup)) cerr << "Aviso: no se pudo escribir " << rutaRollup << "\n";
+}
+
+/*
+ * 5.5 memoriaEstimada
+ * Bytes que ocuparían la tabla y sus índices: ~48 bytes de texto por línea
+ * (como en cargarBitacora) y ~64 bytes por registro entre columnas,
+ * índices roaring, índice invertido y filtro de IPs (medido con --stats).
+ * Un .gz se cuenta como ~8 veces su tamaño, lo típico en texto de bitácora.
+ */
+size_t memoriaEstimada(const vector<string>& rutas) {
+    size_t texto = 0;
+    struct stat st;
+    for (const string& r : rutas) {
+        string real = rutaEntrada(r);
+        if (stat(real.c_str(), &st) != 0) continue;
+        bool comprimido = real.size() > 3 && real.compare(real.size() - 3, 3, ".gz") == 0;
+        texto += (size_t)st.st_size * (comprimido ? 8 : 1);
+    }
+    return texto / 48 * 64;
+}
+
+/*
+ * 5.6 main
+ * 1) Lee argumentos (-f archivo, --sin-indices, --guardar-filtros,
+ *    --columnar, --existe ip, --hilos n, --fijar-nucleos, --paginas, --flujo,
+ *    --mem, --anio-base, --cambio-anio, --detectar, --escaneos, --stats[-hw],
+ *    --traza y consultas)
+ * 2) Carga la bitácora (o el juego de archivos rotados, mezclados por
+ *    tiempo, o su copia columnar) en la tabla (una sola pasada); con --flujo
+ *    (o si la tabla no cabe en --mem) se salta 2) y 3) y cada consulta lee
+ *    el archivo al vuelo
+ * 3) Construye a la vez los índices secundarios (en paralelo por tramos),
+ *    el índice invertido, el filtro de IPs y los rollups por minuto (o los
+ *    carga de ruta.rollup con --columnar), sobre el conjunto de hilos
+ * 4) Ejecuta cada consulta, separando resultados con una línea en blanco;
+ *    con --detectar N/T y/o --escaneos P/T en lugar de 3) y 4) pasa los
+ *    registros por los detectores de fuerza bruta y de escaneo de puertos
+ */
+int main(int argc, char* argv[]) {
+    Estadisticas::global().habilitarSiSePide(argc, argv, "Consultas");
+    if (!Presupuesto::global().habilitarSiSePide(argc, argv)) return 1;
+    if (!Calendario::global().habilitarSiSePide(argc, argv)) return 1;
+    string ruta = "bitacora.txt", existe;
+    vector<string> consultas;
+    uint32_t umbral = 0, ventana = 0;
+    ConfigEscaneo escaneos;
+    escaneos.umbral = 0;
+    bool indices = true, guardar = false, fijar = false, flujo = false, columnar = false;
+    unsigned hilos = 0;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-f" && i + 1 < argc) ruta = argv[++i];
+        else if (arg == "--hilos" && i + 1 < argc) {
+            char* fin = nullptr;
+            unsigned long n = strtoul(argv[++i], &fin, 10);
+            if (fin == argv[i] || *fin != '\0' || argv[i][0] == '-' || n > 4096) {
+                cerr << "--hilos espera un número de hilos (0 = los núcleos del CPU, hasta 4096): " << argv[i] << "\n";
+                return 1;
+            }
+            hilos = (unsigned)n;
+        }
+        else if (arg == "--fijar-nucleos") fijar = true;
+        else if (arg == "--paginas" && i + 1 < argc) {
+            TipoPaginas tipo;
+            if (!leerTipoPaginas(argv[++i], tipo)) {
+                cerr << "Tipo de páginas desconocido: " << argv[i] << " (normales, thp o hugetlb)\n";
+                return 1;
+            }
+            fijarPoliticaPaginas(tipo);
+        }
+        else if (arg == "--sin-indices") indices = false;
+        else if (arg == "--flujo") flujo = true;
+        else if (arg == "--guardar-filtros") guardar = true;
+        else if (arg == "--columnar") columnar = true;
+        else if (arg == "--existe" && i + 1 < argc) existe = argv[++i];
+        else if (arg == "--detectar" && i + 1 < argc) {
+            unsigned n = 0, s = 0;
+            char sobra;
+            if (sscanf(argv[++i], "%u/%u%c", &n, &s, &sobra) != 2 || n == 0 || n > DetectorFuerzaBruta::UMBRAL_MAX ||
+                s == 0) {
+                cerr << "--detectar espera N/T (N fallos en T segundos, 1 <= N <= "
+                     << DetectorFuerzaBruta::UMBRAL_MAX << ", T > 0): " << argv[i] << "\n";
+                return 1;
+            }
+            umbral = n;
+            ventana = s;
+        }
+        else if (arg == "--escaneos" && i + 1 < argc) {
+            unsigned p = 0, s = 0;
+            char sobra;
+            if (sscanf(argv[++i], "%u/%u%c", &p, &s, &sobra) != 2 || p == 0 || p > 65535 || s == 0) {
+                cerr << "--escaneos espera P/T (P puertos distintos en T segundos, 1 <= P <= 65535, T > 0): "
+                     << argv[i] << "\n";
+                return 1;
+            }
+            escaneos.umbral = p;
+            escaneos.ventana = s;
+        }
+        else if (arg == "-f" || arg == "--hilos" || arg == "--paginas" || arg == "--existe" ||
+                 arg == "--detectar" || arg == "--escaneos") {
+            // opción con valor al final de la línea: no es una consulta
+            cerr << arg << " espera un valor\n";
+            return 1;
+        }
+        else consultas.push_back(arg);
+    }
+    if (!existe.empty()) return existeIp(ruta, existe);
+    PoolHilos::configurar(hilos, fijar);
+
+    vector<string> rutas = archivosRotados(ruta);
+    size_t estimada = memoriaEstimada(rutas);
+    if (!flujo && !Presupuesto::global().cabe(estimada)) {
+        cerr << "Aviso: la tabla (~" << (estimada >> 20) << " MiB) no cabe en --mem ("
+             << (Presupuesto::global().limiteBytes() >> 20) << " MiB); las consultas se leen en flujo\n";
+        flujo = true;
+    }
+    BaseDatos db;
+    if (!flujo && !cargarTabla(ruta, rutas, columnar, db.tabla)) return 1;
+    if (umbral > 0 || escaneos.umbral > 0) {
+        bool ok = true;
+        if (umbral > 0) ok = detectarFuerzaBruta(db, rutas, flujo, umbral, ventana, cout);
+        if (umbral > 0 && escaneos.umbral > 0) cout << "\n";
+        if (escaneos.umbral > 0) ok = detectarEscaneos(db, rutas, flujo, escaneos, cout) && ok;
+        return ok ? 0 : 1;
+    }
+    if (!flujo && (indices || guardar)) {
+        // los índices y los rollups son independientes: se construyen a la vez
+        Temporizador indice("indice");
+        bool filtroOk = true;
+        GrupoTareas g;
+        g.lanzar([&] { db.indices.construir(db.tabla); });
+        g.lanzar([&] {
+            EventoTraza e("invertido");
+            db.invertido.construir(db.tabla);
+        });
+        g.lanzar([&] {
+            EventoTraza e("filtroIp");
+            filtroOk = db.filtroIp.construir(db.tabla.ip);
+        });
+        if (indices) {
+            g.lanzar([&] {
+                EventoTraza e("rollups");
+                prepararRollups(ruta, columnar, db.tabla, db.rollups);
+            });
+        }
+        g.esperar();
+        if (!filtroOk) return 1;
+        db.conIndices = indices;
+    }
+    if (!flujo && guardar) {
+        Temporizador escritura("escritura");
+        if (!guardarFiltros(ruta, db)) return 1;
+    }
+
+    bool leerStdin = consultas.empty();
+    string linea;
+    bool todasValidas = true;
+    size_t ejecutadas = 0;
+    for (size_t i = 0;; i++) {
+        string texto;
+        if (leerStdin) {
+            if (!getline(cin, linea)) break;
+            if (linea.empty()) continue;
+            texto = linea;
+        } else {
+            if (i >= consultas.size()) break;
+            texto = consultas[i];
+        }
+        if (ejecutadas++ > 0) cout << "\n";
+        Temporizador consulta("consulta");
+        bool valida = flujo ? ejecutarEnFlujo(rutas, texto, cout) : ejecutarConsulta(db, texto, cout);
+        todasValidas = valida && todasValidas;
+    }
+    return todasValidas ? 0 : 1;
+}